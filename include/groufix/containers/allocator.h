@@ -0,0 +1,195 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#ifndef GFX_CONTAINERS_ALLOCATOR_H
+#define GFX_CONTAINERS_ALLOCATOR_H
+
+#include "groufix/utils.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+
+
+/********************************************************
+ * Allocator interface
+ *******************************************************/
+
+/** Allocator */
+typedef struct GFXAllocator GFXAllocator;
+
+
+/**
+ * Reallocation function, behaves as realloc.
+ *
+ * @param ptr     Memory to reallocate, NULL to allocate new memory.
+ * @param oldSize Size ptr was allocated with, 0 if ptr is NULL.
+ * @param newSize New size of the memory, 0 to free ptr.
+ * @return NULL on failure or when freeing, ptr is untouched on failure.
+ *
+ */
+typedef void* (*GFXReallocFunc) (GFXAllocator*, void* ptr, size_t oldSize, size_t newSize);
+
+
+/** Allocator */
+struct GFXAllocator
+{
+	GFXReallocFunc  reallocate;
+
+	size_t          allocs;     /* Number of (re)allocations served */
+	size_t          heapAllocs; /* Number of (re)allocations on the heap */
+};
+
+
+/**
+ * Initializes an allocator which forwards to the heap.
+ *
+ * This is the same as not using an allocator at all,
+ * except for the fact that allocations are counted.
+ *
+ */
+GFX_API void gfx_allocator_init(
+
+		GFXAllocator* allocator);
+
+/**
+ * Reallocates memory using an allocator.
+ *
+ * @param allocator Allocator to use, NULL to use the heap directly.
+ * @return NULL on failure or when freeing, ptr is untouched on failure.
+ *
+ */
+static GFX_ALWAYS_INLINE void* gfx_allocator_realloc(
+
+		GFXAllocator*  allocator,
+		void*          ptr,
+		size_t         oldSize,
+		size_t         newSize)
+{
+	if(allocator)
+	{
+		void* new = allocator->reallocate(allocator, ptr, oldSize, newSize);
+		if(new) ++allocator->allocs;
+
+		return new;
+	}
+
+	if(newSize) return realloc(ptr, newSize);
+	free(ptr);
+
+	return NULL;
+}
+
+
+/********************************************************
+ * Linear arena allocator
+ *******************************************************/
+
+/** Arena */
+typedef struct GFXArena
+{
+	GFXAllocator  allocator; /* Pass this to containers */
+
+	size_t        blockSize; /* Minimum size of a block */
+	void*         blocks;    /* Current block, links to all previous blocks */
+	void*         last;      /* Most recent allocation */
+
+} GFXArena;
+
+
+/**
+ * Initializes an arena.
+ *
+ * @param blockSize Minimum number of bytes to allocate at once.
+ *
+ * Allocations are taken linearly from blocks of memory, only the most recent
+ * allocation can be resized in place or freed, all others are freed on reset.
+ * This makes it well suited for short lived containers, such as per-frame data.
+ * The arena is not thread safe.
+ *
+ */
+GFX_API void gfx_arena_init(
+
+		GFXArena*  arena,
+		size_t     blockSize);
+
+/**
+ * Frees all memory held by the arena.
+ *
+ * All memory allocated by the arena is invalidated.
+ *
+ */
+GFX_API void gfx_arena_clear(
+
+		GFXArena* arena);
+
+/**
+ * Frees all allocations at once, but keeps its memory.
+ *
+ * All memory allocated by the arena is invalidated.
+ * If multiple blocks were in use, they are merged into a single block,
+ * so the arena does not touch the heap anymore once it has grown large enough.
+ *
+ */
+GFX_API void gfx_arena_reset(
+
+		GFXArena* arena);
+
+
+/********************************************************
+ * Fixed size pool allocator
+ *******************************************************/
+
+/** Pool */
+typedef struct GFXPool
+{
+	GFXAllocator  allocator; /* Pass this to containers */
+
+	size_t        blockSize;  /* Size of a single block */
+	size_t        chunkSize;  /* Number of blocks to allocate at once */
+	void*         chunks;     /* Linked list of chunks */
+	void*         free;       /* Linked list of free blocks */
+
+} GFXPool;
+
+
+/**
+ * Initializes a pool.
+ *
+ * @param blockSize Size of each block in bytes.
+ * @param chunkSize Number of blocks to allocate from the heap at once.
+ *
+ * Allocations of at most blockSize bytes are served by a free list of blocks,
+ * which are kept when freed. Larger allocations are forwarded to the heap.
+ * The pool is not thread safe.
+ *
+ */
+GFX_API void gfx_pool_init(
+
+		GFXPool*  pool,
+		size_t    blockSize,
+		size_t    chunkSize);
+
+/**
+ * Frees all memory held by the pool.
+ *
+ * All blocks allocated by the pool are invalidated,
+ * allocations forwarded to the heap are not.
+ *
+ */
+GFX_API void gfx_pool_clear(
+
+		GFXPool* pool);
+
+
+#endif // GFX_CONTAINERS_ALLOCATOR_H
@@ -15,7 +15,7 @@
 #ifndef GFX_CONTAINERS_DEQUE_H
 #define GFX_CONTAINERS_DEQUE_H
 
-#include "groufix/utils.h"
+#include "groufix/containers/allocator.h"
 
 #include <stddef.h>
 
@@ -33,6 +33,7 @@ typedef struct GFXDeque
 {
 	size_t            elementSize;
 	size_t            capacity; /* in bytes */
+	GFXAllocator*     allocator;
 
 	void*             data;
 	GFXDequeIterator  begin;
@@ -92,6 +93,20 @@ GFX_API void gfx_deque_init(
 		GFXDeque*  deque,
 		size_t     elementSize);
 
+/**
+ * Initializes a deque which allocates its memory through an allocator.
+ *
+ * @param allocator Allocator to use, NULL to use the heap.
+ *
+ * The allocator must outlive the content of the deque.
+ *
+ */
+GFX_API void gfx_deque_init_with_allocator(
+
+		GFXDeque*      deque,
+		size_t         elementSize,
+		GFXAllocator*  allocator);
+
 /**
  * Initializes a deque with a preset content.
  *
@@ -112,6 +127,7 @@ GFX_API void gfx_deque_init_from_buffer(
  * Initializes a copy of a deque.
  *
  * Note: size will be 0 if the data could not be allocated.
+ * The copy uses the heap, not the allocator of src.
  *
  */
 GFX_API void gfx_deque_init_copy(
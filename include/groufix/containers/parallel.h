@@ -0,0 +1,86 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#ifndef GFX_CONTAINERS_PARALLEL_H
+#define GFX_CONTAINERS_PARALLEL_H
+
+#include "groufix/containers/thread_pool.h"
+
+#include <stddef.h>
+
+
+/********************************************************
+ * Parallel algorithms
+ *******************************************************/
+
+/** Parallel for body, processes the range [begin, end) */
+typedef void (*GFXParallelForFunc) (size_t begin, size_t end, void* data);
+
+
+/** Comparison function, returns < 0, 0 or > 0 as in qsort */
+typedef int (*GFXParallelCompare) (const void*, const void*, void* data);
+
+
+/**
+ * Processes a range of indices, split into chunks across a thread pool.
+ *
+ * @param pool  Thread pool to execute the chunks with (can be NULL).
+ * @param grain Minimum number of indices per chunk, 0 for no minimum.
+ * @param func  Function to call for each chunk.
+ * @param data  Data to pass as argument to func.
+ *
+ * The size of the chunks adapts to the number of cores of the system.
+ * The calling thread processes chunks as well and this call blocks until
+ * all chunks are processed, it can therefore be called from within a task.
+ * If no pool is given or tasks could not be pushed, all chunks
+ * are processed by the calling thread.
+ *
+ */
+GFX_API void gfx_parallel_for(
+
+		GFXThreadPool*      pool,
+		size_t              begin,
+		size_t              end,
+		size_t              grain,
+		GFXParallelForFunc  func,
+		void*               data);
+
+/**
+ * Stable sorts an array, split into chunks across a thread pool.
+ *
+ * @param pool    Thread pool to execute the chunks with (can be NULL).
+ * @param base    Array of elements to sort.
+ * @param scratch Buffer of at least num * size bytes, NULL to allocate one.
+ * @param num     Number of elements in the array.
+ * @param size    Size of a single element in bytes.
+ * @param compare Comparison function.
+ * @param data    Data to pass as argument to compare.
+ * @return Zero on failure, in which case the array is untouched.
+ *
+ * Chunks are merge sorted and merged pairwise afterwards.
+ * The calling thread helps out as with gfx_parallel_for.
+ *
+ */
+GFX_API int gfx_parallel_sort(
+
+		GFXThreadPool*      pool,
+		void*               base,
+		void*               scratch,
+		size_t              num,
+		size_t              size,
+		GFXParallelCompare  compare,
+		void*               data);
+
+
+#endif // GFX_CONTAINERS_PARALLEL_H
@@ -0,0 +1,195 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#ifndef GFX_CONTAINERS_SLOT_MAP_H
+#define GFX_CONTAINERS_SLOT_MAP_H
+
+#include "groufix/containers/vector.h"
+
+
+/********************************************************
+ * Slot map container
+ *******************************************************/
+
+/** Slot map handle (0 is never a valid handle) */
+typedef unsigned int GFXSlotHandle;
+
+
+/** Slot map */
+typedef struct GFXSlotMap
+{
+	GFXVector      data;    /* Densely packed elements */
+	GFXVector      handles; /* Handle of each element in data */
+	GFXVector      slots;   /* Indirection from handles to data */
+
+	size_t         free;    /* First free slot + 1, 0 if none */
+	size_t         last;    /* Last free slot + 1, 0 if none */
+	unsigned char  seed;    /* Generation of new slots */
+
+} GFXSlotMap;
+
+
+/**
+ * Initializes a slot map.
+ *
+ * A slot map stores elements densely packed, so they can be iterated over
+ * through its data vector, while every element is referenced by a stable handle.
+ * Handles carry an 8 bit generation, so handles of erased elements are detected.
+ * The generation wraps around, free slots are reused in the order they were
+ * freed, so a stale handle only becomes valid again after its slot is reused
+ * 256 times, which requires cycling through all free slots 256 times.
+ *
+ */
+GFX_API void gfx_slot_map_init(
+
+		GFXSlotMap*  map,
+		size_t       elementSize);
+
+/**
+ * Clears the content of a slot map, freeing all its memory.
+ *
+ * All handles become invalid, as the generations of all slots are discarded
+ * they may be handed out again, use gfx_slot_map_reset to prevent this.
+ *
+ */
+GFX_API void gfx_slot_map_clear(
+
+		GFXSlotMap* map);
+
+/**
+ * Erases all elements, but keeps the slot table.
+ *
+ * All handles become invalid, the slots and their generations are kept
+ * so the same handles are not handed out again right away.
+ *
+ */
+GFX_API void gfx_slot_map_reset(
+
+		GFXSlotMap* map);
+
+/**
+ * Requests a minimum capacity, which will hold as long as nothing is erased.
+ *
+ * @return If zero, out of memory.
+ *
+ */
+GFX_API int gfx_slot_map_reserve(
+
+		GFXSlotMap*  map,
+		size_t       numElements);
+
+/**
+ * Inserts an element at the end of the data vector.
+ *
+ * @param element Data to copy into the new element, can be NULL to copy nothing.
+ * @return The handle of the new element, 0 on failure.
+ *
+ */
+GFX_API GFXSlotHandle gfx_slot_map_insert(
+
+		GFXSlotMap*  map,
+		const void*  element);
+
+/**
+ * Erases the element at a given index of the data vector.
+ *
+ * The last element is moved into its place, the handle of this element
+ * remains valid, but its index becomes the given index.
+ *
+ */
+GFX_API void gfx_slot_map_erase_at(
+
+		GFXSlotMap*  map,
+		size_t       index);
+
+/**
+ * Retrieves the index of an element in the data vector.
+ *
+ * @return Zero if the handle is invalid, the index + 1 otherwise.
+ *
+ */
+GFX_API size_t gfx_slot_map_get_index(
+
+		const GFXSlotMap*  map,
+		GFXSlotHandle      handle);
+
+/**
+ * Erases an element.
+ *
+ * @return Zero if the handle was invalid.
+ *
+ * Same as gfx_slot_map_erase_at, so the last element is moved into its place.
+ *
+ */
+GFX_API int gfx_slot_map_erase(
+
+		GFXSlotMap*    map,
+		GFXSlotHandle  handle);
+
+/**
+ * Frees all unused slots at the end of the slot table.
+ *
+ * Memory held by the slot table is shrunk accordingly,
+ * the handles of elements which are still present remain valid.
+ * Stale handles of freed slots might become valid again sooner than usual
+ * once new slots are created in their place.
+ * This is never done automatically, as insertion and erasure are O(1) already.
+ *
+ */
+GFX_API void gfx_slot_map_compact(
+
+		GFXSlotMap* map);
+
+/**
+ * Retrieves an element.
+ *
+ * @return NULL if the handle is invalid.
+ *
+ */
+static GFX_ALWAYS_INLINE void* gfx_slot_map_at(
+
+		const GFXSlotMap*  map,
+		GFXSlotHandle      handle)
+{
+	size_t index = gfx_slot_map_get_index(map, handle);
+	return index ? gfx_vector_at(&map->data, index - 1) : NULL;
+}
+
+/**
+ * Retrieves the handle of the element at a given index of the data vector.
+ *
+ * This method does not check the bounds!
+ *
+ */
+static GFX_ALWAYS_INLINE GFXSlotHandle gfx_slot_map_get_handle(
+
+		const GFXSlotMap*  map,
+		size_t             index)
+{
+	return *(GFXSlotHandle*)gfx_vector_at(&map->handles, index);
+}
+
+/**
+ * Returns the number of elements in the slot map.
+ *
+ */
+static GFX_ALWAYS_INLINE size_t gfx_slot_map_get_size(
+
+		const GFXSlotMap* map)
+{
+	return gfx_vector_get_size(&map->handles);
+}
+
+
+#endif // GFX_CONTAINERS_SLOT_MAP_H
@@ -109,6 +109,10 @@ GFX_API unsigned int gfx_thread_pool_shrink(
  * @return Zero on failure.
  *
  * This function is thread safe.
+ * Note: priorities are grouped into 4 bands of 64 values each, tasks within
+ * the same band are not executed in any particular order.
+ * Tasks pushed from within a task of the same pool are queued at the calling
+ * thread and are executed by it first, other threads will steal them when idle.
  *
  */
 GFX_API int gfx_thread_pool_push(
@@ -153,4 +157,80 @@ GFX_API void gfx_thread_pool_flush(
 		GFXThreadPool* pool);
 
 
+/********************************************************
+ * Task groups & dependencies
+ *******************************************************/
+
+/** Thread pool task group */
+typedef struct GFXThreadPoolGroup
+{
+	GFXThreadPool* pool; /* Pool to execute the tasks with */
+
+} GFXThreadPoolGroup;
+
+
+/**
+ * Creates a new task group.
+ *
+ * @param pool Thread pool to push all tasks of the group to.
+ * @return NULL on failure.
+ *
+ */
+GFX_API GFXThreadPoolGroup* gfx_thread_pool_group_create(
+
+		GFXThreadPool* pool);
+
+/**
+ * Makes sure a task group is freed properly.
+ *
+ * Note: the group cannot have any unfinished tasks, nor can any tasks still
+ * depend on it, call gfx_thread_pool_group_wait first.
+ *
+ */
+GFX_API void gfx_thread_pool_group_free(
+
+		GFXThreadPoolGroup* group);
+
+/**
+ * Pushes a new task to the thread pool of a group, as part of the group.
+ *
+ * @param depend   Group to finish before the task can be executed (can be NULL).
+ * @param task     Function to execute.
+ * @param data     Data to pass as argument to task.
+ * @param priority Priority of the task, a lower value means higher priority.
+ * @return Zero on failure.
+ *
+ * If depend has no unfinished tasks, the task is pushed immediately.
+ * Otherwise it is pushed as soon as all tasks of depend are finished,
+ * including tasks pushed to depend until that point.
+ * Note: depend cannot be equal to group.
+ *
+ * This function is thread safe.
+ *
+ */
+GFX_API int gfx_thread_pool_group_push(
+
+		GFXThreadPoolGroup*  group,
+		GFXThreadPoolGroup*  depend,
+		GFXThreadPoolTask    task,
+		void*                data,
+		signed char          priority);
+
+/**
+ * Blocks the calling thread until all tasks of a group are finished.
+ *
+ * The calling thread executes pending tasks of the pool while waiting,
+ * this function can therefore be called from within a task of the same pool.
+ *
+ * Note: if the pool is suspended and never gets resumed, or if no threads
+ * exist while there are running tasks, this might block indefinitely.
+ *
+ * This function is thread safe.
+ *
+ */
+GFX_API void gfx_thread_pool_group_wait(
+
+		GFXThreadPoolGroup* group);
+
+
 #endif // GFX_CONTAINERS_THREAD_POOL_H
@@ -15,7 +15,7 @@
 #ifndef GFX_CONTAINERS_VECTOR_H
 #define GFX_CONTAINERS_VECTOR_H
 
-#include "groufix/utils.h"
+#include "groufix/containers/allocator.h"
 
 #include <stddef.h>
 
@@ -33,6 +33,7 @@ typedef struct GFXVector
 {
 	size_t             elementSize;
 	size_t             capacity; /* in bytes */
+	GFXAllocator*      allocator;
 
 	GFXVectorIterator  begin;
 	GFXVectorIterator  end;
@@ -91,6 +92,20 @@ GFX_API void gfx_vector_init(
 		GFXVector*  vector,
 		size_t      elementSize);
 
+/**
+ * Initializes a vector which allocates its memory through an allocator.
+ *
+ * @param allocator Allocator to use, NULL to use the heap.
+ *
+ * The allocator must outlive the content of the vector.
+ *
+ */
+GFX_API void gfx_vector_init_with_allocator(
+
+		GFXVector*     vector,
+		size_t         elementSize,
+		GFXAllocator*  allocator);
+
 /**
  * Initializes a vector with a preset content.
  *
@@ -108,6 +123,8 @@ GFX_API void gfx_vector_init_from_buffer(
 /**
  * Initializes a copy of a vector.
  *
+ * Note: the copy uses the heap, not the allocator of src.
+ *
  */
 GFX_API void gfx_vector_init_copy(
 
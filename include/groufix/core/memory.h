@@ -151,7 +151,8 @@ typedef enum GFXBufferUsage
 	GFX_BUFFER_WRITE           = 0x004,
 	GFX_BUFFER_MAP_READ        = 0x008,
 	GFX_BUFFER_MAP_WRITE       = 0x010,
-	GFX_BUFFER_MAP_PERSISTENT  = 0x020
+	GFX_BUFFER_MAP_PERSISTENT  = 0x020,
+	GFX_BUFFER_STREAM          = 0x040  /* Implies GFX_BUFFER_WRITE, GFX_BUFFER_MAP_WRITE and GFX_BUFFER_MAP_PERSISTENT */
 
 } GFXBufferUsage;
 
@@ -170,6 +171,14 @@ typedef struct GFXBuffer
 } GFXBuffer;
 
 
+/** Asynchronous buffer read */
+typedef struct GFXBufferRead
+{
+	size_t size; /* Number of bytes being read */
+
+} GFXBufferRead;
+
+
 /**
  * Creates a new buffer.
  *
@@ -178,6 +187,7 @@ typedef struct GFXBuffer
  * @param count Number of backbuffers to allocate (0 is the same as 1).
  * @return NULL on failure.
  *
+ * If usage contains GFX_BUFFER_STREAM, count must be at least 2.
  * Note: if data is not NULL, this data is only copied to the current backbuffer.
  *
  */
@@ -216,6 +226,10 @@ GFX_API void gfx_buffer_free(
 /**
  * Advances to the next backbuffer.
  *
+ * If GFX_BUFFER_STREAM was given at creation, a fence is placed for the previous
+ * backbuffer and this blocks until the GPU is done with the next backbuffer.
+ * All stream allocations are reset, so the buffer acts as a ring of count frames.
+ *
  */
 GFX_API void gfx_buffer_swap(
 
@@ -229,6 +243,9 @@ GFX_API void gfx_buffer_swap(
  * @param offset Byte offset in the buffer to begin reading at.
  * @return Number of bytes actually read.
  *
+ * This stalls until the GPU is done writing to the buffer, use
+ * gfx_buffer_read_async to read back without waiting.
+ *
  * Note: GFX_BUFFER_READ must be set at creation.
  *
  */
@@ -239,6 +256,50 @@ GFX_API size_t gfx_buffer_read(
 		void*             data,
 		size_t            offset);
 
+/**
+ * Starts reading data from the current backbuffer asynchronously.
+ *
+ * @param size   Size of the data to read, in bytes.
+ * @param offset Byte offset in the buffer to begin reading at.
+ * @return The read to finish later on, NULL on failure.
+ *
+ * The data is copied to a staging buffer by the GPU, after which a fence is placed.
+ * The read must be finished with gfx_buffer_read_finish, and does not depend on
+ * the buffer anymore, so the buffer can be altered or freed in the meantime.
+ *
+ * Note: GFX_BUFFER_READ must be set at creation.
+ *
+ */
+GFX_API GFXBufferRead* gfx_buffer_read_async(
+
+		const GFXBuffer*  buffer,
+		size_t            size,
+		size_t            offset);
+
+/**
+ * Polls whether an asynchronous read is done.
+ *
+ * @return Non-zero if gfx_buffer_read_finish will not block.
+ *
+ */
+GFX_API int gfx_buffer_read_poll(
+
+		GFXBufferRead* read);
+
+/**
+ * Finishes an asynchronous read, blocking until the data is available.
+ *
+ * @param data Pointer to write to, can be NULL to discard the data.
+ * @return Number of bytes actually read.
+ *
+ * The read is freed, the pointer should not be used anymore.
+ *
+ */
+GFX_API size_t gfx_buffer_read_finish(
+
+		GFXBufferRead*  read,
+		void*           data);
+
 /**
  * Writes data to the current backbuffer synchronously.
  *
@@ -342,6 +403,123 @@ GFX_API int gfx_buffer_unmap(
 
 		const GFXBuffer* buffer);
 
+/**
+ * Allocates a region of the current backbuffer of a streaming buffer.
+ *
+ * @param size   Size of the region in bytes.
+ * @param align  Alignment of the offset of the region in bytes (0 is the same as 1).
+ * @param offset Returns the byte offset of the region within the current backbuffer.
+ * @return Pointer to write the region to, NULL if it does not fit or not a streaming buffer.
+ *
+ * The returned pointer is valid until the next call to gfx_buffer_swap.
+ * The region can be written to without any synchronization, as the backbuffer
+ * is never in use by the GPU between two calls to gfx_buffer_swap.
+ *
+ * Note: GFX_BUFFER_STREAM must be set at creation.
+ *
+ */
+GFX_API void* gfx_buffer_stream_alloc(
+
+		GFXBuffer*  buffer,
+		size_t      size,
+		size_t      align,
+		size_t*     offset);
+
+/**
+ * Makes all regions allocated by gfx_buffer_stream_alloc visible to the GPU.
+ *
+ * This must be called after writing and before using the data.
+ * If the buffer is persistently mapped this is a no-op, otherwise the data
+ * is written to the buffer from client memory.
+ *
+ */
+GFX_API void gfx_buffer_stream_flush(
+
+		GFXBuffer* buffer);
+
+
+/********************************************************
+ * Buffer heap (sub-allocates ranges of large buffers)
+ *******************************************************/
+
+/** Buffer range */
+typedef struct GFXBufferRange
+{
+	GFXBuffer*  buffer; /* Backing buffer of the range */
+	size_t      offset; /* Byte offset within the buffer */
+	size_t      size;   /* Size of the range in bytes (at least the requested size) */
+
+} GFXBufferRange;
+
+
+/** Buffer heap */
+typedef struct GFXBufferHeap
+{
+	/* Read only fields */
+	GFXBufferUsage  usage;     /* Usage of all backing buffers */
+	size_t          blockSize; /* Size of each backing buffer in bytes */
+	size_t          minSize;   /* Size of the smallest range in bytes */
+
+} GFXBufferHeap;
+
+
+/**
+ * Creates a new buffer heap.
+ *
+ * @param usage     Usage bitflag of all backing buffers, cannot contain GFX_BUFFER_STREAM.
+ * @param blockSize Size of each backing buffer, rounded up to a power of two.
+ * @param minSize   Size of the smallest range, rounded up to a power of two.
+ * @return NULL on failure.
+ *
+ * Ranges are handed out by a buddy allocator, so all ranges are a power of two
+ * in size and aligned to their own size. Backing buffers are created on demand,
+ * this way many small meshes can share a few buffers (and vertex layouts).
+ *
+ */
+GFX_API GFXBufferHeap* gfx_buffer_heap_create(
+
+		GFXBufferUsage  usage,
+		size_t          blockSize,
+		size_t          minSize);
+
+/**
+ * Makes sure the buffer heap is freed properly.
+ *
+ * All backing buffers are freed, all ranges become invalid.
+ *
+ */
+GFX_API void gfx_buffer_heap_free(
+
+		GFXBufferHeap* heap);
+
+/**
+ * Allocates a range of a backing buffer.
+ *
+ * @param size  Size of the range in bytes, must not exceed blockSize.
+ * @param align Alignment of the offset in bytes, must be a power of two (0 is the same as 1).
+ * @param range Returns the allocated range.
+ * @return Zero on failure.
+ *
+ */
+GFX_API int gfx_buffer_heap_alloc(
+
+		GFXBufferHeap*   heap,
+		size_t           size,
+		size_t           align,
+		GFXBufferRange*  range);
+
+/**
+ * Releases a range allocated by gfx_buffer_heap_alloc.
+ *
+ * The range must be exactly as it was returned by gfx_buffer_heap_alloc.
+ * Free neighbouring ranges are merged, backing buffers are never freed.
+ *
+ */
+GFX_API void gfx_buffer_heap_release(
+
+		GFXBufferHeap*         heap,
+		const GFXBufferRange*  range);
+
 
 /********************************************************
  * Vertex Layout metadata
@@ -15,6 +15,7 @@
 #ifndef GFX_CORE_PIPELINE_H
 #define GFX_CORE_PIPELINE_H
 
+#include "groufix/containers/thread_pool.h"
 #include "groufix/core/shading.h"
 #include "groufix/core/window.h"
 
@@ -40,14 +41,54 @@ typedef unsigned int GFXBucketSource;
 typedef unsigned int GFXBucketUnit;
 
 
+/** Bucket flags */
+typedef enum GFXBucketFlags
+{
+	GFX_BUCKET_BATCH  = 0x01, /* Merge compatible adjacent units into a single draw call */
+	GFX_BUCKET_RECORD = 0x02  /* Record all draw calls and replay them until a unit changes */
+
+} GFXBucketFlags;
+
+
+/** Bucket sort mode */
+typedef enum GFXBucketSortMode
+{
+	GFX_BUCKET_SORT_STATE,            /* Sort on state, then program and vertex layout */
+	GFX_BUCKET_SORT_DEPTH_ASCENDING,  /* Sort on state, then depth, front to back */
+	GFX_BUCKET_SORT_DEPTH_DESCENDING  /* Sort on state, then depth, back to front */
+
+} GFXBucketSortMode;
+
+
 /** Bucket to manage render units */
 typedef struct GFXBucket
 {
-	unsigned char bits; /* Number of state bits sorted on */
+	unsigned char      bits;  /* Number of state bits sorted on */
+	GFXBucketFlags     flags;
+	GFXBucketSortMode  sort;
+	GFXThreadPool*     pool;  /* Thread pool to sort with, can be NULL */
 
 } GFXBucket;
 
 
+/** Statistics of a processed bucket */
+typedef struct GFXBucketStats
+{
+	size_t visible;      /* Number of visible units */
+	size_t culled;       /* Number of units hidden by frustum culling */
+	size_t pending;      /* Number of units hidden until their program map is ready */
+	size_t moved;        /* Number of units whose sorted position changed */
+	size_t draws;        /* Number of issued draw calls */
+	size_t batched;      /* Number of units drawn as part of a batched draw call */
+
+	size_t layoutBinds;  /* Number of issued vertex layout binds */
+	size_t layoutSkips;  /* Number of vertex layout binds skipped as redundant */
+	size_t mapUses;      /* Number of issued property map uses (program bind and uploads) */
+	size_t mapSkips;     /* Number of property map uses skipped as redundant */
+
+} GFXBucketStats;
+
+
 /**
  * Sets the number of bits to sort on.
  *
@@ -59,6 +100,48 @@ GFX_API void gfx_bucket_set_bits(
 		GFXBucket*     bucket,
 		unsigned char  bits);
 
+/**
+ * Sets what to sort on after the state bits.
+ *
+ * When sorting on depth, units of equal state and depth keep their relative order,
+ * the program and vertex layout are not sorted on.
+ * The bucket is sorted incrementally as long as few units change depth each frame.
+ *
+ */
+GFX_API void gfx_bucket_set_sort_mode(
+
+		GFXBucket*         bucket,
+		GFXBucketSortMode  mode);
+
+/**
+ * Sets the view frustum to cull units with.
+ *
+ * @param matrix Column major 4x4 (view) projection matrix, NULL to disable culling.
+ *
+ * When culling, the bounding sphere of each unit is tested against the frustum
+ * every time the bucket is processed, units outside are hidden until they are
+ * inside again. Very large buckets are culled using the thread pool of the bucket.
+ *
+ */
+GFX_API void gfx_bucket_set_frustum(
+
+		GFXBucket*    bucket,
+		const float*  matrix);
+
+/**
+ * Sets the thread pool to sort the units of the bucket with.
+ *
+ * @param pool Thread pool to use, NULL to sort with the calling thread only.
+ *
+ * Only very large buckets are sorted in parallel, the thread executing
+ * the pipeline helps out and blocks until sorting is done.
+ *
+ */
+GFX_API void gfx_bucket_set_thread_pool(
+
+		GFXBucket*      bucket,
+		GFXThreadPool*  pool);
+
 /**
  * Adds a new source to the bucket.
  *
@@ -82,6 +165,31 @@ GFX_API GFXBucketSource gfx_bucket_add_source(
 		size_t            offset,
 		size_t            count);
 
+/**
+ * Adds a new source to the bucket with a vertex base.
+ *
+ * @param vertexBase Vertex offset added to the vertex base of all units using this source.
+ * @param indexBase  Byte offset added to the index buffer offset of the layout.
+ * @return The ID of the source, 0 on failure.
+ *
+ * This allows multiple meshes sub-allocated from the same buffers to share
+ * a single vertex layout, so their units can be batched together.
+ * indexBase must be a multiple of the size of the index type of the source.
+ * gfx_bucket_get_vertex_base and gfx_bucket_set_vertex_base are relative to this base.
+ *
+ * Note: requires GFX_EXT_VERTEX_BASE_INDICES for it to work when drawing with an index buffer.
+ *
+ */
+GFX_API GFXBucketSource gfx_bucket_add_source_with_base(
+
+		GFXBucket*        bucket,
+		GFXVertexLayout*  layout,
+		unsigned char     srcIndex,
+		size_t            offset,
+		size_t            count,
+		unsigned int      vertexBase,
+		size_t            indexBase);
+
 /**
  * Removes a source from the bucket.
  *
@@ -101,6 +209,10 @@ GFX_API void gfx_bucket_remove_source(
  * @param visible  Non-zero if visible, invisible otherwise.
  * @return The ID of the inserted unit, 0 on failure.
  *
+ * If the program map is still linking (see gfx_program_link_async),
+ * the unit is not drawn until the link is done, which is polled by the bucket
+ * every time it is processed (see gfx_program_map_is_ready).
+ *
  */
 GFX_API GFXBucketUnit gfx_bucket_insert(
 
@@ -110,15 +222,72 @@ GFX_API GFXBucketUnit gfx_bucket_insert(
 		unsigned int           copy,
 		int                    visible);
 
+/**
+ * Inserts a number of units sharing the same source, property map and copy.
+ *
+ * @param num   Number of units to insert.
+ * @param units Returns the IDs of the inserted units, must hold num IDs.
+ * @return Zero on failure, in which case no units are inserted and all IDs are 0.
+ *
+ * Memory is reserved once for all units, this is much faster than calling
+ * gfx_bucket_insert num times.
+ *
+ */
+GFX_API int gfx_bucket_insert_multiple(
+
+		GFXBucket*             bucket,
+		size_t                 num,
+		GFXBucketSource        src,
+		const GFXPropertyMap*  map,
+		unsigned int           copy,
+		int                    visible,
+		GFXBucketUnit*         units);
+
+/**
+ * Inserts a number of units, described by parallel arrays.
+ *
+ * @param num    Number of units to insert.
+ * @param srcs   Source of each unit.
+ * @param maps   Property map of each unit.
+ * @param copies Copy of the property map of each unit.
+ * @param units  Returns the IDs of the inserted units, must hold num IDs.
+ * @return Zero on failure, in which case no units are inserted and all IDs are 0.
+ *
+ */
+GFX_API int gfx_bucket_insert_range(
+
+		GFXBucket*                    bucket,
+		size_t                        num,
+		const GFXBucketSource*        srcs,
+		const GFXPropertyMap* const*  maps,
+		const unsigned int*           copies,
+		int                           visible,
+		GFXBucketUnit*                units);
+
 /**
  * Erases and frees a unit from its bucket.
  *
+ * Once erased (or once its source is removed), the ID of the unit is invalid,
+ * all functions taking the ID will ignore it (getters return 0).
+ *
  */
 GFX_API void gfx_bucket_erase(
 
 		GFXBucket*     bucket,
 		GFXBucketUnit  unit);
 
+/**
+ * Erases and frees a number of units from their bucket.
+ *
+ * @param num Number of units to erase.
+ *
+ */
+GFX_API void gfx_bucket_erase_range(
+
+		GFXBucket*            bucket,
+		size_t                num,
+		const GFXBucketUnit*  units);
+
 /**
  * Returns the index of the copy of the property map in use.
  *
@@ -176,12 +345,34 @@ GFX_API GFXUnitState gfx_bucket_get_state(
 /**
  * Returns whether a unit is visible or not.
  *
+ * This is the visibility set by the user, it may still be culled.
+ *
  */
 GFX_API int gfx_bucket_is_visible(
 
 		const GFXBucket*  bucket,
 		GFXBucketUnit     unit);
 
+/**
+ * Returns the depth associated with a unit.
+ *
+ */
+GFX_API float gfx_bucket_get_depth(
+
+		const GFXBucket*  bucket,
+		GFXBucketUnit     unit);
+
+/**
+ * Retrieves the statistics of the last time the bucket was processed.
+ *
+ * @param stats Returns the statistics (cannot be NULL).
+ *
+ */
+GFX_API void gfx_bucket_get_stats(
+
+		const GFXBucket*  bucket,
+		GFXBucketStats*   stats);
+
 /**
  * Sets the index of the copy of the property map to use.
  *
@@ -252,6 +443,20 @@ GFX_API void gfx_bucket_set_state(
 		GFXBucketUnit  unit,
 		GFXUnitState   state);
 
+/**
+ * Sets the state of a number of units.
+ *
+ * @param num    Number of units to set the state of.
+ * @param states State of each unit.
+ *
+ */
+GFX_API void gfx_bucket_set_state_range(
+
+		GFXBucket*            bucket,
+		size_t                num,
+		const GFXBucketUnit*  units,
+		const GFXUnitState*   states);
+
 /**
  * Sets the visibility of a unit.
  *
@@ -264,6 +469,73 @@ GFX_API void gfx_bucket_set_visible(
 		GFXBucketUnit  unit,
 		int            visible);
 
+/**
+ * Sets the visibility of a number of units.
+ *
+ * @param num     Number of units to set the visibility of.
+ * @param visible Visibility of each unit, non-zero if visible.
+ *
+ */
+GFX_API void gfx_bucket_set_visible_range(
+
+		GFXBucket*            bucket,
+		size_t                num,
+		const GFXBucketUnit*  units,
+		const int*            visible);
+
+/**
+ * Sets the bounding sphere of a unit to cull with.
+ *
+ * @param sphere Center (x, y, z) and radius (4 floats), if the radius is negative,
+ *               the unit is never culled (this is the default).
+ *
+ */
+GFX_API void gfx_bucket_set_bounds(
+
+		GFXBucket*     bucket,
+		GFXBucketUnit  unit,
+		const float*   sphere);
+
+/**
+ * Sets the bounding sphere of a number of units.
+ *
+ * @param num     Number of units to set the bounds of.
+ * @param spheres Bounding sphere of each unit (4 floats each).
+ *
+ */
+GFX_API void gfx_bucket_set_bounds_range(
+
+		GFXBucket*            bucket,
+		size_t                num,
+		const GFXBucketUnit*  units,
+		const float*          spheres);
+
+/**
+ * Sets the depth to sort a unit on (for example its distance to the camera).
+ *
+ * Only used when the sort mode of the bucket is one of the depth modes, defaults to 0.
+ *
+ */
+GFX_API void gfx_bucket_set_depth(
+
+		GFXBucket*     bucket,
+		GFXBucketUnit  unit,
+		float          depth);
+
+/**
+ * Sets the depth of a number of units.
+ *
+ * @param num    Number of units to set the depth of.
+ * @param depths Depth of each unit.
+ *
+ */
+GFX_API void gfx_bucket_set_depth_range(
+
+		GFXBucket*            bucket,
+		size_t                num,
+		const GFXBucketUnit*  units,
+		const float*          depths);
+
 
 /********************************************************
  * Process to perform post-processing
@@ -551,7 +823,8 @@ typedef enum GFXPipelineAttachment
 /** Pipeline */
 typedef struct GFXPipeline
 {
-	GFXViewport viewport; /* Viewport used to render to textures */
+	GFXViewport     viewport; /* Viewport used to render to textures */
+	GFXThreadPool*  pool;     /* Thread pool to prepare buckets with, can be NULL */
 
 } GFXPipeline;
 
@@ -572,6 +845,22 @@ GFX_API void gfx_pipeline_free(
 
 		GFXPipeline* pipeline);
 
+/**
+ * Sets the thread pool to prepare the buckets of the pipeline with.
+ *
+ * @param pool Thread pool to use, NULL to prepare buckets while executing them.
+ *
+ * When executing, all buckets are first sorted, culled and recorded in parallel,
+ * after which the calling thread replays them in order. Only the replaying
+ * touches the context, so buckets of different pipes are prepared concurrently.
+ * Note: buckets cannot be modified by other threads during execution.
+ *
+ */
+GFX_API void gfx_pipeline_set_thread_pool(
+
+		GFXPipeline*    pipeline,
+		GFXThreadPool*  pool);
+
 /**
  * Specifies what color attachments to draw to.
  *
@@ -608,7 +897,8 @@ GFX_API int gfx_pipeline_attach(
 /**
  * Adds a bucket to the pipeline.
  *
- * @param bits Number of manual bits to sort by (clamped to [0, GFX_UNIT_STATE_MAX_BITS]).
+ * @param bits  Number of manual bits to sort by (clamped to [0, GFX_UNIT_STATE_MAX_BITS]).
+ * @param flags Flags to apply to the bucket.
  * @return The new pipe (NULL on failure).
  *
  * Note: all state and parameters will be copied from the previous pipe.
@@ -617,7 +907,8 @@ GFX_API int gfx_pipeline_attach(
 GFX_API GFXPipe* gfx_pipeline_push_bucket(
 
 		GFXPipeline*    pipeline,
-		unsigned char   bits);
+		unsigned char   bits,
+		GFXBucketFlags  flags);
 
 /**
  * Adds a process to the pipeline.
@@ -115,6 +115,83 @@ GFX_API int gfx_shader_compile(
 		GFXShader* shader);
 
 
+/********************************************************
+ * Shader Library (shared shader variants)
+ *******************************************************/
+
+/** Shader library */
+typedef struct GFXShaderLibrary
+{
+	size_t shaders; /* Number of unique shaders created */
+	size_t shared;  /* Number of requests served by an existing shader */
+
+} GFXShaderLibrary;
+
+
+/**
+ * Creates a new shader library.
+ *
+ * @return NULL on failure.
+ *
+ */
+GFX_API GFXShaderLibrary* gfx_shader_library_create(void);
+
+/**
+ * Makes sure the shader library is freed properly.
+ *
+ * This will free all shaders returned by the library.
+ *
+ */
+GFX_API void gfx_shader_library_free(
+
+		GFXShaderLibrary* library);
+
+/**
+ * Sets a named source to be included by shader variants.
+ *
+ * @param name Name to refer to with #include "name" or #include <name> (the string is copied).
+ * @param src  Null terminated source (the string is copied), NULL to remove the include.
+ * @return Zero on failure.
+ *
+ * Note: shaders returned before this call are not affected.
+ *
+ */
+GFX_API int gfx_shader_library_set_include(
+
+		GFXShaderLibrary*  library,
+		const char*        name,
+		const char*        src);
+
+/**
+ * Returns a shader compiled from a source with a set of defines.
+ *
+ * @param stage   The GPU pipeline stage to participate in.
+ * @param src     Null terminated base source.
+ * @param num     Number of defines.
+ * @param defines Array containing the defines, either "NAME" or "NAME VALUE".
+ * @return NULL on failure.
+ *
+ * All includes are resolved, comments and redundant whitespace are removed and the
+ * defines are inserted after #version, in sorted order. If the result equals that
+ * of a previous call, the same shader is returned, so it is only compiled once.
+ *
+ * Lines are kept and #line directives are inserted, so compile errors refer to the
+ * lines of the given source. Lines of an include are reported with the position
+ * of the include in the order they were set (starting at 1) as source string number.
+ *
+ * The shader is owned by the library and cannot be freed or altered,
+ * it can be linked into any number of programs.
+ *
+ */
+GFX_API GFXShader* gfx_shader_library_get(
+
+		GFXShaderLibrary*  library,
+		GFXShaderStage     stage,
+		const char*        src,
+		size_t             num,
+		const char**       defines);
+
+
 /********************************************************
  * Program properties & block properties
  *******************************************************/
@@ -256,6 +333,8 @@ GFX_API int gfx_program_set_feedback(
  *
  * Additionally, an error will be generated on failure.
  * This will remove any evidence of a previous link operation.
+ * If a link was issued by gfx_program_link_async, this waits for it to finish
+ * and the given shaders are ignored.
  *
  */
 GFX_API int gfx_program_link(
@@ -265,6 +344,39 @@ GFX_API int gfx_program_link(
 		GFXShader**  shaders,
 		int          binary);
 
+/**
+ * Issues compiling and linking of given shaders into a program, without waiting for it.
+ *
+ * @param shaders All shader objects to link into the program (cannot be NULL).
+ * @param binary  If non-zero, the binary representation can be fetched afterwards.
+ * @return Zero on failure.
+ *
+ * The program is linked once gfx_program_is_ready returns non-zero, only then
+ * will properties and blocks be available. Compile errors are reported when it is done.
+ * Issue all programs before querying any of them, so the driver can compile them in
+ * parallel (only if GL_KHR_parallel_shader_compile is available).
+ *
+ */
+GFX_API int gfx_program_link_async(
+
+		GFXProgram*  program,
+		size_t       num,
+		GFXShader**  shaders,
+		int          binary);
+
+/**
+ * Returns whether a program is linked, finishing an asynchronous link if it is done.
+ *
+ * @return Non-zero if the program is linked.
+ *
+ * If the driver cannot report completion, this blocks until the link is done.
+ * Additionally, an error will be generated if the link failed.
+ *
+ */
+GFX_API int gfx_program_is_ready(
+
+		GFXProgram* program);
+
 /**
  * Retrieves the binary representation of a program.
  *
@@ -321,6 +433,9 @@ GFX_API const GFXProperty* gfx_program_get_property(
  * @param name Name of the property in the shader (the string is copied).
  * @return program->properties on failure, index otherwise.
  *
+ * Names are looked up in a table built when the program is linked,
+ * so this does not require a current context once linked.
+ *
  */
 GFX_API unsigned short gfx_program_get_named_property(
 
@@ -347,6 +462,9 @@ GFX_API const GFXPropertyBlock* gfx_program_get_property_block(
  * @param name Name of the property block in the shader (the string is copied).
  * @return program->blocks on failure, index otherwise.
  *
+ * Names are looked up in a table built when the program is linked,
+ * so this does not require a current context once linked.
+ *
  */
 GFX_API unsigned short gfx_program_get_named_property_block(
 
@@ -354,6 +472,77 @@ GFX_API unsigned short gfx_program_get_named_property_block(
 		const char*        name);
 
 
+/********************************************************
+ * Program Cache (binaries of linked programs on disk)
+ *******************************************************/
+
+/** Statistics of the program cache */
+typedef struct GFXProgramCacheStats
+{
+	size_t hits;      /* Number of programs loaded from a cached binary */
+	size_t misses;    /* Number of programs linked from their shaders */
+	size_t evictions; /* Number of binaries evicted to stay within the size limit */
+	size_t entries;   /* Number of binaries currently cached */
+	size_t size;      /* Byte size of all binaries currently cached */
+
+} GFXProgramCacheStats;
+
+
+/**
+ * Opens the program cache, loading all binaries stored in a file.
+ *
+ * @param path    Path to the cache file, it is created if it does not exist.
+ * @param maxSize Maximum byte size of all binaries, 0 for no limit.
+ * @return Zero on failure.
+ *
+ * While open, gfx_program_link first attempts to load a cached binary.
+ * The key of a binary is a hash of the shader sources, attributes, feedback
+ * and driver, so a binary is never used with a different driver or source.
+ * If no binary exists the program is linked and its binary is stored, when the
+ * cache exceeds maxSize the least recently used binaries are evicted.
+ *
+ * If a cache was opened already, it is closed first.
+ * Note: requires GFX_EXT_PROGRAM_BINARY, if not supported the cache is never used.
+ *
+ */
+GFX_API int gfx_program_cache_open(
+
+		const char*  path,
+		size_t       maxSize);
+
+/**
+ * Writes all changes of the program cache to its file.
+ *
+ * @return Zero on failure or if no cache is open.
+ *
+ */
+GFX_API int gfx_program_cache_save(void);
+
+/**
+ * Saves and closes the program cache.
+ *
+ * Programs that finish linking after this call are not stored.
+ *
+ */
+GFX_API void gfx_program_cache_close(void);
+
+/**
+ * Retrieves the statistics of the program cache.
+ *
+ * @param stats Returns the statistics (cannot be NULL), all zero if no cache is open.
+ *
+ */
+GFX_API void gfx_program_cache_get_stats(
+
+		GFXProgramCacheStats* stats);
+
+/**
+ * Resets the hit, miss and eviction statistics of the program cache.
+ *
+ */
+GFX_API void gfx_program_cache_reset_stats(void);
+
+
 /********************************************************
  * Program Map (programs mapped to stages)
  *******************************************************/
@@ -428,6 +617,22 @@ GFX_API GFXProgram* gfx_program_map_get(
 		const GFXProgramMap*  map,
 		GFXShaderStage        stage);
 
+/**
+ * Returns whether all programs of the program map are linked.
+ *
+ * @return Non-zero if the program map can be used for drawing.
+ *
+ * This calls gfx_program_is_ready for every program.
+ * Buckets skip units of which the program map is not ready, they poll without
+ * blocking if GL_KHR_parallel_shader_compile is available. Without it, a bucket
+ * waits for the link the first time it needs the program map.
+ * Units of a program map that failed to link are never drawn.
+ *
+ */
+GFX_API int gfx_program_map_is_ready(
+
+		GFXProgramMap* map);
+
 
 /********************************************************
  * Sampler property (how to sample texels)
@@ -484,6 +689,15 @@ typedef struct GFXPropertyMap
 } GFXPropertyMap;
 
 
+/** Statistics of a property map */
+typedef struct GFXPropertyMapStats
+{
+	size_t uploads; /* Number of properties uploaded to a program */
+	size_t skips;   /* Number of unchanged values not uploaded again */
+
+} GFXPropertyMapStats;
+
+
 /**
  * Creates a new property map.
  *
@@ -494,6 +708,8 @@ typedef struct GFXPropertyMap
  * Note: this will signal the program map to setup its executable pipeline.
  * After this the program map cannot be altered until it is not in use by
  * any property maps anymore.
+ * The programs may still be linking asynchronously, properties can only be
+ * forwarded once gfx_program_map_is_ready returns non-zero.
  *
  */
 GFX_API GFXPropertyMap* gfx_property_map_create(
@@ -624,7 +840,44 @@ GFX_API int gfx_property_map_forward_named_block(
 		const char*      name);
 
 /**
- * Sets the value of a vector/matrix property.
+ * Forwards data send to a given index to a property block, storing its content in the map.
+ *
+ * @return Zero on failure.
+ *
+ * The content of the block is set with gfx_property_map_set_value, using
+ * the offsets of the block members as described by GFXPropertyBlock.
+ * Whenever the map is used, the content is streamed into a uniform buffer
+ * owned by the context and only the range is bound, so the entire block
+ * costs a single bind instead of a call per value.
+ *
+ * Note: counts towards GFX_LIM_MAX_BUFFER_PROPERTIES like any other block.
+ *
+ */
+GFX_API int gfx_property_map_forward_block_value(
+
+		GFXPropertyMap*  map,
+		unsigned char    index,
+		int              copies,
+		GFXShaderStage   stage,
+		unsigned short   block);
+
+/**
+ * Forwards data send to a given index to a given uniform block name, storing its content in the map.
+ *
+ * @param name Uniform block name within the program to forward to.
+ * @return Zero on failure.
+ *
+ */
+GFX_API int gfx_property_map_forward_named_block_value(
+
+		GFXPropertyMap*  map,
+		unsigned char    index,
+		int              copies,
+		GFXShaderStage   stage,
+		const char*      name);
+
+/**
+ * Sets the value of a vector/matrix property or a block value property.
  *
  * @param index  Index of the property to set the value of.
  * @param copy   Index of the copy to set the value of.
@@ -744,5 +997,28 @@ GFX_API int gfx_property_map_set_buffer(
 		size_t            offset,
 		size_t            size);
 
+/**
+ * Retrieves the upload statistics of a property map.
+ *
+ * @param stats Returns the statistics (cannot be NULL).
+ *
+ * Statistics accumulate until reset, reset them every frame for per frame numbers.
+ * Vector/matrix values are only uploaded if they changed or if another map
+ * uploaded values to the same program since, all other properties are always uploaded.
+ *
+ */
+GFX_API void gfx_property_map_get_stats(
+
+		const GFXPropertyMap*  map,
+		GFXPropertyMapStats*   stats);
+
+/**
+ * Resets the statistics of a property map.
+ *
+ */
+GFX_API void gfx_property_map_reset_stats(
+
+		GFXPropertyMap* map);
+
 
 #endif // GFX_CORE_SHADING_H
@@ -36,4 +36,156 @@ GFX_API const long double GFX_MATH_RAD_TO_DEG;
 GFX_API const long double GFX_MATH_DEG_TO_RAD;
 
 
+/********************************************************
+ * Batched transforms
+ *******************************************************/
+
+/** Structure of arrays of 3 component vectors */
+typedef struct GFXVec3Array
+{
+	float* x;
+	float* y;
+	float* z;
+
+} GFXVec3Array;
+
+
+/** Structure of arrays of 4 component vectors */
+typedef struct GFXVec4Array
+{
+	float* x;
+	float* y;
+	float* z;
+	float* w;
+
+} GFXVec4Array;
+
+
+/** Structure of arrays of quaternions */
+typedef struct GFXQuatArray
+{
+	float* w;
+	float* x;
+	float* y;
+	float* z;
+
+} GFXQuatArray;
+
+
+/**
+ * Transforms an array of points by a matrix.
+ *
+ * @param dest Destination array, may be equal to src.
+ * @param a    Matrix to transform with.
+ * @param src  Array of num points, the fourth component is taken to be 1.
+ *
+ */
+GFX_API void gfx_math_transform_vec3(
+
+		gfx_vec3*        dest,
+		const gfx_mat4*  a,
+		const gfx_vec3*  src,
+		size_t           num);
+
+/**
+ * Transforms an array of vectors by a matrix.
+ *
+ * @param dest Destination array, may be equal to src.
+ * @param a    Matrix to transform with.
+ * @param src  Array of num vectors.
+ *
+ */
+GFX_API void gfx_math_transform_vec4(
+
+		gfx_vec4*        dest,
+		const gfx_mat4*  a,
+		const gfx_vec4*  src,
+		size_t           num);
+
+/**
+ * Transforms a structure of arrays of points by a matrix.
+ *
+ * @param dest Destination arrays, may be equal to those of src.
+ * @param src  Arrays of num components each, the fourth component is taken to be 1.
+ *
+ */
+GFX_API void gfx_math_transform_vec3_soa(
+
+		const GFXVec3Array*  dest,
+		const gfx_mat4*      a,
+		const GFXVec3Array*  src,
+		size_t               num);
+
+/**
+ * Transforms a structure of arrays of vectors by a matrix.
+ *
+ * @param dest Destination arrays, may be equal to those of src.
+ * @param src  Arrays of num components each.
+ *
+ */
+GFX_API void gfx_math_transform_vec4_soa(
+
+		const GFXVec4Array*  dest,
+		const gfx_mat4*      a,
+		const GFXVec4Array*  src,
+		size_t               num);
+
+/**
+ * Composes translations, rotations and scales into matrices.
+ *
+ * @param dest        Destination array of num matrices.
+ * @param translation Array of num translations.
+ * @param rotation    Array of num rotations, assumed to be of unit length.
+ * @param scale       Array of num scales, NULL for no scaling.
+ *
+ * Each matrix equals translation * rotation * scale.
+ *
+ */
+GFX_API void gfx_math_compose(
+
+		gfx_mat4*        dest,
+		const gfx_vec3*  translation,
+		const gfx_quat*  rotation,
+		const gfx_vec3*  scale,
+		size_t           num);
+
+/**
+ * Composes structures of arrays of translations, rotations and scales into matrices.
+ *
+ * @param scale Arrays of num scales, NULL for no scaling.
+ *
+ */
+GFX_API void gfx_math_compose_soa(
+
+		gfx_mat4*            dest,
+		const GFXVec3Array*  translation,
+		const GFXQuatArray*  rotation,
+		const GFXVec3Array*  scale,
+		size_t               num);
+
+/**
+ * Normalizes an array of quaternions.
+ *
+ * @param dest Destination array, may be equal to src.
+ *
+ */
+GFX_API void gfx_math_normalize_quat(
+
+		gfx_quat*        dest,
+		const gfx_quat*  src,
+		size_t           num);
+
+/**
+ * Normalizes a structure of arrays of quaternions.
+ *
+ * @param dest Destination arrays, may be equal to those of src.
+ *
+ */
+GFX_API void gfx_math_normalize_quat_soa(
+
+		const GFXQuatArray*  dest,
+		const GFXQuatArray*  src,
+		size_t               num);
+
+
 #endif // GFX_MATH_H
@@ -15,7 +15,7 @@
 #ifndef GFX_MATH_MAT_H
 #define GFX_MATH_MAT_H
 
-#include "groufix/utils.h"
+#include "groufix/math/simd.h"
 
 #include <float.h>
 #include <math.h>
@@ -56,13 +56,17 @@
 
 	#define GFX_MAT_TYPE
 	#define GFX_MAT_DATA float
+	#define GFX_MAT_FLOAT
 	#include "groufix/math/mat.h"
+	#undef GFX_MAT_FLOAT
 	#undef GFX_MAT_DATA
 	#undef GFX_MAT_TYPE
 
 	#define GFX_MAT_TYPE d
 	#define GFX_MAT_DATA double
+	#define GFX_MAT_DOUBLE
 	#include "groufix/math/mat.h"
+	#undef GFX_MAT_DOUBLE
 	#undef GFX_MAT_DATA
 	#undef GFX_MAT_TYPE
 
@@ -88,6 +92,13 @@
 	#define GFX_MAT_ALIGN GFX_SSE_NO_ALIGN
 #endif
 
+/* SIMD kernels */
+#if defined(GFX_SIMD_SSE2) && defined(GFX_MAT_FLOAT) && GFX_MAT_SIZE == 4
+	#define GFX_MAT_SSE
+#elif defined(GFX_SIMD_AVX) && defined(GFX_MAT_DOUBLE) && GFX_MAT_SIZE == 4
+	#define GFX_MAT_AVX
+#endif
+
 /* Vector specific */
 #if defined(GFX_MAT_USE_VEC)
 	#ifndef GFX_MATH_VEC_H
@@ -187,6 +198,60 @@ static GFX_ALWAYS_INLINE GFX_MAT_NAME* GFX_MAT_FUNC(mult)(
 		const GFX_MAT_NAME*  a,
 		const GFX_MAT_NAME*  b)
 {
+#if defined(GFX_MAT_SSE)
+
+	/* Each column is a linear combination of the columns of a */
+	__m128 a0 = _mm_loadu_ps(a->data + 0);
+	__m128 a1 = _mm_loadu_ps(a->data + 4);
+	__m128 a2 = _mm_loadu_ps(a->data + 8);
+	__m128 a3 = _mm_loadu_ps(a->data + 12);
+
+	__m128 res[4];
+
+	size_t c;
+	for(c = 0; c < 4; ++c)
+	{
+		const float* col = b->data + (c << 2);
+		res[c] = _mm_add_ps(
+			_mm_add_ps(
+				_mm_mul_ps(a0, _mm_set1_ps(col[0])),
+				_mm_mul_ps(a1, _mm_set1_ps(col[1]))),
+			_mm_add_ps(
+				_mm_mul_ps(a2, _mm_set1_ps(col[2])),
+				_mm_mul_ps(a3, _mm_set1_ps(col[3]))));
+	}
+
+	for(c = 0; c < 4; ++c)
+		_mm_storeu_ps(dest->data + (c << 2), res[c]);
+
+#elif defined(GFX_MAT_AVX)
+
+	/* Each column is a linear combination of the columns of a */
+	__m256d a0 = _mm256_loadu_pd(a->data + 0);
+	__m256d a1 = _mm256_loadu_pd(a->data + 4);
+	__m256d a2 = _mm256_loadu_pd(a->data + 8);
+	__m256d a3 = _mm256_loadu_pd(a->data + 12);
+
+	__m256d res[4];
+
+	size_t c;
+	for(c = 0; c < 4; ++c)
+	{
+		const double* col = b->data + (c << 2);
+		res[c] = _mm256_add_pd(
+			_mm256_add_pd(
+				_mm256_mul_pd(a0, _mm256_set1_pd(col[0])),
+				_mm256_mul_pd(a1, _mm256_set1_pd(col[1]))),
+			_mm256_add_pd(
+				_mm256_mul_pd(a2, _mm256_set1_pd(col[2])),
+				_mm256_mul_pd(a3, _mm256_set1_pd(col[3]))));
+	}
+
+	for(c = 0; c < 4; ++c)
+		_mm256_storeu_pd(dest->data + (c << 2), res[c]);
+
+#else
+
 	GFX_MAT_NAME res;
 	GFX_MAT_FUNC(set_zero)(&res);
 
@@ -200,6 +265,9 @@ static GFX_ALWAYS_INLINE GFX_MAT_NAME* GFX_MAT_FUNC(mult)(
 		}
 
 	*dest = res;
+
+#endif
+
 	return dest;
 }
 
@@ -233,6 +301,22 @@ static GFX_ALWAYS_INLINE GFX_MAT_NAME* GFX_MAT_FUNC(transpose)(
 		GFX_MAT_NAME*        dest,
 		const GFX_MAT_NAME*  a)
 {
+#if defined(GFX_MAT_SSE)
+
+	__m128 c0 = _mm_loadu_ps(a->data + 0);
+	__m128 c1 = _mm_loadu_ps(a->data + 4);
+	__m128 c2 = _mm_loadu_ps(a->data + 8);
+	__m128 c3 = _mm_loadu_ps(a->data + 12);
+
+	_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+	_mm_storeu_ps(dest->data + 0, c0);
+	_mm_storeu_ps(dest->data + 4, c1);
+	_mm_storeu_ps(dest->data + 8, c2);
+	_mm_storeu_ps(dest->data + 12, c3);
+
+#else
+
 	GFX_MAT_NAME res;
 
 	size_t r, c, c2;
@@ -241,6 +325,9 @@ static GFX_ALWAYS_INLINE GFX_MAT_NAME* GFX_MAT_FUNC(transpose)(
 			res.data[r + c2] = a->data[c + r * GFX_MAT_SIZE];
 
 	*dest = res;
+
+#endif
+
 	return dest;
 }
 
@@ -301,7 +388,7 @@ static GFX_ALWAYS_INLINE int GFX_MAT_FUNC(inverse)(
 	return 1;
 }
 
-#elif MAT_SIZE == 3
+#elif GFX_MAT_SIZE == 3
 
 /**
  * Computes the determinant of a matrix.
@@ -402,6 +489,102 @@ static GFX_ALWAYS_INLINE int GFX_MAT_FUNC(inverse)(
 		GFX_MAT_NAME*        dest,
 		const GFX_MAT_NAME*  a)
 {
+#if defined(GFX_MAT_SSE)
+
+	/* Transpose so each register holds a row */
+	__m128 r0 = _mm_loadu_ps(a->data + 0);
+	__m128 r1 = _mm_loadu_ps(a->data + 4);
+	__m128 r2 = _mm_loadu_ps(a->data + 8);
+	__m128 r3 = _mm_loadu_ps(a->data + 12);
+
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+	/* Determinants of 2x2 submatrices, (S0, S1, S2, S3) and (S4, S5, S4, S5) */
+	__m128 sa = _mm_sub_ps(
+		_mm_mul_ps(
+			_mm_shuffle_ps(r0, r0, _MM_SHUFFLE(1, 0, 0, 0)),
+			_mm_shuffle_ps(r1, r1, _MM_SHUFFLE(2, 3, 2, 1))),
+		_mm_mul_ps(
+			_mm_shuffle_ps(r0, r0, _MM_SHUFFLE(2, 3, 2, 1)),
+			_mm_shuffle_ps(r1, r1, _MM_SHUFFLE(1, 0, 0, 0))));
+
+	__m128 sb = _mm_sub_ps(
+		_mm_mul_ps(
+			_mm_shuffle_ps(r0, r0, _MM_SHUFFLE(2, 1, 2, 1)),
+			_mm_shuffle_ps(r1, r1, _MM_SHUFFLE(3, 3, 3, 3))),
+		_mm_mul_ps(
+			_mm_shuffle_ps(r0, r0, _MM_SHUFFLE(3, 3, 3, 3)),
+			_mm_shuffle_ps(r1, r1, _MM_SHUFFLE(2, 1, 2, 1))));
+
+	/* Same for the bottom rows, (C0, C1, C2, C3) and (C4, C5, C4, C5) */
+	__m128 ca = _mm_sub_ps(
+		_mm_mul_ps(
+			_mm_shuffle_ps(r2, r2, _MM_SHUFFLE(1, 0, 0, 0)),
+			_mm_shuffle_ps(r3, r3, _MM_SHUFFLE(2, 3, 2, 1))),
+		_mm_mul_ps(
+			_mm_shuffle_ps(r2, r2, _MM_SHUFFLE(2, 3, 2, 1)),
+			_mm_shuffle_ps(r3, r3, _MM_SHUFFLE(1, 0, 0, 0))));
+
+	__m128 cb = _mm_sub_ps(
+		_mm_mul_ps(
+			_mm_shuffle_ps(r2, r2, _MM_SHUFFLE(2, 1, 2, 1)),
+			_mm_shuffle_ps(r3, r3, _MM_SHUFFLE(3, 3, 3, 3))),
+		_mm_mul_ps(
+			_mm_shuffle_ps(r2, r2, _MM_SHUFFLE(3, 3, 3, 3)),
+			_mm_shuffle_ps(r3, r3, _MM_SHUFFLE(2, 1, 2, 1))));
+
+	const __m128 pmpm = _mm_setr_ps(1.0f, -1.0f, 1.0f, -1.0f);
+	const __m128 mpmp = _mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f);
+
+	/* Signed cofactor factors of the top two columns */
+	__m128 t = _mm_shuffle_ps(cb, ca, _MM_SHUFFLE(2, 3, 1, 0));
+	__m128 k1 = _mm_mul_ps(pmpm, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 0, 1, 1)));
+	__m128 k2 = _mm_mul_ps(mpmp, _mm_shuffle_ps(t, ca, _MM_SHUFFLE(1, 2, 3, 0)));
+	__m128 k3 = _mm_mul_ps(pmpm, _mm_shuffle_ps(ca, ca, _MM_SHUFFLE(0, 0, 1, 3)));
+
+	__m128 c0 = _mm_add_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r1, r1, _MM_SHUFFLE(0, 0, 0, 1)), k1),
+		_mm_add_ps(
+			_mm_mul_ps(_mm_shuffle_ps(r1, r1, _MM_SHUFFLE(1, 1, 2, 2)), k2),
+			_mm_mul_ps(_mm_shuffle_ps(r1, r1, _MM_SHUFFLE(2, 3, 3, 3)), k3)));
+
+	__m128 c1 = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r0, r0, _MM_SHUFFLE(0, 0, 0, 1)), k1),
+		_mm_add_ps(
+			_mm_mul_ps(_mm_shuffle_ps(r0, r0, _MM_SHUFFLE(1, 1, 2, 2)), k2),
+			_mm_mul_ps(_mm_shuffle_ps(r0, r0, _MM_SHUFFLE(2, 3, 3, 3)), k3))));
+
+	/* Signed cofactor factors of the bottom two columns */
+	t = _mm_shuffle_ps(sb, sa, _MM_SHUFFLE(2, 3, 1, 0));
+	k1 = _mm_mul_ps(pmpm, _mm_shuffle_ps(t, t, _MM_SHUFFLE(2, 0, 1, 1)));
+	k2 = _mm_mul_ps(mpmp, _mm_shuffle_ps(t, sa, _MM_SHUFFLE(1, 2, 3, 0)));
+	k3 = _mm_mul_ps(pmpm, _mm_shuffle_ps(sa, sa, _MM_SHUFFLE(0, 0, 1, 3)));
+
+	__m128 c2 = _mm_add_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r3, r3, _MM_SHUFFLE(0, 0, 0, 1)), k1),
+		_mm_add_ps(
+			_mm_mul_ps(_mm_shuffle_ps(r3, r3, _MM_SHUFFLE(1, 1, 2, 2)), k2),
+			_mm_mul_ps(_mm_shuffle_ps(r3, r3, _MM_SHUFFLE(2, 3, 3, 3)), k3)));
+
+	__m128 c3 = _mm_sub_ps(_mm_setzero_ps(), _mm_add_ps(
+		_mm_mul_ps(_mm_shuffle_ps(r2, r2, _MM_SHUFFLE(0, 0, 0, 1)), k1),
+		_mm_add_ps(
+			_mm_mul_ps(_mm_shuffle_ps(r2, r2, _MM_SHUFFLE(1, 1, 2, 2)), k2),
+			_mm_mul_ps(_mm_shuffle_ps(r2, r2, _MM_SHUFFLE(2, 3, 3, 3)), k3))));
+
+	/* Check if determinant is non-zero */
+	__m128 det = _gfx_simd_dot4(r0, c0);
+	if(fabs(_mm_cvtss_f32(det)) <= DBL_EPSILON) return 0;
+
+	det = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+	_mm_storeu_ps(dest->data + 0, _mm_mul_ps(c0, det));
+	_mm_storeu_ps(dest->data + 4, _mm_mul_ps(c1, det));
+	_mm_storeu_ps(dest->data + 8, _mm_mul_ps(c2, det));
+	_mm_storeu_ps(dest->data + 12, _mm_mul_ps(c3, det));
+
+#else
+
 	/* Determinants of 2x2 submatrices */
 	GFX_MAT_DATA S0 = a->data[0] * a->data[5]  - a->data[4]  * a->data[1];
 	GFX_MAT_DATA S1 = a->data[0] * a->data[9]  - a->data[8]  * a->data[1];
@@ -423,7 +606,7 @@ static GFX_ALWAYS_INLINE int GFX_MAT_FUNC(inverse)(
 
 	GFX_MAT_NAME res;
 	det = 1.0 / det;
-	res.data[0]  = det * (a->data[5]  * C5 - a->data[9]  * C4 + a->data[14] * C3);
+	res.data[0]  = det * (a->data[5]  * C5 - a->data[9]  * C4 + a->data[13] * C3);
 	res.data[1]  = det * (a->data[9]  * C2 - a->data[1]  * C5 - a->data[13] * C1);
 	res.data[2]  = det * (a->data[1]  * C4 - a->data[5]  * C2 + a->data[13] * C0);
 	res.data[3]  = det * (a->data[5]  * C1 - a->data[1]  * C3 - a->data[9]  * C0);
@@ -442,6 +625,8 @@ static GFX_ALWAYS_INLINE int GFX_MAT_FUNC(inverse)(
 
 	*dest = res;
 
+#endif
+
 	return 1;
 }
 
@@ -473,6 +658,32 @@ static GFX_ALWAYS_INLINE GFX_VEC_NAME* GFX_MAT_FUNC(mult_vec)(
 		const GFX_MAT_NAME*  a,
 		const GFX_VEC_NAME*  b)
 {
+#if defined(GFX_MAT_SSE)
+
+	__m128 res = _mm_add_ps(
+		_mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(a->data + 0), _mm_set1_ps(b->data[0])),
+			_mm_mul_ps(_mm_loadu_ps(a->data + 4), _mm_set1_ps(b->data[1]))),
+		_mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(a->data + 8), _mm_set1_ps(b->data[2])),
+			_mm_mul_ps(_mm_loadu_ps(a->data + 12), _mm_set1_ps(b->data[3]))));
+
+	_mm_storeu_ps(dest->data, res);
+
+#elif defined(GFX_MAT_AVX)
+
+	__m256d res = _mm256_add_pd(
+		_mm256_add_pd(
+			_mm256_mul_pd(_mm256_loadu_pd(a->data + 0), _mm256_set1_pd(b->data[0])),
+			_mm256_mul_pd(_mm256_loadu_pd(a->data + 4), _mm256_set1_pd(b->data[1]))),
+		_mm256_add_pd(
+			_mm256_mul_pd(_mm256_loadu_pd(a->data + 8), _mm256_set1_pd(b->data[2])),
+			_mm256_mul_pd(_mm256_loadu_pd(a->data + 12), _mm256_set1_pd(b->data[3]))));
+
+	_mm256_storeu_pd(dest->data, res);
+
+#else
+
 	GFX_VEC_NAME res;
 	GFX_VEC_FUNC(set_zero)(&res);
 
@@ -485,6 +696,8 @@ static GFX_ALWAYS_INLINE GFX_VEC_NAME* GFX_MAT_FUNC(mult_vec)(
 	}
 	*dest = res;
 
+#endif
+
 	return dest;
 }
 
@@ -495,6 +708,8 @@ static GFX_ALWAYS_INLINE GFX_VEC_NAME* GFX_MAT_FUNC(mult_vec)(
 #undef GFX_MAT_FUNC
 #undef GFX_MAT_STORE
 #undef GFX_MAT_ALIGN
+#undef GFX_MAT_SSE
+#undef GFX_MAT_AVX
 
 #undef GFX_VEC_NAME
 #undef GFX_VEC_FUNC
@@ -15,7 +15,7 @@
 #ifndef GFX_MATH_QUAT_H
 #define GFX_MATH_QUAT_H
 
-#include "groufix/utils.h"
+#include "groufix/math/simd.h"
 
 #include <math.h>
 #include <string.h>
@@ -39,7 +39,9 @@
 
 	#define GFX_QUAT_TYPE
 	#define GFX_QUAT_DATA float
+	#define GFX_QUAT_FLOAT
 	#include "groufix/math/quat.h"
+	#undef GFX_QUAT_FLOAT
 	#undef GFX_QUAT_DATA
 	#undef GFX_QUAT_TYPE
 
@@ -68,6 +70,11 @@
 	#define GFX_QUAT_ALIGN GFX_SSE_NO_ALIGN
 #endif
 
+/* SIMD kernels */
+#if defined(GFX_SIMD_SSE2) && defined(GFX_QUAT_FLOAT)
+	#define GFX_QUAT_SSE
+#endif
+
 /* Matrix specific */
 #if defined(GFX_QUAT_USE_MAT)
 	#ifndef GFX_MATH_MAT_H
@@ -135,10 +142,20 @@ static GFX_ALWAYS_INLINE GFX_QUAT_NAME* GFX_QUAT_FUNC(add)(
 		const GFX_QUAT_NAME*  a,
 		const GFX_QUAT_NAME*  b)
 {
+#if defined(GFX_QUAT_SSE)
+
+	_mm_storeu_ps(dest->data, _mm_add_ps(
+		_mm_loadu_ps(a->data),
+		_mm_loadu_ps(b->data)));
+
+#else
+
 	size_t i;
 	for(i = 0; i < 4; ++i)
 		dest->data[i] = a->data[i] + b->data[i];
 
+#endif
+
 	return dest;
 }
 
@@ -154,10 +171,20 @@ static GFX_ALWAYS_INLINE GFX_QUAT_NAME* GFX_QUAT_FUNC(sub)(
 		const GFX_QUAT_NAME*  a,
 		const GFX_QUAT_NAME*  b)
 {
+#if defined(GFX_QUAT_SSE)
+
+	_mm_storeu_ps(dest->data, _mm_sub_ps(
+		_mm_loadu_ps(a->data),
+		_mm_loadu_ps(b->data)));
+
+#else
+
 	size_t i;
 	for(i = 0; i < 4; ++i)
 		dest->data[i] = a->data[i] - b->data[i];
 
+#endif
+
 	return dest;
 }
 
@@ -173,6 +200,37 @@ static GFX_ALWAYS_INLINE GFX_QUAT_NAME* GFX_QUAT_FUNC(mult)(
 		const GFX_QUAT_NAME*  a,
 		const GFX_QUAT_NAME*  b)
 {
+#if defined(GFX_QUAT_SSE)
+
+	/* Each component of a scales a signed permutation of b */
+	__m128 vb = _mm_loadu_ps(b->data);
+
+	__m128 res = _mm_add_ps(
+		_mm_add_ps(
+			_mm_mul_ps(
+				_mm_set1_ps(a->data[0]),
+				vb),
+			_mm_mul_ps(
+				_mm_set1_ps(a->data[1]),
+				_mm_mul_ps(
+					_mm_setr_ps(-1.0f, 1.0f, -1.0f, 1.0f),
+					_mm_shuffle_ps(vb, vb, _MM_SHUFFLE(2, 3, 0, 1))))),
+		_mm_add_ps(
+			_mm_mul_ps(
+				_mm_set1_ps(a->data[2]),
+				_mm_mul_ps(
+					_mm_setr_ps(-1.0f, 1.0f, 1.0f, -1.0f),
+					_mm_shuffle_ps(vb, vb, _MM_SHUFFLE(1, 0, 3, 2)))),
+			_mm_mul_ps(
+				_mm_set1_ps(a->data[3]),
+				_mm_mul_ps(
+					_mm_setr_ps(-1.0f, -1.0f, 1.0f, 1.0f),
+					_mm_shuffle_ps(vb, vb, _MM_SHUFFLE(0, 1, 2, 3))))));
+
+	_mm_storeu_ps(dest->data, res);
+
+#else
+
 	GFX_QUAT_NAME res;
 	res.data[0] = a->data[0] * b->data[0] - a->data[1] * b->data[1] - a->data[2] * b->data[2] - a->data[3] * b->data[3];
 	res.data[1] = a->data[0] * b->data[1] + a->data[1] * b->data[0] + a->data[2] * b->data[3] - a->data[3] * b->data[2];
@@ -181,6 +239,8 @@ static GFX_ALWAYS_INLINE GFX_QUAT_NAME* GFX_QUAT_FUNC(mult)(
 
 	*dest = res;
 
+#endif
+
 	return dest;
 }
 
@@ -196,10 +256,20 @@ static GFX_ALWAYS_INLINE GFX_QUAT_NAME* GFX_QUAT_FUNC(scale)(
 		const GFX_QUAT_NAME*  a,
 		GFX_QUAT_DATA         scalar)
 {
+#if defined(GFX_QUAT_SSE)
+
+	_mm_storeu_ps(dest->data, _mm_mul_ps(
+		_mm_loadu_ps(a->data),
+		_mm_set1_ps(scalar)));
+
+#else
+
 	size_t i;
 	for(i = 0; i < 4; ++i)
 		dest->data[i] = a->data[i] * scalar;
 
+#endif
+
 	return dest;
 }
 
@@ -230,6 +300,13 @@ static GFX_ALWAYS_INLINE GFX_QUAT_DATA GFX_QUAT_FUNC(norm_squared)(
 
 		const GFX_QUAT_NAME* a)
 {
+#if defined(GFX_QUAT_SSE)
+
+	__m128 va = _mm_loadu_ps(a->data);
+	return _mm_cvtss_f32(_gfx_simd_dot4(va, va));
+
+#else
+
 	GFX_QUAT_DATA norm = 0;
 
 	size_t i;
@@ -239,6 +316,8 @@ static GFX_ALWAYS_INLINE GFX_QUAT_DATA GFX_QUAT_FUNC(norm_squared)(
 		norm += (*val) * (*val);
 	}
 	return norm;
+
+#endif
 }
 
 /**
@@ -263,6 +342,13 @@ static GFX_ALWAYS_INLINE GFX_QUAT_NAME* GFX_QUAT_FUNC(normalize)(
 		GFX_QUAT_NAME*        dest,
 		const GFX_QUAT_NAME*  a)
 {
+#if defined(GFX_QUAT_SSE)
+
+	_mm_storeu_ps(dest->data, _gfx_simd_normalize4(
+		_mm_loadu_ps(a->data)));
+
+#else
+
 	double norm = GFX_QUAT_FUNC(norm)(a);
 	if(norm) norm = 1.0 / norm;
 
@@ -270,6 +356,8 @@ static GFX_ALWAYS_INLINE GFX_QUAT_NAME* GFX_QUAT_FUNC(normalize)(
 	for(i = 0; i < 4; ++i)
 		dest->data[i] = a->data[i] * norm;
 
+#endif
+
 	return dest;
 }
 
@@ -445,6 +533,7 @@ static GFX_ALWAYS_INLINE GFX_MAT_NAME* GFX_QUAT_FUNC(to_matrix)(
 #undef GFX_QUAT_NAME
 #undef GFX_QUAT_FUNC
 #undef GFX_QUAT_ALIGN
+#undef GFX_QUAT_SSE
 
 #undef GFX_MAT_NAME
 #undef GFX_VEC_NAME
@@ -0,0 +1,117 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#ifndef GFX_MATH_SIMD_H
+#define GFX_MATH_SIMD_H
+
+#include "groufix/utils.h"
+
+
+/********************************************************
+ * Instruction set selection
+ *******************************************************/
+
+/* Only use intrinsics if asked for and available */
+#if defined(GFX_SSE_YES) && !defined(GFX_SSE_NO)
+
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#define GFX_SIMD_SSE2
+		#include <emmintrin.h>
+	#endif
+
+	#if defined(GFX_SIMD_SSE2) && defined(__SSE4_1__)
+		#define GFX_SIMD_SSE4_1
+		#include <smmintrin.h>
+	#endif
+
+	#if defined(GFX_SIMD_SSE2) && defined(__AVX__)
+		#define GFX_SIMD_AVX
+		#include <immintrin.h>
+	#endif
+
+#endif
+
+
+/********************************************************
+ * Shared kernels
+ *******************************************************/
+
+#if defined(GFX_SIMD_SSE2)
+
+/**
+ * Computes the dot product of two 4 component float vectors.
+ *
+ * @return The dot product in all components.
+ *
+ */
+static GFX_ALWAYS_INLINE __m128 _gfx_simd_dot4(
+
+		__m128  a,
+		__m128  b)
+{
+#if defined(GFX_SIMD_SSE4_1)
+
+	return _mm_dp_ps(a, b, 0xff);
+
+#else
+
+	__m128 m = _mm_mul_ps(a, b);
+	m = _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+
+	return _mm_add_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+
+#endif
+}
+
+/**
+ * Scales a 4 component float vector to unit length.
+ *
+ * @return The zero vector if the given vector has zero length.
+ *
+ */
+static GFX_ALWAYS_INLINE __m128 _gfx_simd_normalize4(
+
+		__m128 a)
+{
+	__m128 dot = _gfx_simd_dot4(a, a);
+	__m128 mask = _mm_cmpneq_ps(dot, _mm_setzero_ps());
+
+	return _mm_and_ps(mask, _mm_div_ps(a, _mm_sqrt_ps(dot)));
+}
+
+#endif // GFX_SIMD_SSE2
+
+#if defined(GFX_SIMD_AVX)
+
+/**
+ * Computes the dot product of two 4 component double vectors.
+ *
+ * @return The dot product in all components.
+ *
+ */
+static GFX_ALWAYS_INLINE __m256d _gfx_simd_dot4d(
+
+		__m256d  a,
+		__m256d  b)
+{
+	__m256d m = _mm256_mul_pd(a, b);
+	m = _mm256_hadd_pd(m, m);
+
+	return _mm256_add_pd(m, _mm256_permute2f128_pd(m, m, 0x01));
+}
+
+#endif // GFX_SIMD_AVX
+
+
+#endif // GFX_MATH_SIMD_H
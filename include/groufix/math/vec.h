@@ -15,7 +15,7 @@
 #ifndef GFX_MATH_VEC_H
 #define GFX_MATH_VEC_H
 
-#include "groufix/utils.h"
+#include "groufix/math/simd.h"
 
 #include <math.h>
 #include <string.h>
@@ -91,13 +91,17 @@
 
 	#define GFX_VEC_TYPE
 	#define GFX_VEC_DATA float
+	#define GFX_VEC_FLOAT
 	#include "groufix/math/vec.h"
+	#undef GFX_VEC_FLOAT
 	#undef GFX_VEC_DATA
 	#undef GFX_VEC_TYPE
 
 	#define GFX_VEC_TYPE d
 	#define GFX_VEC_DATA double
+	#define GFX_VEC_DOUBLE
 	#include "groufix/math/vec.h"
+	#undef GFX_VEC_DOUBLE
 	#undef GFX_VEC_DATA
 	#undef GFX_VEC_TYPE
 
@@ -126,6 +130,13 @@
 	#define GFX_VEC_ALIGN GFX_SSE_NO_ALIGN
 #endif
 
+/* SIMD kernels */
+#if defined(GFX_SIMD_SSE2) && defined(GFX_VEC_FLOAT) && GFX_VEC_SIZE == 4
+	#define GFX_VEC_SSE
+#elif defined(GFX_SIMD_AVX) && defined(GFX_VEC_DOUBLE) && GFX_VEC_SIZE == 4
+	#define GFX_VEC_AVX
+#endif
+
 
 /********************************************************
  * Vector Template
@@ -177,10 +188,20 @@ static GFX_ALWAYS_INLINE GFX_VEC_NAME* GFX_VEC_FUNC(add)(
 		const GFX_VEC_NAME*  a,
 		const GFX_VEC_NAME*  b)
 {
+#if defined(GFX_VEC_SSE)
+
+	_mm_storeu_ps(dest->data, _mm_add_ps(
+		_mm_loadu_ps(a->data),
+		_mm_loadu_ps(b->data)));
+
+#else
+
 	size_t i;
 	for(i = 0; i < GFX_VEC_SIZE; ++i)
 		dest->data[i] = a->data[i] + b->data[i];
 
+#endif
+
 	return dest;
 }
 
@@ -196,10 +217,20 @@ static GFX_ALWAYS_INLINE GFX_VEC_NAME* GFX_VEC_FUNC(sub)(
 		const GFX_VEC_NAME*  a,
 		const GFX_VEC_NAME*  b)
 {
+#if defined(GFX_VEC_SSE)
+
+	_mm_storeu_ps(dest->data, _mm_sub_ps(
+		_mm_loadu_ps(a->data),
+		_mm_loadu_ps(b->data)));
+
+#else
+
 	size_t i;
 	for(i = 0; i < GFX_VEC_SIZE; ++i)
 		dest->data[i] = a->data[i] - b->data[i];
 
+#endif
+
 	return dest;
 }
 
@@ -215,10 +246,20 @@ static GFX_ALWAYS_INLINE GFX_VEC_NAME* GFX_VEC_FUNC(mult)(
 		const GFX_VEC_NAME*  a,
 		const GFX_VEC_NAME*  b)
 {
+#if defined(GFX_VEC_SSE)
+
+	_mm_storeu_ps(dest->data, _mm_mul_ps(
+		_mm_loadu_ps(a->data),
+		_mm_loadu_ps(b->data)));
+
+#else
+
 	size_t i;
 	for(i = 0; i < GFX_VEC_SIZE; ++i)
 		dest->data[i] = a->data[i] * b->data[i];
 
+#endif
+
 	return dest;
 }
 
@@ -234,10 +275,20 @@ static GFX_ALWAYS_INLINE GFX_VEC_NAME* GFX_VEC_FUNC(scale)(
 		const GFX_VEC_NAME*  a,
 		const GFX_VEC_DATA   scalar)
 {
+#if defined(GFX_VEC_SSE)
+
+	_mm_storeu_ps(dest->data, _mm_mul_ps(
+		_mm_loadu_ps(a->data),
+		_mm_set1_ps(scalar)));
+
+#else
+
 	size_t i;
 	for(i = 0; i < GFX_VEC_SIZE; ++i)
 		dest->data[i] = a->data[i] * scalar;
 
+#endif
+
 	return dest;
 }
 
@@ -250,6 +301,20 @@ static GFX_ALWAYS_INLINE GFX_VEC_DATA GFX_VEC_FUNC(dot)(
 		const GFX_VEC_NAME*  a,
 		const GFX_VEC_NAME*  b)
 {
+#if defined(GFX_VEC_SSE)
+
+	return _mm_cvtss_f32(_gfx_simd_dot4(
+		_mm_loadu_ps(a->data),
+		_mm_loadu_ps(b->data)));
+
+#elif defined(GFX_VEC_AVX)
+
+	return _mm_cvtsd_f64(_mm256_castpd256_pd128(_gfx_simd_dot4d(
+		_mm256_loadu_pd(a->data),
+		_mm256_loadu_pd(b->data))));
+
+#else
+
 	GFX_VEC_DATA dot = 0;
 
 	size_t i;
@@ -257,6 +322,8 @@ static GFX_ALWAYS_INLINE GFX_VEC_DATA GFX_VEC_FUNC(dot)(
 		dot += a->data[i] * b->data[i];
 
 	return dot;
+
+#endif
 }
 
 #if GFX_VEC_SIZE == 3
@@ -318,6 +385,13 @@ static GFX_ALWAYS_INLINE GFX_VEC_NAME* GFX_VEC_FUNC(normalize)(
 		GFX_VEC_NAME*        dest,
 		const GFX_VEC_NAME*  a)
 {
+#if defined(GFX_VEC_SSE)
+
+	_mm_storeu_ps(dest->data, _gfx_simd_normalize4(
+		_mm_loadu_ps(a->data)));
+
+#else
+
 	double mag = GFX_VEC_FUNC(magnitude)(a);
 	if(mag) mag = 1.0 / mag;
 
@@ -325,6 +399,8 @@ static GFX_ALWAYS_INLINE GFX_VEC_NAME* GFX_VEC_FUNC(normalize)(
 	for(i = 0; i < GFX_VEC_SIZE; ++i)
 		dest->data[i] = a->data[i] * mag;
 
+#endif
+
 	return dest;
 }
 
@@ -349,5 +425,7 @@ static GFX_ALWAYS_INLINE int GFX_VEC_FUNC(is_zero)(
 #undef GFX_VEC_NAME
 #undef GFX_VEC_FUNC
 #undef GFX_VEC_ALIGN
+#undef GFX_VEC_SSE
+#undef GFX_VEC_AVX
 
 #endif // TEMPLATE
@@ -62,21 +62,29 @@ GFX_API void gfx_mesh_free(
 /**
  * Creates a new vertex layout associated with the mesh.
  *
- * @param sources Fixed number of vertex sources associated with this layout.
+ * @param buffers    Fixed number of buffers of the layout.
+ * @param attributes Fixed number of (sparse) vertex attributes of the layout.
+ * @param sources    Fixed number of vertex sources associated with this layout.
  * @return ID to identify the layout at this mesh (0 on failure).
  *
+ * The layout is freed when the mesh is freed, see gfx_vertex_layout_create.
+ *
  */
 GFX_API GFXMeshLayout gfx_mesh_add_layout(
 
 		GFXMesh*       mesh,
+		unsigned char  buffers,
+		unsigned char  attributes,
 		unsigned char  sources);
 
 /**
  * Shares a vertex layout associated with the mesh.
  *
- * @param share Vertex Layout to share.
+ * @param layout Vertex Layout to share.
  * @return ID to identify the layout at this mesh (0 on failure).
  *
+ * The layout is not freed by the mesh, it must outlive all meshes sharing it.
+ *
  */
 GFX_API GFXMeshLayout gfx_mesh_share_layout(
 
@@ -96,19 +104,29 @@ GFX_API GFXVertexLayout* gfx_mesh_get_layout(
 		GFXMeshLayout   layout);
 
 /**
- * Creates an automatic buffer.
+ * Creates a buffer associated with the mesh.
  *
+ * @param heap Heap to allocate the buffer from, NULL to create a separate buffer.
+ * @param size Size of the buffer in bytes.
+ * @param data Data to write to the buffer, can be NULL.
  * @return ID to identify the buffer (0 on failure).
  *
- * Note: the buffer will be aligned to GFX_LARGE_INTEGER so it can be used
- * for any index buffer.
+ * If a heap is given, the buffer is a range of one of its backing buffers,
+ * which is released when the mesh is freed. Many small meshes allocated from
+ * the same heap can share a layout (see gfx_mesh_share_layout), so their units
+ * use the same vertex layout state and can be batched by a bucket.
+ *
+ * Note: the buffer will be aligned to the largest index type so it can be used
+ * for any index buffer. When allocated from a heap, GFX_BUFFER_WRITE must be set
+ * in the usage of the heap for data to be written.
  *
  */
 GFX_API GFXMeshBuffer gfx_mesh_add_buffer(
 
-		GFXMesh*     mesh,
-		size_t       size,
-		const void*  data);
+		GFXMesh*        mesh,
+		GFXBufferHeap*  heap,
+		size_t          size,
+		const void*     data);
 
 /**
  * Uses a vertex buffer for a given attribue of a layout.
@@ -120,10 +138,19 @@ GFX_API GFXMeshBuffer gfx_mesh_add_buffer(
  * @param stride Byte offset between consecutive attributes (must be <= GFX_LIM_MAX_VERTEX_STRIDE).
  * @return Zero on failure.
  *
+ * The buffer is bound as close to the start of its backing buffer as the stride allows,
+ * the vertex its range starts at is applied as vertex base of the layout when drawn.
+ *
+ * Note: all vertex buffers of a layout must start at the same vertex,
+ * if not, this call will fail. If the layout is shared, the buffer can only
+ * be set if it is not yet set or it resolves to the same backing buffer, offset
+ * and stride, as other meshes depend on it. This holds for ranges of the same
+ * backing buffer of a heap if the stride is a power of two no larger than its minSize.
+ *
  */
 GFX_API int gfx_mesh_set_vertex_buffer(
 
-		const GFXMesh*  mesh,
+		GFXMesh*        mesh,
 		GFXMeshLayout   layout,
 		GFXMeshBuffer   buffer,
 		unsigned int    index,
@@ -136,14 +163,19 @@ GFX_API int gfx_mesh_set_vertex_buffer(
  * @param layout Vertex layout ID to set the buffer for.
  * @param buffer Buffer ID to use for this layout.
  * @param offset Byte offset within the buffer to start reading at.
+ * @return Zero on failure.
+ *
+ * The buffer is bound at the start of the backing buffer of its range,
+ * the offset of the range is applied when drawn.
  *
  * Note: offset must be a multiple of the size of the largest index used within layout.
- * If not, using this layout in a batch will fail.
+ * If not, using this layout in a batch will fail. If the layout is shared, this call
+ * fails if a different backing buffer is already bound.
  *
  */
-GFX_API void gfx_mesh_set_index_buffer(
+GFX_API int gfx_mesh_set_index_buffer(
 
-		const GFXMesh*  mesh,
+		GFXMesh*        mesh,
 		GFXMeshLayout   layout,
 		GFXMeshBuffer   buffer,
 		size_t          offset);
@@ -0,0 +1,380 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/containers/allocator.h"
+
+#include <string.h>
+
+/* Alignment of all memory handed out */
+#define GFX_INT_ALLOCATOR_ALIGN  16
+#define GFX_INT_ALLOCATOR_ROUND(x) \
+	(((x) + (GFX_INT_ALLOCATOR_ALIGN - 1)) & ~(size_t)(GFX_INT_ALLOCATOR_ALIGN - 1))
+
+/******************************************************/
+/** Block of an arena */
+typedef struct GFX_ArenaBlock
+{
+	struct GFX_ArenaBlock*  next; /* Previous block */
+	size_t                  size; /* Usable bytes */
+	size_t                  used;
+
+} GFX_ArenaBlock;
+
+
+/** Chunk of a pool */
+typedef struct GFX_PoolChunk
+{
+	struct GFX_PoolChunk* next;
+
+} GFX_PoolChunk;
+
+
+/** Free block of a pool */
+typedef struct GFX_PoolBlock
+{
+	struct GFX_PoolBlock* next;
+
+} GFX_PoolBlock;
+
+
+/* Size of the headers, keeping the data aligned */
+#define GFX_INT_ARENA_HEADER \
+	GFX_INT_ALLOCATOR_ROUND(sizeof(GFX_ArenaBlock))
+#define GFX_INT_POOL_HEADER \
+	GFX_INT_ALLOCATOR_ROUND(sizeof(GFX_PoolChunk))
+
+/******************************************************/
+static void* _gfx_allocator_realloc(
+
+		GFXAllocator*  allocator,
+		void*          ptr,
+		size_t         oldSize,
+		size_t         newSize)
+{
+	if(!newSize)
+	{
+		free(ptr);
+		return NULL;
+	}
+
+	void* new = realloc(ptr, newSize);
+	if(new) ++allocator->heapAllocs;
+
+	return new;
+}
+
+/******************************************************/
+void gfx_allocator_init(
+
+		GFXAllocator* allocator)
+{
+	allocator->reallocate = _gfx_allocator_realloc;
+	allocator->allocs = 0;
+	allocator->heapAllocs = 0;
+}
+
+/******************************************************/
+static inline void* _gfx_arena_get_data(
+
+		GFX_ArenaBlock* block)
+{
+	return GFX_PTR_ADD_BYTES(block, GFX_INT_ARENA_HEADER);
+}
+
+/******************************************************/
+static GFX_ArenaBlock* _gfx_arena_add_block(
+
+		GFXArena*  arena,
+		size_t     size)
+{
+	GFX_ArenaBlock* block = malloc(GFX_INT_ARENA_HEADER + size);
+	if(!block) return NULL;
+
+	++arena->allocator.heapAllocs;
+
+	block->next = arena->blocks;
+	block->size = size;
+	block->used = 0;
+
+	arena->blocks = block;
+
+	return block;
+}
+
+/******************************************************/
+static void* _gfx_arena_alloc(
+
+		GFXArena*  arena,
+		size_t     size)
+{
+	size = GFX_INT_ALLOCATOR_ROUND(size);
+
+	/* Allocate a new block if it doesn't fit */
+	GFX_ArenaBlock* block = arena->blocks;
+	if(!block || block->size - block->used < size)
+	{
+		block = _gfx_arena_add_block(
+			arena,
+			size > arena->blockSize ? size : arena->blockSize);
+
+		if(!block) return NULL;
+	}
+
+	void* ptr = GFX_PTR_ADD_BYTES(_gfx_arena_get_data(block), block->used);
+	block->used += size;
+
+	return arena->last = ptr;
+}
+
+/******************************************************/
+static void* _gfx_arena_realloc(
+
+		GFXAllocator*  allocator,
+		void*          ptr,
+		size_t         oldSize,
+		size_t         newSize)
+{
+	GFXArena* arena = (GFXArena*)allocator;
+
+	/* The most recent allocation can be resized or freed in place */
+	if(ptr && ptr == arena->last)
+	{
+		GFX_ArenaBlock* block = arena->blocks;
+		size_t offset = GFX_PTR_DIFF(_gfx_arena_get_data(block), ptr);
+
+		if(!newSize)
+		{
+			block->used = offset;
+			arena->last = NULL;
+
+			return NULL;
+		}
+
+		if(block->size - offset >= newSize)
+		{
+			block->used = offset + GFX_INT_ALLOCATOR_ROUND(newSize);
+			return ptr;
+		}
+	}
+
+	/* Everything else is freed on reset */
+	if(!newSize) return NULL;
+
+	void* new = _gfx_arena_alloc(arena, newSize);
+	if(new && ptr) memcpy(new, ptr, oldSize < newSize ? oldSize : newSize);
+
+	return new;
+}
+
+/******************************************************/
+void gfx_arena_init(
+
+		GFXArena*  arena,
+		size_t     blockSize)
+{
+	arena->allocator.reallocate = _gfx_arena_realloc;
+	arena->allocator.allocs = 0;
+	arena->allocator.heapAllocs = 0;
+
+	arena->blockSize = GFX_INT_ALLOCATOR_ROUND(blockSize);
+	arena->blocks = NULL;
+	arena->last = NULL;
+}
+
+/******************************************************/
+void gfx_arena_clear(
+
+		GFXArena* arena)
+{
+	GFX_ArenaBlock* block = arena->blocks;
+	while(block)
+	{
+		GFX_ArenaBlock* next = block->next;
+		free(block);
+		block = next;
+	}
+
+	arena->blocks = NULL;
+	arena->last = NULL;
+}
+
+/******************************************************/
+void gfx_arena_reset(
+
+		GFXArena* arena)
+{
+	GFX_ArenaBlock* block = arena->blocks;
+	arena->last = NULL;
+
+	if(!block) return;
+
+	/* Merge all blocks into one so the next frame fits */
+	if(block->next)
+	{
+		size_t size = 0;
+		for(; block; block = block->next)
+			size += block->size;
+
+		gfx_arena_clear(arena);
+		_gfx_arena_add_block(arena, size);
+	}
+
+	else block->used = 0;
+}
+
+/******************************************************/
+static void* _gfx_pool_take(
+
+		GFXPool* pool)
+{
+	/* Allocate a new chunk and link all its blocks */
+	if(!pool->free)
+	{
+		size_t stride = GFX_INT_ALLOCATOR_ROUND(pool->blockSize);
+		GFX_PoolChunk* chunk = malloc(
+			GFX_INT_POOL_HEADER + stride * pool->chunkSize);
+
+		if(!chunk) return NULL;
+
+		++pool->allocator.heapAllocs;
+
+		chunk->next = pool->chunks;
+		pool->chunks = chunk;
+
+		size_t b = pool->chunkSize;
+		while(b--)
+		{
+			GFX_PoolBlock* block = GFX_PTR_ADD_BYTES(
+				chunk, GFX_INT_POOL_HEADER + stride * b);
+
+			block->next = pool->free;
+			pool->free = block;
+		}
+	}
+
+	GFX_PoolBlock* block = pool->free;
+	pool->free = block->next;
+
+	return block;
+}
+
+/******************************************************/
+static void _gfx_pool_give(
+
+		GFXPool*  pool,
+		void*     ptr)
+{
+	GFX_PoolBlock* block = ptr;
+	block->next = pool->free;
+	pool->free = block;
+}
+
+/******************************************************/
+static void* _gfx_pool_realloc(
+
+		GFXAllocator*  allocator,
+		void*          ptr,
+		size_t         oldSize,
+		size_t         newSize)
+{
+	GFXPool* pool = (GFXPool*)allocator;
+
+	/* Sizes decide whether memory is a block or on the heap */
+	int inPool = ptr && oldSize <= pool->blockSize;
+	void* new;
+
+	if(!newSize)
+	{
+		if(inPool) _gfx_pool_give(pool, ptr);
+		else free(ptr);
+
+		return NULL;
+	}
+
+	if(newSize <= pool->blockSize)
+	{
+		if(inPool) return ptr;
+
+		new = _gfx_pool_take(pool);
+		if(!new) return NULL;
+
+		if(ptr)
+		{
+			memcpy(new, ptr, newSize);
+			free(ptr);
+		}
+
+		return new;
+	}
+
+	/* Too large for a block */
+	if(ptr && !inPool)
+	{
+		new = realloc(ptr, newSize);
+		if(new) ++pool->allocator.heapAllocs;
+
+		return new;
+	}
+
+	new = malloc(newSize);
+	if(!new) return NULL;
+
+	++pool->allocator.heapAllocs;
+
+	if(ptr)
+	{
+		memcpy(new, ptr, oldSize);
+		_gfx_pool_give(pool, ptr);
+	}
+
+	return new;
+}
+
+/******************************************************/
+void gfx_pool_init(
+
+		GFXPool*  pool,
+		size_t    blockSize,
+		size_t    chunkSize)
+{
+	pool->allocator.reallocate = _gfx_pool_realloc;
+	pool->allocator.allocs = 0;
+	pool->allocator.heapAllocs = 0;
+
+	/* Each free block stores a link */
+	pool->blockSize =
+		blockSize < sizeof(GFX_PoolBlock) ? sizeof(GFX_PoolBlock) : blockSize;
+	pool->chunkSize =
+		chunkSize ? chunkSize : 1;
+
+	pool->chunks = NULL;
+	pool->free = NULL;
+}
+
+/******************************************************/
+void gfx_pool_clear(
+
+		GFXPool* pool)
+{
+	GFX_PoolChunk* chunk = pool->chunks;
+	while(chunk)
+	{
+		GFX_PoolChunk* next = chunk->next;
+		free(chunk);
+		chunk = next;
+	}
+
+	pool->chunks = NULL;
+	pool->free = NULL;
+}
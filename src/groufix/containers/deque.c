@@ -43,6 +43,10 @@ static int _gfx_deque_realloc(
 	size_t begin = GFX_PTR_DIFF(deque->data, deque->begin);
 	size_t end = GFX_PTR_DIFF(deque->data, deque->end);
 
+	/* Elements wrap at the upper bound, not at the capacity */
+	/* Anything beyond the upper bound is never used, so never move it */
+	size_t upper = deque->capacity - (deque->capacity % deque->elementSize);
+
 	long int diff =
 		(long int)capacity - (long int)deque->capacity;
 	long int elemDiff =
@@ -58,7 +62,7 @@ static int _gfx_deque_realloc(
 			memmove(
 				GFX_PTR_ADD_BYTES(deque->begin, elemDiff),
 				deque->begin,
-				deque->capacity - begin
+				upper - begin
 			);
 			begin += elemDiff;
 		}
@@ -75,14 +79,19 @@ static int _gfx_deque_realloc(
 	}
 
 	/* Make sure to check if it worked */
-	void* new = realloc(deque->data, capacity);
+	void* new = gfx_allocator_realloc(
+		deque->allocator,
+		deque->data,
+		deque->capacity,
+		capacity);
+
 	if(!new)
 	{
 		/* Move memory back >.> */
 		if(diff < 0 && begin > end) memmove(
 			deque->begin,
 			GFX_PTR_ADD_BYTES(deque->begin, elemDiff),
-			deque->capacity - (begin - elemDiff)
+			upper - (begin - elemDiff)
 		);
 
 		/* Out of memory error */
@@ -102,7 +111,7 @@ static int _gfx_deque_realloc(
 	if(diff > 0 && begin > end) deque->begin = memmove(
 		GFX_PTR_ADD_BYTES(deque->begin, elemDiff),
 		deque->begin,
-		deque->capacity - begin
+		upper - begin
 	);
 
 	deque->capacity = capacity;
@@ -184,7 +193,7 @@ void gfx_deque_free(
 {
 	if(deque)
 	{
-		free(deque->data);
+		gfx_deque_clear(deque);
 		free(deque);
 	}
 }
@@ -199,6 +208,17 @@ void gfx_deque_init(
 	deque->elementSize = elementSize;
 }
 
+/******************************************************/
+void gfx_deque_init_with_allocator(
+
+		GFXDeque*      deque,
+		size_t         elementSize,
+		GFXAllocator*  allocator)
+{
+	gfx_deque_init(deque, elementSize);
+	deque->allocator = allocator;
+}
+
 /******************************************************/
 void gfx_deque_init_from_buffer(
 
@@ -246,7 +266,12 @@ void gfx_deque_clear(
 
 		GFXDeque* deque)
 {
-	free(deque->data);
+	gfx_allocator_realloc(
+		deque->allocator,
+		deque->data,
+		deque->capacity,
+		0);
+
 	deque->data = NULL;
 	deque->begin = NULL;
 	deque->end = NULL;
@@ -292,9 +317,9 @@ GFXDequeIterator gfx_deque_push_begin(
 	/* Reallocate if necessary */
 	if(newSize > deque->capacity)
 	{
-		/* Get new capacity if empty */
+		/* Get new capacity if empty or doubling is not enough */
 		size_t cap = deque->capacity << 1;
-		if(!cap) cap = _gfx_deque_get_max_capacity(newSize);
+		if(cap < newSize) cap = _gfx_deque_get_max_capacity(newSize);
 
 		if(!_gfx_deque_realloc(deque, cap)) return deque->end;
 	}
@@ -327,25 +352,22 @@ GFXDequeIterator gfx_deque_push_end(
 {
 	size_t oldSize = gfx_deque_get_byte_size(deque);
 	size_t newSize = oldSize + deque->elementSize;
-	size_t allSize = newSize;
 	size_t upper = deque->capacity - (deque->capacity % deque->elementSize);
 
 	/* Pad with an empty element */
-	if((size_t)GFX_PTR_DIFF(deque->data, deque->end) == upper && oldSize)
-		newSize += deque->elementSize;
-
-	else if(GFX_PTR_DIFF(deque->begin, deque->end) < 0)
+	if(
+		((size_t)GFX_PTR_DIFF(deque->data, deque->end) == upper && oldSize) ||
+		GFX_PTR_DIFF(deque->begin, deque->end) < 0)
 	{
 		newSize += deque->elementSize;
-		allSize += deque->elementSize;
 	}
 
 	/* Reallocate if necessary */
 	if(newSize > deque->capacity)
 	{
-		/* Get new capacity if empty */
+		/* Get new capacity if empty or doubling is not enough */
 		size_t cap = deque->capacity << 1;
-		if(!cap) cap = _gfx_deque_get_max_capacity(allSize);
+		if(cap < newSize) cap = _gfx_deque_get_max_capacity(newSize);
 
 		if(!_gfx_deque_realloc(deque, cap)) return deque->end;
 		upper = deque->capacity - (deque->capacity % deque->elementSize);
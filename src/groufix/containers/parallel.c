@@ -0,0 +1,342 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/containers/parallel.h"
+#include "groufix/core/threading.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Chunking */
+#define GFX_INT_PARALLEL_SPLIT       4    /* Number of chunks per core */
+#define GFX_INT_PARALLEL_SORT_GRAIN  1024 /* Minimum number of elements per sorted chunk */
+#define GFX_INT_PARALLEL_SORT_BLOCK  16   /* Number of elements to insertion sort */
+
+/******************************************************/
+/** Parallel for invocation */
+typedef struct GFX_For
+{
+	size_t              begin;
+	size_t              end;
+	size_t              chunk;  /* Size of a chunk */
+	size_t              chunks; /* Number of chunks */
+	GFX_ATOMIC(size_t)  next;   /* Next chunk to process */
+
+	GFXParallelForFunc  func;
+	void*               data;
+
+} GFX_For;
+
+
+/** Parallel sort invocation */
+typedef struct GFX_Sort
+{
+	char*               src;
+	char*               dst;
+	size_t              num;
+	size_t              size;
+	size_t              width; /* Number of elements per sorted run */
+
+	GFXParallelCompare  compare;
+	void*               data;
+
+} GFX_Sort;
+
+
+/******************************************************/
+static size_t _gfx_parallel_get_chunk_size(
+
+		size_t  num,
+		size_t  grain,
+		size_t  split)
+{
+	unsigned long cores = _gfx_platform_get_num_cores();
+	size_t chunks = (cores ? cores : 1) * split;
+
+	size_t chunk = (num + chunks - 1) / chunks;
+
+	return chunk > grain ? chunk : (grain ? grain : 1);
+}
+
+/******************************************************/
+static void _gfx_parallel_for_task(
+
+		void* arg)
+{
+	GFX_For* f = (GFX_For*)arg;
+
+	/* Keep claiming chunks until none are left */
+	while(1)
+	{
+		size_t c = GFX_ATOMIC_ADD(&f->next, 1) - 1;
+		if(c >= f->chunks) break;
+
+		size_t begin = f->begin + c * f->chunk;
+		size_t end = (f->end - begin > f->chunk) ?
+			begin + f->chunk : f->end;
+
+		f->func(begin, end, f->data);
+	}
+}
+
+/******************************************************/
+void gfx_parallel_for(
+
+		GFXThreadPool*      pool,
+		size_t              begin,
+		size_t              end,
+		size_t              grain,
+		GFXParallelForFunc  func,
+		void*               data)
+{
+	if(begin >= end) return;
+
+	size_t num = end - begin;
+	size_t chunk = _gfx_parallel_get_chunk_size(
+		num, grain, GFX_INT_PARALLEL_SPLIT);
+
+	size_t chunks = (num - 1) / chunk + 1;
+
+	/* Don't bother with a single chunk */
+	GFXThreadPoolGroup* group = NULL;
+	if(pool && pool->size && chunks > 1)
+		group = gfx_thread_pool_group_create(pool);
+
+	if(!group)
+	{
+		func(begin, end, data);
+		return;
+	}
+
+	GFX_For f =
+	{
+		.begin = begin,
+		.end = end,
+		.chunk = chunk,
+		.chunks = chunks,
+		.next = 0,
+		.func = func,
+		.data = data
+	};
+
+	/* Push a task for each thread, the calling thread claims chunks too */
+	size_t tasks = chunks - 1;
+	tasks = (tasks > pool->size) ? pool->size : tasks;
+
+	while(tasks--) if(!gfx_thread_pool_group_push(
+		group,
+		NULL,
+		_gfx_parallel_for_task,
+		&f,
+		0))
+	{
+		break;
+	}
+
+	_gfx_parallel_for_task(&f);
+
+	gfx_thread_pool_group_wait(group);
+	gfx_thread_pool_group_free(group);
+}
+
+/******************************************************/
+static void _gfx_parallel_merge(
+
+		const GFX_Sort*  sort,
+		const char*      src,
+		char*            dst,
+		size_t           begin,
+		size_t           mid,
+		size_t           end)
+{
+	size_t size = sort->size;
+
+	const char* l  = src + begin * size;
+	const char* le = src + mid * size;
+	const char* r  = le;
+	const char* re = src + end * size;
+
+	dst += begin * size;
+
+	while(l < le && r < re)
+	{
+		/* Take from the left run on equality to remain stable */
+		if(sort->compare(r, l, sort->data) < 0)
+		{
+			memcpy(dst, r, size);
+			r += size;
+		}
+		else
+		{
+			memcpy(dst, l, size);
+			l += size;
+		}
+
+		dst += size;
+	}
+
+	memcpy(dst, l, le - l);
+	memcpy(dst + (le - l), r, re - r);
+}
+
+/******************************************************/
+static void _gfx_parallel_sort_runs(
+
+		size_t  begin,
+		size_t  end,
+		void*   data)
+{
+	const GFX_Sort* sort = (const GFX_Sort*)data;
+	size_t size = sort->size;
+
+	for(; begin < end; ++begin)
+	{
+		size_t lo = begin * sort->width;
+		size_t hi = lo + sort->width;
+		hi = (hi > sort->num) ? sort->num : hi;
+
+		/* Insertion sort small blocks, use the scratch buffer as temporary */
+		char* temp = sort->dst + lo * size;
+		size_t b, i, j;
+
+		for(b = lo; b < hi; b += GFX_INT_PARALLEL_SORT_BLOCK)
+		{
+			size_t e = b + GFX_INT_PARALLEL_SORT_BLOCK;
+			e = (e > hi) ? hi : e;
+
+			for(i = b + 1; i < e; ++i)
+			{
+				memcpy(temp, sort->src + i * size, size);
+
+				for(j = i; j > b; --j)
+				{
+					char* prev = sort->src + (j - 1) * size;
+					if(sort->compare(prev, temp, sort->data) <= 0) break;
+
+					memcpy(prev + size, prev, size);
+				}
+
+				memcpy(sort->src + j * size, temp, size);
+			}
+		}
+
+		/* Merge the blocks bottom up */
+		char* src = sort->src;
+		char* dst = sort->dst;
+		size_t w;
+
+		for(w = GFX_INT_PARALLEL_SORT_BLOCK; w < hi - lo; w <<= 1)
+		{
+			for(b = lo; b < hi; b += w << 1)
+			{
+				size_t m = (hi - b > w) ? b + w : hi;
+				size_t e = (hi - m > w) ? m + w : hi;
+
+				_gfx_parallel_merge(sort, src, dst, b, m, e);
+			}
+
+			char* t = src;
+			src = dst;
+			dst = t;
+		}
+
+		/* Make sure the run ends up in the source */
+		if(src != sort->src) memcpy(
+			sort->src + lo * size,
+			src + lo * size,
+			(hi - lo) * size);
+	}
+}
+
+/******************************************************/
+static void _gfx_parallel_merge_runs(
+
+		size_t  begin,
+		size_t  end,
+		void*   data)
+{
+	const GFX_Sort* sort = (const GFX_Sort*)data;
+
+	for(; begin < end; ++begin)
+	{
+		size_t b = begin * (sort->width << 1);
+		size_t m = (sort->num - b > sort->width) ? b + sort->width : sort->num;
+		size_t e = (sort->num - m > sort->width) ? m + sort->width : sort->num;
+
+		_gfx_parallel_merge(sort, sort->src, sort->dst, b, m, e);
+	}
+}
+
+/******************************************************/
+int gfx_parallel_sort(
+
+		GFXThreadPool*      pool,
+		void*               base,
+		void*               scratch,
+		size_t              num,
+		size_t              size,
+		GFXParallelCompare  compare,
+		void*               data)
+{
+	if(num <= 1) return 1;
+
+	/* Allocate scratch buffer */
+	void* alloc = NULL;
+	if(!scratch)
+	{
+		alloc = malloc(num * size);
+		if(!alloc) return 0;
+
+		scratch = alloc;
+	}
+
+	/* Sort a run per core */
+	GFX_Sort sort =
+	{
+		.src = base,
+		.dst = scratch,
+		.num = num,
+		.size = size,
+		.compare = compare,
+		.data = data
+	};
+
+	sort.width = _gfx_parallel_get_chunk_size(
+		num, GFX_INT_PARALLEL_SORT_GRAIN, 1);
+
+	size_t runs = (num - 1) / sort.width + 1;
+
+	gfx_parallel_for(pool, 0, runs, 1, _gfx_parallel_sort_runs, &sort);
+
+	/* Merge runs pairwise */
+	while(runs > 1)
+	{
+		runs = (runs + 1) >> 1;
+		gfx_parallel_for(pool, 0, runs, 1, _gfx_parallel_merge_runs, &sort);
+
+		char* t = sort.src;
+		sort.src = sort.dst;
+		sort.dst = t;
+
+		sort.width <<= 1;
+	}
+
+	/* Make sure the result ends up in the given array */
+	if(sort.src != base)
+		memcpy(base, sort.src, num * size);
+
+	free(alloc);
+
+	return 1;
+}
@@ -0,0 +1,344 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/containers/slot_map.h"
+#include "groufix/core/errors.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/* Handle layout, lower bits are the slot + 1, upper bits the generation */
+#define GFX_INT_SLOT_INDEX_BITS  24
+#define GFX_INT_SLOT_INDEX_MASK  ((1u << GFX_INT_SLOT_INDEX_BITS) - 1)
+#define GFX_INT_SLOT_MAX         GFX_INT_SLOT_INDEX_MASK
+
+/******************************************************/
+/** Internal slot */
+typedef struct GFX_Slot
+{
+	size_t         index;      /* Index into data if used, next free slot + 1 if free */
+	unsigned char  generation;
+
+} GFX_Slot;
+
+/******************************************************/
+static inline GFXSlotHandle _gfx_slot_map_make_handle(
+
+		size_t         slot,
+		unsigned char  generation)
+{
+	return
+		((GFXSlotHandle)generation << GFX_INT_SLOT_INDEX_BITS) |
+		(GFXSlotHandle)(slot + 1);
+}
+
+/******************************************************/
+static inline int _gfx_slot_map_is_used(
+
+		const GFXSlotMap*  map,
+		size_t             slot,
+		const GFX_Slot*    s)
+{
+	return
+		s->index < gfx_slot_map_get_size(map) &&
+		gfx_slot_map_get_handle(map, s->index) ==
+			_gfx_slot_map_make_handle(slot, s->generation);
+}
+
+/******************************************************/
+static void _gfx_slot_map_free(
+
+		GFXSlotMap*  map,
+		size_t       slot)
+{
+	/* Append to the free list, so a slot is reused as late as possible */
+	/* A stale handle only aliases once its slot is reused 256 times */
+	((GFX_Slot*)gfx_vector_at(&map->slots, slot))->index = 0;
+
+	if(map->last)
+		((GFX_Slot*)gfx_vector_at(&map->slots, map->last - 1))->index = slot + 1;
+	else
+		map->free = slot + 1;
+
+	map->last = slot + 1;
+}
+
+/******************************************************/
+void gfx_slot_map_init(
+
+		GFXSlotMap*  map,
+		size_t       elementSize)
+{
+	gfx_vector_init(&map->data, elementSize);
+	gfx_vector_init(&map->handles, sizeof(GFXSlotHandle));
+	gfx_vector_init(&map->slots, sizeof(GFX_Slot));
+
+	map->free = 0;
+	map->last = 0;
+	map->seed = 0;
+}
+
+/******************************************************/
+void gfx_slot_map_clear(
+
+		GFXSlotMap* map)
+{
+	gfx_vector_clear(&map->data);
+	gfx_vector_clear(&map->handles);
+	gfx_vector_clear(&map->slots);
+
+	map->free = 0;
+	map->last = 0;
+	++map->seed;
+}
+
+/******************************************************/
+void gfx_slot_map_reset(
+
+		GFXSlotMap* map)
+{
+	/* Keep all slots, so their generations are not reused */
+	size_t index;
+	for(index = 0; index < gfx_slot_map_get_size(map); ++index)
+	{
+		GFXSlotHandle handle = gfx_slot_map_get_handle(map, index);
+		GFX_Slot* s = gfx_vector_at(
+			&map->slots,
+			(handle & GFX_INT_SLOT_INDEX_MASK) - 1);
+
+		++s->generation;
+	}
+
+	gfx_vector_clear(&map->data);
+	gfx_vector_clear(&map->handles);
+
+	/* Free all slots, lowest first */
+	map->free = 0;
+	map->last = 0;
+
+	size_t slot;
+	for(slot = 0; slot < gfx_vector_get_size(&map->slots); ++slot)
+		_gfx_slot_map_free(map, slot);
+}
+
+/******************************************************/
+int gfx_slot_map_reserve(
+
+		GFXSlotMap*  map,
+		size_t       numElements)
+{
+	/* There are never less slots than elements */
+	return
+		gfx_vector_reserve(&map->data, numElements) &&
+		gfx_vector_reserve(&map->handles, numElements) &&
+		gfx_vector_reserve(&map->slots, numElements);
+}
+
+/******************************************************/
+GFXSlotHandle gfx_slot_map_insert(
+
+		GFXSlotMap*  map,
+		const void*  element)
+{
+	size_t index = gfx_slot_map_get_size(map);
+
+	/* Insert the element and its handle */
+	GFXVectorIterator it = gfx_vector_insert(
+		&map->data,
+		element,
+		map->data.end
+	);
+
+	if(it == map->data.end) return 0;
+
+	GFXVectorIterator hit = gfx_vector_insert(
+		&map->handles,
+		NULL,
+		map->handles.end
+	);
+
+	if(hit == map->handles.end)
+	{
+		gfx_vector_erase_at(&map->data, index);
+		return 0;
+	}
+
+	/* Get a new slot if no free ones are left */
+	size_t slot = map->free;
+	if(!slot)
+	{
+		slot = gfx_vector_get_size(&map->slots);
+
+		GFX_Slot new;
+		new.index = 0;
+		new.generation = map->seed;
+
+		if(slot < GFX_INT_SLOT_MAX) it = gfx_vector_insert(
+			&map->slots,
+			&new,
+			map->slots.end
+		);
+
+		else
+		{
+			gfx_errors_output(
+				"[GFX Out Of Memory]: Slot map ran out of handles."
+			);
+			it = map->slots.end;
+		}
+
+		if(it == map->slots.end)
+		{
+			gfx_vector_erase_at(&map->handles, index);
+			gfx_vector_erase_at(&map->data, index);
+
+			return 0;
+		}
+	}
+
+	else --slot;
+
+	/* Take the slot */
+	GFX_Slot* s = gfx_vector_at(&map->slots, slot);
+	if(map->free)
+	{
+		map->free = s->index;
+		if(!map->free) map->last = 0;
+	}
+
+	s->index = index;
+
+	GFXSlotHandle handle = _gfx_slot_map_make_handle(slot, s->generation);
+	*(GFXSlotHandle*)hit = handle;
+
+	return handle;
+}
+
+/******************************************************/
+void gfx_slot_map_erase_at(
+
+		GFXSlotMap*  map,
+		size_t       index)
+{
+	size_t last = gfx_slot_map_get_size(map) - 1;
+	GFXSlotHandle handle = gfx_slot_map_get_handle(map, index);
+
+	/* Move the last element into its place */
+	if(index != last)
+	{
+		GFXSlotHandle moved = gfx_slot_map_get_handle(map, last);
+		GFX_Slot* s = gfx_vector_at(
+			&map->slots,
+			(moved & GFX_INT_SLOT_INDEX_MASK) - 1);
+
+		memcpy(
+			gfx_vector_at(&map->data, index),
+			gfx_vector_at(&map->data, last),
+			map->data.elementSize);
+
+		*(GFXSlotHandle*)gfx_vector_at(&map->handles, index) = moved;
+		s->index = index;
+	}
+
+	gfx_vector_erase_at(&map->data, last);
+	gfx_vector_erase_at(&map->handles, last);
+
+	/* Invalidate the handle and free its slot */
+	size_t slot = (handle & GFX_INT_SLOT_INDEX_MASK) - 1;
+	GFX_Slot* s = gfx_vector_at(&map->slots, slot);
+
+	++s->generation;
+	_gfx_slot_map_free(map, slot);
+}
+
+/******************************************************/
+size_t gfx_slot_map_get_index(
+
+		const GFXSlotMap*  map,
+		GFXSlotHandle      handle)
+{
+	size_t slot = handle & GFX_INT_SLOT_INDEX_MASK;
+	if(!slot || slot > gfx_vector_get_size(&map->slots))
+		return 0;
+
+	/* Check the data as well, in case the generation wrapped around */
+	const GFX_Slot* s = gfx_vector_at(&map->slots, slot - 1);
+	if(
+		s->index >= gfx_slot_map_get_size(map) ||
+		gfx_slot_map_get_handle(map, s->index) != handle)
+	{
+		return 0;
+	}
+
+	return s->index + 1;
+}
+
+/******************************************************/
+int gfx_slot_map_erase(
+
+		GFXSlotMap*    map,
+		GFXSlotHandle  handle)
+{
+	size_t index = gfx_slot_map_get_index(map, handle);
+	if(!index) return 0;
+
+	gfx_slot_map_erase_at(map, index - 1);
+
+	return 1;
+}
+
+/******************************************************/
+void gfx_slot_map_compact(
+
+		GFXSlotMap* map)
+{
+	size_t size = gfx_vector_get_size(&map->slots);
+	size_t used = size;
+
+	/* Find the last used slot */
+	while(used)
+	{
+		const GFX_Slot* s = gfx_vector_at(&map->slots, used - 1);
+		if(_gfx_slot_map_is_used(map, used - 1, s))
+			break;
+
+		/* Make sure new slots don't reuse generations of stale handles */
+		if((unsigned char)(s->generation - map->seed) < 128)
+			map->seed = s->generation;
+
+		--used;
+	}
+
+	if(used == size) return;
+
+	map->free = 0;
+	map->last = 0;
+
+	if(!used)
+	{
+		gfx_vector_clear(&map->slots);
+		return;
+	}
+
+	gfx_vector_erase_range_at(&map->slots, size - used, used);
+
+	/* Rebuild the free list of the remaining slots, lowest first */
+	size_t slot;
+	for(slot = 0; slot < used; ++slot)
+	{
+		GFX_Slot* s = gfx_vector_at(&map->slots, slot);
+		if(!_gfx_slot_map_is_used(map, slot, s))
+			_gfx_slot_map_free(map, slot);
+	}
+}
@@ -13,6 +13,7 @@
  */
 
 #include "groufix/containers/thread_pool.h"
+#include "groufix/containers/deque.h"
 #include "groufix/containers/vector.h"
 #include "groufix/core/errors.h"
 #include "groufix/core/threading.h"
@@ -25,31 +26,103 @@
 #define GFX_INT_POOL_SUSPENDED  0x01
 #define GFX_INT_POOL_RESUMED    0x02
 
+/* Scheduling */
+#define GFX_INT_POOL_BANDS       4        /* Number of priority bands */
+#define GFX_INT_POOL_BAND_SHIFT  6        /* Shift of a priority to get its band */
+#define GFX_INT_POOL_DEQUE_SIZE  64       /* Initial size of a worker deque, must be a power of two */
+#define GFX_INT_POOL_HELP_WAIT   1000000  /* Nanoseconds to block for between attempts to help */
+
 /******************************************************/
 /** Forward declarate */
 struct GFX_Pool;
+struct GFX_Group;
+struct GFX_ThreadList;
 
 
 /** Actual task */
 typedef struct GFX_Task
 {
-	signed char        priority;
 	void*              data;
 	GFXThreadPoolTask  task;
+	struct GFX_Group*  group; /* Group to notify when done, can be NULL */
 
 } GFX_Task;
 
 
+/** Task waiting for a group */
+typedef struct GFX_Deferred
+{
+	GFX_Task     task;
+	signed char  priority;
+
+} GFX_Deferred;
+
+
+/** Internal task group */
+typedef struct GFX_Group
+{
+	/* Super class */
+	GFXThreadPoolGroup group;
+
+	/* Hidden data */
+	GFX_ATOMIC(size_t)  pending;  /* Number of unfinished tasks */
+	GFXVector           deferred; /* Stores GFX_Deferred */
+
+	GFX_PlatformMutex   mutex;
+	GFX_PlatformCond    done;     /* Condition that waits for all tasks to finish */
+
+} GFX_Group;
+
+
+/** Circular task array */
+typedef struct GFX_TaskArray
+{
+	struct GFX_TaskArray*  prev; /* Array it replaced, freed with the deque */
+	int64_t                mask; /* Size - 1 */
+	GFX_Task               tasks[];
+
+} GFX_TaskArray;
+
+
+/** Chase-Lev work stealing deque */
+typedef struct GFX_TaskDeque
+{
+	GFX_ATOMIC(int64_t)         top;    /* Stealing end */
+	GFX_ATOMIC(int64_t)         bottom; /* Owning end */
+	GFX_ATOMIC(GFX_TaskArray*)  array;
+
+} GFX_TaskDeque;
+
+
+/** Worker thread data */
+typedef struct GFX_Worker
+{
+	struct GFX_Pool*        pool;
+	struct GFX_ThreadList*  node;
+	GFX_TaskDeque           deques[GFX_INT_POOL_BANDS];
+
+} GFX_Worker;
+
+
+/** Worker node */
+typedef struct GFX_WorkerList
+{
+	struct GFX_WorkerList*  next;
+	unsigned int            size; /* Number of workers of this particular node */
+
+} GFX_WorkerList;
+
+
 /** Actual thread node */
 typedef struct GFX_ThreadList
 {
 	/* Hidden data */
-	struct GFX_Pool*        pool;
-	struct GFX_ThreadList*  next;
+	struct GFX_Pool*           pool;
+	struct GFX_ThreadList*     next;
 
-	unsigned int            size;  /* Number of threads of this particular node */
-	unsigned char           alive; /* Whether or not these threads are still alive */
-	void*                   arg;   /* Argument for initialization */
+	unsigned int               size;  /* Number of threads of this particular node */
+	GFX_ATOMIC(unsigned char)  alive; /* Whether or not these threads are still alive */
+	void*                      arg;   /* Argument for initialization */
 
 } GFX_ThreadList;
 
@@ -61,15 +134,23 @@ typedef struct GFX_Pool
 	GFXThreadPool pool;
 
 	/* Hidden data */
-	unsigned char      status;
-	GFXVector          tasks;   /* Priority queue storing GFX_Task */
+	GFX_ATOMIC(unsigned char)    status;
+	GFX_ATOMIC(size_t)           pending;  /* Number of queued tasks */
+	GFX_ATOMIC(size_t)           sleepers; /* Number of threads waiting for a task */
+	GFX_ATOMIC(size_t)           flushers; /* Number of threads waiting for a flush */
 
-	GFX_ThreadList*    threads; /* All associated threads */
-	GFX_ThreadList*    deads;   /* Terminated threads */
+	GFX_ThreadList*              threads;  /* All associated threads */
+	GFX_ThreadList*              deads;    /* Terminated threads */
+	GFX_ATOMIC(GFX_WorkerList*)  workers;  /* All worker deques, including those of terminated threads */
+	GFX_PlatformKey              worker;   /* Worker of the calling thread */
 
-	GFX_PlatformMutex  mutex;
-	GFX_PlatformCond   assign;  /* Condition that waits for a task */
-	GFX_PlatformCond   flush;   /* Condition that waits for a flush to finish */
+	GFX_PlatformMutex            queue;    /* Guards the injection queue */
+	GFXDeque                     injected[GFX_INT_POOL_BANDS]; /* Tasks pushed from outside the pool, stores GFX_Task */
+	GFX_ATOMIC(size_t)           numInjected[GFX_INT_POOL_BANDS];
+
+	GFX_PlatformMutex            mutex;
+	GFX_PlatformCond             assign;   /* Condition that waits for a task */
+	GFX_PlatformCond             flush;    /* Condition that waits for a flush to finish */
 
 } GFX_Pool;
 
@@ -94,90 +175,419 @@ static void _gfx_thread_list_join(
 }
 
 /******************************************************/
-static int _gfx_thread_pool_push(
+static inline GFX_Worker* _gfx_worker_list_get(
 
-		GFX_Pool*  pool,
-		GFX_Task   task)
+		GFX_WorkerList*  list,
+		unsigned int     index)
 {
-	/* Insert the new element */
-	size_t elem = gfx_vector_get_size(&pool->tasks);
+	return ((GFX_Worker*)(list + 1)) + index;
+}
 
-	GFX_Task* et = gfx_vector_insert(
-		&pool->tasks,
-		&task,
-		pool->tasks.end
-	);
+/******************************************************/
+static GFX_TaskArray* _gfx_task_array_create(
 
-	if(et == pool->tasks.end) return 0;
+		int64_t size)
+{
+	GFX_TaskArray* arr = malloc(
+		sizeof(GFX_TaskArray) +
+		sizeof(GFX_Task) * size);
 
-	/* Correct heap again */
-	while(elem > 0)
+	if(arr)
 	{
-		/* Get parent and compare */
-		size_t parent = (elem - 1) >> 1;
-		GFX_Task* pt = gfx_vector_at(&pool->tasks, parent);
+		arr->prev = NULL;
+		arr->mask = size - 1;
+	}
 
-		if(pt->priority <= et->priority)
-			break;
+	return arr;
+}
+
+/******************************************************/
+static int _gfx_task_deque_init(
+
+		GFX_TaskDeque* deque)
+{
+	deque->top = 0;
+	deque->bottom = 0;
+	deque->array = _gfx_task_array_create(GFX_INT_POOL_DEQUE_SIZE);
+
+	return deque->array != NULL;
+}
+
+/******************************************************/
+static void _gfx_task_deque_clear(
+
+		GFX_TaskDeque* deque)
+{
+	/* Free all retired arrays as well */
+	while(deque->array)
+	{
+		GFX_TaskArray* prev = deque->array->prev;
+		free(deque->array);
+
+		deque->array = prev;
+	}
+}
+
+/******************************************************/
+static int _gfx_task_deque_push(
+
+		GFX_TaskDeque*  deque,
+		GFX_Task        task)
+{
+	/* Only ever called by the owning thread */
+	int64_t b = GFX_ATOMIC_LOAD(&deque->bottom, GFX_ATOMIC_RELAXED);
+	int64_t t = GFX_ATOMIC_LOAD(&deque->top, GFX_ATOMIC_ACQUIRE);
+	GFX_TaskArray* arr = GFX_ATOMIC_LOAD(&deque->array, GFX_ATOMIC_RELAXED);
+
+	if(b - t > arr->mask)
+	{
+		/* Grow the array, keep the old one alive for stealing threads */
+		GFX_TaskArray* grown = _gfx_task_array_create((arr->mask + 1) << 1);
+		if(!grown) return 0;
+
+		int64_t i;
+		for(i = t; i < b; ++i)
+			grown->tasks[i & grown->mask] = arr->tasks[i & arr->mask];
+
+		grown->prev = arr;
+		GFX_ATOMIC_STORE(&deque->array, grown, GFX_ATOMIC_RELEASE);
+
+		arr = grown;
+	}
+
+	arr->tasks[b & arr->mask] = task;
 
-		/* Swap */
-		task = *pt;
-		*pt = *et;
-		*et = task;
+	GFX_ATOMIC_FENCE(GFX_ATOMIC_RELEASE);
+	GFX_ATOMIC_STORE(&deque->bottom, b + 1, GFX_ATOMIC_RELAXED);
 
-		elem = parent;
+	return 1;
+}
+
+/******************************************************/
+static int _gfx_task_deque_pop(
+
+		GFX_TaskDeque*  deque,
+		GFX_Task*       task)
+{
+	/* Only ever called by the owning thread */
+	/* Only the owner grows the deque, so skip the fence when it is empty */
+	int64_t b = GFX_ATOMIC_LOAD(&deque->bottom, GFX_ATOMIC_RELAXED) - 1;
+	if(b < GFX_ATOMIC_LOAD(&deque->top, GFX_ATOMIC_RELAXED))
+		return 0;
+
+	GFX_TaskArray* arr = GFX_ATOMIC_LOAD(&deque->array, GFX_ATOMIC_RELAXED);
+
+	GFX_ATOMIC_STORE(&deque->bottom, b, GFX_ATOMIC_RELAXED);
+	GFX_ATOMIC_FENCE(GFX_ATOMIC_SEQ_CST);
+
+	int64_t t = GFX_ATOMIC_LOAD(&deque->top, GFX_ATOMIC_RELAXED);
+
+	/* Empty deque */
+	if(t > b)
+	{
+		GFX_ATOMIC_STORE(&deque->bottom, b + 1, GFX_ATOMIC_RELAXED);
+		return 0;
+	}
+
+	*task = arr->tasks[b & arr->mask];
+
+	/* Last task, race against stealing threads */
+	if(t == b)
+	{
+		int won = GFX_ATOMIC_CAS(&deque->top, &t, t + 1);
+		GFX_ATOMIC_STORE(&deque->bottom, b + 1, GFX_ATOMIC_RELAXED);
+
+		return won;
 	}
 
 	return 1;
 }
 
 /******************************************************/
-static GFX_Task _gfx_thread_pool_pop(
+static int _gfx_task_deque_steal(
+
+		GFX_TaskDeque*  deque,
+		GFX_Task*       task)
+{
+	/* Missing a task that was just pushed is fine, the thief tries again */
+	int64_t t = GFX_ATOMIC_LOAD(&deque->top, GFX_ATOMIC_ACQUIRE);
+	if(t >= GFX_ATOMIC_LOAD(&deque->bottom, GFX_ATOMIC_RELAXED))
+		return 0;
+
+	GFX_ATOMIC_FENCE(GFX_ATOMIC_SEQ_CST);
+	int64_t b = GFX_ATOMIC_LOAD(&deque->bottom, GFX_ATOMIC_ACQUIRE);
+
+	if(t >= b) return 0;
+
+	/* Read the task before claiming it */
+	GFX_TaskArray* arr = GFX_ATOMIC_LOAD(&deque->array, GFX_ATOMIC_ACQUIRE);
+	*task = arr->tasks[t & arr->mask];
+
+	return GFX_ATOMIC_CAS(&deque->top, &t, t + 1);
+}
+
+/******************************************************/
+static inline unsigned int _gfx_thread_pool_get_band(
+
+		signed char priority)
+{
+	return (unsigned int)((int)priority - SCHAR_MIN) >> GFX_INT_POOL_BAND_SHIFT;
+}
+
+/******************************************************/
+static int _gfx_thread_pool_pop_injected(
+
+		GFX_Pool*     pool,
+		unsigned int  band,
+		GFX_Task*     task)
+{
+	/* Avoid locking if nothing was injected */
+	if(!GFX_ATOMIC_LOAD(pool->numInjected + band, GFX_ATOMIC_RELAXED))
+		return 0;
+
+	int found = 0;
+	_gfx_platform_mutex_lock(&pool->queue);
+
+	GFXDeque* queue = pool->injected + band;
+	if(queue->begin != queue->end)
+	{
+		*task = *(GFX_Task*)queue->begin;
+		gfx_deque_pop_begin(queue);
+
+		GFX_ATOMIC_SUB(pool->numInjected + band, 1);
+		found = 1;
+	}
+
+	_gfx_platform_mutex_unlock(&pool->queue);
+
+	return found;
+}
+
+/******************************************************/
+static int _gfx_thread_pool_steal(
+
+		GFX_Pool*     pool,
+		GFX_Worker*   worker,
+		unsigned int  band,
+		GFX_Task*     task)
+{
+	/* Try to steal from any other worker */
+	GFX_WorkerList* list =
+		GFX_ATOMIC_LOAD(&pool->workers, GFX_ATOMIC_ACQUIRE);
+
+	while(list)
+	{
+		unsigned int w;
+		for(w = 0; w < list->size; ++w)
+		{
+			GFX_Worker* victim = _gfx_worker_list_get(list, w);
+
+			if(
+				victim != worker &&
+				_gfx_task_deque_steal(victim->deques + band, task))
+			{
+				return 1;
+			}
+		}
+
+		list = list->next;
+	}
+
+	return 0;
+}
+
+/******************************************************/
+static void _gfx_thread_pool_unqueue(
 
 		GFX_Pool* pool)
 {
-	GFX_Task* et = pool->tasks.begin;
-	GFX_Task ret = *et;
+	/* Tell flushing threads that everything is flushed */
+	if(
+		!GFX_ATOMIC_SUB(&pool->pending, 1) &&
+		GFX_ATOMIC_LOAD(&pool->flushers, GFX_ATOMIC_SEQ_CST))
+	{
+		_gfx_platform_mutex_lock(&pool->mutex);
+		_gfx_platform_cond_broadcast(&pool->flush);
+		_gfx_platform_mutex_unlock(&pool->mutex);
+	}
+}
 
-	/* Override root and remove element */
-	size_t size = gfx_vector_get_size(&pool->tasks) - 1;
+/******************************************************/
+static int _gfx_thread_pool_take(
 
-	*et = *(GFX_Task*)gfx_vector_at(&pool->tasks, size);
-	gfx_vector_erase_at(&pool->tasks, size);
+		GFX_Pool*    pool,
+		GFX_Worker*  worker,
+		GFX_Task*    task)
+{
+	if(!GFX_ATOMIC_LOAD(&pool->pending, GFX_ATOMIC_SEQ_CST))
+		return 0;
+
+	/* Search for a task per band, in order of priority */
+	/* First our own deque, then the injected tasks, then steal */
+	unsigned int b;
+	for(b = 0; b < GFX_INT_POOL_BANDS; ++b)
+	{
+		if(
+			(worker && _gfx_task_deque_pop(worker->deques + b, task)) ||
+			_gfx_thread_pool_pop_injected(pool, b, task) ||
+			_gfx_thread_pool_steal(pool, worker, b, task))
+		{
+			break;
+		}
+	}
+
+	if(b >= GFX_INT_POOL_BANDS)
+		return 0;
 
-	/* Heapify the root */
-	size_t elem = 0;
+	_gfx_thread_pool_unqueue(pool);
+
+	return 1;
+}
+
+/******************************************************/
+static int _gfx_thread_pool_wait(
+
+		GFX_Pool*        pool,
+		GFX_ThreadList*  node)
+{
+	int alive = 1;
+
+	/* Wait until there is a task to perform */
+	_gfx_platform_mutex_lock(&pool->mutex);
+	GFX_ATOMIC_ADD(&pool->sleepers, 1);
 
 	while(1)
 	{
-		GFX_Task* bt = et;
-		size_t b = elem;
+		if(
+			!node->alive ||
+			pool->status == GFX_INT_POOL_TERMINATE)
+		{
+			alive = 0;
+			break;
+		}
 
-		/* Get child with largest priority */
-		size_t l = (elem << 1) + 1;
-		size_t r = (elem << 1) + 2;
+		if(
+			pool->status == GFX_INT_POOL_RESUMED &&
+			GFX_ATOMIC_LOAD(&pool->pending, GFX_ATOMIC_SEQ_CST))
+		{
+			break;
+		}
 
-		GFX_Task* lt = gfx_vector_at(&pool->tasks, l);
-		GFX_Task* rt = gfx_vector_at(&pool->tasks, r);
+		_gfx_platform_cond_wait(&pool->assign, &pool->mutex);
+	}
 
-		if(l < size && lt->priority < bt->priority)
-			bt = lt, b = l;
-		if(r < size && rt->priority < bt->priority)
-			bt = rt, b = r;
+	GFX_ATOMIC_SUB(&pool->sleepers, 1);
+	_gfx_platform_mutex_unlock(&pool->mutex);
 
-		if(b == elem)
-			break;
+	return alive;
+}
+
+/******************************************************/
+static int _gfx_thread_pool_push(
+
+		GFX_Pool*    pool,
+		GFX_Task     task,
+		signed char  priority)
+{
+	unsigned int band = _gfx_thread_pool_get_band(priority);
+
+	/* Count it before publishing, so it cannot be taken before counted */
+	GFX_ATOMIC_ADD(&pool->pending, 1);
+
+	/* Push it to the deque of the calling worker */
+	GFX_Worker* worker = _gfx_platform_key_get(pool->worker);
+	int success;
+
+	if(worker)
+		success = _gfx_task_deque_push(worker->deques + band, task);
+
+	/* Or inject it if not called from within the pool */
+	else
+	{
+		_gfx_platform_mutex_lock(&pool->queue);
 
-		/* Swap */
-		GFX_Task temp = *bt;
-		*bt = *et;
-		*et = temp;
+		GFXDeque* queue = pool->injected + band;
+		success = gfx_deque_push_end(queue, &task) != queue->end;
 
-		elem = b;
-		et = bt;
+		if(success) GFX_ATOMIC_ADD(pool->numInjected + band, 1);
+
+		_gfx_platform_mutex_unlock(&pool->queue);
+	}
+
+	if(!success)
+	{
+		_gfx_thread_pool_unqueue(pool);
+		return 0;
+	}
+
+	/* Wake up a singular thread if any are waiting */
+	if(GFX_ATOMIC_LOAD(&pool->sleepers, GFX_ATOMIC_SEQ_CST))
+	{
+		_gfx_platform_mutex_lock(&pool->mutex);
+		_gfx_platform_cond_signal(&pool->assign);
+		_gfx_platform_mutex_unlock(&pool->mutex);
+	}
+
+	return 1;
+}
+
+/******************************************************/
+static void _gfx_thread_pool_group_finish(
+
+		GFX_Group* group)
+{
+	/* Decrement without locking unless this is the last task */
+	size_t pending = GFX_ATOMIC_LOAD(&group->pending, GFX_ATOMIC_SEQ_CST);
+	while(pending > 1)
+		if(GFX_ATOMIC_CAS(&group->pending, &pending, pending - 1))
+			return;
+
+	/* The last decrement happens while holding the mutex */
+	/* Waiting threads lock it after seeing zero, so the group stays alive */
+	/* until the mutex is unlocked, after which it is not touched again */
+	_gfx_platform_mutex_lock(&group->mutex);
+
+	if(GFX_ATOMIC_SUB(&group->pending, 1))
+	{
+		/* A new task was pushed in the meantime */
+		_gfx_platform_mutex_unlock(&group->mutex);
+		return;
+	}
+
+	/* Take all deferred tasks and wake up waiting threads */
+	GFX_Pool* pool = (GFX_Pool*)group->group.pool;
+	GFXVector deferred = group->deferred;
+	gfx_vector_init(&group->deferred, sizeof(GFX_Deferred));
+
+	_gfx_platform_cond_broadcast(&group->done);
+
+	_gfx_platform_mutex_unlock(&group->mutex);
+
+	/* Push all deferred tasks */
+	/* If pushing fails, just perform it right here */
+	GFX_Deferred* def;
+	for(
+		def = deferred.begin;
+		def != deferred.end;
+		def = gfx_vector_next(&deferred, def))
+	{
+		if(!_gfx_thread_pool_push(pool, def->task, def->priority))
+		{
+			def->task.task(def->task.data);
+			if(def->task.group) _gfx_thread_pool_group_finish(def->task.group);
+		}
 	}
 
-	return ret;
+	gfx_vector_clear(&deferred);
+}
+
+/******************************************************/
+static inline void _gfx_thread_pool_run(
+
+		GFX_Task task)
+{
+	task.task(task.data);
+	if(task.group) _gfx_thread_pool_group_finish(task.group);
 }
 
 /******************************************************/
@@ -185,50 +595,36 @@ static unsigned int _gfx_thread_addr(
 
 		void* arg)
 {
-	GFX_ThreadList* node = (GFX_ThreadList*)arg;
-	GFX_Pool* pool = node->pool;
+	GFX_Worker* worker = (GFX_Worker*)arg;
+	GFX_ThreadList* node = worker->node;
+	GFX_Pool* pool = worker->pool;
 
 	/* Initialize */
+	_gfx_platform_key_set(pool->worker, worker);
 	arg = NULL;
 
 	if(pool->pool.init)
 		arg = pool->pool.init(node->arg);
 
 	/* Run as long as not terminating */
-	_gfx_platform_mutex_lock(&pool->mutex);
-
-	while(
-		node->alive &&
-		pool->status != GFX_INT_POOL_TERMINATE)
+	while(1)
 	{
+		GFX_Task task;
+
 		/* If allowed and available, perform a task */
 		if(
-			pool->status == GFX_INT_POOL_RESUMED &&
-			pool->tasks.begin != pool->tasks.end)
+			GFX_ATOMIC_LOAD(&node->alive, GFX_ATOMIC_RELAXED) &&
+			GFX_ATOMIC_LOAD(&pool->status, GFX_ATOMIC_RELAXED) == GFX_INT_POOL_RESUMED &&
+			_gfx_thread_pool_take(pool, worker, &task))
 		{
-			GFX_Task task = _gfx_thread_pool_pop(pool);
-
-			/* Tell flushing threads that everything is flushed */
-			if(pool->tasks.begin == pool->tasks.end)
-				_gfx_platform_cond_broadcast(&pool->flush);
-
-			/* Unlock during task */
-			_gfx_platform_mutex_unlock(&pool->mutex);
-
-			task.task(task.data);
-
-			_gfx_platform_mutex_lock(&pool->mutex);
+			_gfx_thread_pool_run(task);
 		}
 
 		/* If not, block */
-		else _gfx_platform_cond_wait(
-			&pool->assign,
-			&pool->mutex
-		);
+		else if(!_gfx_thread_pool_wait(pool, node))
+			break;
 	}
 
-	_gfx_platform_mutex_unlock(&pool->mutex);
-
 	/* Terminate */
 	if(pool->pool.terminate)
 		pool->pool.terminate(arg);
@@ -254,35 +650,56 @@ GFXThreadPool* gfx_thread_pool_create(
 		return NULL;
 	}
 
-	/* Create mutex */
-	if(_gfx_platform_mutex_init(&pool->mutex))
+	/* Create worker key */
+	if(_gfx_platform_key_init(&pool->worker))
 	{
-		/* Create condition variable */
-		if(_gfx_platform_cond_init(&pool->assign))
+		/* Create mutexes */
+		if(_gfx_platform_mutex_init(&pool->queue))
 		{
-			if(_gfx_platform_cond_init(&pool->flush))
+			if(_gfx_platform_mutex_init(&pool->mutex))
 			{
-				/* Initialize */
-				pool->status = suspend ?
-					GFX_INT_POOL_SUSPENDED :
-					GFX_INT_POOL_RESUMED;
-
-				pool->pool.size = 0;
-				pool->pool.init = init;
-				pool->pool.terminate = terminate;
-
-				gfx_vector_init(&pool->tasks, sizeof(GFX_Task));
-
-				pool->threads = NULL;
-				pool->deads = NULL;
-
-				return (GFXThreadPool*)pool;
+				/* Create condition variable */
+				if(_gfx_platform_cond_init(&pool->assign))
+				{
+					if(_gfx_platform_cond_init(&pool->flush))
+					{
+						/* Initialize */
+						pool->status = suspend ?
+							GFX_INT_POOL_SUSPENDED :
+							GFX_INT_POOL_RESUMED;
+
+						pool->pool.size = 0;
+						pool->pool.init = init;
+						pool->pool.terminate = terminate;
+
+						pool->pending = 0;
+						pool->sleepers = 0;
+						pool->flushers = 0;
+
+						pool->threads = NULL;
+						pool->deads = NULL;
+						pool->workers = NULL;
+
+						unsigned int b;
+						for(b = 0; b < GFX_INT_POOL_BANDS; ++b)
+						{
+							gfx_deque_init(pool->injected + b, sizeof(GFX_Task));
+							pool->numInjected[b] = 0;
+						}
+
+						return (GFXThreadPool*)pool;
+					}
+
+					_gfx_platform_cond_clear(&pool->assign);
+				}
+
+				_gfx_platform_mutex_clear(&pool->mutex);
 			}
 
-			_gfx_platform_cond_clear(&pool->assign);
+			_gfx_platform_mutex_clear(&pool->queue);
 		}
 
-		_gfx_platform_mutex_clear(&pool->mutex);
+		_gfx_platform_key_clear(pool->worker);
 	}
 
 	/* Nevermind */
@@ -303,7 +720,11 @@ void gfx_thread_pool_free(
 		/* Tell threads to terminate */
 		_gfx_platform_mutex_lock(&internal->mutex);
 
-		internal->status = GFX_INT_POOL_TERMINATE;
+		GFX_ATOMIC_STORE(
+			&internal->status,
+			GFX_INT_POOL_TERMINATE,
+			GFX_ATOMIC_RELAXED);
+
 		_gfx_platform_cond_broadcast(&internal->assign);
 
 		_gfx_platform_mutex_unlock(&internal->mutex);
@@ -332,12 +753,33 @@ void gfx_thread_pool_free(
 			node = next;
 		}
 
+		/* Free all workers */
+		GFX_WorkerList* list = internal->workers;
+
+		while(list)
+		{
+			GFX_WorkerList* next = list->next;
+
+			unsigned int w, b;
+			for(w = 0; w < list->size; ++w)
+				for(b = 0; b < GFX_INT_POOL_BANDS; ++b)
+					_gfx_task_deque_clear(_gfx_worker_list_get(list, w)->deques + b);
+
+			free(list);
+			list = next;
+		}
+
 		/* Clear all the things */
+		_gfx_platform_key_clear(internal->worker);
+		_gfx_platform_mutex_clear(&internal->queue);
 		_gfx_platform_mutex_clear(&internal->mutex);
 		_gfx_platform_cond_clear(&internal->assign);
 		_gfx_platform_cond_clear(&internal->flush);
 
-		gfx_vector_clear(&internal->tasks);
+		unsigned int b;
+		for(b = 0; b < GFX_INT_POOL_BANDS; ++b)
+			gfx_deque_clear(internal->injected + b);
+
 		free(pool);
 	}
 }
@@ -351,7 +793,7 @@ unsigned int gfx_thread_pool_expand(
 {
 	GFX_Pool* internal = (GFX_Pool*)pool;
 
-	/* Allocate new node */
+	/* Allocate new nodes */
 	if(!size || UINT_MAX - size < pool->size)
 		return 0;
 
@@ -362,19 +804,57 @@ unsigned int gfx_thread_pool_expand(
 
 	if(!node) return 0;
 
+	GFX_WorkerList* list = malloc(
+		sizeof(GFX_WorkerList) +
+		sizeof(GFX_Worker) * size
+	);
+
+	if(!list)
+	{
+		free(node);
+		return 0;
+	}
+
 	node->next  = internal->threads;
 	node->pool  = internal;
 	node->alive = 1;
 	node->arg   = arg;
 
+	/* Initialize all workers */
+	unsigned int w, b;
+	for(w = 0; w < size; ++w)
+	{
+		GFX_Worker* worker = _gfx_worker_list_get(list, w);
+		worker->pool = internal;
+		worker->node = node;
+
+		for(b = 0; b < GFX_INT_POOL_BANDS; ++b)
+			if(!_gfx_task_deque_init(worker->deques + b)) break;
+
+		if(b < GFX_INT_POOL_BANDS)
+		{
+			while(b--) _gfx_task_deque_clear(worker->deques + b);
+			break;
+		}
+	}
+
+	/* Make the workers visible to stealing threads */
+	list->next = internal->workers;
+	list->size = w;
+
+	if(w) GFX_ATOMIC_STORE(
+		&internal->workers,
+		list,
+		GFX_ATOMIC_RELEASE);
+
 	/* Initialize all threads */
 	unsigned int s;
-	for(s = 0; s < size; ++s)
+	for(s = 0; s < w; ++s)
 	{
 		if(!_gfx_platform_thread_init(
 			_gfx_thread_list_get(node, s),
 			_gfx_thread_addr,
-			node,
+			_gfx_worker_list_get(list, s),
 			1))
 		{
 			break;
@@ -385,9 +865,12 @@ unsigned int gfx_thread_pool_expand(
 	pool->size += s;
 
 	/* Fail if none managed to initialize */
+	/* The workers stay available to steal from */
 	if(!s)
 	{
+		if(!w) free(list);
 		free(node);
+
 		return 0;
 	}
 
@@ -417,9 +900,8 @@ unsigned int gfx_thread_pool_shrink(
 		/* Tell threads to terminate */
 		_gfx_platform_mutex_lock(&internal->mutex);
 
-		node->alive = 0;
-		if(internal->status == GFX_INT_POOL_RESUMED)
-			_gfx_platform_cond_broadcast(&internal->assign);
+		GFX_ATOMIC_STORE(&node->alive, 0, GFX_ATOMIC_RELAXED);
+		_gfx_platform_cond_broadcast(&internal->assign);
 
 		_gfx_platform_mutex_unlock(&internal->mutex);
 
@@ -452,26 +934,15 @@ int gfx_thread_pool_push(
 		void*              data,
 		signed char        priority)
 {
-	GFX_Pool* internal = (GFX_Pool*)pool;
-
 	/* Create a new task */
 	GFX_Task elem =
 	{
-		.priority = priority,
 		.data = data,
-		.task = task
+		.task = task,
+		.group = NULL
 	};
 
-	/* Push it and wake up a singular thread */
-	_gfx_platform_mutex_lock(&internal->mutex);
-
-	int success = _gfx_thread_pool_push(internal, elem);
-	if(internal->status == GFX_INT_POOL_RESUMED)
-		_gfx_platform_cond_signal(&internal->assign);
-
-	_gfx_platform_mutex_unlock(&internal->mutex);
-
-	return success;
+	return _gfx_thread_pool_push((GFX_Pool*)pool, elem, priority);
 }
 
 /******************************************************/
@@ -484,7 +955,10 @@ void gfx_thread_pool_suspend(
 	/* Tell threads to suspend */
 	_gfx_platform_mutex_lock(&internal->mutex);
 
-	internal->status = GFX_INT_POOL_SUSPENDED;
+	GFX_ATOMIC_STORE(
+		&internal->status,
+		GFX_INT_POOL_SUSPENDED,
+		GFX_ATOMIC_RELAXED);
 
 	_gfx_platform_mutex_unlock(&internal->mutex);
 }
@@ -499,7 +973,11 @@ void gfx_thread_pool_resume(
 	/* Tell threads to resume */
 	_gfx_platform_mutex_lock(&internal->mutex);
 
-	internal->status = GFX_INT_POOL_RESUMED;
+	GFX_ATOMIC_STORE(
+		&internal->status,
+		GFX_INT_POOL_RESUMED,
+		GFX_ATOMIC_RELAXED);
+
 	_gfx_platform_cond_broadcast(&internal->assign);
 
 	_gfx_platform_mutex_unlock(&internal->mutex);
@@ -512,11 +990,184 @@ void gfx_thread_pool_flush(
 {
 	GFX_Pool* internal = (GFX_Pool*)pool;
 
-	/* Wait until task queue is empty */
+	/* Wait until no tasks are queued anymore */
 	_gfx_platform_mutex_lock(&internal->mutex);
+	GFX_ATOMIC_ADD(&internal->flushers, 1);
 
-	while(internal->tasks.begin != internal->tasks.end)
+	while(GFX_ATOMIC_LOAD(&internal->pending, GFX_ATOMIC_SEQ_CST))
 		_gfx_platform_cond_wait(&internal->flush, &internal->mutex);
 
+	GFX_ATOMIC_SUB(&internal->flushers, 1);
+	_gfx_platform_mutex_unlock(&internal->mutex);
+}
+
+/******************************************************/
+GFXThreadPoolGroup* gfx_thread_pool_group_create(
+
+		GFXThreadPool* pool)
+{
+	/* Create a new group */
+	GFX_Group* group = malloc(sizeof(GFX_Group));
+	if(!group)
+	{
+		/* Out of memory error */
+		gfx_errors_output(
+			"[GFX Out Of Memory]: Thread pool group could not be allocated."
+		);
+		return NULL;
+	}
+
+	/* Create mutex */
+	if(_gfx_platform_mutex_init(&group->mutex))
+	{
+		/* Create condition variable */
+		if(_gfx_platform_cond_init(&group->done))
+		{
+			/* Initialize */
+			group->group.pool = pool;
+			group->pending = 0;
+
+			gfx_vector_init(&group->deferred, sizeof(GFX_Deferred));
+
+			return (GFXThreadPoolGroup*)group;
+		}
+
+		_gfx_platform_mutex_clear(&group->mutex);
+	}
+
+	/* Nevermind */
+	free(group);
+
+	return NULL;
+}
+
+/******************************************************/
+void gfx_thread_pool_group_free(
+
+		GFXThreadPoolGroup* group)
+{
+	if(group)
+	{
+		GFX_Group* internal = (GFX_Group*)group;
+
+		/* Make sure the last finishing task released the group */
+		_gfx_platform_mutex_lock(&internal->mutex);
+		_gfx_platform_mutex_unlock(&internal->mutex);
+
+		/* Clear all the things */
+		_gfx_platform_mutex_clear(&internal->mutex);
+		_gfx_platform_cond_clear(&internal->done);
+
+		gfx_vector_clear(&internal->deferred);
+		free(group);
+	}
+}
+
+/******************************************************/
+int gfx_thread_pool_group_push(
+
+		GFXThreadPoolGroup*  group,
+		GFXThreadPoolGroup*  depend,
+		GFXThreadPoolTask    task,
+		void*                data,
+		signed char          priority)
+{
+	GFX_Group* internal = (GFX_Group*)group;
+	GFX_Group* dep = (GFX_Group*)depend;
+
+	/* Create a new task */
+	GFX_Deferred elem =
+	{
+		.task =
+		{
+			.data = data,
+			.task = task,
+			.group = internal
+		},
+		.priority = priority
+	};
+
+	/* Count the task before it can possibly finish */
+	GFX_ATOMIC_ADD(&internal->pending, 1);
+
+	/* Defer it if the dependency is not done yet */
+	if(dep)
+	{
+		_gfx_platform_mutex_lock(&dep->mutex);
+
+		int deferred = 0;
+		int success = 1;
+
+		if(GFX_ATOMIC_LOAD(&dep->pending, GFX_ATOMIC_SEQ_CST))
+		{
+			deferred = 1;
+			success = gfx_vector_insert(
+				&dep->deferred,
+				&elem,
+				dep->deferred.end) != dep->deferred.end;
+		}
+
+		_gfx_platform_mutex_unlock(&dep->mutex);
+
+		if(deferred)
+		{
+			if(!success) _gfx_thread_pool_group_finish(internal);
+			return success;
+		}
+	}
+
+	/* Otherwise push it right away */
+	if(!_gfx_thread_pool_push(
+		(GFX_Pool*)group->pool,
+		elem.task,
+		priority))
+	{
+		_gfx_thread_pool_group_finish(internal);
+		return 0;
+	}
+
+	return 1;
+}
+
+/******************************************************/
+void gfx_thread_pool_group_wait(
+
+		GFXThreadPoolGroup* group)
+{
+	GFX_Group* internal = (GFX_Group*)group;
+	GFX_Pool* pool = (GFX_Pool*)group->pool;
+
+	GFX_Worker* worker = _gfx_platform_key_get(pool->worker);
+
+	while(GFX_ATOMIC_LOAD(&internal->pending, GFX_ATOMIC_SEQ_CST))
+	{
+		GFX_Task task;
+
+		/* Help out while waiting */
+		if(
+			GFX_ATOMIC_LOAD(&pool->status, GFX_ATOMIC_RELAXED) == GFX_INT_POOL_RESUMED &&
+			_gfx_thread_pool_take(pool, worker, &task))
+		{
+			_gfx_thread_pool_run(task);
+		}
+
+		/* Nothing to do, block for a while */
+		/* Don't block indefinitely as new tasks might become available */
+		else
+		{
+			_gfx_platform_mutex_lock(&internal->mutex);
+
+			if(GFX_ATOMIC_LOAD(&internal->pending, GFX_ATOMIC_SEQ_CST)) _gfx_platform_cond_wait_time(
+				&internal->done,
+				&internal->mutex,
+				GFX_INT_POOL_HELP_WAIT);
+
+			_gfx_platform_mutex_unlock(&internal->mutex);
+		}
+	}
+
+	/* Zero is stored while the mutex is locked, */
+	/* wait for the finishing task to let go of the group */
+	_gfx_platform_mutex_lock(&internal->mutex);
 	_gfx_platform_mutex_unlock(&internal->mutex);
 }
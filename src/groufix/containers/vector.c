@@ -42,7 +42,12 @@ static int _gfx_vector_realloc(
 		size_t      capacity)
 {
 	/* Make sure to check if it worked */
-	void* new = realloc(vector->begin, capacity);
+	void* new = gfx_allocator_realloc(
+		vector->allocator,
+		vector->begin,
+		vector->capacity,
+		capacity);
+
 	if(!new)
 	{
 		/* Out of memory error */
@@ -119,7 +124,7 @@ void gfx_vector_free(
 {
 	if(vector)
 	{
-		free(vector->begin);
+		gfx_vector_clear(vector);
 		free(vector);
 	}
 }
@@ -134,6 +139,17 @@ void gfx_vector_init(
 	vector->elementSize = elementSize;
 }
 
+/******************************************************/
+void gfx_vector_init_with_allocator(
+
+		GFXVector*     vector,
+		size_t         elementSize,
+		GFXAllocator*  allocator)
+{
+	gfx_vector_init(vector, elementSize);
+	vector->allocator = allocator;
+}
+
 /******************************************************/
 void gfx_vector_init_from_buffer(
 
@@ -173,7 +189,12 @@ void gfx_vector_clear(
 
 		GFXVector* vector)
 {
-	free(vector->begin);
+	gfx_allocator_realloc(
+		vector->allocator,
+		vector->begin,
+		vector->capacity,
+		0);
+
 	vector->begin = NULL;
 	vector->end = NULL;
 
@@ -244,23 +265,30 @@ GFXVectorIterator gfx_vector_insert_range(
 	size_t newSize = oldSize + diff;
 	size_t mov = GFX_PTR_DIFF(pos, vector->end);
 
-	/* Copy to a temporary buffer */
+	/* Copy to a temporary buffer if the range overlaps the vector itself */
 	void* buff = NULL;
 
-	if(start)
+	if(
+		start &&
+		GFX_PTR_DIFF(start, vector->end) > 0 &&
+		GFX_PTR_DIFF(vector->begin, GFX_PTR_ADD_BYTES(start, diff)) > 0)
 	{
-		buff = malloc(diff);
+		buff = gfx_allocator_realloc(vector->allocator, NULL, 0, diff);
 		if(!buff) return vector->end;
 
 		memcpy(buff, start, diff);
 	}
 
+	else buff = start;
+
 	/* Reallocate if necessary */
 	if(newSize > vector->capacity)
 	{
 		if(!_gfx_vector_realloc(vector, newSize, _gfx_vector_get_max_capacity(newSize)))
 		{
-			free(buff);
+			if(buff != start) gfx_allocator_realloc(
+				vector->allocator, buff, diff, 0);
+
 			return vector->end;
 		}
 
@@ -274,7 +302,8 @@ GFXVectorIterator gfx_vector_insert_range(
 	if(mov) memmove(GFX_PTR_ADD_BYTES(pos, diff), pos, mov);
 	if(buff) memcpy(pos, buff, diff);
 
-	free(buff);
+	if(buff != start) gfx_allocator_realloc(
+		vector->allocator, buff, diff, 0);
 
 	return pos;
 }
@@ -12,8 +12,12 @@
  *
  */
 
-#include "groufix/core/renderer.h"
+#include "groufix/containers/parallel.h"
+#include "groufix/containers/slot_map.h"
+#include "groufix/core/utils.h"
+#include "groufix/math/simd.h"
 
+#include <math.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,6 +26,27 @@
 /* Internal bucket flags */
 #define GFX_INT_BUCKET_PROCESS_UNITS  0x01
 #define GFX_INT_BUCKET_SORT           0x02
+#define GFX_INT_BUCKET_MERGE          0x04
+
+/* Number of 8 bit digits in the program/vao and depth sort keys */
+#define GFX_INT_BUCKET_KEY_DIGITS     8
+#define GFX_INT_BUCKET_DEPTH_DIGITS   4
+
+/* Merge dirty units unless more than 1/ratio of all visible units are dirty */
+#define GFX_INT_BUCKET_MERGE_RATIO    8
+
+/* Minimum number of units to sort or cull in parallel */
+#define GFX_INT_BUCKET_PARALLEL_MIN   16384
+
+/* Maximum number of chunks and minimum number of units per chunk of a parallel sort */
+#define GFX_INT_BUCKET_SORT_CHUNKS    16
+#define GFX_INT_BUCKET_SORT_GRAIN     4096
+
+/* Minimum number of units to cull per task */
+#define GFX_INT_BUCKET_CULL_GRAIN     4096
+
+/* Minimum size of the per-frame arena in bytes */
+#define GFX_INT_BUCKET_FRAME_SIZE     1024
 
 /* Internal unit state and action (for processing) */
 #define GFX_INT_UNIT_VISIBLE     (1 << (GFX_UNIT_STATE_MAX_BITS +1))
@@ -39,6 +64,10 @@
 
 #define GFX_INT_DRAW_COUNT                       6
 
+/* Internal recorded state changes */
+#define GFX_INT_RECORD_LAYOUT  0x01
+#define GFX_INT_RECORD_MAP     0x02
+
 
 /******************************************************/
 /** Internal draw function */
@@ -48,7 +77,7 @@ typedef void (*GFX_DrawFunc)(
 		size_t,
 		unsigned int,
 		unsigned int,
-		unsigned int,
+		size_t,
 		GFX_CONT_ARG);
 
 
@@ -61,13 +90,26 @@ typedef struct GFX_Bucket
 	/* Hidden data */
 	unsigned char      flags;
 	GFXVectorIterator  visible;      /* Everything after is not visible in units */
+	GFXBucketStats     stats;        /* Statistics of last process */
 
-	GFXVector          refs;         /* Stores GFX_Ref */
-	GFXVector          sources;      /* Stores GFX_Source */
+	GFXSlotMap         refs;         /* Stores GFX_Ref, handles are GFXBucketUnit */
+	GFXSlotMap         sources;      /* Stores GFX_Source, handles are GFXBucketSource */
 	GFXVector          units;        /* Stores GFX_Unit */
+	GFXVector          sortBuffer;   /* Stores GFX_Unit, scratch buffer for sorting */
+	GFXVector          dirty;        /* Stores GFXBucketUnit, handles of units to merge into sorted units */
+	GFXArena           frame;        /* Backs dirty, reset after every preprocess */
+
+	GFXVector          runs;         /* Stores size_t, number of units per draw call */
+	GFXVector          commands;     /* Stores GFX_Command, indirect commands of batched units */
+	GFXBuffer*         indirect;     /* Buffer to upload commands to */
 
-	GFXDeque           emptyRefs;    /* Stores GFXBucketUnit, empty reference IDs */
-	GFXDeque           emptySources; /* Stores GFXBucketSource, empty source IDs */
+	GFXVector          records;      /* Stores GFX_Record, recorded visible units */
+	unsigned char      recorded;     /* Non-zero if records is up to date */
+	unsigned char      prepared;     /* Non-zero if preprocessed and recorded ahead of processing */
+
+	unsigned char      cull;         /* Non-zero if units are culled against the frustum */
+	size_t             pending;      /* Number of references of which the program map is not ready */
+	float              frustum[4][8];/* x, y, z and w of all frustum planes, padded to 8 */
 
 } GFX_Bucket;
 
@@ -75,17 +117,22 @@ typedef struct GFX_Bucket
 /** Internal reference of a unit */
 typedef struct GFX_Ref
 {
-	unsigned int           unit; /* units[unit - 1] = unit, 0 when empty */
-	unsigned char          type; /* Drawing type */
+	unsigned int           unit;    /* units[unit - 1] = unit */
+	unsigned char          type;    /* Drawing type */
+	unsigned char          visible; /* Visibility set by the user, the unit can still be culled */
+	unsigned char          pending; /* Non-zero if the program map is not ready, never visible */
+	unsigned char          failed;  /* Non-zero if the program map failed to link, never visible */
 
-	GFXBucketSource        src;  /* Source of the bucket to use (ID - 1), sources[src] = source */
+	unsigned int           src;  /* Source of the bucket to use, sources.data[src] = source */
 	const GFXPropertyMap*  map;
 	unsigned int           copy; /* Copy of the property map to use */
 
 	size_t                 instances;
 	unsigned int           instanceBase;
 	unsigned int           vertexBase;
-	unsigned int           indexBase;
+	size_t                 indexBase; /* In bytes */
+
+	float                  bounds[4]; /* Bounding sphere (center and radius), radius < 0 is never culled */
 
 } GFX_Ref;
 
@@ -93,24 +140,109 @@ typedef struct GFX_Ref
 /** Internal source */
 typedef struct GFX_Source
 {
-	GFXVertexLayout*  layout;  /* NULL when empty */
+	GFXVertexLayout*  layout;
 	unsigned char     index;   /* Source index at the layout */
 	GFXVertexSource   source;  /* If indexed, source.indexed will be GFX_INT_DRAW_COUNT, 0 otherwise */
+	unsigned int      vertexBase;
 
 } GFX_Source;
 
 
+/** Internal indirect draw command */
+typedef union GFX_Command
+{
+	/* Non-indexed */
+	struct
+	{
+		GLuint  count;
+		GLuint  instances;
+		GLuint  first;
+		GLuint  instanceBase;
+
+	} arrays;
+
+	/* Indexed */
+	struct
+	{
+		GLuint  count;
+		GLuint  instances;
+		GLuint  first;        /* In indices, not bytes */
+		GLint   vertexBase;
+		GLuint  instanceBase;
+
+	} elements;
+
+} GFX_Command;
+
+
 /** Internal render unit (actually sorted on) */
 typedef struct GFX_Unit
 {
-	GFXBucketUnit  ref;      /* Reference, units[refs[ref] - 1] = this (const, equal to ID - 1) */
+	unsigned int   ref;      /* Reference, units[refs.data[ref] - 1] = this */
 	GFXUnitState   state;    /* Combination of unit state, action and manual state */
 	GLuint         program;  /* Program or program map to sort on */
 	GLuint         vao;      /* layout to sort on */
+	uint32_t       depth;    /* Depth to sort on, as ordered integer */
 
 } GFX_Unit;
 
 
+/** Internal sort key description */
+typedef struct GFX_SortKey
+{
+	GFXUnitState   mask;     /* Manual state bits to sort on */
+	unsigned char  bits;     /* Number of manual state bits */
+	unsigned char  depth;    /* Non-zero to sort on depth instead of program/vao */
+	uint32_t       flip;     /* Mask to apply to depth, all bits to sort descending */
+
+} GFX_SortKey;
+
+
+/** Internal recorded unit, everything to bind and draw it */
+typedef struct GFX_Record
+{
+	unsigned char          bind;      /* Combination of GFX_INT_RECORD_* */
+	unsigned char          func;      /* Draw function to use */
+	GLuint                 vao;
+	const GFXPropertyMap*  map;
+	unsigned int           copy;
+
+	GFXVertexSource        source;
+	size_t                 instances;
+	unsigned int           instanceBase;
+	unsigned int           vertexBase;
+	size_t                 indexBase; /* In bytes */
+
+} GFX_Record;
+
+
+/** Internal parallel radix sort data */
+typedef struct GFX_RadixData
+{
+	const GFX_SortKey*  key;
+	GFX_Unit*           src;
+	GFX_Unit*           dst;
+	size_t              num;
+	size_t              chunks;  /* Number of chunks the units are split in */
+	unsigned char       digits;  /* Number of digits of the composite key */
+	unsigned char       digit;   /* Digit currently scattered */
+	unsigned char       all;     /* Non-zero to count all digits at once */
+	size_t*             hist;    /* Histogram per chunk per digit, turned into offsets */
+
+} GFX_RadixData;
+
+
+/** Internal culling task data */
+typedef struct GFX_CullData
+{
+	GFX_Bucket*  bucket;
+	GFX_ATOMIC(size_t)  visible;  /* Number of visible units */
+	GFX_ATOMIC(size_t)  culled;   /* Number of units hidden by culling */
+	GFX_ATOMIC(int)     changed;  /* Non-zero if any visibility changed */
+
+} GFX_CullData;
+
+
 /******************************************************/
 static void _gfx_draw(
 
@@ -118,7 +250,7 @@ static void _gfx_draw(
 		size_t                  inst,
 		unsigned int            instBase,
 		unsigned int            vertBase,
-		unsigned int            indBase,
+		size_t                  indBase,
 		GFX_CONT_ARG)
 {
 	GFX_REND_GET.DrawArrays(
@@ -135,7 +267,7 @@ static void _gfx_draw_instanced(
 		size_t                  inst,
 		unsigned int            instBase,
 		unsigned int            vertBase,
-		unsigned int            indBase,
+		size_t                  indBase,
 		GFX_CONT_ARG)
 {
 	GFX_REND_GET.DrawArraysInstanced(
@@ -153,7 +285,7 @@ static void _gfx_draw_instanced_base(
 		size_t                  inst,
 		unsigned int            instBase,
 		unsigned int            vertBase,
-		unsigned int            indBase,
+		size_t                  indBase,
 		GFX_CONT_ARG)
 {
 	GFX_REND_GET.DrawArraysInstancedBaseInstance(
@@ -172,7 +304,7 @@ static void _gfx_draw_indexed(
 		size_t                  inst,
 		unsigned int            instBase,
 		unsigned int            vertBase,
-		unsigned int            indBase,
+		size_t                  indBase,
 		GFX_CONT_ARG)
 {
 	GFX_REND_GET.DrawElements(
@@ -190,7 +322,7 @@ static void _gfx_draw_indexed_instanced(
 		size_t                  inst,
 		unsigned int            instBase,
 		unsigned int            vertBase,
-		unsigned int            indBase,
+		size_t                  indBase,
 		GFX_CONT_ARG)
 {
 	GFX_REND_GET.DrawElementsInstanced(
@@ -209,7 +341,7 @@ static void _gfx_draw_indexed_instanced_base(
 		size_t                  inst,
 		unsigned int            instBase,
 		unsigned int            vertBase,
-		unsigned int            indBase,
+		size_t                  indBase,
 		GFX_CONT_ARG)
 {
 	GFX_REND_GET.DrawElementsInstancedBaseInstance(
@@ -229,7 +361,7 @@ static void _gfx_draw_indexed_vertex_base(
 		size_t                  inst,
 		unsigned int            instBase,
 		unsigned int            vertBase,
-		unsigned int            indBase,
+		size_t                  indBase,
 		GFX_CONT_ARG)
 {
 	GFX_REND_GET.DrawElementsBaseVertex(
@@ -248,7 +380,7 @@ static void _gfx_draw_indexed_instanced_vertex_base(
 		size_t                  inst,
 		unsigned int            instBase,
 		unsigned int            vertBase,
-		unsigned int            indBase,
+		size_t                  indBase,
 		GFX_CONT_ARG)
 {
 	GFX_REND_GET.DrawElementsInstancedBaseVertex(
@@ -268,7 +400,7 @@ static void _gfx_draw_indexed_instanced_base_vertex_base(
 		size_t                  inst,
 		unsigned int            instBase,
 		unsigned int            vertBase,
-		unsigned int            indBase,
+		size_t                  indBase,
 		GFX_CONT_ARG)
 {
 	GFX_REND_GET.DrawElementsInstancedBaseVertexBaseInstance(
@@ -283,47 +415,85 @@ static void _gfx_draw_indexed_instanced_base_vertex_base(
 }
 
 /******************************************************/
-static void _gfx_bucket_invoke(
+/** Jump table of all draw functions, indexed by type + indexed */
+static const GFX_DrawFunc _gfx_draw_funcs[] =
+{
+	_gfx_draw,
+	_gfx_draw_instanced,
+	_gfx_draw_instanced_base,
+	_gfx_draw,
+	_gfx_draw_instanced,
+	_gfx_draw_instanced_base,
+	_gfx_draw_indexed,
+	_gfx_draw_indexed_instanced,
+	_gfx_draw_indexed_instanced_base,
+	_gfx_draw_indexed_vertex_base,
+	_gfx_draw_indexed_instanced_vertex_base,
+	_gfx_draw_indexed_instanced_base_vertex_base
+};
+
+/******************************************************/
+static void _gfx_bucket_bind(
 
 		const GFX_Ref*     ref,
 		const GFX_Source*  source,
 		const GFX_Unit*    unit,
+		const GFX_Ref*     prevRef,
+		const GFX_Unit*    prevUnit,
+		GFXBucketStats*    stats,
 		GFX_CONT_ARG)
 {
 	/* Bind VAO & Tessellation vertices */
-	_gfx_gl_vertex_layout_bind(
-		unit->vao,
-		GFX_CONT_AS_ARG);
+	/* Skip whatever is equal to the previous unit */
+	if(prevUnit && prevUnit->vao == unit->vao)
+		++stats->layoutSkips;
+
+	else
+	{
+		_gfx_gl_vertex_layout_bind(
+			unit->vao,
+			GFX_CONT_AS_ARG);
+
+		++stats->layoutBinds;
+	}
 
 	_gfx_states_set_patch_vertices(
 		source->source.patchSize,
 		GFX_CONT_AS_ARG);
 
-	/* Bind shader program */
-	_gfx_property_map_use(
-		ref->map,
-		ref->copy,
-		ref->instanceBase,
-		GFX_CONT_AS_ARG);
+	/* Bind shader program and upload properties */
+	/* The same copy with the same base uploads identical values */
+	if(
+		prevRef &&
+		prevRef->map == ref->map &&
+		prevRef->copy == ref->copy &&
+		prevRef->instanceBase == ref->instanceBase)
+	{
+		++stats->mapSkips;
+	}
 
-	/* Jump table & invoke draw call */
-	static const GFX_DrawFunc jump[] =
+	else
 	{
-		_gfx_draw,
-		_gfx_draw_instanced,
-		_gfx_draw_instanced_base,
-		_gfx_draw,
-		_gfx_draw_instanced,
-		_gfx_draw_instanced_base,
-		_gfx_draw_indexed,
-		_gfx_draw_indexed_instanced,
-		_gfx_draw_indexed_instanced_base,
-		_gfx_draw_indexed_vertex_base,
-		_gfx_draw_indexed_instanced_vertex_base,
-		_gfx_draw_indexed_instanced_base_vertex_base
-	};
+		_gfx_property_map_use(
+			ref->map,
+			ref->copy,
+			ref->instanceBase,
+			GFX_CONT_AS_ARG);
+
+		++stats->mapUses;
+	}
+}
+
+/******************************************************/
+static void _gfx_bucket_draw(
 
-	jump[ref->type + source->source.indexed](
+		const GFX_Ref*     ref,
+		const GFX_Source*  source,
+		GFXBucketStats*    stats,
+		GFX_CONT_ARG)
+{
+	/* Jump table & invoke draw call */
+	_gfx_draw_funcs[ref->type + source->source.indexed](
 		&source->source,
 		ref->instances,
 		ref->instanceBase,
@@ -331,6 +501,36 @@ static void _gfx_bucket_invoke(
 		ref->indexBase,
 		GFX_CONT_AS_ARG
 	);
+
+	++stats->draws;
+}
+
+/******************************************************/
+static void _gfx_bucket_draw_indirect(
+
+		const GFX_Source*  source,
+		const GLvoid*      indirect,
+		size_t             num,
+		GFXBucketStats*    stats,
+		GFX_CONT_ARG)
+{
+	if(source->source.indexed)
+		GFX_REND_GET.MultiDrawElementsIndirect(
+			source->source.primitive,
+			source->source.indexType,
+			indirect,
+			num,
+			sizeof(GFX_Command));
+
+	else
+		GFX_REND_GET.MultiDrawArraysIndirect(
+			source->source.primitive,
+			indirect,
+			num,
+			sizeof(GFX_Command));
+
+	++stats->draws;
+	stats->batched += num;
 }
 
 /******************************************************/
@@ -375,39 +575,17 @@ static void _gfx_bucket_set_draw_type(
 /******************************************************/
 static GFX_Ref* _gfx_bucket_insert_ref(
 
-		GFX_Bucket*   bucket,
-		unsigned int  unitIndex)
+		GFX_Bucket*     bucket,
+		unsigned int    unitIndex,
+		GFXBucketUnit*  handle)
 {
-	GFX_Ref* it;
-
-	if(bucket->emptyRefs.begin != bucket->emptyRefs.end)
-	{
-		/* Replace an empty reference */
-		GFXBucketUnit unit = *(GFXBucketUnit*)bucket->emptyRefs.begin;
-		gfx_deque_pop_begin(&bucket->emptyRefs);
-
-		it = gfx_vector_at(&bucket->refs, unit - 1);
-	}
-	else
-	{
-		/* Check new index for overflow */
-		size_t size = gfx_vector_get_size(&bucket->refs);
-		GFXBucketUnit unit = size + 1;
-
-		if(unit < size)
-		{
-			/* Overflow error */
-			gfx_errors_push(
-				GFX_ERROR_OVERFLOW,
-				"Overflow occurred during unit insertion at a bucket."
-			);
-			return NULL;
-		}
+	/* Insert a new reference at the end */
+	*handle = gfx_slot_map_insert(&bucket->refs, NULL);
+	if(!*handle) return NULL;
 
-		/* Insert a new reference at the end */
-		it = gfx_vector_insert(&bucket->refs, NULL, bucket->refs.end);
-		if(it == bucket->refs.end) return NULL;
-	}
+	GFX_Ref* it = gfx_vector_previous(
+		&bucket->refs.data,
+		bucket->refs.data.end);
 
 	it->unit = unitIndex + 1;
 	return it;
@@ -419,27 +597,15 @@ static void _gfx_bucket_erase_ref(
 		GFX_Bucket*   bucket,
 		unsigned int  index)
 {
-	size_t size = gfx_vector_get_size(&bucket->refs);
-	GFXBucketUnit unit = index + 1;
+	/* The last reference takes its place, so fix its unit */
+	gfx_slot_map_erase_at(&bucket->refs, index);
 
-	if(unit < size)
+	if(index < gfx_slot_map_get_size(&bucket->refs))
 	{
-		/* Save ID and mark as empty */
-		gfx_deque_push_end(&bucket->emptyRefs, &unit);
-		((GFX_Ref*)gfx_vector_at(&bucket->refs, index))->unit = 0;
-	}
-	else
-	{
-		/* Remove last element */
-		gfx_vector_erase_at(&bucket->refs, index);
-		--size;
-	}
+		GFX_Ref* ref = gfx_vector_at(&bucket->refs.data, index);
+		GFX_Unit* unit = gfx_vector_at(&bucket->units, ref->unit - 1);
 
-	/* Clear both deque and vector */
-	if(!size || size == gfx_deque_get_size(&bucket->emptyRefs))
-	{
-		gfx_vector_clear(&bucket->refs);
-		gfx_deque_clear(&bucket->emptyRefs);
+		unit->ref = index;
 	}
 }
 
@@ -460,60 +626,106 @@ static void _gfx_bucket_erase_unit(
 		GFX_Bucket*  bucket,
 		GFX_Unit*    unit)
 {
+	/* Erasing keeps the order of the visible units intact */
 	bucket->flags |= GFX_INT_BUCKET_PROCESS_UNITS;
+	unit->state |= GFX_INT_UNIT_ERASE;
+}
 
-	if(unit->state & GFX_INT_UNIT_VISIBLE)
-		bucket->flags |= GFX_INT_BUCKET_SORT;
+/******************************************************/
+static inline void _gfx_bucket_fix_unit(
 
-	unit->state |= GFX_INT_UNIT_ERASE;
+		GFX_Bucket*  bucket,
+		GFX_Unit*    unit,
+		size_t       index)
+{
+	GFX_Ref* ref = gfx_vector_at(&bucket->refs.data, unit->ref);
+
+	if(ref->unit != index + 1)
+	{
+		ref->unit = index + 1;
+		++bucket->stats.moved;
+	}
+}
+
+/******************************************************/
+static void _gfx_bucket_fix_units(
+
+		GFX_Bucket*  bucket,
+		size_t       start)
+{
+	/* Only touch references whose unit has moved */
+	size_t num = gfx_vector_get_size(&bucket->units);
+	GFX_Unit* units = bucket->units.begin;
+
+	for(; start < num; ++start)
+		_gfx_bucket_fix_unit(bucket, units + start, start);
 }
 
 /******************************************************/
-static void _gfx_bucket_process_units(
+static size_t _gfx_bucket_process_units(
 
 		GFX_Bucket* bucket)
 {
-	/* Iterate and filter the ones to be erased */
-	GFX_Unit* end = bucket->units.end;
-	GFX_Unit* it = bucket->units.begin;
-	unsigned int num = 0;
+	GFX_Unit* units = bucket->units.begin;
+	size_t num = gfx_vector_get_size(&bucket->units);
+	size_t vis = gfx_vector_get_index(&bucket->units, bucket->visible);
 
-	while(it != end)
-	{
-		/* Swap out if it should be erased */
-		if(GFX_INT_UNIT_ERASE & it->state)
+	/* Erase references first, as units still match their references */
+	size_t first = num;
+	size_t sorted = 0;
+	size_t r, w;
+
+	for(r = 0; r < num; ++r)
+		if(GFX_INT_UNIT_ERASE & units[r].state)
 		{
-			/* Erase precautions */
-			_gfx_bucket_erase_ref(bucket, it->ref);
+			GFX_Ref* ref = gfx_vector_at(&bucket->refs.data, units[r].ref);
+			if(ref->pending) --bucket->pending;
 
-			end = gfx_vector_previous(&bucket->units, end);
-			_gfx_bucket_swap_units(it, end);
+			_gfx_bucket_erase_ref(bucket, units[r].ref);
+		}
 
-			++num;
+	/* Filter the ones to be erased, preserving order */
+	for(r = 0, w = 0; r < num; ++r)
+	{
+		if(GFX_INT_UNIT_ERASE & units[r].state)
+		{
+			if(first > r) first = r;
+		}
+		else
+		{
+			if(r < vis) ++sorted;
+			if(w != r) units[w] = units[r];
+			++w;
 		}
-		else it = gfx_vector_next(&bucket->units, it);
 	}
 
 	/* Erase the ones to be erased :D */
-	gfx_vector_erase_range(&bucket->units, num, it);
+	gfx_vector_erase_range(
+		&bucket->units,
+		num - w,
+		gfx_vector_at(&bucket->units, w)
+	);
 
-	/* Iterate again and filter visible */
-	end = bucket->units.end;
-	it = bucket->units.begin;
-	num = 0;
+	/* Iterate again and move visible units to the front */
+	/* Visible units keep their relative order */
+	units = bucket->units.begin;
+	num = w;
+	vis = sorted;
+	sorted = 0;
 
-	while(it != end)
+	for(r = 0, w = 0; r < num; ++r)
 	{
-		/* Swap out if not visible */
-		if(!(GFX_INT_UNIT_VISIBLE & it->state))
-		{
-			end = gfx_vector_previous(&bucket->units, end);
-			_gfx_bucket_swap_units(it, end);
-		}
-		else
+		if(GFX_INT_UNIT_VISIBLE & units[r].state)
 		{
-			it = gfx_vector_next(&bucket->units, it);
-			++num;
+			/* Units that were already visible are still sorted */
+			if(r < vis) ++sorted;
+
+			if(w != r)
+			{
+				_gfx_bucket_swap_units(units + w, units + r);
+				if(first > w) first = w;
+			}
+			++w;
 		}
 	}
 
@@ -521,248 +733,1443 @@ static void _gfx_bucket_process_units(
 	bucket->visible = gfx_vector_advance(
 		&bucket->units,
 		bucket->units.begin,
-		num
+		w
 	);
+
+	_gfx_bucket_fix_units(bucket, first);
+
+	return sorted;
 }
 
 /******************************************************/
-static int _gfx_bucket_qsort(
+static inline uint32_t _gfx_bucket_to_depth(
 
-		const void* u1,
-		const void* u2)
+		float depth)
 {
-	const GFX_Unit* unit1 = (const GFX_Unit*)u1;
-	const GFX_Unit* unit2 = (const GFX_Unit*)u2;
+	/* Flip all bits of negative floats and the sign of positive floats */
+	/* so comparing the bits as unsigned integer equals comparing the floats */
+	union { float f; uint32_t i; } bits;
+	bits.f = depth;
 
-	return
-		(unit1->program < unit2->program) ? -1 :
-		(unit1->program > unit2->program) ? 1 :
-		(unit1->vao < unit2->vao) ? -1 :
-		(unit1->vao > unit2->vao) ? 1 :
-		0;
+	return bits.i & 0x80000000 ? ~bits.i : bits.i | 0x80000000;
 }
 
 /******************************************************/
-static void _gfx_bucket_sort_units(
+static inline float _gfx_bucket_from_depth(
 
-		GFX_Bucket*   bucket,
-		GFXUnitState  bit,
-		unsigned int  start,
-		unsigned int  num)
+		uint32_t depth)
 {
-	if(num <= 1) return;
+	union { float f; uint32_t i; } bits;
+	bits.i = depth & 0x80000000 ? depth & 0x7fffffff : ~depth;
 
-	/* Quicksort equal states based on bucket flags */
-	if(!bit) qsort(
-		gfx_vector_at(&bucket->units, start),
-		num,
-		sizeof(GFX_Unit),
-		_gfx_bucket_qsort);
+	return bits.f;
+}
 
-	else
-	{
-		/* Radix sort based on state :) */
-		/* Start, mid, end */
-		unsigned int st = start;
-		unsigned int mi = start + num;
-		unsigned int en = mi;
+/******************************************************/
+static inline void _gfx_bucket_get_sort_key(
 
-		while(st < mi)
-		{
-			GFX_Unit* unit = gfx_vector_at(&bucket->units, st);
+		const GFX_Bucket*  bucket,
+		GFX_SortKey*       key)
+{
+	GFXBucketSortMode mode = bucket->bucket.sort;
 
-			/* If 1, put in 1 bucket */
-			if(unit->state & bit)
-			{
-				_gfx_bucket_swap_units(
-					unit,
-					gfx_vector_at(&bucket->units, --mi)
-				);
-			}
-			else ++st;
-		}
+	key->mask  = ((GFXUnitState)1 << bucket->bucket.bits) - 1;
+	key->bits  = bucket->bucket.bits;
+	key->depth = mode != GFX_BUCKET_SORT_STATE;
+	key->flip  = mode == GFX_BUCKET_SORT_DEPTH_DESCENDING ? 0xffffffff : 0;
+}
 
-		/* Sort both buckets */
-		bit >>= 1;
-		_gfx_bucket_sort_units(bucket, bit, start, mi - start);
-		_gfx_bucket_sort_units(bucket, bit, mi, en - mi);
-	}
+/******************************************************/
+static inline uint64_t _gfx_bucket_get_key(
+
+		const GFX_Unit*     unit,
+		const GFX_SortKey*  key)
+{
+	/* Program is more significant than vao */
+	return key->depth ?
+		(uint64_t)(unit->depth ^ key->flip) :
+		((uint64_t)unit->program << 32) | (uint64_t)unit->vao;
 }
 
 /******************************************************/
-static void _gfx_bucket_fix_units(
+static inline int _gfx_bucket_greater(
 
-		GFX_Bucket* bucket)
+		const GFX_Unit*     unit1,
+		const GFX_Unit*     unit2,
+		const GFX_SortKey*  key)
 {
-	GFX_Unit* it;
-	size_t ind = 0;
+	GFXUnitState state1 = unit1->state & key->mask;
+	GFXUnitState state2 = unit2->state & key->mask;
 
-	for(
-		it = bucket->units.begin;
-		it != bucket->units.end;
-		it = gfx_vector_next(&bucket->units, it))
-	{
-		GFX_Ref* ref = gfx_vector_at(&bucket->refs, it->ref);
-		ref->unit = ++ind;
-	}
+	return (state1 != state2) ?
+		state1 > state2 :
+		_gfx_bucket_get_key(unit1, key) > _gfx_bucket_get_key(unit2, key);
 }
 
 /******************************************************/
-static void _gfx_bucket_preprocess(
+static int _gfx_bucket_qsort_index(
 
-		GFX_Bucket* bucket)
+		const void* i1,
+		const void* i2)
 {
-	/* Process all units */
-	if(bucket->flags & GFX_INT_BUCKET_PROCESS_UNITS)
-		_gfx_bucket_process_units(bucket);
+	unsigned int index1 = *(const unsigned int*)i1;
+	unsigned int index2 = *(const unsigned int*)i2;
 
-	/* Sort all units */
-	if(bucket->flags & GFX_INT_BUCKET_SORT)
-		_gfx_bucket_sort_units(
-			bucket,
-			(GFXUnitState)1 << (bucket->bucket.bits - 1),
-			0,
-			gfx_vector_get_index(&bucket->units, bucket->visible)
-		);
+	return
+		(index1 < index2) ? -1 :
+		(index1 > index2) ? 1 :
+		0;
+}
 
-	/* Fix all unit references */
-	if(bucket->flags)
-		_gfx_bucket_fix_units(bucket);
+/******************************************************/
+static inline unsigned char _gfx_bucket_get_key_digits(
 
-	bucket->flags = 0;
+		const GFX_SortKey* sortKey)
+{
+	return sortKey->depth ? GFX_INT_BUCKET_DEPTH_DIGITS : GFX_INT_BUCKET_KEY_DIGITS;
 }
 
 /******************************************************/
-GFXBucket* _gfx_bucket_create(
+static void _gfx_bucket_radix_count(
 
-		unsigned char bits)
+		const GFX_Unit*     units,
+		size_t              num,
+		const GFX_SortKey*  sortKey,
+		size_t              hist[][256])
 {
-	/* Allocate bucket */
-	GFX_Bucket* bucket = calloc(1, sizeof(GFX_Bucket));
-	if(!bucket)
-	{
-		/* Out of memory error */
-		gfx_errors_push(
-			GFX_ERROR_OUT_OF_MEMORY,
-			"Bucket could not be allocated."
-		);
-		return NULL;
-	}
+	/* The composite key is the 64 bit program/vao key or 32 bit depth key */
+	/* with the manual state bits as most significant digits */
+	GFXUnitState mask = sortKey->mask;
+	unsigned char keyDigits = _gfx_bucket_get_key_digits(sortKey);
+	unsigned char stateDigits = (sortKey->bits + 7) >> 3;
 
-	gfx_vector_init(&bucket->refs, sizeof(GFX_Ref));
-	gfx_vector_init(&bucket->sources, sizeof(GFX_Source));
-	gfx_vector_init(&bucket->units, sizeof(GFX_Unit));
+	memset(hist, 0, sizeof(size_t) * 256 * (keyDigits + stateDigits));
 
-	gfx_deque_init(&bucket->emptyRefs, sizeof(GFXBucketUnit));
-	gfx_deque_init(&bucket->emptySources, sizeof(GFXBucketSource));
+	/* Build a histogram of all digits in a single pass */
+	size_t i;
+	unsigned char d;
 
-	bucket->visible =
-		bucket->units.begin;
-	bucket->bucket.bits =
-		bits > GFX_UNIT_STATE_MAX_BITS ? GFX_UNIT_STATE_MAX_BITS : bits;
+	for(i = 0; i < num; ++i)
+	{
+		uint64_t key = _gfx_bucket_get_key(units + i, sortKey);
+		GFXUnitState state = units[i].state & mask;
 
-	return (GFXBucket*)bucket;
+		for(d = 0; d < keyDigits; ++d)
+			++hist[d][(key >> (d << 3)) & 0xff];
+		for(d = 0; d < stateDigits; ++d)
+			++hist[keyDigits + d][(state >> (d << 3)) & 0xff];
+	}
 }
 
 /******************************************************/
-void _gfx_bucket_free(
+static void _gfx_bucket_radix_count_digit(
 
-		GFXBucket* bucket)
+		const GFX_Unit*     units,
+		size_t              num,
+		const GFX_SortKey*  sortKey,
+		unsigned char       digit,
+		size_t*             hist)
 {
-	if(bucket)
+	unsigned char keyDigits = _gfx_bucket_get_key_digits(sortKey);
+	size_t i;
+
+	memset(hist, 0, sizeof(size_t) * 256);
+
+	if(digit < keyDigits)
 	{
-		GFX_Bucket* internal = (GFX_Bucket*)bucket;
+		unsigned char shift = digit << 3;
+		for(i = 0; i < num; ++i)
+			++hist[(_gfx_bucket_get_key(units + i, sortKey) >> shift) & 0xff];
+	}
+	else
+	{
+		GFXUnitState mask = sortKey->mask;
+		unsigned char shift = (digit - keyDigits) << 3;
 
-		/* Unblock all layouts */
-		GFX_Source* src;
-		for(
-			src = internal->sources.begin;
-			src != internal->sources.end;
-			src = gfx_vector_next(&internal->sources, src))
-		{
-			if(src->layout) _gfx_vertex_layout_unblock(
-				src->layout,
-				src->index
-			);
-		}
+		for(i = 0; i < num; ++i)
+			++hist[((units[i].state & mask) >> shift) & 0xff];
+	}
+}
 
-		/* Free all the things */
-		gfx_vector_clear(&internal->refs);
-		gfx_vector_clear(&internal->sources);
-		gfx_vector_clear(&internal->units);
+/******************************************************/
+static void _gfx_bucket_radix_scatter(
+
+		const GFX_Unit*     src,
+		GFX_Unit*           dst,
+		size_t              num,
+		const GFX_SortKey*  sortKey,
+		unsigned char       digit,
+		size_t*             offsets)
+{
+	/* Stable, units with equal digits keep their order */
+	unsigned char keyDigits = _gfx_bucket_get_key_digits(sortKey);
+	size_t i;
 
-		gfx_deque_clear(&internal->emptyRefs);
-		gfx_deque_clear(&internal->emptySources);
+	if(digit < keyDigits)
+	{
+		unsigned char shift = digit << 3;
+		for(i = 0; i < num; ++i) dst[offsets[
+			(_gfx_bucket_get_key(src + i, sortKey) >> shift) & 0xff]++] = src[i];
+	}
+	else
+	{
+		GFXUnitState mask = sortKey->mask;
+		unsigned char shift = (digit - keyDigits) << 3;
 
-		free(bucket);
+		for(i = 0; i < num; ++i) dst[offsets[
+			((src[i].state & mask) >> shift) & 0xff]++] = src[i];
 	}
 }
 
 /******************************************************/
-void _gfx_bucket_process(
+static void _gfx_bucket_radix_sort(
 
-		GFXBucket*           bucket,
-		const GFXPipeState*  state,
-		GFX_CONT_ARG)
+		GFX_Unit*           units,
+		GFX_Unit*           scratch,
+		size_t              num,
+		const GFX_SortKey*  sortKey)
 {
-	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+	if(num <= 1) return;
 
-	/* Preprocess, set states and invoke units */
-	_gfx_bucket_preprocess(internal);
-	_gfx_states_set(state, GFX_CONT_AS_ARG);
+	unsigned char digits =
+		_gfx_bucket_get_key_digits(sortKey) + ((sortKey->bits + 7) >> 3);
 
-	GFX_Unit* unit;
-	for(
-		unit = internal->units.begin;
-		unit != internal->visible;
-		unit = gfx_vector_next(&internal->units, unit))
+	size_t hist[GFX_INT_BUCKET_KEY_DIGITS + sizeof(GFXUnitState)][256];
+	_gfx_bucket_radix_count(units, num, sortKey, hist);
+
+	GFX_Unit* src = units;
+	GFX_Unit* dst = scratch;
+	unsigned char d;
+
+	/* Least significant digit first, each pass is stable */
+	for(d = 0; d < digits; ++d)
 	{
-		GFX_Ref* ref = gfx_vector_at(
-			&internal->refs,
-			unit->ref);
+		size_t* count = hist[d];
+		size_t b;
 
-		GFX_Source* src = gfx_vector_at(
-			&internal->sources,
-			ref->src);
+		/* Skip the pass if all units share the same digit */
+		for(b = 0; b < 256 && !count[b]; ++b);
+		if(count[b] == num) continue;
 
-		_gfx_bucket_invoke(
-			ref,
-			src,
-			unit,
-			GFX_CONT_AS_ARG);
+		/* Convert to offsets */
+		size_t offset = 0;
+		for(b = 0; b < 256; ++b)
+		{
+			size_t c = count[b];
+			count[b] = offset;
+			offset += c;
+		}
+
+		/* Scatter into the other buffer */
+		_gfx_bucket_radix_scatter(src, dst, num, sortKey, d, count);
+
+		GFX_Unit* temp = src;
+		src = dst;
+		dst = temp;
 	}
+
+	/* Make sure the result ends up in the given units */
+	if(src != units)
+		memcpy(units, src, sizeof(GFX_Unit) * num);
 }
 
 /******************************************************/
-void gfx_bucket_set_bits(
+static void _gfx_bucket_radix_chunk_count(
 
-		GFXBucket*     bucket,
-		unsigned char  bits)
+		size_t  begin,
+		size_t  end,
+		void*   data)
 {
-	/* Clamp */
-	bits = bits > GFX_UNIT_STATE_MAX_BITS ?
-		GFX_UNIT_STATE_MAX_BITS : bits;
-
-	/* Make sure to resort */
-	if(bucket->bits != bits)
-		((GFX_Bucket*)bucket)->flags |= GFX_INT_BUCKET_SORT;
+	GFX_RadixData* radix = data;
 
-	bucket->bits = bits;
+	for(; begin < end; ++begin)
+	{
+		size_t first = begin * radix->num / radix->chunks;
+		size_t last = (begin + 1) * radix->num / radix->chunks;
+
+		/* Count all digits up front, which decides the passes to skip */
+		/* After that chunks hold different units, so count again per pass */
+		if(radix->all) _gfx_bucket_radix_count(
+			radix->src + first,
+			last - first,
+			radix->key,
+			(size_t(*)[256])(radix->hist + begin * radix->digits * 256));
+
+		else _gfx_bucket_radix_count_digit(
+			radix->src + first,
+			last - first,
+			radix->key,
+			radix->digit,
+			radix->hist + (begin * radix->digits + radix->digit) * 256);
+	}
 }
 
 /******************************************************/
-GFXBucketSource gfx_bucket_add_source(
+static void _gfx_bucket_radix_chunk_scatter(
 
-		GFXBucket*        bucket,
+		size_t  begin,
+		size_t  end,
+		void*   data)
+{
+	GFX_RadixData* radix = data;
+
+	for(; begin < end; ++begin)
+	{
+		size_t first = begin * radix->num / radix->chunks;
+		size_t last = (begin + 1) * radix->num / radix->chunks;
+
+		_gfx_bucket_radix_scatter(
+			radix->src + first,
+			radix->dst,
+			last - first,
+			radix->key,
+			radix->digit,
+			radix->hist + (begin * radix->digits + radix->digit) * 256);
+	}
+}
+
+/******************************************************/
+static int _gfx_bucket_radix_sort_parallel(
+
+		GFX_Bucket*         bucket,
+		GFX_Unit*           units,
+		GFX_Unit*           scratch,
+		size_t              num,
+		const GFX_SortKey*  sortKey)
+{
+	/* One chunk per thread, each with its own histogram */
+	size_t chunks = bucket->bucket.pool->size + 1;
+	if(chunks > GFX_INT_BUCKET_SORT_CHUNKS) chunks = GFX_INT_BUCKET_SORT_CHUNKS;
+	if(chunks > num / GFX_INT_BUCKET_SORT_GRAIN) chunks = num / GFX_INT_BUCKET_SORT_GRAIN;
+
+	if(chunks <= 1)
+		return 0;
+
+	unsigned char digits =
+		_gfx_bucket_get_key_digits(sortKey) + ((sortKey->bits + 7) >> 3);
+
+	size_t* hist = gfx_allocator_realloc(
+		&bucket->frame.allocator,
+		NULL, 0,
+		sizeof(size_t) * 256 * digits * chunks);
+
+	if(!hist) return 0;
+
+	GFX_RadixData radix =
+	{
+		.key    = sortKey,
+		.src    = units,
+		.dst    = scratch,
+		.num    = num,
+		.chunks = chunks,
+		.digits = digits,
+		.all    = 1,
+		.hist   = hist
+	};
+
+	gfx_parallel_for(
+		bucket->bucket.pool,
+		0, chunks, 1,
+		_gfx_bucket_radix_chunk_count,
+		&radix);
+
+	/* Least significant digit first, each pass is stable */
+	for(radix.digit = 0; radix.digit < digits; ++radix.digit)
+	{
+		/* Skip the pass if all units share the same digit */
+		size_t b, c;
+
+		for(b = 0; b < 256; ++b)
+		{
+			size_t n = 0;
+			for(c = 0; c < chunks; ++c)
+				n += hist[(c * digits + radix.digit) * 256 + b];
+
+			if(n) break;
+		}
+
+		size_t n = 0;
+		for(c = 0; c < chunks; ++c)
+			n += hist[(c * digits + radix.digit) * 256 + b];
+
+		if(n == num) continue;
+
+		/* Count again if units moved since counting */
+		if(!radix.all) gfx_parallel_for(
+			bucket->bucket.pool,
+			0, chunks, 1,
+			_gfx_bucket_radix_chunk_count,
+			&radix);
+
+		/* Offsets per digit value, then per chunk in order */
+		/* So every chunk scatters to its own disjoint ranges */
+		size_t offset = 0;
+
+		for(b = 0; b < 256; ++b)
+			for(c = 0; c < chunks; ++c)
+			{
+				size_t* count = hist + (c * digits + radix.digit) * 256 + b;
+				size_t n = *count;
+
+				*count = offset;
+				offset += n;
+			}
+
+		radix.all = 0;
+
+		gfx_parallel_for(
+			bucket->bucket.pool,
+			0, chunks, 1,
+			_gfx_bucket_radix_chunk_scatter,
+			&radix);
+
+		GFX_Unit* temp = radix.src;
+		radix.src = radix.dst;
+		radix.dst = temp;
+	}
+
+	/* Make sure the result ends up in the given units */
+	if(radix.src != units)
+		memcpy(units, radix.src, sizeof(GFX_Unit) * num);
+
+	gfx_allocator_realloc(
+		&bucket->frame.allocator,
+		hist,
+		sizeof(size_t) * 256 * digits * chunks,
+		0);
+
+	return 1;
+}
+
+/******************************************************/
+static int _gfx_bucket_sort_units(
+
+		GFX_Bucket* bucket)
+{
+	size_t num = gfx_vector_get_index(&bucket->units, bucket->visible);
+
+	/* Make sure the scratch buffer can hold all units */
+	if(!gfx_vector_reserve(&bucket->sortBuffer, num))
+		return 0;
+
+	/* Sort very large buckets in parallel if possible */
+	/* Splitting costs an extra read per pass, which a single core cannot win back */
+	GFX_SortKey key;
+	_gfx_bucket_get_sort_key(bucket, &key);
+
+	if(
+		!bucket->bucket.pool ||
+		num < GFX_INT_BUCKET_PARALLEL_MIN ||
+		_gfx_platform_get_num_cores() < 2 ||
+		!_gfx_bucket_radix_sort_parallel(
+			bucket,
+			bucket->units.begin,
+			bucket->sortBuffer.begin,
+			num,
+			&key))
+	{
+		_gfx_bucket_radix_sort(
+			bucket->units.begin,
+			bucket->sortBuffer.begin,
+			num,
+			&key);
+	}
+
+	_gfx_bucket_fix_units(bucket, 0);
+
+	return 1;
+}
+
+/******************************************************/
+static int _gfx_bucket_merge_units(
+
+		GFX_Bucket*  bucket,
+		size_t       sorted)
+{
+	GFX_Unit* units = bucket->units.begin;
+	size_t num = gfx_vector_get_index(&bucket->units, bucket->visible);
+
+	/* Replace all dirty references by their sorted unit index */
+	/* Ignore units that got erased, hidden or are not sorted yet */
+	unsigned int* dirty = bucket->dirty.begin;
+	size_t cnt = gfx_vector_get_size(&bucket->dirty);
+	size_t dirtyCnt = 0;
+	size_t i;
+
+	for(i = 0; i < cnt; ++i)
+	{
+		size_t index = gfx_slot_map_get_index(&bucket->refs, dirty[i]);
+		if(!index) continue;
+
+		GFX_Ref* ref = gfx_vector_at(&bucket->refs.data, index - 1);
+
+		if(ref->unit <= sorted && units[ref->unit - 1].ref == index - 1)
+			dirty[dirtyCnt++] = ref->unit - 1;
+	}
+
+	/* Sort the indices and remove duplicates */
+	if(dirtyCnt > 1)
+		qsort(dirty, dirtyCnt, sizeof(unsigned int), _gfx_bucket_qsort_index);
+
+	for(i = 1, cnt = dirtyCnt ? 1 : 0; i < dirtyCnt; ++i)
+		if(dirty[i] != dirty[cnt - 1]) dirty[cnt++] = dirty[i];
+
+	dirtyCnt = cnt;
+
+	/* Nothing to merge or too much to merge, just sort it all */
+	size_t pending = dirtyCnt + (num - sorted);
+
+	if(!pending)
+		return 1;
+	if(pending * GFX_INT_BUCKET_MERGE_RATIO > num)
+		return _gfx_bucket_sort_units(bucket);
+
+	/* Make sure the scratch buffer can hold all pending units */
+	/* and an equally large radix sort buffer */
+	if(!gfx_vector_reserve(&bucket->sortBuffer, pending << 1))
+		return 0;
+
+	GFX_Unit* pend = bucket->sortBuffer.begin;
+
+	/* Take all dirty units out, preserving order of the rest */
+	size_t first = dirtyCnt ? dirty[0] : sorted;
+	size_t r, w;
+
+	for(r = first, w = first, i = 0; r < sorted; ++r)
+	{
+		if(i < dirtyCnt && dirty[i] == r)
+			pend[i++] = units[r];
+		else
+			units[w++] = units[r];
+	}
+
+	/* Append all newly visible units and sort */
+	memcpy(
+		pend + dirtyCnt,
+		units + sorted,
+		sizeof(GFX_Unit) * (num - sorted));
+
+	GFX_SortKey key;
+	_gfx_bucket_get_sort_key(bucket, &key);
+
+	_gfx_bucket_radix_sort(
+		pend,
+		pend + pending,
+		pending,
+		&key);
+
+	/* Merge from the back so no sorted unit is overwritten */
+	size_t out = num;
+
+	while(pending)
+	{
+		if(w && _gfx_bucket_greater(units + w - 1, pend + pending - 1, &key))
+			units[--out] = units[--w];
+		else
+			units[--out] = pend[--pending];
+	}
+
+	/* Only fix what has been touched */
+	_gfx_bucket_fix_units(bucket, out < first ? out : first);
+
+	return 1;
+}
+
+/******************************************************/
+static inline int _gfx_bucket_in_frustum(
+
+		const GFX_Bucket*  bucket,
+		const float*       sphere)
+{
+	if(sphere[3] < 0.0f) return 1;
+
+#if defined(GFX_SIMD_SSE2)
+
+	/* Test against four planes at once */
+	__m128 x = _mm_set1_ps(sphere[0]);
+	__m128 y = _mm_set1_ps(sphere[1]);
+	__m128 z = _mm_set1_ps(sphere[2]);
+	__m128 r = _mm_set1_ps(-sphere[3]);
+
+	__m128 d0 = _mm_add_ps(
+		_mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(bucket->frustum[0] + 0), x),
+			_mm_mul_ps(_mm_loadu_ps(bucket->frustum[1] + 0), y)),
+		_mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(bucket->frustum[2] + 0), z),
+			_mm_loadu_ps(bucket->frustum[3] + 0)));
+
+	__m128 d1 = _mm_add_ps(
+		_mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(bucket->frustum[0] + 4), x),
+			_mm_mul_ps(_mm_loadu_ps(bucket->frustum[1] + 4), y)),
+		_mm_add_ps(
+			_mm_mul_ps(_mm_loadu_ps(bucket->frustum[2] + 4), z),
+			_mm_loadu_ps(bucket->frustum[3] + 4)));
+
+	return !_mm_movemask_ps(_mm_or_ps(
+		_mm_cmplt_ps(d0, r),
+		_mm_cmplt_ps(d1, r)));
+
+#else
+
+	unsigned char p;
+	for(p = 0; p < 6; ++p)
+	{
+		float d =
+			bucket->frustum[0][p] * sphere[0] +
+			bucket->frustum[1][p] * sphere[1] +
+			bucket->frustum[2][p] * sphere[2] +
+			bucket->frustum[3][p];
+
+		if(d < -sphere[3]) return 0;
+	}
+
+	return 1;
+
+#endif
+}
+
+/******************************************************/
+static void _gfx_bucket_cull_range(
+
+		size_t  begin,
+		size_t  end,
+		void*   data)
+{
+	GFX_CullData* cull = data;
+	GFX_Bucket* bucket = cull->bucket;
+	GFX_Unit* units = bucket->units.begin;
+
+	GFX_Ref* refs = bucket->refs.data.begin;
+	size_t visible = 0;
+	size_t culled = 0;
+	int changed = 0;
+
+	/* References are densely packed, so iterate over those */
+	for(; begin < end; ++begin)
+	{
+		GFX_Ref* ref = refs + begin;
+		GFX_Unit* unit = units + (ref->unit - 1);
+
+		if(!ref->visible || ref->pending || ref->failed || (unit->state & GFX_INT_UNIT_ERASE))
+			continue;
+
+		int vis = _gfx_bucket_in_frustum(bucket, ref->bounds);
+		int cur = unit->state & GFX_INT_UNIT_VISIBLE ? 1 : 0;
+
+		if(vis != cur)
+		{
+			unit->state ^= GFX_INT_UNIT_VISIBLE;
+			changed = 1;
+		}
+
+		if(vis) ++visible;
+		else ++culled;
+	}
+
+	if(visible) GFX_ATOMIC_ADD(&cull->visible, visible);
+	if(culled) GFX_ATOMIC_ADD(&cull->culled, culled);
+	if(changed) GFX_ATOMIC_STORE(&cull->changed, 1, GFX_ATOMIC_RELAXED);
+}
+
+/******************************************************/
+static void _gfx_bucket_cull(
+
+		GFX_Bucket* bucket)
+{
+	GFX_CullData data =
+	{
+		.bucket  = bucket,
+		.visible = 0,
+		.culled  = 0,
+		.changed = 0
+	};
+
+	/* Cull very large buckets in parallel if possible */
+	size_t num = gfx_slot_map_get_size(&bucket->refs);
+
+	if(bucket->bucket.pool && num >= GFX_INT_BUCKET_PARALLEL_MIN)
+	{
+		gfx_parallel_for(
+			bucket->bucket.pool,
+			0, num,
+			GFX_INT_BUCKET_CULL_GRAIN,
+			_gfx_bucket_cull_range,
+			&data);
+	}
+
+	else _gfx_bucket_cull_range(0, num, &data);
+
+	/* Visible units are moved to the front when processing */
+	if(data.changed)
+		bucket->flags |= GFX_INT_BUCKET_PROCESS_UNITS;
+
+	bucket->stats.culled = data.culled;
+}
+
+/******************************************************/
+static void _gfx_bucket_poll_refs(
+
+		GFX_Bucket* bucket)
+{
+	/* Show units of which the program map became ready */
+	size_t failed = 0;
+
+	GFX_Ref* ref;
+	for(
+		ref = bucket->refs.data.begin;
+		ref != bucket->refs.data.end;
+		ref = gfx_vector_next(&bucket->refs.data, ref))
+	{
+		if(!ref->pending) continue;
+
+		int status = _gfx_program_map_poll(ref->map->programMap);
+		if(status == GFX_INT_MAP_PENDING) continue;
+
+		ref->pending = 0;
+		--bucket->pending;
+
+		/* Never show units that cannot be drawn */
+		if(status == GFX_INT_MAP_FAILED)
+		{
+			ref->failed = 1;
+			++failed;
+
+			continue;
+		}
+
+		/* When culling, visible units are shown by the cull */
+		GFX_Unit* un = gfx_vector_at(&bucket->units, ref->unit - 1);
+
+		if(ref->visible && !bucket->cull && !(un->state & GFX_INT_UNIT_ERASE))
+		{
+			un->state |= GFX_INT_UNIT_VISIBLE;
+			bucket->flags |= GFX_INT_BUCKET_PROCESS_UNITS;
+		}
+	}
+
+	if(failed) gfx_errors_push(
+		GFX_ERROR_LINK_FAIL,
+		"Units of a bucket are never drawn, their program map failed to link."
+	);
+}
+
+/******************************************************/
+static void _gfx_bucket_preprocess(
+
+		GFX_Bucket* bucket)
+{
+	bucket->stats.moved = 0;
+	bucket->stats.culled = 0;
+
+	/* Cull all units against the frustum */
+	if(bucket->cull) _gfx_bucket_cull(bucket);
+
+	/* Any change to the units invalidates the records */
+	if(bucket->flags) bucket->recorded = 0;
+
+	/* Process all units */
+	size_t sorted = gfx_vector_get_index(&bucket->units, bucket->visible);
+
+	if(bucket->flags & GFX_INT_BUCKET_PROCESS_UNITS)
+		sorted = _gfx_bucket_process_units(bucket);
+
+	/* Sort all units or merge the ones out of order */
+	/* On failure, retry by sorting everything next time */
+	unsigned char flags = 0;
+
+	if(bucket->flags & GFX_INT_BUCKET_SORT)
+	{
+		if(!_gfx_bucket_sort_units(bucket))
+			flags |= GFX_INT_BUCKET_SORT;
+	}
+
+	else if(
+		(bucket->flags & GFX_INT_BUCKET_MERGE) ||
+		sorted != gfx_vector_get_index(&bucket->units, bucket->visible))
+	{
+		if(!_gfx_bucket_merge_units(bucket, sorted))
+			flags |= GFX_INT_BUCKET_SORT;
+	}
+
+	gfx_vector_clear(&bucket->dirty);
+	gfx_arena_reset(&bucket->frame);
+
+	bucket->flags = flags;
+	bucket->stats.visible = gfx_vector_get_index(&bucket->units, bucket->visible);
+	bucket->stats.pending = bucket->pending;
+}
+
+/******************************************************/
+static inline int _gfx_bucket_is_batchable(
+
+		const GFX_Ref*     ref1,
+		const GFX_Source*  src1,
+		const GFX_Unit*    unit1,
+		const GFX_Ref*     ref2,
+		const GFX_Source*  src2,
+		const GFX_Unit*    unit2)
+{
+	/* Everything but the draw parameters must be equal */
+	return
+		unit1->vao == unit2->vao &&
+		ref1->map == ref2->map &&
+		ref1->copy == ref2->copy &&
+		ref1->instanceBase == ref2->instanceBase &&
+		src1->source.primitive == src2->source.primitive &&
+		src1->source.patchSize == src2->source.patchSize &&
+		src1->source.indexed == src2->source.indexed &&
+		(!src1->source.indexed || src1->source.indexType == src2->source.indexType);
+}
+
+/******************************************************/
+static void _gfx_bucket_get_command(
+
+		const GFX_Ref*     ref,
+		const GFX_Source*  source,
+		GFX_Command*       cmd)
+{
+	const GFXVertexSource* src = &source->source;
+
+	/* Use the same bases the draw functions would use */
+	GLuint inst =
+		(ref->type == GFX_INT_DRAW_INSTANCED_BASE ||
+		ref->type == GFX_INT_DRAW_INSTANCED_BASE_VERTEX_BASE) ?
+		ref->instanceBase : 0;
+
+	GLint vert =
+		(ref->type == GFX_INT_DRAW_VERTEX_BASE ||
+		ref->type == GFX_INT_DRAW_INSTANCED_VERTEX_BASE ||
+		ref->type == GFX_INT_DRAW_INSTANCED_BASE_VERTEX_BASE) ?
+		ref->vertexBase : 0;
+
+	if(!src->indexed)
+	{
+		cmd->arrays.count        = src->count;
+		cmd->arrays.instances    = ref->instances;
+		cmd->arrays.first        = src->first + ref->vertexBase;
+		cmd->arrays.instanceBase = inst;
+	}
+	else
+	{
+		/* First is stored in bytes, commands use indices */
+		unsigned char size = _gfx_sizeof_data_type(src->indexType);
+
+		cmd->elements.count        = src->count;
+		cmd->elements.instances    = ref->instances;
+		cmd->elements.first        = (src->first + ref->indexBase) / size;
+		cmd->elements.vertexBase   = vert;
+		cmd->elements.instanceBase = inst;
+	}
+}
+
+/******************************************************/
+static int _gfx_bucket_upload_commands(
+
+		GFX_Bucket*  bucket,
+		size_t       num,
+		GFX_CONT_ARG)
+{
+	size_t size = sizeof(GFX_Command) * num;
+
+	/* Grow the indirect buffer to a power of two */
+	if(!bucket->indirect || bucket->indirect->size < size)
+	{
+		size_t cap = sizeof(GFX_Command);
+		while(cap < size) cap <<= 1;
+
+		gfx_buffer_free(bucket->indirect);
+		bucket->indirect = gfx_buffer_create(GFX_BUFFER_WRITE, cap, NULL, 1);
+
+		if(!bucket->indirect) return 0;
+	}
+
+	/* Don't wait for the previous commands */
+	else gfx_buffer_orphan(bucket->indirect);
+
+	if(gfx_buffer_write(bucket->indirect, size, bucket->commands.begin, 0) != size)
+		return 0;
+
+	_gfx_gl_indirect_buffer_bind(
+		_gfx_buffer_get_handle(
+			bucket->indirect,
+			_gfx_buffer_get_current(bucket->indirect)),
+		GFX_CONT_AS_ARG);
+
+	return 1;
+}
+
+/******************************************************/
+static void _gfx_bucket_submit(
+
+		GFX_Bucket* bucket,
+		GFX_CONT_ARG)
+{
+	/* Keep track of the previous unit to skip redundant state */
+	const GFX_Ref* prevRef = NULL;
+	const GFX_Unit* prevUnit = NULL;
+
+	GFX_Unit* unit;
+	for(
+		unit = bucket->units.begin;
+		unit != bucket->visible;
+		unit = gfx_vector_next(&bucket->units, unit))
+	{
+		GFX_Ref* ref = gfx_vector_at(
+			&bucket->refs.data,
+			unit->ref);
+
+		GFX_Source* src = gfx_vector_at(
+			&bucket->sources.data,
+			ref->src);
+
+		_gfx_bucket_bind(
+			ref,
+			src,
+			unit,
+			prevRef,
+			prevUnit,
+			&bucket->stats,
+			GFX_CONT_AS_ARG);
+
+		_gfx_bucket_draw(
+			ref,
+			src,
+			&bucket->stats,
+			GFX_CONT_AS_ARG);
+
+		prevRef = ref;
+		prevUnit = unit;
+	}
+}
+
+/******************************************************/
+static int _gfx_bucket_record(
+
+		GFX_Bucket* bucket)
+{
+	size_t num = gfx_vector_get_index(&bucket->units, bucket->visible);
+
+	gfx_vector_clear(&bucket->records);
+	if(!gfx_vector_reserve(&bucket->records, num))
+		return 0;
+
+	/* Resolve all references and redundant state up front */
+	const GFX_Ref* prevRef = NULL;
+	const GFX_Unit* prevUnit = NULL;
+
+	GFX_Unit* unit;
+	for(
+		unit = bucket->units.begin;
+		unit != bucket->visible;
+		unit = gfx_vector_next(&bucket->units, unit))
+	{
+		const GFX_Ref* ref = gfx_vector_at(&bucket->refs.data, unit->ref);
+		const GFX_Source* src = gfx_vector_at(&bucket->sources.data, ref->src);
+
+		GFX_Record rec;
+		rec.bind = 0;
+		rec.func = ref->type + src->source.indexed;
+		rec.vao = unit->vao;
+		rec.map = ref->map;
+		rec.copy = ref->copy;
+		rec.source = src->source;
+		rec.instances = ref->instances;
+		rec.instanceBase = ref->instanceBase;
+		rec.vertexBase = ref->vertexBase;
+		rec.indexBase = ref->indexBase;
+
+		if(!prevUnit || prevUnit->vao != unit->vao)
+			rec.bind |= GFX_INT_RECORD_LAYOUT;
+
+		if(
+			!prevRef ||
+			prevRef->map != ref->map ||
+			prevRef->copy != ref->copy ||
+			prevRef->instanceBase != ref->instanceBase)
+		{
+			rec.bind |= GFX_INT_RECORD_MAP;
+		}
+
+		gfx_vector_insert(&bucket->records, &rec, bucket->records.end);
+
+		prevRef = ref;
+		prevUnit = unit;
+	}
+
+	return 1;
+}
+
+/******************************************************/
+static void _gfx_bucket_replay(
+
+		GFX_Bucket* bucket,
+		GFX_CONT_ARG)
+{
+	/* Same as submitting, but without touching any units */
+	GFXBucketStats* stats = &bucket->stats;
+
+	GFX_Record* rec;
+	for(
+		rec = bucket->records.begin;
+		rec != bucket->records.end;
+		rec = gfx_vector_next(&bucket->records, rec))
+	{
+		if(!(rec->bind & GFX_INT_RECORD_LAYOUT))
+			++stats->layoutSkips;
+
+		else
+		{
+			_gfx_gl_vertex_layout_bind(
+				rec->vao,
+				GFX_CONT_AS_ARG);
+
+			++stats->layoutBinds;
+		}
+
+		_gfx_states_set_patch_vertices(
+			rec->source.patchSize,
+			GFX_CONT_AS_ARG);
+
+		if(!(rec->bind & GFX_INT_RECORD_MAP))
+			++stats->mapSkips;
+
+		else
+		{
+			_gfx_property_map_use(
+				rec->map,
+				rec->copy,
+				rec->instanceBase,
+				GFX_CONT_AS_ARG);
+
+			++stats->mapUses;
+		}
+
+		_gfx_draw_funcs[rec->func](
+			&rec->source,
+			rec->instances,
+			rec->instanceBase,
+			rec->vertexBase,
+			rec->indexBase,
+			GFX_CONT_AS_ARG
+		);
+
+		++stats->draws;
+	}
+}
+
+/******************************************************/
+static int _gfx_bucket_submit_batched(
+
+		GFX_Bucket*  bucket,
+		size_t       num,
+		GFX_CONT_ARG)
+{
+	/* Make sure all runs and commands fit */
+	if(
+		!gfx_vector_reserve(&bucket->runs, num) ||
+		!gfx_vector_reserve(&bucket->commands, num))
+	{
+		return 0;
+	}
+
+	GFX_Unit* units = bucket->units.begin;
+	size_t* runs = bucket->runs.begin;
+	GFX_Command* cmds = bucket->commands.begin;
+
+	size_t numRuns = 0;
+	size_t numCmds = 0;
+
+	/* Find runs of compatible units and build their commands */
+	size_t i, j;
+	for(i = 0; i < num; i = j)
+	{
+		const GFX_Ref* ref = gfx_vector_at(&bucket->refs.data, units[i].ref);
+		const GFX_Source* src = gfx_vector_at(&bucket->sources.data, ref->src);
+
+		for(j = i + 1; j < num; ++j)
+		{
+			const GFX_Ref* ref2 = gfx_vector_at(&bucket->refs.data, units[j].ref);
+			const GFX_Source* src2 = gfx_vector_at(&bucket->sources.data, ref2->src);
+
+			if(!_gfx_bucket_is_batchable(ref, src, units + i, ref2, src2, units + j))
+				break;
+
+			if(j == i + 1)
+				_gfx_bucket_get_command(ref, src, cmds + numCmds++);
+
+			_gfx_bucket_get_command(ref2, src2, cmds + numCmds++);
+		}
+
+		runs[numRuns++] = j - i;
+	}
+
+	/* Upload commands if supported */
+	/* Otherwise they're read from client memory */
+	const char* indirect = (const char*)cmds;
+
+	if(numCmds && GFX_REND_GET.intExt[GFX_INT_EXT_MULTI_DRAW_INDIRECT])
+	{
+		if(!_gfx_bucket_upload_commands(bucket, numCmds, GFX_CONT_AS_ARG))
+			return 0;
+
+		indirect = NULL;
+	}
+
+	/* Submit all runs */
+	const GFX_Ref* prevRef = NULL;
+	const GFX_Unit* prevUnit = NULL;
+	size_t r;
+
+	for(i = 0, r = 0; r < numRuns; i += runs[r++])
+	{
+		const GFX_Ref* ref = gfx_vector_at(&bucket->refs.data, units[i].ref);
+		const GFX_Source* src = gfx_vector_at(&bucket->sources.data, ref->src);
+
+		_gfx_bucket_bind(
+			ref,
+			src,
+			units + i,
+			prevRef,
+			prevUnit,
+			&bucket->stats,
+			GFX_CONT_AS_ARG);
+
+		if(runs[r] == 1) _gfx_bucket_draw(
+			ref,
+			src,
+			&bucket->stats,
+			GFX_CONT_AS_ARG);
+
+		else
+		{
+			_gfx_bucket_draw_indirect(
+				src,
+				indirect,
+				runs[r],
+				&bucket->stats,
+				GFX_CONT_AS_ARG);
+
+			indirect += sizeof(GFX_Command) * runs[r];
+		}
+
+		prevRef = ref;
+		prevUnit = units + i;
+	}
+
+	return 1;
+}
+
+/******************************************************/
+GFXBucket* _gfx_bucket_create(
+
+		unsigned char   bits,
+		GFXBucketFlags  flags)
+{
+	/* Allocate bucket */
+	GFX_Bucket* bucket = calloc(1, sizeof(GFX_Bucket));
+	if(!bucket)
+	{
+		/* Out of memory error */
+		gfx_errors_push(
+			GFX_ERROR_OUT_OF_MEMORY,
+			"Bucket could not be allocated."
+		);
+		return NULL;
+	}
+
+	gfx_slot_map_init(&bucket->refs, sizeof(GFX_Ref));
+	gfx_slot_map_init(&bucket->sources, sizeof(GFX_Source));
+	gfx_vector_init(&bucket->units, sizeof(GFX_Unit));
+	gfx_vector_init(&bucket->sortBuffer, sizeof(GFX_Unit));
+	gfx_vector_init(&bucket->runs, sizeof(size_t));
+	gfx_vector_init(&bucket->commands, sizeof(GFX_Command));
+	gfx_vector_init(&bucket->records, sizeof(GFX_Record));
+
+	gfx_arena_init(&bucket->frame, GFX_INT_BUCKET_FRAME_SIZE);
+	gfx_vector_init_with_allocator(
+		&bucket->dirty,
+		sizeof(GFXBucketUnit),
+		&bucket->frame.allocator);
+
+	bucket->visible =
+		bucket->units.begin;
+	bucket->bucket.bits =
+		bits > GFX_UNIT_STATE_MAX_BITS ? GFX_UNIT_STATE_MAX_BITS : bits;
+	bucket->bucket.flags =
+		flags;
+	bucket->bucket.sort =
+		GFX_BUCKET_SORT_STATE;
+	bucket->bucket.pool =
+		NULL;
+
+	return (GFXBucket*)bucket;
+}
+
+/******************************************************/
+void _gfx_bucket_free(
+
+		GFXBucket* bucket)
+{
+	if(bucket)
+	{
+		GFX_Bucket* internal = (GFX_Bucket*)bucket;
+
+		/* Unblock all layouts */
+		GFX_Source* src;
+		for(
+			src = internal->sources.data.begin;
+			src != internal->sources.data.end;
+			src = gfx_vector_next(&internal->sources.data, src))
+		{
+			_gfx_vertex_layout_unblock(
+				src->layout,
+				src->index
+			);
+		}
+
+		/* Free all the things */
+		gfx_slot_map_clear(&internal->refs);
+		gfx_slot_map_clear(&internal->sources);
+		gfx_vector_clear(&internal->units);
+		gfx_vector_clear(&internal->sortBuffer);
+		gfx_vector_clear(&internal->dirty);
+		gfx_vector_clear(&internal->runs);
+		gfx_arena_clear(&internal->frame);
+		gfx_vector_clear(&internal->commands);
+		gfx_vector_clear(&internal->records);
+
+		gfx_buffer_free(internal->indirect);
+
+		free(bucket);
+	}
+}
+
+/******************************************************/
+void _gfx_bucket_poll(
+
+		GFXBucket* bucket)
+{
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+
+	/* Check units waiting for their programs */
+	if(internal->pending) _gfx_bucket_poll_refs(internal);
+}
+
+/******************************************************/
+void _gfx_bucket_prepare(
+
+		GFXBucket* bucket)
+{
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+
+	_gfx_bucket_preprocess(internal);
+	internal->prepared = 1;
+
+	/* Record units which won't be batched, so only replaying is left */
+	size_t num = gfx_vector_get_index(&internal->units, internal->visible);
+
+	if(!internal->recorded && (!(bucket->flags & GFX_BUCKET_BATCH) || num <= 1))
+		internal->recorded = _gfx_bucket_record(internal);
+}
+
+/******************************************************/
+void _gfx_bucket_process(
+
+		GFXBucket*           bucket,
+		const GFXPipeState*  state,
+		GFX_CONT_ARG)
+{
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+
+	/* Preprocess if not prepared yet */
+	int prepared = internal->prepared;
+	internal->prepared = 0;
+
+	if(!prepared)
+	{
+		_gfx_bucket_poll(bucket);
+		_gfx_bucket_preprocess(internal);
+	}
+
+	/* Set states and invoke units */
+	_gfx_states_set(state, GFX_CONT_AS_ARG);
+
+	internal->stats.draws = 0;
+	internal->stats.batched = 0;
+	internal->stats.layoutBinds = 0;
+	internal->stats.layoutSkips = 0;
+	internal->stats.mapUses = 0;
+	internal->stats.mapSkips = 0;
+
+	/* Batch units if requested, draw them one by one on failure */
+	size_t num = gfx_vector_get_index(&internal->units, internal->visible);
+
+	if(
+		!(bucket->flags & GFX_BUCKET_BATCH) ||
+		num <= 1 ||
+		!_gfx_bucket_submit_batched(internal, num, GFX_CONT_AS_ARG))
+	{
+		/* Replay recorded units if requested or prepared, record them if outdated */
+		if(
+			((bucket->flags & GFX_BUCKET_RECORD) || prepared) &&
+			(internal->recorded || (internal->recorded = _gfx_bucket_record(internal))))
+		{
+			_gfx_bucket_replay(internal, GFX_CONT_AS_ARG);
+		}
+
+		else _gfx_bucket_submit(internal, GFX_CONT_AS_ARG);
+	}
+}
+
+/******************************************************/
+void gfx_bucket_set_bits(
+
+		GFXBucket*     bucket,
+		unsigned char  bits)
+{
+	/* Clamp */
+	bits = bits > GFX_UNIT_STATE_MAX_BITS ?
+		GFX_UNIT_STATE_MAX_BITS : bits;
+
+	/* Make sure to resort */
+	if(bucket->bits != bits)
+		((GFX_Bucket*)bucket)->flags |= GFX_INT_BUCKET_SORT;
+
+	bucket->bits = bits;
+}
+
+/******************************************************/
+void gfx_bucket_set_sort_mode(
+
+		GFXBucket*         bucket,
+		GFXBucketSortMode  mode)
+{
+	/* Make sure to resort */
+	if(bucket->sort != mode)
+		((GFX_Bucket*)bucket)->flags |= GFX_INT_BUCKET_SORT;
+
+	bucket->sort = mode;
+}
+
+/******************************************************/
+void gfx_bucket_set_frustum(
+
+		GFXBucket*    bucket,
+		const float*  matrix)
+{
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+
+	if(!matrix)
+	{
+		/* Show all units hidden by culling */
+		if(internal->cull)
+		{
+			GFX_Ref* ref;
+			for(
+				ref = internal->refs.data.begin;
+				ref != internal->refs.data.end;
+				ref = gfx_vector_next(&internal->refs.data, ref))
+			{
+				GFX_Unit* un = gfx_vector_at(&internal->units, ref->unit - 1);
+				if(ref->visible && !ref->pending && !ref->failed)
+					un->state |= GFX_INT_UNIT_VISIBLE;
+			}
+
+			internal->flags |= GFX_INT_BUCKET_PROCESS_UNITS;
+		}
+
+		internal->cull = 0;
+		return;
+	}
+
+	/* Extract all planes, the matrix is column major */
+	/* Left, right, bottom, top, near and far */
+	unsigned char p;
+	for(p = 0; p < 8; ++p)
+	{
+		float plane[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+
+		if(p < 6)
+		{
+			unsigned char row = p >> 1;
+			float sign = (p & 1) ? -1.0f : 1.0f;
+
+			plane[0] = matrix[3] + sign * matrix[row];
+			plane[1] = matrix[7] + sign * matrix[row + 4];
+			plane[2] = matrix[11] + sign * matrix[row + 8];
+			plane[3] = matrix[15] + sign * matrix[row + 12];
+
+			/* Normalize so distances are in world units */
+			float len = sqrtf(
+				plane[0] * plane[0] +
+				plane[1] * plane[1] +
+				plane[2] * plane[2]);
+
+			if(len > 0.0f)
+			{
+				plane[0] /= len;
+				plane[1] /= len;
+				plane[2] /= len;
+				plane[3] /= len;
+			}
+		}
+
+		internal->frustum[0][p] = plane[0];
+		internal->frustum[1][p] = plane[1];
+		internal->frustum[2][p] = plane[2];
+		internal->frustum[3][p] = plane[3];
+	}
+
+	internal->cull = 1;
+}
+
+/******************************************************/
+void gfx_bucket_set_thread_pool(
+
+		GFXBucket*      bucket,
+		GFXThreadPool*  pool)
+{
+	bucket->pool = pool;
+}
+
+/******************************************************/
+GFXBucketSource gfx_bucket_add_source(
+
+		GFXBucket*        bucket,
 		GFXVertexLayout*  layout,
 		unsigned char     srcIndex,
 		size_t            offset,
 		size_t            count)
+{
+	return gfx_bucket_add_source_with_base(
+		bucket,
+		layout,
+		srcIndex,
+		offset,
+		count,
+		0,
+		0
+	);
+}
+
+/******************************************************/
+GFXBucketSource gfx_bucket_add_source_with_base(
+
+		GFXBucket*        bucket,
+		GFXVertexLayout*  layout,
+		unsigned char     srcIndex,
+		size_t            offset,
+		size_t            count,
+		unsigned int      vertexBase,
+		size_t            indexBase)
 {
 	/* Get source */
 	GFX_Source src;
 	src.layout = layout;
 	src.index = srcIndex;
+	src.vertexBase = vertexBase;
 
 	if(!layout || !gfx_vertex_layout_get_source(
 		layout,
@@ -786,9 +2193,9 @@ GFXBucketSource gfx_bucket_add_source(
 		if(!_gfx_gl_vertex_layout_get_index_buffer(layout, &offset))
 			return 0;
 
-		GFXDataType type;
-		type.unpacked = src.source.indexType;
-		unsigned char size = _gfx_sizeof_data_type(type);
+		offset += indexBase;
+
+		unsigned char size = _gfx_sizeof_data_type(src.source.indexType);
 
 		/* Also check alignment of the buffer */
 		if(offset % size)
@@ -803,48 +2210,12 @@ GFXBucketSource gfx_bucket_add_source(
 		return 0;
 
 	/* Insert source */
-	GFX_Bucket* internal = (GFX_Bucket*)bucket;
-	GFXBucketSource id = 0;
-
-	if(internal->emptySources.begin != internal->emptySources.end)
-	{
-		/* replace an empty ID */
-		id = *(GFXBucketSource*)internal->emptySources.begin;
-		gfx_deque_pop_begin(&internal->emptySources);
-
-		*(GFX_Source*)gfx_vector_at(&internal->sources, id - 1) = src;
-	}
-	else
-	{
-		/* Get index + 1 as ID, check for overflow, yet again */
-		size_t size = gfx_vector_get_size(&internal->sources);
-		id = size + 1;
-
-		if(id < size)
-		{
-			/* Overflow error */
-			gfx_errors_push(
-				GFX_ERROR_OVERFLOW,
-				"Overflow occurred during source insertion at a bucket."
-			);
-
-			_gfx_vertex_layout_unblock(layout, srcIndex);
-			return 0;
-		}
-
-		/* Insert a new source at the end */
-		GFXVectorIterator it = gfx_vector_insert(
-			&internal->sources,
-			&src,
-			internal->sources.end
-		);
+	GFXBucketSource id = gfx_slot_map_insert(
+		&((GFX_Bucket*)bucket)->sources,
+		&src
+	);
 
-		if(it == internal->sources.end)
-		{
-			_gfx_vertex_layout_unblock(layout, srcIndex);
-			return 0;
-		}
-	}
+	if(!id) _gfx_vertex_layout_unblock(layout, srcIndex);
 
 	return id;
 }
@@ -856,51 +2227,173 @@ void gfx_bucket_remove_source(
 		GFXBucketSource  src)
 {
 	GFX_Bucket* internal = (GFX_Bucket*)bucket;
-	GFX_Source* source = gfx_vector_at(&internal->sources, src - 1);
 
 	/* Derpsies */
-	size_t size = gfx_vector_get_size(&internal->sources);
-	if(src && src <= size && source->layout)
+	size_t index = gfx_slot_map_get_index(&internal->sources, src);
+	if(index--)
 	{
 		/* Unblock the layout */
+		GFX_Source* source = gfx_vector_at(&internal->sources.data, index);
 		_gfx_vertex_layout_unblock(source->layout, source->index);
 
-		if(src < size)
-		{
-			/* Save ID and mark as empty */
-			gfx_deque_push_end(&internal->emptySources, &src);
-			source->layout = NULL;
-		}
+		/* The last source takes its place */
+		unsigned int moved = gfx_slot_map_get_size(&internal->sources) - 1;
+		gfx_slot_map_erase_at(&internal->sources, index);
 
-		else if(src == size)
+		/* Erase any unit using the source */
+		/* And fix the references to the moved source */
+		GFX_Ref* ref;
+		for(
+			ref = internal->refs.data.begin;
+			ref != internal->refs.data.end;
+			ref = gfx_vector_next(&internal->refs.data, ref))
 		{
-			/* Remove last element */
-			gfx_vector_erase_at(&internal->sources, src - 1);
-			--size;
+			if(ref->src == index) _gfx_bucket_erase_unit(
+				internal,
+				gfx_vector_at(&internal->units, ref->unit - 1)
+			);
+
+			else if(ref->src == moved)
+				ref->src = index;
 		}
+	}
+}
+
+/******************************************************/
+static int _gfx_bucket_insert_units(
+
+		GFX_Bucket*                   bucket,
+		size_t                        num,
+		const GFXBucketSource*        srcs,
+		const GFXPropertyMap* const*  maps,
+		const unsigned int*           copies,
+		size_t                        stride,
+		int                           visible,
+		GFXBucketUnit*                ids)
+{
+	/* No IDs are returned on failure */
+	memset(ids, 0, sizeof(GFXBucketUnit) * num);
+
+	/* Validate all sources and maps first */
+	size_t i;
+	for(i = 0; i < (stride ? num : 1); ++i)
+	{
+		if(!maps[i] || !gfx_slot_map_get_index(&bucket->sources, srcs[i]))
+			return 0;
+	}
+
+	/* Reserve all memory at once */
+	/* Reallocating invalidates the visible iterator, so keep its index */
+	size_t size = gfx_vector_get_size(&bucket->units);
+	size_t vis = gfx_vector_get_index(&bucket->units, bucket->visible);
+
+	int reserved = gfx_vector_reserve(&bucket->units, size + num);
+	bucket->visible = gfx_vector_at(&bucket->units, vis);
+
+	if(!reserved)
+		return 0;
+	if(!gfx_slot_map_reserve(&bucket->refs, gfx_slot_map_get_size(&bucket->refs) + num))
+		return 0;
+
+	size_t failed = 0;
+
+	for(i = 0; i < num; ++i)
+	{
+		size_t index = gfx_slot_map_get_index(&bucket->sources, srcs[i * stride]);
+		GFX_Source* source = gfx_vector_at(&bucket->sources.data, index - 1);
+		const GFXPropertyMap* map = maps[i * stride];
+
+		/* Units are hidden while their programs are linking */
+		int status = _gfx_program_map_poll(map->programMap);
+		int ready = status == GFX_INT_MAP_READY;
+
+		/* Initialize the new unit */
+		GFX_Unit unit;
+		unit.state   = visible && ready ? GFX_INT_UNIT_VISIBLE : 0;
+		unit.program = _gfx_gl_program_map_get_handle(map->programMap);
+		unit.vao     = _gfx_gl_vertex_layout_get_handle(source->layout);
+		unit.depth   = _gfx_bucket_to_depth(0.0f);
+
+		/* Insert a reference for it */
+		GFX_Ref* ref = _gfx_bucket_insert_ref(
+			bucket,
+			size + i,
+			ids + i
+		);
+
+		if(!ref) break;
+		unit.ref = gfx_vector_get_index(&bucket->refs.data, ref);
+
+		/* Initialize the reference */
+		ref->src          = index - 1;
+		ref->map          = map;
+		ref->copy         = copies[i * stride];
+		ref->instances    = 1;
+		ref->instanceBase = 0;
+		ref->vertexBase   = source->vertexBase;
+		ref->indexBase    = 0;
+		ref->visible      = visible ? 1 : 0;
+		ref->pending      = status == GFX_INT_MAP_PENDING ? 1 : 0;
+		ref->failed       = status == GFX_INT_MAP_FAILED ? 1 : 0;
+
+		ref->bounds[0] = 0.0f;
+		ref->bounds[1] = 0.0f;
+		ref->bounds[2] = 0.0f;
+		ref->bounds[3] = -1.0f;
+
+		_gfx_bucket_set_draw_type(ref);
+
+		/* Insert the unit */
+		GFXVectorIterator it = gfx_vector_insert(
+			&bucket->units,
+			&unit,
+			bucket->units.end
+		);
 
-		/* Clear both deque and vector */
-		if(!size || size == gfx_deque_get_size(&internal->emptySources))
+		if(it == bucket->units.end)
 		{
-			gfx_vector_clear(&internal->sources);
-			gfx_deque_clear(&internal->emptySources);
+			_gfx_bucket_erase_ref(bucket, unit.ref);
+			break;
 		}
 
-		/* Erase any unit using the source */
-		GFX_Ref* ref;
-		--src;
+		bucket->pending += ref->pending;
+		failed += ref->failed;
+	}
 
-		for(
-			ref = internal->refs.begin;
-			ref != internal->refs.end;
-			ref = gfx_vector_next(&internal->refs, ref))
+	if(i < num)
+	{
+		/* Nevermind, erase them all again, newest first */
+		while(i--)
 		{
-			if(ref->src == src) _gfx_bucket_erase_unit(
-				internal,
-				gfx_vector_at(&internal->units, ref->unit - 1)
-			);
+			GFX_Unit* last = gfx_vector_previous(
+				&bucket->units,
+				bucket->units.end);
+
+			GFX_Ref* ref = gfx_vector_at(&bucket->refs.data, last->ref);
+			bucket->pending -= ref->pending;
+
+			_gfx_bucket_erase_ref(bucket, last->ref);
+			gfx_vector_erase(&bucket->units, last);
 		}
+
+		/* Including the ID of the unit that failed */
+		memset(ids, 0, sizeof(GFXBucketUnit) * num);
+
+		/* Erasing might shrink the vector */
+		bucket->visible = gfx_vector_at(&bucket->units, vis);
+
+		return 0;
 	}
+
+	/* Force to process, visible units will be merged */
+	if(num) bucket->flags |= GFX_INT_BUCKET_PROCESS_UNITS;
+
+	if(failed) gfx_errors_push(
+		GFX_ERROR_LINK_FAIL,
+		"Units inserted into a bucket are never drawn, their program map failed to link."
+	);
+
+	return 1;
 }
 
 /******************************************************/
@@ -912,58 +2405,61 @@ GFXBucketUnit gfx_bucket_insert(
 		unsigned int           copy,
 		int                    visible)
 {
-	--src;
-
-	/* Validate index & source */
-	GFX_Bucket* internal = (GFX_Bucket*)bucket;
-	GFX_Source* source = gfx_vector_at(&internal->sources, src);
-
-	size_t cnt = gfx_vector_get_size(&internal->sources);
-	if(!map || src >= cnt || !source->layout) return 0;
-
-	/* Initialize the new unit */
-	GFX_Unit unit;
-	unit.state   = visible ? GFX_INT_UNIT_VISIBLE : 0;
-	unit.program = _gfx_gl_program_map_get_handle(map->programMap);
-	unit.vao     = _gfx_gl_vertex_layout_get_handle(source->layout);
+	GFXBucketUnit id;
+	if(!_gfx_bucket_insert_units(
+		(GFX_Bucket*)bucket, 1, &src, &map, &copy, 0, visible, &id))
+	{
+		return 0;
+	}
 
-	/* Insert a reference for it */
-	GFX_Ref* ref = _gfx_bucket_insert_ref(
-		internal,
-		gfx_vector_get_size(&internal->units)
-	);
+	return id;
+}
 
-	if(!ref) return 0;
-	unit.ref = gfx_vector_get_index(&internal->refs, ref);
+/******************************************************/
+int gfx_bucket_insert_multiple(
 
-	/* Initialize the reference */
-	ref->src          = src;
-	ref->map          = map;
-	ref->copy         = copy;
-	ref->instances    = 1;
-	ref->instanceBase = 0;
-	ref->vertexBase   = 0;
+		GFXBucket*             bucket,
+		size_t                 num,
+		GFXBucketSource        src,
+		const GFXPropertyMap*  map,
+		unsigned int           copy,
+		int                    visible,
+		GFXBucketUnit*         units)
+{
+	return _gfx_bucket_insert_units(
+		(GFX_Bucket*)bucket, num, &src, &map, &copy, 0, visible, units);
+}
 
-	_gfx_bucket_set_draw_type(ref);
+/******************************************************/
+int gfx_bucket_insert_range(
+
+		GFXBucket*                    bucket,
+		size_t                        num,
+		const GFXBucketSource*        srcs,
+		const GFXPropertyMap* const*  maps,
+		const unsigned int*           copies,
+		int                           visible,
+		GFXBucketUnit*                units)
+{
+	return _gfx_bucket_insert_units(
+		(GFX_Bucket*)bucket, num, srcs, maps, copies, 1, visible, units);
+}
 
-	/* Insert the unit */
-	GFXVectorIterator it = gfx_vector_insert(
-		&internal->units,
-		&unit,
-		internal->units.end
-	);
+/******************************************************/
+static GFX_Unit* _gfx_bucket_get_unit(
 
-	if(it == internal->units.end)
-	{
-		_gfx_bucket_erase_ref(internal, unit.ref);
-		return 0;
-	}
+		const GFXBucket*  bucket,
+		GFXBucketUnit     unit,
+		GFX_Ref**         ref)
+{
+	/* Stale handles and erased units are invalid */
+	const GFX_Bucket* internal = (const GFX_Bucket*)bucket;
 
-	/* Force to process */
-	internal->flags |= GFX_INT_BUCKET_PROCESS_UNITS;
-	if(visible) internal->flags |= GFX_INT_BUCKET_SORT;
+	*ref = gfx_slot_map_at(&internal->refs, unit);
+	if(!*ref) return NULL;
 
-	return unit.ref + 1;
+	GFX_Unit* un = gfx_vector_at(&internal->units, (*ref)->unit - 1);
+	return un->state & GFX_INT_UNIT_ERASE ? NULL : un;
 }
 
 /******************************************************/
@@ -972,12 +2468,24 @@ void gfx_bucket_erase(
 		GFXBucket*     bucket,
 		GFXBucketUnit  unit)
 {
-	GFX_Ref* ref =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->refs, unit - 1);
-	GFX_Unit* un =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->units, ref->unit - 1);
+	gfx_bucket_erase_range(bucket, 1, &unit);
+}
+
+/******************************************************/
+void gfx_bucket_erase_range(
+
+		GFXBucket*            bucket,
+		size_t                num,
+		const GFXBucketUnit*  units)
+{
+	size_t i;
+	for(i = 0; i < num; ++i)
+	{
+		GFX_Ref* ref;
+		GFX_Unit* un = _gfx_bucket_get_unit(bucket, units[i], &ref);
 
-	_gfx_bucket_erase_unit((GFX_Bucket*)bucket, un);
+		if(un) _gfx_bucket_erase_unit((GFX_Bucket*)bucket, un);
+	}
 }
 
 /******************************************************/
@@ -986,8 +2494,8 @@ unsigned int gfx_bucket_get_copy(
 		const GFXBucket*  bucket,
 		GFXBucketUnit     unit)
 {
-	const GFX_Ref* ref =
-		gfx_vector_at(&((const GFX_Bucket*)bucket)->refs, unit - 1);
+	GFX_Ref* ref;
+	if(!_gfx_bucket_get_unit(bucket, unit, &ref)) return 0;
 
 	return ref->copy;
 }
@@ -998,8 +2506,8 @@ size_t gfx_bucket_get_instances(
 		const GFXBucket*  bucket,
 		GFXBucketUnit     unit)
 {
-	const GFX_Ref* ref =
-		gfx_vector_at(&((const GFX_Bucket*)bucket)->refs, unit - 1);
+	GFX_Ref* ref;
+	if(!_gfx_bucket_get_unit(bucket, unit, &ref)) return 0;
 
 	return ref->instances;
 }
@@ -1010,8 +2518,8 @@ unsigned int gfx_bucket_get_instance_base(
 		const GFXBucket*  bucket,
 		GFXBucketUnit     unit)
 {
-	const GFX_Ref* ref =
-		gfx_vector_at(&((const GFX_Bucket*)bucket)->refs, unit - 1);
+	GFX_Ref* ref;
+	if(!_gfx_bucket_get_unit(bucket, unit, &ref)) return 0;
 
 	return ref->instanceBase;
 }
@@ -1022,10 +2530,13 @@ unsigned int gfx_bucket_get_vertex_base(
 		const GFXBucket*  bucket,
 		GFXBucketUnit     unit)
 {
-	const GFX_Ref* ref =
-		gfx_vector_at(&((const GFX_Bucket*)bucket)->refs, unit - 1);
+	GFX_Ref* ref;
+	if(!_gfx_bucket_get_unit(bucket, unit, &ref)) return 0;
+
+	const GFX_Source* src =
+		gfx_vector_at(&((GFX_Bucket*)bucket)->sources.data, ref->src);
 
-	return ref->vertexBase;
+	return ref->vertexBase - src->vertexBase;
 }
 
 /******************************************************/
@@ -1034,16 +2545,15 @@ unsigned int gfx_bucket_get_index_base(
 		const GFXBucket*  bucket,
 		GFXBucketUnit     unit)
 {
-	const GFX_Ref* ref =
-		gfx_vector_at(&((const GFX_Bucket*)bucket)->refs, unit - 1);
+	GFX_Ref* ref;
+	if(!_gfx_bucket_get_unit(bucket, unit, &ref)) return 0;
+
 	const GFX_Source* src =
-		gfx_vector_at(&((const GFX_Bucket*)bucket)->sources, ref->src);
+		gfx_vector_at(&((const GFX_Bucket*)bucket)->sources.data, ref->src);
 
-	GFXDataType type;
-	type.unpacked = src->source.indexType;
-	unsigned char size = _gfx_sizeof_data_type(type);
+	unsigned char size = _gfx_sizeof_data_type(src->source.indexType);
 
-	return ref->indexBase / size;
+	return (unsigned int)(ref->indexBase / size);
 }
 
 /******************************************************/
@@ -1052,11 +2562,10 @@ GFXUnitState gfx_bucket_get_state(
 		const GFXBucket*  bucket,
 		GFXBucketUnit     unit)
 {
-	const GFX_Ref* ref =
-		gfx_vector_at(&((const GFX_Bucket*)bucket)->refs, unit - 1);
-	const GFX_Unit* un =
-		gfx_vector_at(&((const GFX_Bucket*)bucket)->units, ref->unit - 1);
+	GFX_Ref* ref;
+	const GFX_Unit* un = _gfx_bucket_get_unit(bucket, unit, &ref);
 
+	if(!un) return 0;
 	return un->state & GFX_INT_UNIT_MANUAL;
 }
 
@@ -1066,12 +2575,33 @@ int gfx_bucket_is_visible(
 		const GFXBucket*  bucket,
 		GFXBucketUnit     unit)
 {
-	const GFX_Ref* ref =
-		gfx_vector_at(&((const GFX_Bucket*)bucket)->refs, unit - 1);
-	const GFX_Unit* un =
-		gfx_vector_at(&((const GFX_Bucket*)bucket)->units, ref->unit - 1);
+	GFX_Ref* ref;
+	const GFX_Unit* un = _gfx_bucket_get_unit(bucket, unit, &ref);
+
+	if(!un) return 0;
+	return ref->visible;
+}
+
+/******************************************************/
+float gfx_bucket_get_depth(
+
+		const GFXBucket*  bucket,
+		GFXBucketUnit     unit)
+{
+	GFX_Ref* ref;
+	const GFX_Unit* un = _gfx_bucket_get_unit(bucket, unit, &ref);
+
+	if(!un) return 0.0f;
+	return _gfx_bucket_from_depth(un->depth);
+}
+
+/******************************************************/
+void gfx_bucket_get_stats(
 
-	return un->state & GFX_INT_UNIT_VISIBLE;
+		const GFXBucket*  bucket,
+		GFXBucketStats*   stats)
+{
+	*stats = ((const GFX_Bucket*)bucket)->stats;
 }
 
 /******************************************************/
@@ -1081,10 +2611,11 @@ void gfx_bucket_set_copy(
 		GFXBucketUnit  unit,
 		unsigned int   copy)
 {
-	GFX_Ref* ref =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->refs, unit - 1);
+	GFX_Ref* ref;
+	if(!_gfx_bucket_get_unit(bucket, unit, &ref)) return;
 
 	ref->copy = copy;
+	((GFX_Bucket*)bucket)->recorded = 0;
 }
 
 /******************************************************/
@@ -1094,11 +2625,13 @@ void gfx_bucket_set_instances(
 		GFXBucketUnit  unit,
 		size_t         instances)
 {
-	GFX_Ref* ref =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->refs, unit - 1);
+	GFX_Ref* ref;
+	if(!_gfx_bucket_get_unit(bucket, unit, &ref)) return;
 
 	ref->instances = instances;
 	_gfx_bucket_set_draw_type(ref);
+
+	((GFX_Bucket*)bucket)->recorded = 0;
 }
 
 /******************************************************/
@@ -1108,11 +2641,13 @@ void gfx_bucket_set_instance_base(
 		GFXBucketUnit  unit,
 		unsigned int   base)
 {
-	GFX_Ref* ref =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->refs, unit - 1);
+	GFX_Ref* ref;
+	if(!_gfx_bucket_get_unit(bucket, unit, &ref)) return;
 
 	ref->instanceBase = base;
 	_gfx_bucket_set_draw_type(ref);
+
+	((GFX_Bucket*)bucket)->recorded = 0;
 }
 
 /******************************************************/
@@ -1122,11 +2657,16 @@ void gfx_bucket_set_vertex_base(
 		GFXBucketUnit  unit,
 		unsigned int   base)
 {
-	GFX_Ref* ref =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->refs, unit - 1);
+	GFX_Ref* ref;
+	if(!_gfx_bucket_get_unit(bucket, unit, &ref)) return;
+
+	const GFX_Source* src =
+		gfx_vector_at(&((GFX_Bucket*)bucket)->sources.data, ref->src);
 
-	ref->vertexBase = base;
+	ref->vertexBase = src->vertexBase + base;
 	_gfx_bucket_set_draw_type(ref);
+
+	((GFX_Bucket*)bucket)->recorded = 0;
 }
 
 /******************************************************/
@@ -1136,16 +2676,16 @@ void gfx_bucket_set_index_base(
 		GFXBucketUnit  unit,
 		unsigned int   base)
 {
-	GFX_Ref* ref =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->refs, unit - 1);
+	GFX_Ref* ref;
+	if(!_gfx_bucket_get_unit(bucket, unit, &ref)) return;
+
 	GFX_Source* src =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->sources, ref->src);
+		gfx_vector_at(&((GFX_Bucket*)bucket)->sources.data, ref->src);
 
-	GFXDataType type;
-	type.unpacked = src->source.indexType;
-	unsigned char size = _gfx_sizeof_data_type(type);
+	unsigned char size = _gfx_sizeof_data_type(src->source.indexType);
 
-	ref->indexBase = base * size;
+	ref->indexBase = (size_t)base * size;
+	((GFX_Bucket*)bucket)->recorded = 0;
 }
 
 /******************************************************/
@@ -1155,19 +2695,147 @@ void gfx_bucket_set_state(
 		GFXBucketUnit  unit,
 		GFXUnitState   state)
 {
-	GFX_Ref* ref =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->refs, unit - 1);
-	GFX_Unit* un =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->units, ref->unit - 1);
+	gfx_bucket_set_state_range(bucket, 1, &unit, &state);
+}
 
-	/* Detect equal states */
-	/* Force a re-sort if visible */
-	state = (state & GFX_INT_UNIT_MANUAL) | (un->state & ~GFX_INT_UNIT_MANUAL);
+/******************************************************/
+static void _gfx_bucket_reserve_dirty(
 
-	if(un->state != state && (un->state & GFX_INT_UNIT_VISIBLE))
-		((GFX_Bucket*)bucket)->flags |= GFX_INT_BUCKET_SORT;
+		GFX_Bucket*  bucket,
+		size_t       num)
+{
+	/* Reserve for the worst case, force a re-sort on failure */
+	if(
+		!(bucket->flags & GFX_INT_BUCKET_SORT) &&
+		!gfx_vector_reserve(&bucket->dirty, gfx_vector_get_size(&bucket->dirty) + num))
+	{
+		bucket->flags |= GFX_INT_BUCKET_SORT;
+	}
+}
+
+/******************************************************/
+static void _gfx_bucket_set_dirty(
+
+		GFX_Bucket*      bucket,
+		const GFX_Unit*  unit,
+		GFXBucketUnit    id)
+{
+	/* Only visible units need to be merged */
+	if(
+		(unit->state & GFX_INT_UNIT_VISIBLE) &&
+		!(bucket->flags & GFX_INT_BUCKET_SORT))
+	{
+		GFXVectorIterator it = gfx_vector_insert(
+			&bucket->dirty,
+			&id,
+			bucket->dirty.end
+		);
+
+		if(it == bucket->dirty.end)
+			bucket->flags |= GFX_INT_BUCKET_SORT;
+		else
+			bucket->flags |= GFX_INT_BUCKET_MERGE;
+	}
+}
+
+/******************************************************/
+void gfx_bucket_set_state_range(
+
+		GFXBucket*            bucket,
+		size_t                num,
+		const GFXBucketUnit*  units,
+		const GFXUnitState*   states)
+{
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+	_gfx_bucket_reserve_dirty(internal, num);
+
+	size_t i;
+	for(i = 0; i < num; ++i)
+	{
+		GFX_Ref* ref;
+		GFX_Unit* un = _gfx_bucket_get_unit(bucket, units[i], &ref);
+
+		if(!un) continue;
+
+		/* Detect equal states */
+		GFXUnitState state =
+			(states[i] & GFX_INT_UNIT_MANUAL) | (un->state & ~GFX_INT_UNIT_MANUAL);
+
+		if(un->state != state)
+			_gfx_bucket_set_dirty(internal, un, units[i]);
+
+		un->state = state;
+	}
+}
+
+/******************************************************/
+void gfx_bucket_set_bounds(
+
+		GFXBucket*     bucket,
+		GFXBucketUnit  unit,
+		const float*   sphere)
+{
+	gfx_bucket_set_bounds_range(bucket, 1, &unit, sphere);
+}
+
+/******************************************************/
+void gfx_bucket_set_bounds_range(
+
+		GFXBucket*            bucket,
+		size_t                num,
+		const GFXBucketUnit*  units,
+		const float*          spheres)
+{
+	size_t i;
+	for(i = 0; i < num; ++i)
+	{
+		GFX_Ref* ref;
+		if(!_gfx_bucket_get_unit(bucket, units[i], &ref))
+			continue;
+
+		memcpy(ref->bounds, spheres + (i << 2), sizeof(ref->bounds));
+	}
+}
+
+/******************************************************/
+void gfx_bucket_set_depth(
+
+		GFXBucket*     bucket,
+		GFXBucketUnit  unit,
+		float          depth)
+{
+	gfx_bucket_set_depth_range(bucket, 1, &unit, &depth);
+}
+
+/******************************************************/
+void gfx_bucket_set_depth_range(
+
+		GFXBucket*            bucket,
+		size_t                num,
+		const GFXBucketUnit*  units,
+		const float*          depths)
+{
+	/* Only mark as dirty when sorting on depth */
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+	int sort = bucket->sort != GFX_BUCKET_SORT_STATE;
+
+	if(sort) _gfx_bucket_reserve_dirty(internal, num);
+
+	size_t i;
+	for(i = 0; i < num; ++i)
+	{
+		GFX_Ref* ref;
+		GFX_Unit* un = _gfx_bucket_get_unit(bucket, units[i], &ref);
+
+		if(!un) continue;
 
-	un->state = state;
+		uint32_t depth = _gfx_bucket_to_depth(depths[i]);
+
+		if(sort && un->depth != depth)
+			_gfx_bucket_set_dirty(internal, un, units[i]);
+
+		un->depth = depth;
+	}
 }
 
 /******************************************************/
@@ -1177,22 +2845,44 @@ void gfx_bucket_set_visible(
 		GFXBucketUnit  unit,
 		int            visible)
 {
-	GFX_Ref* ref =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->refs, unit - 1);
-	GFX_Unit* un =
-		gfx_vector_at(&((GFX_Bucket*)bucket)->units, ref->unit - 1);
+	gfx_bucket_set_visible_range(bucket, 1, &unit, &visible);
+}
+
+/******************************************************/
+void gfx_bucket_set_visible_range(
+
+		GFXBucket*            bucket,
+		size_t                num,
+		const GFXBucketUnit*  units,
+		const int*            visible)
+{
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+	int process = 0;
 
-	if(!(un->state & GFX_INT_UNIT_ERASE))
+	size_t i;
+	for(i = 0; i < num; ++i)
 	{
-		visible = visible ? 1 : 0;
-		int cur = un->state & GFX_INT_UNIT_VISIBLE ? 1 : 0;
+		GFX_Ref* ref;
+		GFX_Unit* un = _gfx_bucket_get_unit(bucket, units[i], &ref);
+
+		if(!un) continue;
 
-		if(visible != cur) ((GFX_Bucket*)bucket)->flags |=
-			GFX_INT_BUCKET_PROCESS_UNITS | GFX_INT_BUCKET_SORT;
+		ref->visible = visible[i] ? 1 : 0;
 
-		if(visible)
+		/* When culling, visible units are shown by the next cull */
+		/* Units waiting for their programs are shown when ready */
+		if(ref->visible && (internal->cull || ref->pending || ref->failed))
+			continue;
+
+		int cur = un->state & GFX_INT_UNIT_VISIBLE ? 1 : 0;
+		process |= ref->visible != cur;
+
+		if(ref->visible)
 			un->state |= GFX_INT_UNIT_VISIBLE;
 		else
 			un->state &= ~GFX_INT_UNIT_VISIBLE;
 	}
+
+	if(process) ((GFX_Bucket*)bucket)->flags |=
+		GFX_INT_BUCKET_PROCESS_UNITS;
 }
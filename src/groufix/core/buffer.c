@@ -32,6 +32,16 @@ const GFXRenderObjectFlags GFX_BUFFER_OBJECT_FLAGS =
 #endif
 
 
+/** Internal streaming backbuffer */
+typedef struct GFX_BufferRegion
+{
+	void*            ptr;    /* Persistently mapped or client memory */
+	unsigned char    mapped; /* Non-zero if ptr is persistently mapped */
+	GFX_FenceHandle  fence;  /* Placed when swapped away from, NULL if none */
+
+} GFX_BufferRegion;
+
+
 /** Internal Buffer */
 typedef struct GFX_Buffer
 {
@@ -42,9 +52,26 @@ typedef struct GFX_Buffer
 	GFX_RenderObjectID  id;
 	unsigned char       current;
 
+	GFX_BufferRegion*   regions; /* Of each backbuffer, NULL if not streaming */
+	size_t              head;    /* Next free byte of the current backbuffer */
+	size_t              flushed; /* Bytes of the current backbuffer visible to the GPU */
+
 } GFX_Buffer;
 
 
+/** Internal asynchronous read */
+typedef struct GFX_BufferRead
+{
+	/* Super class */
+	GFXBufferRead read;
+
+	/* Hidden data */
+	GFX_BufferHandle  handle; /* Staging buffer */
+	GFX_FenceHandle   fence;
+
+} GFX_BufferRead;
+
+
 /******************************************************/
 static inline GFX_BufferHandle* _gfx_buffer_get(
 
@@ -97,7 +124,8 @@ static inline GLbitfield _gfx_buffer_from_usage(
 		(usage & GFX_BUFFER_WRITE ? GL_DYNAMIC_STORAGE_BIT : 0) |
 		(usage & GFX_BUFFER_MAP_READ ? GL_MAP_READ_BIT : 0) |
 		(usage & GFX_BUFFER_MAP_WRITE ? GL_MAP_WRITE_BIT : 0) |
-		(usage & GFX_BUFFER_MAP_PERSISTENT ? GL_MAP_PERSISTENT_BIT : 0);
+		(usage & GFX_BUFFER_MAP_PERSISTENT ? GL_MAP_PERSISTENT_BIT : 0) |
+		(usage & GFX_BUFFER_STREAM ? GL_MAP_COHERENT_BIT : 0);
 }
 
 /******************************************************/
@@ -108,7 +136,8 @@ static inline GLbitfield _gfx_buffer_from_usage_to_access(
 	return
 		(usage & GFX_BUFFER_MAP_READ ? GL_MAP_READ_BIT : 0) |
 		(usage & GFX_BUFFER_MAP_WRITE ? GL_MAP_WRITE_BIT : 0) |
-		(usage & GFX_BUFFER_MAP_PERSISTENT ? GL_MAP_PERSISTENT_BIT : 0);
+		(usage & GFX_BUFFER_MAP_PERSISTENT ? GL_MAP_PERSISTENT_BIT : 0) |
+		(usage & GFX_BUFFER_STREAM ? GL_MAP_COHERENT_BIT : 0);
 }
 
 /******************************************************/
@@ -153,6 +182,28 @@ static void _gfx_buffer_clear(
 {
 #if defined(GFX_RENDERER_GL)
 
+	/* Deleting unmaps all streaming backbuffers */
+	if(buffer->regions)
+	{
+		unsigned char i;
+		for(i = 0; i < buffer->buffer.count; ++i)
+		{
+			GFX_BufferRegion* reg = buffer->regions + i;
+
+			if(reg->fence) GFX_REND_GET.DeleteSync(reg->fence);
+			if(reg->mapped) reg->ptr = NULL;
+
+			reg->mapped = 0;
+			reg->fence = NULL;
+		}
+	}
+
+	/* Deleting a bound buffer unbinds it */
+	unsigned char i;
+	for(i = 0; i < buffer->buffer.count; ++i)
+		if(GFX_REND_GET.indirect == *_gfx_buffer_get(buffer, i))
+			GFX_REND_GET.indirect = 0;
+
 	GFX_REND_GET.DeleteBuffers(
 		buffer->buffer.count,
 		_gfx_buffer_get(buffer, 0));
@@ -165,6 +216,46 @@ static void _gfx_buffer_clear(
 		buffer->buffer.count * sizeof(GFX_BufferHandle));
 }
 
+/******************************************************/
+static int _gfx_buffer_map_region(
+
+		GFX_Buffer*    buffer,
+		unsigned char  index,
+		GFX_CONT_ARG)
+{
+	GFX_BufferRegion* reg = buffer->regions + index;
+
+#if defined(GFX_RENDERER_GL)
+
+	/* Try to persistently map the backbuffer */
+	if(GFX_REND_GET.intExt[GFX_INT_EXT_BUFFER_STORAGE])
+	{
+		void* ptr = GFX_REND_GET.MapNamedBufferRange(
+			*_gfx_buffer_get(buffer, index),
+			0,
+			buffer->buffer.size,
+			_gfx_buffer_from_usage_to_access(buffer->buffer.usage)
+		);
+
+		if(ptr)
+		{
+			free(reg->ptr);
+			reg->ptr = ptr;
+			reg->mapped = 1;
+
+			return 1;
+		}
+	}
+
+#endif
+
+	/* Fall back to client memory */
+	if(!reg->ptr) reg->ptr = malloc(buffer->buffer.size);
+	if(!reg->ptr) return 0;
+
+	return 1;
+}
+
 /******************************************************/
 static int _gfx_buffer_init(
 
@@ -220,11 +311,107 @@ static int _gfx_buffer_init(
 		}
 	}
 
+	/* Map all backbuffers of a streaming buffer */
+	if(buffer->regions) for(i = 0; i < buffer->buffer.count; ++i)
+		if(!_gfx_buffer_map_region(buffer, i, GFX_CONT_AS_ARG))
+		{
+			_gfx_buffer_clear(buffer, GFX_CONT_AS_ARG);
+			return 0;
+		}
+
 #endif
 
+	buffer->head = 0;
+	buffer->flushed = 0;
+
 	return 1;
 }
 
+/******************************************************/
+static void _gfx_buffer_free_regions(
+
+		GFX_Buffer* buffer)
+{
+	if(buffer->regions)
+	{
+		/* Only client memory is left */
+		unsigned char i;
+		for(i = 0; i < buffer->buffer.count; ++i)
+			if(!buffer->regions[i].mapped) free(buffer->regions[i].ptr);
+
+		free(buffer->regions);
+		buffer->regions = NULL;
+	}
+}
+
+/******************************************************/
+static void _gfx_buffer_stream_flush(
+
+		GFX_Buffer* buffer,
+		GFX_CONT_ARG)
+{
+	GFX_BufferRegion* reg = buffer->regions + buffer->current;
+
+#if defined(GFX_RENDERER_GL)
+
+	/* Upload from client memory if not mapped */
+	if(!reg->mapped && reg->ptr && buffer->head > buffer->flushed)
+		GFX_REND_GET.NamedBufferSubData(
+			*_gfx_buffer_get(buffer, buffer->current),
+			buffer->flushed,
+			buffer->head - buffer->flushed,
+			GFX_PTR_ADD_BYTES(reg->ptr, buffer->flushed)
+		);
+
+#endif
+
+	buffer->flushed = buffer->head;
+}
+
+/******************************************************/
+static void _gfx_buffer_stream_swap(
+
+		GFX_Buffer* buffer,
+		GFX_CONT_ARG)
+{
+	_gfx_buffer_stream_flush(buffer, GFX_CONT_AS_ARG);
+
+	GFX_BufferRegion* reg = buffer->regions + buffer->current;
+
+#if defined(GFX_RENDERER_GL)
+
+	/* Fence the backbuffer for all issued commands */
+	if(reg->fence) GFX_REND_GET.DeleteSync(reg->fence);
+	reg->fence = GFX_REND_GET.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+#endif
+
+	/* Advance and wait for the GPU to release the next backbuffer */
+	buffer->current = (buffer->current + 1) % buffer->buffer.count;
+	buffer->head = 0;
+	buffer->flushed = 0;
+
+	reg = buffer->regions + buffer->current;
+
+#if defined(GFX_RENDERER_GL)
+
+	if(reg->fence)
+	{
+		GLenum result;
+		do result = GFX_REND_GET.ClientWaitSync(
+			reg->fence,
+			GL_SYNC_FLUSH_COMMANDS_BIT,
+			1000000000);
+
+		while(result == GL_TIMEOUT_EXPIRED);
+
+		GFX_REND_GET.DeleteSync(reg->fence);
+		reg->fence = NULL;
+	}
+
+#endif
+}
+
 /******************************************************/
 static void _gfx_buffer_obj_destruct(
 
@@ -348,6 +535,12 @@ GFXBuffer* gfx_buffer_create(
 		const void*     data,
 		unsigned char   count)
 {
+	/* Streaming requires writing to a persistent mapping */
+	if(usage & GFX_BUFFER_STREAM) usage |=
+		GFX_BUFFER_WRITE |
+		GFX_BUFFER_MAP_WRITE |
+		GFX_BUFFER_MAP_PERSISTENT;
+
 	/* Herpaderp */
 	if(
 		!size ||
@@ -357,6 +550,16 @@ GFXBuffer* gfx_buffer_create(
 		return NULL;
 	}
 
+	/* With a single backbuffer every swap would wait for the GPU */
+	if((usage & GFX_BUFFER_STREAM) && count < 2)
+	{
+		gfx_errors_push(
+			GFX_ERROR_INVALID_VALUE,
+			"A streaming buffer needs at least two backbuffers."
+		);
+		return NULL;
+	}
+
 	GFX_CONT_INIT(NULL);
 
 	/* Always create at least one buffer */
@@ -380,9 +583,26 @@ GFXBuffer* gfx_buffer_create(
 	buffer->buffer.size = size;
 	buffer->buffer.count = count;
 
+	if(usage & GFX_BUFFER_STREAM)
+	{
+		buffer->regions = calloc(count, sizeof(GFX_BufferRegion));
+		if(!buffer->regions)
+		{
+			/* Out of memory error */
+			gfx_errors_output(
+				"[GFX Out Of Memory]: Buffer could not allocate its streaming regions."
+			);
+			free(buffer);
+
+			return NULL;
+		}
+	}
+
 	if(!_gfx_buffer_init(buffer, 1, &data, GFX_CONT_AS_ARG))
 	{
+		_gfx_buffer_free_regions(buffer);
 		free(buffer);
+
 		return NULL;
 	}
 
@@ -395,6 +615,7 @@ GFXBuffer* gfx_buffer_create(
 		&GFX_CONT_GET.objects))
 	{
 		_gfx_buffer_clear(buffer, GFX_CONT_AS_ARG);
+		_gfx_buffer_free_regions(buffer);
 		free(buffer);
 
 		return NULL;
@@ -445,6 +666,7 @@ void gfx_buffer_free(
 		/* Clear as object */
 		/* Object clearing will call the destruct callback */
 		_gfx_render_object_id_clear(&((GFX_Buffer*)buffer)->id);
+		_gfx_buffer_free_regions((GFX_Buffer*)buffer);
 		free(buffer);
 	}
 }
@@ -461,7 +683,10 @@ void gfx_buffer_swap(
 	if(!_gfx_buffer_check(internal, GFX_CONT_AS_ARG)) return;
 
 	/* Get new current index */
-	internal->current = (internal->current + 1) % buffer->count;
+	if(internal->regions)
+		_gfx_buffer_stream_swap(internal, GFX_CONT_AS_ARG);
+	else
+		internal->current = (internal->current + 1) % buffer->count;
 }
 
 /******************************************************/
@@ -485,6 +710,7 @@ size_t gfx_buffer_read(
 	size = (offset + size > buffer->size) ?
 		buffer->size - offset : size;
 
+	/* Read directly, a staging copy only pays off when not waiting */
 #if defined(GFX_RENDERER_GL)
 
 	GFX_REND_GET.GetNamedBufferSubData(
@@ -499,6 +725,162 @@ size_t gfx_buffer_read(
 	return size;
 }
 
+/******************************************************/
+GFXBufferRead* gfx_buffer_read_async(
+
+		const GFXBuffer*  buffer,
+		size_t            size,
+		size_t            offset)
+{
+	/* Derp */
+	if(!size || offset >= buffer->size) return NULL;
+
+	/* Check context */
+	GFX_CONT_INIT(NULL);
+
+	const GFX_Buffer* internal = (const GFX_Buffer*)buffer;
+	if(!_gfx_buffer_check(internal, GFX_CONT_AS_ARG)) return NULL;
+
+	/* Clip offset and size */
+	size = (offset + size > buffer->size) ?
+		buffer->size - offset : size;
+
+	/* Create new read */
+	GFX_BufferRead* read = calloc(1, sizeof(GFX_BufferRead));
+	if(!read)
+	{
+		/* Out of memory error */
+		gfx_errors_output(
+			"[GFX Out Of Memory]: Buffer read could not be allocated."
+		);
+		return NULL;
+	}
+
+	read->read.size = size;
+
+#if defined(GFX_RENDERER_GL)
+
+	/* Create the staging buffer */
+	GFX_REND_GET.CreateBuffers(1, &read->handle);
+	if(!read->handle)
+	{
+		free(read);
+		return NULL;
+	}
+
+	if(GFX_REND_GET.intExt[GFX_INT_EXT_BUFFER_STORAGE])
+		GFX_REND_GET.NamedBufferStorage(
+			read->handle,
+			size,
+			NULL,
+			GL_MAP_READ_BIT);
+	else
+		GFX_REND_GET.NamedBufferData(
+			read->handle,
+			size,
+			NULL,
+			GL_STREAM_READ);
+
+	/* Copy and fence */
+	GFX_REND_GET.CopyNamedBufferSubData(
+		*_gfx_buffer_get(internal, internal->current),
+		read->handle,
+		offset,
+		0,
+		size
+	);
+
+	read->fence = GFX_REND_GET.FenceSync(
+		GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+#endif
+
+	return (GFXBufferRead*)read;
+}
+
+/******************************************************/
+int gfx_buffer_read_poll(
+
+		GFXBufferRead* read)
+{
+	GFX_BufferRead* internal = (GFX_BufferRead*)read;
+	if(!internal->fence) return 1;
+
+	/* Check context */
+	GFX_CONT_INIT(0);
+
+#if defined(GFX_RENDERER_GL)
+
+	GLenum result = GFX_REND_GET.ClientWaitSync(
+		internal->fence,
+		GL_SYNC_FLUSH_COMMANDS_BIT,
+		0);
+
+	if(result == GL_TIMEOUT_EXPIRED)
+		return 0;
+
+	GFX_REND_GET.DeleteSync(internal->fence);
+
+#endif
+
+	internal->fence = NULL;
+
+	return 1;
+}
+
+/******************************************************/
+size_t gfx_buffer_read_finish(
+
+		GFXBufferRead*  read,
+		void*           data)
+{
+	GFX_BufferRead* internal = (GFX_BufferRead*)read;
+	size_t size = 0;
+
+	/* Check context, leaks the staging buffer without */
+	GFX_CONT_INIT_UNSAFE;
+
+	if(!GFX_CONT_EQ(NULL))
+	{
+#if defined(GFX_RENDERER_GL)
+
+		/* Wait for the copy */
+		if(internal->fence)
+		{
+			GLenum result;
+			do result = GFX_REND_GET.ClientWaitSync(
+				internal->fence,
+				GL_SYNC_FLUSH_COMMANDS_BIT,
+				1000000000);
+
+			while(result == GL_TIMEOUT_EXPIRED);
+
+			GFX_REND_GET.DeleteSync(internal->fence);
+		}
+
+		/* Read and free the staging buffer */
+		if(data)
+		{
+			GFX_REND_GET.GetNamedBufferSubData(
+				internal->handle,
+				0,
+				read->size,
+				data
+			);
+
+			size = read->size;
+		}
+
+		GFX_REND_GET.DeleteBuffers(1, &internal->handle);
+
+#endif
+	}
+
+	free(read);
+
+	return size;
+}
+
 /******************************************************/
 size_t gfx_buffer_write(
 
@@ -709,3 +1091,46 @@ int gfx_buffer_unmap(
 
 	return success;
 }
+
+/******************************************************/
+void* gfx_buffer_stream_alloc(
+
+		GFXBuffer*  buffer,
+		size_t      size,
+		size_t      align,
+		size_t*     offset)
+{
+	GFX_Buffer* internal = (GFX_Buffer*)buffer;
+	if(!size || !internal->regions) return NULL;
+
+	/* Lost its context */
+	GFX_BufferRegion* reg = internal->regions + internal->current;
+	if(!reg->ptr) return NULL;
+
+	/* Align and check if it fits */
+	align = align ? align : 1;
+	size_t head = (internal->head + align - 1) / align * align;
+
+	if(head > buffer->size || size > buffer->size - head)
+		return NULL;
+
+	internal->head = head + size;
+	*offset = head;
+
+	return GFX_PTR_ADD_BYTES(reg->ptr, head);
+}
+
+/******************************************************/
+void gfx_buffer_stream_flush(
+
+		GFXBuffer* buffer)
+{
+	/* Check context */
+	GFX_CONT_INIT();
+
+	GFX_Buffer* internal = (GFX_Buffer*)buffer;
+	if(!internal->regions || !_gfx_buffer_check(internal, GFX_CONT_AS_ARG))
+		return;
+
+	_gfx_buffer_stream_flush(internal, GFX_CONT_AS_ARG);
+}
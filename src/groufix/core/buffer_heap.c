@@ -0,0 +1,383 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/containers/vector.h"
+#include "groufix/core/errors.h"
+#include "groufix/core/memory.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Smallest range to ever hand out */
+#define GFX_INT_HEAP_MIN_SIZE  16
+
+/******************************************************/
+/** Internal free block */
+typedef struct GFX_HeapBlock
+{
+	GFXBuffer*  buffer; /* Backing buffer */
+	size_t      offset;
+
+} GFX_HeapBlock;
+
+
+/** Internal buffer heap */
+typedef struct GFX_Heap
+{
+	/* Super class */
+	GFXBufferHeap heap;
+
+	/* Hidden data */
+	GFXVector      buffers; /* Stores GFXBuffer* */
+	unsigned char  orders;  /* Number of block sizes, sorted free lists are appended to the struct */
+
+} GFX_Heap;
+
+
+/******************************************************/
+static inline size_t _gfx_buffer_heap_round(
+
+		size_t size)
+{
+	/* No power of two to round up to, return 0 */
+	if(size > (SIZE_MAX >> 1) + 1) return 0;
+
+	size_t round = GFX_INT_HEAP_MIN_SIZE;
+	while(round < size) round <<= 1;
+
+	return round;
+}
+
+/******************************************************/
+static inline GFXVector* _gfx_buffer_heap_get_free(
+
+		GFX_Heap*      heap,
+		unsigned char  order)
+{
+	return ((GFXVector*)(heap + 1)) + order;
+}
+
+/******************************************************/
+static inline int _gfx_buffer_heap_compare(
+
+		const GFX_HeapBlock*  a,
+		const GFX_HeapBlock*  b)
+{
+	uintptr_t bufA = (uintptr_t)a->buffer;
+	uintptr_t bufB = (uintptr_t)b->buffer;
+
+	if(bufA != bufB) return bufA < bufB ? -1 : 1;
+	return a->offset < b->offset ? -1 : (a->offset > b->offset ? 1 : 0);
+}
+
+/******************************************************/
+static int _gfx_buffer_heap_find(
+
+		const GFXVector*      free,
+		const GFX_HeapBlock*  block,
+		size_t*               index)
+{
+	/* Binary search for the first block not less than the given block */
+	size_t min = 0;
+	size_t max = gfx_vector_get_size(free);
+
+	while(min < max)
+	{
+		size_t mid = min + ((max - min) >> 1);
+		if(_gfx_buffer_heap_compare(gfx_vector_at(free, mid), block) < 0)
+			min = mid + 1;
+		else
+			max = mid;
+	}
+
+	*index = min;
+
+	return
+		min < gfx_vector_get_size(free) &&
+		!_gfx_buffer_heap_compare(gfx_vector_at(free, min), block);
+}
+
+/******************************************************/
+static int _gfx_buffer_heap_insert(
+
+		GFXVector*            free,
+		const GFX_HeapBlock*  block)
+{
+	size_t index;
+	_gfx_buffer_heap_find(free, block, &index);
+
+	return gfx_vector_insert_at(free, block, index) != free->end;
+}
+
+/******************************************************/
+static int _gfx_buffer_heap_get_order(
+
+		const GFX_Heap*  heap,
+		size_t           size,
+		unsigned char*   order)
+{
+	unsigned char o;
+	for(o = 0; o < heap->orders; ++o)
+		if((heap->heap.minSize << o) >= size)
+		{
+			*order = o;
+			return 1;
+		}
+
+	return 0;
+}
+
+/******************************************************/
+static int _gfx_buffer_heap_take(
+
+		GFX_Heap*       heap,
+		unsigned char   order,
+		GFX_HeapBlock*  block)
+{
+	/* Find the smallest free block that fits */
+	unsigned char o = order;
+	while(o < heap->orders && !gfx_vector_get_size(_gfx_buffer_heap_get_free(heap, o)))
+		++o;
+
+	if(o < heap->orders)
+	{
+		GFXVector* free = _gfx_buffer_heap_get_free(heap, o);
+		*block = *(GFX_HeapBlock*)gfx_vector_at(free, gfx_vector_get_size(free) - 1);
+
+		gfx_vector_erase_at(free, gfx_vector_get_size(free) - 1);
+	}
+
+	else
+	{
+		/* Nothing left, add a new backing buffer */
+		o = heap->orders - 1;
+
+		GFXBuffer* buffer = gfx_buffer_create(
+			heap->heap.usage,
+			heap->heap.blockSize,
+			NULL,
+			1
+		);
+
+		if(!buffer) return 0;
+
+		GFXVectorIterator it = gfx_vector_insert(
+			&heap->buffers,
+			&buffer,
+			heap->buffers.end
+		);
+
+		if(it == heap->buffers.end)
+		{
+			gfx_buffer_free(buffer);
+			return 0;
+		}
+
+		block->buffer = buffer;
+		block->offset = 0;
+	}
+
+	/* Split it until it is of the right order */
+	/* The free lists were shrunk or not touched, so there is memory */
+	while(o > order)
+	{
+		--o;
+
+		GFX_HeapBlock buddy =
+		{
+			.buffer = block->buffer,
+			.offset = block->offset + (heap->heap.minSize << o)
+		};
+
+		if(!_gfx_buffer_heap_insert(_gfx_buffer_heap_get_free(heap, o), &buddy))
+		{
+			/* Put the remainder back in one piece */
+			_gfx_buffer_heap_insert(_gfx_buffer_heap_get_free(heap, o + 1), block);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/******************************************************/
+GFXBufferHeap* gfx_buffer_heap_create(
+
+		GFXBufferUsage  usage,
+		size_t          blockSize,
+		size_t          minSize)
+{
+	/* Backing buffers have a single backbuffer, which cannot stream */
+	if(usage & GFX_BUFFER_STREAM)
+	{
+		gfx_errors_push(
+			GFX_ERROR_INVALID_VALUE,
+			"A buffer heap cannot be used for streaming."
+		);
+		return NULL;
+	}
+
+	/* Compute block sizes */
+	minSize = _gfx_buffer_heap_round(minSize);
+	blockSize = _gfx_buffer_heap_round(blockSize);
+
+	if(!minSize || !blockSize)
+	{
+		gfx_errors_push(
+			GFX_ERROR_OVERFLOW,
+			"Buffer heap sizes could not be rounded up to a power of two."
+		);
+		return NULL;
+	}
+
+	blockSize = blockSize < minSize ? minSize : blockSize;
+
+	unsigned char orders = 1;
+	while((minSize << (orders - 1)) < blockSize) ++orders;
+
+	/* Allocate heap, append free lists to the struct */
+	GFX_Heap* heap = malloc(sizeof(GFX_Heap) + sizeof(GFXVector) * orders);
+	if(!heap)
+	{
+		/* Out of memory error */
+		gfx_errors_output(
+			"[GFX Out Of Memory]: Buffer heap could not be allocated."
+		);
+		return NULL;
+	}
+
+	heap->heap.usage = usage;
+	heap->heap.blockSize = blockSize;
+	heap->heap.minSize = minSize;
+	heap->orders = orders;
+
+	gfx_vector_init(&heap->buffers, sizeof(GFXBuffer*));
+
+	while(orders--) gfx_vector_init(
+		_gfx_buffer_heap_get_free(heap, orders),
+		sizeof(GFX_HeapBlock));
+
+	return (GFXBufferHeap*)heap;
+}
+
+/******************************************************/
+void gfx_buffer_heap_free(
+
+		GFXBufferHeap* heap)
+{
+	if(heap)
+	{
+		GFX_Heap* internal = (GFX_Heap*)heap;
+
+		/* Free all backing buffers */
+		GFXVectorIterator it;
+		for(
+			it = internal->buffers.begin;
+			it != internal->buffers.end;
+			it = gfx_vector_next(&internal->buffers, it))
+		{
+			gfx_buffer_free(*(GFXBuffer**)it);
+		}
+
+		unsigned char o;
+		for(o = 0; o < internal->orders; ++o)
+			gfx_vector_clear(_gfx_buffer_heap_get_free(internal, o));
+
+		gfx_vector_clear(&internal->buffers);
+		free(heap);
+	}
+}
+
+/******************************************************/
+int gfx_buffer_heap_alloc(
+
+		GFXBufferHeap*   heap,
+		size_t           size,
+		size_t           align,
+		GFXBufferRange*  range)
+{
+	GFX_Heap* internal = (GFX_Heap*)heap;
+
+	/* Blocks are aligned to their own size */
+	align = align ? align : 1;
+	if(!size || (align & (align - 1))) return 0;
+
+	unsigned char order;
+	if(!_gfx_buffer_heap_get_order(
+		internal,
+		size > align ? size : align,
+		&order))
+	{
+		return 0;
+	}
+
+	/* Take a block */
+	GFX_HeapBlock block;
+	if(!_gfx_buffer_heap_take(internal, order, &block))
+		return 0;
+
+	range->buffer = block.buffer;
+	range->offset = block.offset;
+	range->size = heap->minSize << order;
+
+	return 1;
+}
+
+/******************************************************/
+void gfx_buffer_heap_release(
+
+		GFXBufferHeap*         heap,
+		const GFXBufferRange*  range)
+{
+	GFX_Heap* internal = (GFX_Heap*)heap;
+
+	/* Find the block size */
+	GFX_HeapBlock block;
+	unsigned char order;
+
+	if(!_gfx_buffer_heap_get_order(internal, range->size, &order))
+		return;
+
+	block.buffer = range->buffer;
+	block.offset = range->offset;
+
+	/* Merge with free buddies */
+	while(order < internal->orders - 1)
+	{
+		GFX_HeapBlock buddy =
+		{
+			.buffer = block.buffer,
+			.offset = block.offset ^ (heap->minSize << order)
+		};
+
+		GFXVector* free = _gfx_buffer_heap_get_free(internal, order);
+
+		size_t index;
+		if(!_gfx_buffer_heap_find(free, &buddy, &index)) break;
+
+		gfx_vector_erase_at(free, index);
+		block.offset = block.offset < buddy.offset ? block.offset : buddy.offset;
+
+		++order;
+	}
+
+	/* Insert the merged block */
+	if(!_gfx_buffer_heap_insert(_gfx_buffer_heap_get_free(internal, order), &block))
+	{
+		/* Out of memory error */
+		gfx_errors_output(
+			"[GFX Out Of Memory]: Buffer heap lost a range during release."
+		);
+	}
+}
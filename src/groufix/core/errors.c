@@ -11,6 +11,8 @@
  * or (at your option) any later version.
  *
  */
+#include "groufix/containers/allocator.h"
+#include "groufix/containers/deque.h"
 
 #include "groufix/core/renderer.h"
 #include "groufix/core/threading.h"
@@ -18,6 +20,10 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+/* Descriptions up to this size (including null terminator) are pooled */
+#define GFX_INT_ERROR_POOL_SIZE  128
 
 /******************************************************/
 /** Internal error */
@@ -41,6 +47,10 @@ static GFXErrorMode _gfx_error_mode;
 static GFXDeque _gfx_errors;
 
 
+/** Memory of all descriptions */
+static GFXPool _gfx_error_pool;
+
+
 /** Synchronize any access */
 static GFX_PlatformMutex  _gfx_error_mutex;
 
@@ -54,6 +64,32 @@ static inline void _gfx_errors_poll(void)
 		_gfx_renderer_poll_errors(GFX_CONT_AS_ARG);
 }
 
+/******************************************************/
+static void _gfx_errors_free(
+
+		GFX_Error* error)
+{
+	/* The pool needs the size to know where it came from */
+	if(error->description) gfx_allocator_realloc(
+		&_gfx_error_pool.allocator,
+		error->description,
+		strlen(error->description) + 1,
+		0);
+}
+
+/******************************************************/
+static void _gfx_errors_free_all(void)
+{
+	GFX_Error* it;
+	for(
+		it = _gfx_errors.begin;
+		it != _gfx_errors.end;
+		it = gfx_deque_next(&_gfx_errors, it))
+	{
+		_gfx_errors_free(it);
+	}
+}
+
 /******************************************************/
 static GFX_Error* _gfx_errors_last(void)
 {
@@ -78,6 +114,11 @@ int _gfx_errors_init(
 	_gfx_error_mode = mode;
 	gfx_deque_init(&_gfx_errors, sizeof(GFX_Error));
 
+	gfx_pool_init(
+		&_gfx_error_pool,
+		GFX_INT_ERROR_POOL_SIZE,
+		GFX_MAX_ERRORS_DEFAULT);
+
 	return 1;
 }
 
@@ -90,7 +131,10 @@ GFXErrorMode _gfx_errors_get_mode(void)
 /******************************************************/
 void _gfx_errors_terminate(void)
 {
+	_gfx_errors_free_all();
+
 	gfx_deque_clear(&_gfx_errors);
+	gfx_pool_clear(&_gfx_error_pool);
 	_gfx_platform_mutex_clear(&_gfx_error_mutex);
 }
 
@@ -157,7 +201,7 @@ void gfx_errors_pop(void)
 	if(err)
 	{
 		/* Make sure to free it properly */
-		free(err->description);
+		_gfx_errors_free(err);
 		gfx_deque_pop_begin(&_gfx_errors);
 	}
 
@@ -173,8 +217,13 @@ void gfx_errors_push(
 {
 	_gfx_platform_mutex_lock(&_gfx_error_mutex);
 
-	if(gfx_deque_get_size(&_gfx_errors) == _gfx_errors_maximum)
+	if(
+		_gfx_errors.begin != _gfx_errors.end &&
+		gfx_deque_get_size(&_gfx_errors) == _gfx_errors_maximum)
+	{
+		_gfx_errors_free(gfx_deque_previous(&_gfx_errors, _gfx_errors.end));
 		gfx_deque_pop_end(&_gfx_errors);
+	}
 
 	/* Construct an error */
 	GFX_Error error =
@@ -201,7 +250,8 @@ void gfx_errors_push(
 		{
 			va_start(vl, description);
 
-			error.description = malloc(size);
+			error.description = gfx_allocator_realloc(
+				&_gfx_error_pool.allocator, NULL, 0, size);
 
 			if(error.description)
 				vsnprintf(error.description, size, description, vl);
@@ -240,15 +290,7 @@ void gfx_errors_empty(void)
 	_gfx_platform_mutex_lock(&_gfx_error_mutex);
 
 	/* Free all descriptions */
-	GFX_Error* it;
-	for(
-		it = _gfx_errors.begin;
-		it != _gfx_errors.end;
-		it = gfx_deque_next(&_gfx_errors, it))
-	{
-		free(it->description);
-	}
-
+	_gfx_errors_free_all();
 	gfx_deque_clear(&_gfx_errors);
 
 	_gfx_platform_mutex_unlock(&_gfx_error_mutex);
@@ -266,9 +308,7 @@ void gfx_errors_set_maximum(
 	/* Remove errors */
 	while(gfx_deque_get_size(&_gfx_errors) > max)
 	{
-		GFX_Error* it = gfx_deque_previous(&_gfx_errors, _gfx_errors.end);
-		free(it->description);
-
+		_gfx_errors_free(gfx_deque_previous(&_gfx_errors, _gfx_errors.end));
 		gfx_deque_pop_end(&_gfx_errors);
 	}
 
@@ -0,0 +1,191 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/core/utils.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/******************************************************/
+/** Internal name lookup entry */
+typedef struct GFX_Name
+{
+	size_t          hash;
+	size_t          name;  /* Offset of the name in the names vector */
+	unsigned short  index; /* Index of the property or block + 1, 0 if empty */
+	unsigned char   block; /* Non-zero if the index is of a block */
+
+} GFX_Name;
+
+
+/******************************************************/
+static size_t _gfx_name_table_hash(
+
+		const char*  name,
+		size_t       len)
+{
+	/* FNV-1a */
+	size_t hash = 2166136261u;
+	while(len--) hash = (hash ^ (unsigned char)*(name++)) * 16777619u;
+
+	return hash;
+}
+
+/******************************************************/
+void _gfx_name_table_init(
+
+		GFX_NameTable* table)
+{
+	gfx_vector_init(&table->names, sizeof(char));
+	gfx_vector_init(&table->lookup, sizeof(GFX_Name));
+}
+
+/******************************************************/
+void _gfx_name_table_clear(
+
+		GFX_NameTable* table)
+{
+	gfx_vector_clear(&table->names);
+	gfx_vector_clear(&table->lookup);
+}
+
+/******************************************************/
+void _gfx_name_table_add(
+
+		GFX_NameTable*  table,
+		const char*     name,
+		size_t          len,
+		unsigned short  index,
+		unsigned char   block)
+{
+	/* Store the name itself */
+	size_t offset = gfx_vector_get_size(&table->names);
+
+	GFXVectorIterator it = gfx_vector_insert_range(
+		&table->names,
+		len + 1,
+		NULL,
+		table->names.end
+	);
+
+	if(it == table->names.end) return;
+
+	memcpy(it, name, len);
+	((char*)it)[len] = 0;
+
+	/* Store the entry, hashed later on */
+	GFX_Name entry =
+	{
+		.hash  = _gfx_name_table_hash(name, len),
+		.name  = offset,
+		.index = index + 1,
+		.block = block
+	};
+
+	it = gfx_vector_insert(
+		&table->lookup,
+		&entry,
+		table->lookup.end
+	);
+
+	if(it == table->lookup.end)
+		gfx_vector_erase_range_at(&table->names, len + 1, offset);
+}
+
+/******************************************************/
+void _gfx_name_table_build(
+
+		GFX_NameTable* table)
+{
+	/* Copy all added entries */
+	size_t num = gfx_vector_get_size(&table->lookup);
+	if(!num) return;
+
+	GFX_Name* entries = malloc(sizeof(GFX_Name) * num);
+	if(!entries)
+	{
+		gfx_vector_clear(&table->lookup);
+		return;
+	}
+
+	memcpy(entries, table->lookup.begin, sizeof(GFX_Name) * num);
+
+	/* Keep the table at most half full */
+	size_t size = 1;
+	while(size < (num << 1)) size <<= 1;
+
+	gfx_vector_clear(&table->lookup);
+	GFXVectorIterator it = gfx_vector_insert_range(
+		&table->lookup,
+		size,
+		NULL,
+		table->lookup.end
+	);
+
+	if(it != table->lookup.end)
+	{
+		memset(it, 0, sizeof(GFX_Name) * size);
+
+		/* Insert all entries using linear probing */
+		size_t e;
+		for(e = 0; e < num; ++e)
+		{
+			size_t i = entries[e].hash & (size - 1);
+			GFX_Name* slot = gfx_vector_at(&table->lookup, i);
+
+			while(slot->index)
+			{
+				i = (i + 1) & (size - 1);
+				slot = gfx_vector_at(&table->lookup, i);
+			}
+
+			*slot = entries[e];
+		}
+	}
+
+	free(entries);
+}
+
+/******************************************************/
+size_t _gfx_name_table_find(
+
+		const GFX_NameTable*  table,
+		const char*           name,
+		unsigned char         block)
+{
+	size_t size = gfx_vector_get_size(&table->lookup);
+	if(!size) return 0;
+
+	size_t len = strlen(name);
+	size_t hash = _gfx_name_table_hash(name, len);
+	size_t i = hash & (size - 1);
+
+	/* Probe until an empty entry is found */
+	GFX_Name* slot = gfx_vector_at(&table->lookup, i);
+	while(slot->index)
+	{
+		if(
+			slot->hash == hash &&
+			slot->block == block &&
+			!strcmp(gfx_vector_at(&table->names, slot->name), name))
+		{
+			return slot->index;
+		}
+
+		i = (i + 1) & (size - 1);
+		slot = gfx_vector_at(&table->lookup, i);
+	}
+
+	return 0;
+}
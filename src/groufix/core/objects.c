@@ -76,40 +76,11 @@ static int _gfx_render_object_id_ref(
 	}
 
 	/* Insert the reference at the container */
-	if(cont->empties.begin != cont->empties.end)
+	ref->id = gfx_slot_map_insert(&cont->objects, &id);
+	if(!ref->id)
 	{
-		/* Replace an empty ID */
-		ref->id = *(unsigned int*)cont->empties.begin;
-		gfx_deque_pop_begin(&cont->empties);
-
-		*(GFX_RenderObjectID**)gfx_vector_at(&cont->objects, ref->id - 1) = id;
-	}
-	else
-	{
-		/* Get index + 1 as ID, overflow? omg, many objects! */
-		size_t size = gfx_vector_get_size(&cont->objects);
-		unsigned int index = size + 1;
-
-		if(index < size)
-		{
-			if(id->refs.objects) free(ref);
-			return 0;
-		}
-
-		/* Insert new ID at the end */
-		GFXVectorIterator it = gfx_vector_insert(
-			&cont->objects,
-			&id,
-			cont->objects.end
-		);
-
-		if(it == cont->objects.end)
-		{
-			if(id->refs.objects) free(ref);
-			return 0;
-		}
-
-		ref->id = index;
+		if(id->refs.objects) free(ref);
+		return 0;
 	}
 
 	/* Insert it at the ID */
@@ -139,26 +110,8 @@ static void _gfx_render_object_id_deref(
 	if(!ref) return;
 
 	/* Remove it from the container */
-	size_t size = gfx_vector_get_size(&cont->objects);
-
-	if(ref->id < size)
-	{
-		/* Empty it and save it in empties */
-		*(GFX_RenderObjectID**)gfx_vector_at(&cont->objects, ref->id - 1) = NULL;
-		gfx_deque_push_end(&cont->empties, &ref->id);
-	}
-	else
-	{
-		/* Remove last element */
-		gfx_vector_erase_at(&cont->objects, --size);
-	}
-
-	/* Clear both deque and vector */
-	if(!size || size == gfx_deque_get_size(&cont->empties))
-	{
-		gfx_vector_clear(&cont->objects);
-		gfx_deque_clear(&cont->empties);
-	}
+	/* The last object takes its place */
+	gfx_slot_map_erase(&cont->objects, ref->id);
 
 	/* Remove the reference */
 	if(id->refs.objects != cont)
@@ -208,8 +161,7 @@ int _gfx_render_objects_init(
 	if(!_gfx_platform_mutex_init(&cont->mutex))
 		return 0;
 
-	gfx_vector_init(&cont->objects, sizeof(GFX_RenderObjectID*));
-	gfx_deque_init(&cont->empties, sizeof(unsigned int));
+	gfx_slot_map_init(&cont->objects, sizeof(GFX_RenderObjectID*));
 	gfx_vector_init(&cont->temp, sizeof(GFX_RenderObjectStorage));
 
 	return 1;
@@ -220,21 +172,17 @@ void _gfx_render_objects_clear(
 
 		GFX_RenderObjects* cont)
 {
-	/* Dereference all objects */
+	/* Dereference all objects, starting at the last */
 	size_t index;
-	for(
-		index = gfx_vector_get_size(&cont->objects);
-		index > 0;
-		--index)
+	while((index = gfx_slot_map_get_size(&cont->objects)))
 	{
 		GFX_RenderObjectID* id =
-			*(GFX_RenderObjectID**)gfx_vector_at(&cont->objects, index - 1);
+			*(GFX_RenderObjectID**)gfx_vector_at(&cont->objects.data, index - 1);
 
-		if(id) _gfx_render_object_id_deref(id, cont, 1);
+		_gfx_render_object_id_deref(id, cont, 1);
 	}
 
-	gfx_vector_clear(&cont->objects);
-	gfx_deque_clear(&cont->empties);
+	gfx_slot_map_clear(&cont->objects);
 	gfx_vector_clear(&cont->temp);
 
 	_gfx_platform_mutex_clear(&cont->mutex);
@@ -251,20 +199,21 @@ void _gfx_render_objects_prepare(
 	/* Keep looping over all IDs with increasing order */
 	/* Do this as long as there are still objects */
 	/* This so all objects are in order for transfering */
-	size_t index = gfx_vector_get_size(&src->objects);
+	/* Objects are erased by moving the last one, so iterate backwards */
+	size_t index = gfx_slot_map_get_size(&src->objects);
 	unsigned char order;
 
 	for(
 		order = 0;
 		index > 0;
-		index = gfx_vector_get_size(&src->objects), ++order)
+		index = gfx_slot_map_get_size(&src->objects), ++order)
 	{
 		while(index--)
 		{
 			GFX_RenderObjectID* id =
-				*(GFX_RenderObjectID**)gfx_vector_at(&src->objects, index);
+				*(GFX_RenderObjectID**)gfx_vector_at(&src->objects.data, index);
 
-			if(id && id->order == order)
+			if(id->order == order)
 			{
 				/* Assign it some temporary storage */
 				GFX_RenderObjectStorage storage =
@@ -298,7 +247,7 @@ void _gfx_render_objects_prepare(
 					id, src, 0);
 
 				/* Check if anything still exists after dereferencing */
-				if(src->objects.begin == src->objects.end)
+				if(!gfx_slot_map_get_size(&src->objects))
 					break;
 			}
 		}
@@ -12,6 +12,7 @@
  *
  */
 
+#include "groufix/containers/parallel.h"
 #include "groufix/core/internal.h"
 
 #include <stdlib.h>
@@ -35,6 +36,8 @@ typedef struct GFX_Pipeline
 	GFX_Pipe*           current;
 	GFX_Pipe*           unlinked;
 
+	GFXVector           prepare;     /* Stores GFXBucket*, buckets to prepare in parallel */
+
 } GFX_Pipeline;
 
 
@@ -285,6 +288,9 @@ GFXPipeline* gfx_pipeline_create(void)
 	GFX_REND_GET.CreateFramebuffers(1, &pl->fbo);
 
 	gfx_vector_init(&pl->attachments, sizeof(GFX_Attachment));
+	gfx_vector_init(&pl->prepare, sizeof(GFXBucket*));
+
+	pl->pipeline.pool = NULL;
 
 	return (GFXPipeline*)pl;
 }
@@ -321,12 +327,22 @@ void gfx_pipeline_free(
 			gfx_pipeline_remove(&internal->unlinked->ptr);
 
 		gfx_vector_clear(&internal->attachments);
+		gfx_vector_clear(&internal->prepare);
 		free(internal->targets);
 
 		free(pipeline);
 	}
 }
 
+/******************************************************/
+void gfx_pipeline_set_thread_pool(
+
+		GFXPipeline*    pipeline,
+		GFXThreadPool*  pool)
+{
+	pipeline->pool = pool;
+}
+
 /******************************************************/
 unsigned int gfx_pipeline_target(
 
@@ -449,10 +465,11 @@ int gfx_pipeline_attach(
 GFXPipe* gfx_pipeline_push_bucket(
 
 		GFXPipeline*    pipeline,
-		unsigned char   bits)
+		unsigned char   bits,
+		GFXBucketFlags  flags)
 {
 	/* Create the pipe and push it */
-	GFX_Pipe* pipe = _gfx_pipe_create_bucket(pipeline, bits);
+	GFX_Pipe* pipe = _gfx_pipe_create_bucket(pipeline, bits, flags);
 	if(!pipe) return NULL;
 
 	_gfx_pipeline_push_pipe(pipe);
@@ -707,6 +724,61 @@ void gfx_pipeline_remove(
 		pipeline->unlinked = new;
 }
 
+/******************************************************/
+static void _gfx_pipeline_prepare_range(
+
+		size_t  begin,
+		size_t  end,
+		void*   data)
+{
+	GFXBucket** buckets = data;
+
+	for(; begin < end; ++begin)
+		_gfx_bucket_prepare(buckets[begin]);
+}
+
+/******************************************************/
+static void _gfx_pipeline_prepare(
+
+		GFX_Pipeline*  pipeline,
+		GFX_Pipe*      pipe,
+		size_t         num)
+{
+	/* Gather all buckets which are about to be executed */
+	int nolimit = !num;
+	gfx_vector_clear(&pipeline->prepare);
+
+	while(pipe && (nolimit | num--))
+	{
+		if(pipe->type == GFX_PIPE_BUCKET)
+		{
+			/* Poll programs here, workers have no context */
+			_gfx_bucket_poll(pipe->ptr.bucket);
+
+			GFXVectorIterator it = gfx_vector_insert(
+				&pipeline->prepare,
+				&pipe->ptr.bucket,
+				pipeline->prepare.end
+			);
+
+			/* Unprepared buckets are preprocessed while executing */
+			if(it == pipeline->prepare.end) break;
+		}
+
+		pipe = (GFX_Pipe*)pipe->node.next;
+	}
+
+	/* Prepare each bucket as a separate chunk */
+	gfx_parallel_for(
+		pipeline->pipeline.pool,
+		0,
+		gfx_vector_get_size(&pipeline->prepare),
+		1,
+		_gfx_pipeline_prepare_range,
+		pipeline->prepare.begin
+	);
+}
+
 /******************************************************/
 void gfx_pipeline_execute(
 
@@ -717,6 +789,13 @@ void gfx_pipeline_execute(
 
 	GFX_Pipeline* internal = (GFX_Pipeline*)pipeline;
 
+	GFX_Pipe* pipe = internal->current ?
+		internal->current : internal->first;
+
+	/* Prepare buckets in parallel, so only replaying them is left */
+	if(pipeline->pool)
+		_gfx_pipeline_prepare(internal, pipe, num);
+
 	/* Bind as framebuffer and set viewport */
 	_gfx_gl_pipeline_bind(
 		GL_DRAW_FRAMEBUFFER,
@@ -729,8 +808,6 @@ void gfx_pipeline_execute(
 
 	/* Iterate over all pipes */
 	int nolimit = !num;
-	GFX_Pipe* pipe = internal->current ?
-		internal->current : internal->first;
 
 	while(pipe && (nolimit | num--))
 	{
@@ -16,6 +16,7 @@
 
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 
 /* Define unsupported float uniform types */
@@ -80,6 +81,12 @@ typedef struct GFX_Program
 	GLuint              handle;     /* OpenGL handle */
 	GFXVector           properties; /* Stores GFX_Property */
 	GFXVector           blocks;     /* Stores GFXPropertyBlock */
+	const void*         owner;      /* Property map which last uploaded values */
+	uint64_t            config;     /* Hash of attributes and feedback, for the program cache */
+	uint64_t            key;        /* Key in the program cache of the pending link */
+	char                pending;    /* Non-zero if a link was issued but not finished */
+
+	GFX_NameTable       names;      /* Names of all properties and blocks */
 
 } GFX_Program;
 
@@ -329,6 +336,13 @@ static unsigned short _gfx_program_prepare_properties(
 			program->handle,
 			name);
 
+		/* Arrays can also be named without the [0] suffix */
+		size_t len = strlen(name);
+		_gfx_name_table_add(&program->names, name, len, i, 0);
+
+		if(len > 3 && !strcmp(name + len - 3, "[0]"))
+			_gfx_name_table_add(&program->names, name, len - 3, i, 0);
+
 		/* Create and insert */
 		GFX_Property prop;
 
@@ -418,6 +432,28 @@ static unsigned short _gfx_program_prepare_blocks(
 			GL_UNIFORM_MATRIX_STRIDE,
 			matStrides);
 
+		/* Get the name */
+		GLint len;
+		GFX_REND_GET.GetActiveUniformBlockiv(
+			program->handle,
+			k,
+			GL_UNIFORM_BLOCK_NAME_LENGTH,
+			&len
+		);
+
+		if(len > 0)
+		{
+			char name[len];
+			GFX_REND_GET.GetActiveUniformBlockName(
+				program->handle,
+				k,
+				len,
+				NULL,
+				name);
+
+			_gfx_name_table_add(&program->names, name, strlen(name), k, 1);
+		}
+
 		/* Create block property */
 		GFXPropertyBlock block;
 		block.size          = size;
@@ -472,6 +508,11 @@ static void _gfx_program_prepare(
 {
 	_gfx_program_unprepare(program);
 
+	/* Linking resets all values */
+	program->owner = NULL;
+
+	_gfx_name_table_clear(&program->names);
+
 	/* Get number of properties */
 	GLint properties;
 	GLint blocks;
@@ -487,6 +528,8 @@ static void _gfx_program_prepare(
 		_gfx_program_prepare_properties(program, properties, GFX_CONT_AS_ARG);
 	program->program.blocks =
 		_gfx_program_prepare_blocks(program, blocks, GFX_CONT_AS_ARG);
+
+	_gfx_name_table_build(&program->names);
 }
 
 /******************************************************/
@@ -499,6 +542,7 @@ static void _gfx_program_obj_free(
 
 	program->id = id;
 	program->program.linked = 0;
+	program->pending = 0;
 	program->handle = 0;
 }
 
@@ -542,6 +586,14 @@ GLint _gfx_gl_program_get_location(
 	return ((GFX_Property*)gfx_vector_at(&internal->properties, index))->location;
 }
 
+/******************************************************/
+int _gfx_program_is_pending(
+
+		const GFXProgram* program)
+{
+	return ((const GFX_Program*)program)->pending;
+}
+
 /******************************************************/
 int _gfx_program_reference(
 
@@ -564,6 +616,30 @@ int _gfx_program_reference(
 	return 1;
 }
 
+/******************************************************/
+int _gfx_program_claim(
+
+		GFXProgram*  program,
+		const void*  owner)
+{
+	GFX_Program* internal = (GFX_Program*)program;
+
+	if(internal->owner == owner) return 1;
+	internal->owner = owner;
+
+	return 0;
+}
+
+/******************************************************/
+void _gfx_program_release(
+
+		GFXProgram*  program,
+		const void*  owner)
+{
+	GFX_Program* internal = (GFX_Program*)program;
+	if(internal->owner == owner) internal->owner = NULL;
+}
+
 /******************************************************/
 GFXProgram* gfx_program_create(
 
@@ -603,6 +679,7 @@ GFXProgram* gfx_program_create(
 
 	gfx_vector_init(&prog->properties, sizeof(GFX_Property));
 	gfx_vector_init(&prog->blocks, sizeof(GFXPropertyBlock));
+	_gfx_name_table_init(&prog->names);
 
 	return (GFXProgram*)prog;
 }
@@ -638,6 +715,7 @@ void gfx_program_free(
 
 			gfx_vector_clear(&internal->properties);
 			gfx_vector_clear(&internal->blocks);
+			_gfx_name_table_clear(&internal->names);
 
 			free(program);
 		}
@@ -665,6 +743,11 @@ int gfx_program_set_attribute(
 		name
 	);
 
+	internal->config = _gfx_program_cache_hash(
+		internal->config, &index, sizeof(unsigned int));
+	internal->config = _gfx_program_cache_hash(
+		internal->config, name, strlen(name) + 1);
+
 	program->linked = 0;
 
 	return 1;
@@ -693,106 +776,230 @@ int gfx_program_set_feedback(
 		mode
 	);
 
+	internal->config = _gfx_program_cache_hash(
+		internal->config, &mode, sizeof(GFXFeedbackMode));
+
+	size_t i;
+	for(i = 0; i < num; ++i) internal->config = _gfx_program_cache_hash(
+		internal->config, names[i], strlen(names[i]) + 1);
+
 	program->linked = 0;
 
 	return 1;
 }
 
 /******************************************************/
-int gfx_program_link(
+static int _gfx_program_issue(
 
-		GFXProgram*  program,
-		size_t       num,
-		GFXShader**  shaders,
-		int          binary)
+		GFX_Program*  program,
+		size_t        num,
+		GFXShader**   shaders,
+		int           binary,
+		int           async,
+		GFX_CONT_ARG)
 {
-	/* Already linked */
-	if(!program->linked)
-	{
-		GFX_CONT_INIT(0);
+	/* Get the key in the program cache */
+	uint64_t key = _gfx_program_cache_key(
+		program->config,
+		num,
+		shaders,
+		GFX_CONT_AS_ARG);
 
-		GFX_Program* internal = (GFX_Program*)program;
+	/* Set binary parameter */
+	if(GFX_CONT_GET.ext[GFX_EXT_PROGRAM_BINARY])
+		GFX_REND_GET.ProgramParameteri(
+			program->handle,
+			GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+			binary || key ? GL_TRUE : GL_FALSE
+		);
 
-		/* Set binary parameter */
-		if(GFX_CONT_GET.ext[GFX_EXT_PROGRAM_BINARY])
-			GFX_REND_GET.ProgramParameteri(
-				internal->handle,
-				GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
-				binary ? GL_TRUE : GL_FALSE
-			);
+	/* Set separable parameter */
+	if(GFX_CONT_GET.ext[GFX_EXT_PROGRAM_MAP])
+		GFX_REND_GET.ProgramParameteri(
+			program->handle,
+			GL_PROGRAM_SEPARABLE,
+			GL_TRUE
+		);
 
-		/* Set separable parameter */
-		if(GFX_CONT_GET.ext[GFX_EXT_PROGRAM_MAP])
-			GFX_REND_GET.ProgramParameteri(
-				internal->handle,
-				GL_PROGRAM_SEPARABLE,
-				GL_TRUE
-			);
+	/* Skip compiling altogether if cached */
+	if(key && _gfx_program_cache_load((GFXProgram*)program, key))
+		return 1;
 
-		/* Compile and attach all shaders */
-		size_t i = 0;
-		for(i = 0; i < num; ++i)
-		{
-			/* Uh oh, compiling went wrong, detach all! */
-			if(!gfx_shader_compile(shaders[i]))
-			{
-				while(i) GFX_REND_GET.DetachShader(
-					internal->handle,
-					_gfx_gl_shader_get_handle(shaders[--i])
-				);
-				return 0;
-			}
+	/* Compile and attach all shaders */
+	size_t i = 0;
+	for(i = 0; i < num; ++i)
+	{
+		/* Errors are reported by the link when compiling asynchronously */
+		if(async)
+			_gfx_shader_compile_async(shaders[i]);
 
-			/* Attach shader */
-			GFX_REND_GET.AttachShader(
-				internal->handle,
-				_gfx_gl_shader_get_handle(shaders[i])
+		/* Uh oh, compiling went wrong, detach all! */
+		else if(!gfx_shader_compile(shaders[i]))
+		{
+			while(i) GFX_REND_GET.DetachShader(
+				program->handle,
+				_gfx_gl_shader_get_handle(shaders[--i])
 			);
+			return 0;
 		}
 
-		/* Try to link */
-		GLint status;
-		GFX_REND_GET.LinkProgram(internal->handle);
+		/* Attach shader */
+		GFX_REND_GET.AttachShader(
+			program->handle,
+			_gfx_gl_shader_get_handle(shaders[i])
+		);
+	}
+
+	/* Start linking */
+	GFX_REND_GET.LinkProgram(program->handle);
+
+	/* Detach all shaders */
+	for(i = 0; i < num; ++i) GFX_REND_GET.DetachShader(
+		program->handle,
+		_gfx_gl_shader_get_handle(shaders[i])
+	);
+
+	program->key = key;
+	program->pending = 1;
+
+	return 1;
+}
+
+/******************************************************/
+static int _gfx_program_finish(
+
+		GFX_Program* program,
+		GFX_CONT_ARG)
+{
+	program->pending = 0;
+
+	/* Wait for the link */
+	GLint status;
+	GFX_REND_GET.GetProgramiv(
+		program->handle,
+		GL_LINK_STATUS, &status
+	);
+
+	if(!status)
+	{
+		/* Generate error */
+		GLint len;
 		GFX_REND_GET.GetProgramiv(
-			internal->handle,
-			GL_LINK_STATUS, &status
+			program->handle,
+			GL_INFO_LOG_LENGTH,
+			&len
 		);
 
-		/* Detach all shaders */
-		for(i = 0; i < num; ++i) GFX_REND_GET.DetachShader(
-			internal->handle,
-			_gfx_gl_shader_get_handle(shaders[i])
+		char buff[len];
+		GFX_REND_GET.GetProgramInfoLog(
+			program->handle,
+			len,
+			NULL,
+			buff
 		);
 
-		if(!status)
-		{
-			/* Generate error */
-			GLint len;
-			GFX_REND_GET.GetProgramiv(
-				internal->handle,
-				GL_INFO_LOG_LENGTH,
-				&len
-			);
+		gfx_errors_push(GFX_ERROR_LINK_FAIL, buff);
 
-			char buff[len];
-			GFX_REND_GET.GetProgramInfoLog(
-				internal->handle,
-				len,
-				NULL,
-				buff
-			);
+		return 0;
+	}
+
+	/* Prepare program */
+	_gfx_program_prepare(program, GFX_CONT_AS_ARG);
+
+	if(program->key)
+		_gfx_program_cache_store((GFXProgram*)program, program->key);
+
+	/* Woop woop! */
+	return program->program.linked = 1;
+}
+
+/******************************************************/
+int gfx_program_link(
+
+		GFXProgram*  program,
+		size_t       num,
+		GFXShader**  shaders,
+		int          binary)
+{
+	/* Already linked */
+	if(program->linked) return 1;
+
+	GFX_CONT_INIT(0);
 
-			gfx_errors_push(GFX_ERROR_LINK_FAIL, buff);
+	GFX_Program* internal = (GFX_Program*)program;
 
+	/* Issue the link if not done so already */
+	if(!internal->pending)
+	{
+		if(!_gfx_program_issue(
+			internal,
+			num,
+			shaders,
+			binary,
+			0,
+			GFX_CONT_AS_ARG))
+		{
 			return 0;
 		}
 
-		/* Prepare program */
-		_gfx_program_prepare(internal, GFX_CONT_AS_ARG);
+		/* Linked from the program cache */
+		if(program->linked) return 1;
 	}
 
-	/* Woop woop! */
-	return program->linked = 1;
+	return _gfx_program_finish(internal, GFX_CONT_AS_ARG);
+}
+
+/******************************************************/
+int gfx_program_link_async(
+
+		GFXProgram*  program,
+		size_t       num,
+		GFXShader**  shaders,
+		int          binary)
+{
+	GFX_Program* internal = (GFX_Program*)program;
+
+	/* Already linked or linking */
+	if(program->linked || internal->pending) return 1;
+
+	GFX_CONT_INIT(0);
+
+	return _gfx_program_issue(
+		internal,
+		num,
+		shaders,
+		binary,
+		1,
+		GFX_CONT_AS_ARG
+	);
+}
+
+/******************************************************/
+int gfx_program_is_ready(
+
+		GFXProgram* program)
+{
+	GFX_Program* internal = (GFX_Program*)program;
+
+	if(program->linked) return 1;
+	if(!internal->pending) return 0;
+
+	GFX_CONT_INIT(0);
+
+	/* Poll without blocking if possible */
+	if(GFX_REND_GET.intExt[GFX_INT_EXT_PARALLEL_SHADER_COMPILE])
+	{
+		GLint status;
+		GFX_REND_GET.GetProgramiv(
+			internal->handle,
+			GL_COMPLETION_STATUS_KHR,
+			&status
+		);
+
+		if(!status) return 0;
+	}
+
+	return _gfx_program_finish(internal, GFX_CONT_AS_ARG);
 }
 
 /******************************************************/
@@ -856,6 +1063,8 @@ int gfx_program_set_binary(
 		&status);
 
 	/* Prepare program */
+	internal->pending = 0;
+
 	if(status)
 	{
 		_gfx_program_prepare(internal, GFX_CONT_AS_ARG);
@@ -884,10 +1093,17 @@ unsigned short gfx_program_get_named_property(
 		const GFXProgram*  program,
 		const char*        name)
 {
-	GFX_CONT_INIT(0);
-
 	const GFX_Program* internal = (const GFX_Program*)program;
 
+	/* Look it up without the driver */
+	if(gfx_vector_get_size(&internal->names.lookup))
+	{
+		size_t index = _gfx_name_table_find(&internal->names, name, 0);
+		return index ? index - 1 : program->properties;
+	}
+
+	GFX_CONT_INIT(program->properties);
+
 	/* Get index */
 	GLuint index;
 	GFX_REND_GET.GetUniformIndices(
@@ -919,10 +1135,17 @@ unsigned short gfx_program_get_named_property_block(
 		const GFXProgram*  program,
 		const char*        name)
 {
-	GFX_CONT_INIT(0);
-
 	const GFX_Program* internal = (const GFX_Program*)program;
 
+	/* Look it up without the driver */
+	if(gfx_vector_get_size(&internal->names.lookup))
+	{
+		size_t index = _gfx_name_table_find(&internal->names, name, 1);
+		return index ? index - 1 : program->blocks;
+	}
+
+	GFX_CONT_INIT(program->blocks);
+
 	/* Get index */
 	GLuint index = GFX_REND_GET.GetUniformBlockIndex(
 		internal->handle,
@@ -0,0 +1,633 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/core/file.h"
+#include "groufix/core/internal.h"
+#include "groufix/core/threading.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Cache file identification */
+#define GFX_INT_PROGRAM_CACHE_MAGIC    "GFXPCACH"
+#define GFX_INT_PROGRAM_CACHE_VERSION  1
+
+/* 64 bit FNV-1a */
+#define GFX_INT_PROGRAM_CACHE_BASIS    14695981039346656037ull
+#define GFX_INT_PROGRAM_CACHE_PRIME    1099511628211ull
+
+/******************************************************/
+/** Cache file header */
+typedef struct GFX_CacheHeader
+{
+	char      magic[8];
+	uint32_t  version;
+	uint32_t  count; /* Number of index entries following the header */
+	uint64_t  tick;  /* Last use counter */
+
+} GFX_CacheHeader;
+
+
+/** Cache file index entry */
+typedef struct GFX_CacheIndex
+{
+	uint64_t  key;
+	uint64_t  use;    /* Tick of the last use */
+	uint64_t  offset; /* Byte offset of the binary in the file */
+	uint32_t  format;
+	uint32_t  size;   /* Byte size of the binary */
+
+} GFX_CacheIndex;
+
+
+/** Internal cache entry */
+typedef struct GFX_CacheEntry
+{
+	GFX_CacheIndex  index; /* Offset is ignored while in memory */
+	void*           data;
+
+} GFX_CacheEntry;
+
+
+/** Internal program cache */
+typedef struct GFX_ProgramCache
+{
+	char*                 path;
+	size_t                maxSize; /* 0 for no limit */
+	size_t                size;    /* Total byte size of all binaries */
+	uint64_t              tick;
+	char                  dirty;   /* Non-zero if the file is out of date */
+
+	GFXVector             entries; /* Stores GFX_CacheEntry */
+	GFXProgramCacheStats  stats;
+
+} GFX_ProgramCache;
+
+
+/** The cache, NULL if not opened */
+static GFX_ProgramCache* _gfx_program_cache = NULL;
+
+
+/** Synchronize any access, initialized once at first use and never cleared */
+static GFX_PlatformMutex _gfx_program_cache_mutex;
+static GFX_PlatformOnce _gfx_program_cache_once = GFX_PLATFORM_ONCE_INIT;
+static char _gfx_program_cache_mutex_init = 0;
+
+
+/******************************************************/
+static void _gfx_program_cache_init(void)
+{
+	_gfx_program_cache_mutex_init =
+		_gfx_platform_mutex_init(&_gfx_program_cache_mutex);
+}
+
+/******************************************************/
+static int _gfx_program_cache_ready(void)
+{
+	/* Programs may use the mutex before the cache is ever opened */
+	_gfx_platform_once(&_gfx_program_cache_once, _gfx_program_cache_init);
+	return _gfx_program_cache_mutex_init;
+}
+
+/******************************************************/
+static int _gfx_program_cache_lock(void)
+{
+	if(!_gfx_program_cache_ready()) return 0;
+	_gfx_platform_mutex_lock(&_gfx_program_cache_mutex);
+
+	return 1;
+}
+
+
+/******************************************************/
+static void _gfx_program_cache_erase(
+
+		GFX_ProgramCache*  cache,
+		GFX_CacheEntry*    entry)
+{
+	cache->size -= entry->index.size;
+	cache->dirty = 1;
+
+	free(entry->data);
+	gfx_vector_erase(&cache->entries, entry);
+}
+
+/******************************************************/
+static void _gfx_program_cache_evict(
+
+		GFX_ProgramCache*  cache,
+		size_t             size)
+{
+	/* Erase least recently used entries until it fits */
+	while(
+		cache->maxSize &&
+		cache->size + size > cache->maxSize &&
+		cache->entries.begin != cache->entries.end)
+	{
+		GFX_CacheEntry* lru = cache->entries.begin;
+		GFX_CacheEntry* it;
+
+		for(
+			it = gfx_vector_next(&cache->entries, lru);
+			it != cache->entries.end;
+			it = gfx_vector_next(&cache->entries, it))
+		{
+			if(it->index.use < lru->index.use) lru = it;
+		}
+
+		_gfx_program_cache_erase(cache, lru);
+		++cache->stats.evictions;
+	}
+}
+
+/******************************************************/
+static GFX_CacheEntry* _gfx_program_cache_find(
+
+		GFX_ProgramCache*  cache,
+		uint64_t           key)
+{
+	GFX_CacheEntry* it;
+	for(
+		it = cache->entries.begin;
+		it != cache->entries.end;
+		it = gfx_vector_next(&cache->entries, it))
+	{
+		if(it->index.key == key) return it;
+	}
+
+	return NULL;
+}
+
+/******************************************************/
+static void _gfx_program_cache_read(
+
+		GFX_ProgramCache* cache)
+{
+	GFX_PlatformFile file;
+	if(!_gfx_platform_file_open(&file, cache->path, GFX_RESOURCE_READ))
+		return;
+
+	/* Read the entire file at once */
+	size_t size = _gfx_platform_file_get_size(file);
+	void* data = size >= sizeof(GFX_CacheHeader) ? malloc(size) : NULL;
+
+	if(!data || _gfx_platform_file_read(file, data, size) != size)
+	{
+		_gfx_platform_file_close(file);
+		free(data);
+
+		return;
+	}
+
+	_gfx_platform_file_close(file);
+
+	/* Validate the header and index */
+	GFX_CacheHeader* header = data;
+	GFX_CacheIndex* index = (GFX_CacheIndex*)(header + 1);
+
+	if(
+		memcmp(header->magic, GFX_INT_PROGRAM_CACHE_MAGIC, sizeof(header->magic)) ||
+		header->version != GFX_INT_PROGRAM_CACHE_VERSION ||
+		header->count > (size - sizeof(GFX_CacheHeader)) / sizeof(GFX_CacheIndex))
+	{
+		free(data);
+		return;
+	}
+
+	cache->tick = header->tick;
+	gfx_vector_reserve(&cache->entries, header->count);
+
+	/* Copy all binaries out of the file */
+	uint32_t i;
+	for(i = 0; i < header->count; ++i)
+	{
+		GFX_CacheEntry entry;
+		entry.index = index[i];
+
+		if(
+			entry.index.offset > size ||
+			entry.index.size > size - entry.index.offset)
+		{
+			continue;
+		}
+
+		entry.data = malloc(entry.index.size);
+		if(!entry.data) break;
+
+		memcpy(
+			entry.data,
+			GFX_PTR_ADD_BYTES(data, entry.index.offset),
+			entry.index.size);
+
+		if(gfx_vector_insert(
+			&cache->entries,
+			&entry,
+			cache->entries.end) == cache->entries.end)
+		{
+			free(entry.data);
+			break;
+		}
+
+		cache->size += entry.index.size;
+	}
+
+	free(data);
+
+	/* The size limit might have changed */
+	_gfx_program_cache_evict(cache, 0);
+}
+
+/******************************************************/
+static int _gfx_program_cache_write(
+
+		GFX_ProgramCache* cache)
+{
+	if(!cache->dirty) return 1;
+
+	/* Write to a temporary file first, so a failed write never corrupts the cache */
+	size_t len = strlen(cache->path);
+	char temp[len + 5];
+
+	memcpy(temp, cache->path, len);
+	memcpy(temp + len, ".tmp", 5);
+
+	GFX_PlatformFile file;
+	if(!_gfx_platform_file_open(&file, temp,
+		GFX_RESOURCE_WRITE |
+		GFX_RESOURCE_TRUNCATE |
+		GFX_RESOURCE_CREATE))
+	{
+		return 0;
+	}
+
+	/* Write header */
+	GFX_CacheHeader header;
+	memcpy(header.magic, GFX_INT_PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+	header.version = GFX_INT_PROGRAM_CACHE_VERSION;
+	header.count = gfx_vector_get_size(&cache->entries);
+	header.tick = cache->tick;
+
+	int success = _gfx_platform_file_write(
+		file, &header, sizeof(GFX_CacheHeader)) == sizeof(GFX_CacheHeader);
+
+	/* Write index, binaries are stored after it in the same order */
+	uint64_t offset =
+		sizeof(GFX_CacheHeader) +
+		sizeof(GFX_CacheIndex) * header.count;
+
+	GFX_CacheEntry* it;
+	for(
+		it = cache->entries.begin;
+		success && it != cache->entries.end;
+		it = gfx_vector_next(&cache->entries, it))
+	{
+		GFX_CacheIndex index = it->index;
+		index.offset = offset;
+		offset += index.size;
+
+		success = _gfx_platform_file_write(
+			file, &index, sizeof(GFX_CacheIndex)) == sizeof(GFX_CacheIndex);
+	}
+
+	/* Write binaries */
+	for(
+		it = cache->entries.begin;
+		success && it != cache->entries.end;
+		it = gfx_vector_next(&cache->entries, it))
+	{
+		success = _gfx_platform_file_write(
+			file, it->data, it->index.size) == it->index.size;
+	}
+
+	_gfx_platform_file_close(file);
+
+	/* Replace the old cache */
+	if(!success || !_gfx_platform_file_move(temp, cache->path))
+	{
+		_gfx_platform_file_remove(temp);
+		return 0;
+	}
+
+	cache->dirty = 0;
+
+	return 1;
+}
+
+/******************************************************/
+uint64_t _gfx_program_cache_hash(
+
+		uint64_t     hash,
+		const void*  data,
+		size_t       size)
+{
+	const unsigned char* bytes = data;
+	hash = hash ? hash : GFX_INT_PROGRAM_CACHE_BASIS;
+
+	while(size--) hash = (hash ^ *(bytes++)) * GFX_INT_PROGRAM_CACHE_PRIME;
+
+	return hash;
+}
+
+/******************************************************/
+uint64_t _gfx_program_cache_key(
+
+		uint64_t           config,
+		size_t             num,
+		GFXShader* const*  shaders,
+		GFX_CONT_ARG)
+{
+	/* Only a hint, load and store check again while locked */
+	if(!_gfx_program_cache || !GFX_CONT_GET.ext[GFX_EXT_PROGRAM_BINARY])
+		return 0;
+
+	uint64_t key = _gfx_program_cache_hash(0, &config, sizeof(uint64_t));
+
+	/* Binaries are only valid for the exact same driver */
+	unsigned char s;
+	for(s = 0; s < GFX_INT_RENDERER_STRINGS; ++s)
+	{
+		const char* str = _gfx_renderer_get_string(s, GFX_CONT_AS_ARG);
+		if(str) key = _gfx_program_cache_hash(key, str, strlen(str) + 1);
+	}
+
+	/* And the exact same shaders */
+	size_t i;
+	for(i = 0; i < num; ++i)
+	{
+		uint64_t hash = _gfx_shader_get_hash(shaders[i]);
+		key = _gfx_program_cache_hash(key, &hash, sizeof(uint64_t));
+	}
+
+	return key ? key : 1;
+}
+
+/******************************************************/
+int _gfx_program_cache_load(
+
+		GFXProgram*  program,
+		uint64_t     key)
+{
+	if(!_gfx_program_cache_lock()) return 0;
+
+	/* It might have been closed in the meantime */
+	GFX_ProgramCache* cache = _gfx_program_cache;
+	if(!cache)
+	{
+		_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+		return 0;
+	}
+
+	/* Copy the binary, so the driver can take its time outside the lock */
+	GFX_CacheEntry* entry = _gfx_program_cache_find(cache, key);
+	GFX_CacheIndex index;
+	void* data = NULL;
+
+	if(entry)
+	{
+		index = entry->index;
+		data = malloc(index.size);
+
+		if(data)
+		{
+			memcpy(data, entry->data, index.size);
+
+			/* Mark it as used, which changes the file as well */
+			index.use = entry->index.use = ++cache->tick;
+			cache->dirty = 1;
+		}
+	}
+
+	if(!data)
+	{
+		++cache->stats.misses;
+		_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+
+		return 0;
+	}
+
+	_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+
+	int success = gfx_program_set_binary(
+		program,
+		index.format,
+		index.size,
+		data);
+
+	free(data);
+
+	_gfx_platform_mutex_lock(&_gfx_program_cache_mutex);
+
+	/* It might have been closed or reopened in the meantime */
+	if(cache == _gfx_program_cache)
+	{
+		if(success) ++cache->stats.hits;
+		else
+		{
+			/* Remove stale binaries, e.g. rejected after a driver update */
+			/* Unless it was used or replaced since */
+			entry = _gfx_program_cache_find(cache, key);
+			if(entry && entry->index.use == index.use)
+				_gfx_program_cache_erase(cache, entry);
+
+			++cache->stats.misses;
+		}
+	}
+
+	_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+
+	return success;
+}
+
+/******************************************************/
+void _gfx_program_cache_store(
+
+		const GFXProgram*  program,
+		uint64_t           key)
+{
+	/* Get the binary outside the lock */
+	GFXProgramFormat format;
+	size_t size;
+	void* data = gfx_program_get_binary(program, &format, &size);
+
+	if(!data) return;
+
+	if(!_gfx_program_cache_lock())
+	{
+		free(data);
+		return;
+	}
+
+	/* It might have been closed since the key was computed */
+	GFX_ProgramCache* cache = _gfx_program_cache;
+	if(!cache)
+	{
+		_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+		free(data);
+
+		return;
+	}
+
+	/* Replace any previous binary */
+	GFX_CacheEntry* entry = _gfx_program_cache_find(cache, key);
+	if(entry) _gfx_program_cache_erase(cache, entry);
+
+	if(size <= UINT32_MAX && (!cache->maxSize || size <= cache->maxSize))
+	{
+		_gfx_program_cache_evict(cache, size);
+
+		GFX_CacheEntry new;
+		new.index.key = key;
+		new.index.use = ++cache->tick;
+		new.index.offset = 0;
+		new.index.format = format;
+		new.index.size = size;
+		new.data = data;
+
+		if(gfx_vector_insert(
+			&cache->entries,
+			&new,
+			cache->entries.end) != cache->entries.end)
+		{
+			cache->size += size;
+			cache->dirty = 1;
+
+			data = NULL;
+		}
+	}
+
+	_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+
+	free(data);
+}
+
+/******************************************************/
+int gfx_program_cache_open(
+
+		const char*  path,
+		size_t       maxSize)
+{
+	gfx_program_cache_close();
+	if(!_gfx_program_cache_ready()) return 0;
+
+	/* Allocate cache */
+	GFX_ProgramCache* cache = calloc(1, sizeof(GFX_ProgramCache));
+	char* copy = malloc(strlen(path) + 1);
+
+	if(!cache || !copy)
+	{
+		free(cache);
+		free(copy);
+
+		/* Out of memory error */
+		gfx_errors_push(
+			GFX_ERROR_OUT_OF_MEMORY,
+			"Program cache could not be allocated."
+		);
+		return 0;
+	}
+
+	strcpy(copy, path);
+	cache->path = copy;
+	cache->maxSize = maxSize;
+
+	gfx_vector_init(&cache->entries, sizeof(GFX_CacheEntry));
+
+	/* Load existing binaries, a missing or invalid file is an empty cache */
+	_gfx_program_cache_read(cache);
+
+	_gfx_platform_mutex_lock(&_gfx_program_cache_mutex);
+	_gfx_program_cache = cache;
+	_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+
+	return 1;
+}
+
+/******************************************************/
+int gfx_program_cache_save(void)
+{
+	if(!_gfx_program_cache_lock()) return 0;
+
+	int success = _gfx_program_cache ?
+		_gfx_program_cache_write(_gfx_program_cache) : 0;
+
+	_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+
+	return success;
+}
+
+/******************************************************/
+void gfx_program_cache_close(void)
+{
+	/* Detach the cache, so no program can use it anymore */
+	if(!_gfx_program_cache_lock()) return;
+
+	GFX_ProgramCache* cache = _gfx_program_cache;
+	_gfx_program_cache = NULL;
+
+	_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+
+	if(!cache) return;
+
+	if(!_gfx_program_cache_write(cache)) gfx_errors_push(
+		GFX_ERROR_PLATFORM_ERROR,
+		"Program cache could not be written to disk."
+	);
+
+	/* Free all binaries */
+	GFX_CacheEntry* it;
+	for(
+		it = cache->entries.begin;
+		it != cache->entries.end;
+		it = gfx_vector_next(&cache->entries, it))
+	{
+		free(it->data);
+	}
+
+	gfx_vector_clear(&cache->entries);
+	free(cache->path);
+	free(cache);
+}
+
+/******************************************************/
+void gfx_program_cache_get_stats(
+
+		GFXProgramCacheStats* stats)
+{
+	memset(stats, 0, sizeof(GFXProgramCacheStats));
+	if(!_gfx_program_cache_lock()) return;
+
+	if(_gfx_program_cache)
+	{
+		*stats = _gfx_program_cache->stats;
+		stats->entries = gfx_vector_get_size(&_gfx_program_cache->entries);
+		stats->size = _gfx_program_cache->size;
+	}
+
+	_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+}
+
+/******************************************************/
+void gfx_program_cache_reset_stats(void)
+{
+	if(!_gfx_program_cache_lock()) return;
+
+	if(_gfx_program_cache)
+	{
+		_gfx_program_cache->stats.hits = 0;
+		_gfx_program_cache->stats.misses = 0;
+		_gfx_program_cache->stats.evictions = 0;
+	}
+
+	_gfx_platform_mutex_unlock(&_gfx_program_cache_mutex);
+}
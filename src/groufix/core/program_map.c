@@ -36,6 +36,7 @@ typedef struct GFX_Map
 	GFX_RenderObjectID  id;
 	GLuint              handle;                     /* OpenGL program or program pipeline handle */
 	unsigned int        blocks;                     /* Number of times blocked */
+	char                ready;                      /* Non-zero if all programs are linked and in use */
 	GFXProgram*         stages[GFX_INT_NUM_STAGES]; /* All stages with their associated program */
 
 } GFX_Map;
@@ -192,7 +193,7 @@ static void _gfx_program_map_obj_restore(
 	GFX_REND_GET.CreateProgramPipelines(1, &map->handle);
 
 	/* Use all programs */
-	if(map->blocks)
+	if(map->ready)
 	{
 		unsigned char stage;
 		for(stage = 0; stage < GFX_INT_NUM_STAGES; ++stage)
@@ -221,6 +222,27 @@ GLuint _gfx_gl_program_map_get_handle(
 	return ((const GFX_Map*)map)->handle;
 }
 
+/******************************************************/
+static void _gfx_program_map_use_stages(
+
+		GFX_Map* map,
+		GFX_CONT_ARG)
+{
+	/* Use all programs */
+	if(GFX_CONT_GET.ext[GFX_EXT_PROGRAM_MAP])
+	{
+		unsigned char stage;
+		for(stage = 0; stage < GFX_INT_NUM_STAGES; ++stage)
+			if(map->stages[stage]) GFX_REND_GET.UseProgramStages(
+				map->handle,
+				_gfx_program_map_get_bitfield(stage),
+				_gfx_gl_program_get_handle(map->stages[stage])
+			);
+	}
+
+	map->ready = 1;
+}
+
 /******************************************************/
 int _gfx_program_map_block(
 
@@ -230,13 +252,19 @@ int _gfx_program_map_block(
 
 	GFX_Map* internal = (GFX_Map*)map;
 
-	/* Check if all programs are linked */
+	/* Check if all programs are linked or linking */
+	unsigned char linked = 1;
 	unsigned char stage;
+
 	for(stage = 0; stage < GFX_INT_NUM_STAGES; ++stage)
 		if(internal->stages[stage])
 		{
-			if(!internal->stages[stage]->linked)
-				return 0;
+			if(!gfx_program_is_ready(internal->stages[stage]))
+			{
+				if(!_gfx_program_is_pending(internal->stages[stage]))
+					return 0;
+				linked = 0;
+			}
 		}
 
 	/* Increase block counter */
@@ -250,16 +278,9 @@ int _gfx_program_map_block(
 		return 0;
 	}
 
-	/* Use all programs */
-	if(GFX_CONT_GET.ext[GFX_EXT_PROGRAM_MAP] && !internal->blocks)
-	{
-		for(stage = 0; stage < GFX_INT_NUM_STAGES; ++stage)
-			if(internal->stages[stage]) GFX_REND_GET.UseProgramStages(
-				internal->handle,
-				_gfx_program_map_get_bitfield(stage),
-				_gfx_gl_program_get_handle(internal->stages[stage])
-			);
-	}
+	/* Use all programs, postponed until all are linked */
+	if(!internal->blocks && linked)
+		_gfx_program_map_use_stages(internal, GFX_CONT_AS_ARG);
 
 	++internal->blocks;
 
@@ -273,6 +294,8 @@ void _gfx_program_map_unblock(
 {
 	GFX_Map* internal = (GFX_Map*)map;
 	internal->blocks = internal->blocks ? internal->blocks - 1 : 0;
+
+	if(!internal->blocks) internal->ready = 0;
 }
 
 /******************************************************/
@@ -455,3 +478,62 @@ GFXProgram* gfx_program_map_get(
 
 	return ((const GFX_Map*)map)->stages[index];
 }
+
+/******************************************************/
+int gfx_program_map_is_ready(
+
+		GFXProgramMap* map)
+{
+	GFX_Map* internal = (GFX_Map*)map;
+	if(internal->ready) return 1;
+
+	/* Poll all programs */
+	unsigned char stage;
+	for(stage = 0; stage < GFX_INT_NUM_STAGES; ++stage)
+		if(internal->stages[stage])
+		{
+			if(!gfx_program_is_ready(internal->stages[stage]))
+				return 0;
+		}
+
+	/* Use them if the pipeline is set up */
+	if(internal->blocks)
+	{
+		GFX_CONT_INIT(0);
+		_gfx_program_map_use_stages(internal, GFX_CONT_AS_ARG);
+	}
+
+	return 1;
+}
+
+/******************************************************/
+int _gfx_program_map_poll(
+
+		GFXProgramMap* map)
+{
+	GFX_Map* internal = (GFX_Map*)map;
+	if(internal->ready) return GFX_INT_MAP_READY;
+
+	GFX_CONT_INIT(GFX_INT_MAP_PENDING);
+
+	unsigned char stage;
+	for(stage = 0; stage < GFX_INT_NUM_STAGES; ++stage)
+		if(internal->stages[stage] && !internal->stages[stage]->linked)
+		{
+			GFXProgram* program = internal->stages[stage];
+
+			/* Not linked nor linking, so the link failed */
+			if(!_gfx_program_is_pending(program))
+				return GFX_INT_MAP_FAILED;
+
+			/* Without parallel compile, this blocks until the link is done */
+			/* It does so only once, after that the program is linked or failed */
+			if(!gfx_program_is_ready(program))
+				return _gfx_program_is_pending(program) ?
+					GFX_INT_MAP_PENDING : GFX_INT_MAP_FAILED;
+		}
+
+	/* All linked, set up the pipeline */
+	return gfx_program_map_is_ready(map) ?
+		GFX_INT_MAP_READY : GFX_INT_MAP_PENDING;
+}
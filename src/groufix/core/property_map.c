@@ -26,6 +26,7 @@
 #define GFX_INT_PROPERTY_MATRIX_PTR  0x04
 #define GFX_INT_PROPERTY_SAMPLER     0x05
 #define GFX_INT_PROPERTY_BLOCK       0x06
+#define GFX_INT_PROPERTY_BLOCK_VALUE 0x07
 
 #define GFX_INT_PROPERTY_HAS_COPIES  0x08
 
@@ -54,16 +55,20 @@ typedef struct GFX_Map
 	unsigned char  samplers; /* Number of sampler properties */
 	unsigned char  blocks;   /* Number of block properties */
 
+	GFXPropertyMapStats stats;
+
 } GFX_Map;
 
 
 /** Internal property */
 typedef struct GFX_Property
 {
-	GLuint         handle;   /* OpenGL program handle */
-	unsigned char  type;     /* Internal type and other flags */
-	GLuint         location; /* Block index or uniform location */
-	size_t         index;    /* Of value in value vector */
+	GFXProgram*       program;
+	GLuint            handle;   /* OpenGL program handle */
+	unsigned char     type;     /* Internal type and other flags */
+	GLuint            location; /* Block index or uniform location */
+	size_t            index;    /* Of value in value vector */
+	GFX_UploadMarker  uploaded; /* Copy of the values in the program */
 
 } GFX_Property;
 
@@ -136,6 +141,7 @@ static int _gfx_property_map_eval_limits(
 
 		/* Buffer property */
 		case GFX_INT_PROPERTY_BLOCK :
+		case GFX_INT_PROPERTY_BLOCK_VALUE :
 
 			if(++map->blocks > GFX_CONT_GET.lim[GFX_LIM_MAX_BUFFER_PROPERTIES])
 			{
@@ -185,6 +191,29 @@ static inline void* _gfx_property_get_copy(
 		data;
 }
 
+/******************************************************/
+static inline unsigned int _gfx_property_get_copy_index(
+
+		unsigned char  flags,
+		unsigned int   copy)
+{
+	return (flags & GFX_INT_PROPERTY_HAS_COPIES) ? copy : 0;
+}
+
+/******************************************************/
+static void _gfx_property_map_invalidate(
+
+		GFX_Map*           map,
+		const GFXProgram*  program)
+{
+	GFX_Property* prop;
+	unsigned char properties = map->map.properties;
+
+	for(prop = (GFX_Property*)(map + 1); properties--; ++prop)
+		if(prop->program == program)
+			_gfx_upload_marker_reset(&prop->uploaded, 0, 0);
+}
+
 /******************************************************/
 static inline void* _gfx_property_derive_copy(
 
@@ -197,6 +226,7 @@ static inline void* _gfx_property_derive_copy(
 	{
 		case GFX_INT_PROPERTY_VECTOR :
 		case GFX_INT_PROPERTY_MATRIX :
+		case GFX_INT_PROPERTY_BLOCK_VALUE :
 			*copySize = ((GFX_Value*)data)->size;
 			data = GFX_PTR_ADD_BYTES(data, sizeof(GFX_Value));
 			break;
@@ -513,6 +543,49 @@ static void _gfx_property_set_block(
 		index);
 }
 
+/******************************************************/
+static void _gfx_property_set_block_value(
+
+		unsigned char  flags,
+		GLuint         program,
+		GLuint         location,
+		void*          data,
+		unsigned int   copy,
+		unsigned int   base,
+		GFX_CONT_ARG)
+{
+	GFX_Value* val = (GFX_Value*)data;
+
+	data = _gfx_property_get_copy(
+		flags,
+		GFX_PTR_ADD_BYTES(data, sizeof(GFX_Value)),
+		val->size,
+		copy
+	);
+
+	/* Stream the block into the ring and bind its range */
+	GLintptr offset;
+	GLuint buffer = _gfx_gl_uniform_ring_write(
+		data,
+		val->size,
+		&offset,
+		GFX_CONT_AS_ARG);
+
+	if(!buffer) return;
+
+	size_t index = _gfx_gl_binder_bind_uniform_buffer(
+		buffer,
+		offset,
+		val->size,
+		0,
+		GFX_CONT_AS_ARG);
+
+	GFX_REND_GET.UniformBlockBinding(
+		program,
+		location,
+		index);
+}
+
 /******************************************************/
 void _gfx_property_map_use(
 
@@ -521,7 +594,8 @@ void _gfx_property_map_use(
 		unsigned int           base,
 		GFX_CONT_ARG)
 {
-	const GFX_Map* internal = (const GFX_Map*)map;
+	/* Upload bookkeeping is not part of the observable state */
+	GFX_Map* internal = (GFX_Map*)map;
 
 	/* Use program map */
 	_gfx_gl_program_map_bind(
@@ -530,11 +604,35 @@ void _gfx_property_map_use(
 	);
 
 	/* Set all values of the program */
-	const GFX_Property* prop;
+	GFX_Property* prop;
 	unsigned char properties = map->properties;
 
-	for(prop = (const GFX_Property*)(internal + 1); properties--; ++prop)
+	for(prop = (GFX_Property*)(internal + 1); properties--; ++prop)
 	{
+		unsigned char type = prop->type & ~GFX_INT_PROPERTY_HAS_COPIES;
+		if(type == GFX_INT_PROPERTY_EMPTY) continue;
+
+		/* Another map might have overwritten our values */
+		if(
+			type >= GFX_INT_PROPERTY_VECTOR &&
+			type <= GFX_INT_PROPERTY_MATRIX_PTR &&
+			!_gfx_program_claim(prop->program, map))
+		{
+			_gfx_property_map_invalidate(internal, prop->program);
+		}
+
+		/* Skip values which are still present in the program */
+		if(
+			(type == GFX_INT_PROPERTY_VECTOR ||
+			type == GFX_INT_PROPERTY_MATRIX) &&
+			!_gfx_upload_marker_set(
+				&prop->uploaded,
+				_gfx_property_get_copy_index(prop->type, copy)))
+		{
+			++internal->stats.skips;
+			continue;
+		}
+
 		/* Jump table */
 		static const GFX_PropertyFunc jump[] =
 		{
@@ -545,11 +643,12 @@ void _gfx_property_map_use(
 			_gfx_property_set_matrix,
 			_gfx_property_set_matrix_ptr,
 			_gfx_property_set_sampler,
-			_gfx_property_set_block
+			_gfx_property_set_block,
+			_gfx_property_set_block_value
 		};
 
 		/* Jump to function */
-		jump[prop->type & ~GFX_INT_PROPERTY_HAS_COPIES](
+		jump[type](
 			prop->type,
 			prop->handle,
 			prop->location,
@@ -558,6 +657,8 @@ void _gfx_property_map_use(
 			base,
 			GFX_CONT_AS_ARG
 		);
+
+		++internal->stats.uploads;
 	}
 }
 
@@ -601,6 +702,7 @@ static void _gfx_property_map_disable(
 			}
 
 			case GFX_INT_PROPERTY_BLOCK :
+			case GFX_INT_PROPERTY_BLOCK_VALUE :
 			{
 				--map->blocks;
 				break;
@@ -627,6 +729,7 @@ static void _gfx_property_map_disable(
 
 		prop->type = GFX_INT_PROPERTY_EMPTY;
 		prop->location = GL_INVALID_INDEX;
+		_gfx_upload_marker_reset(&prop->uploaded, 0, 0);
 	}
 }
 
@@ -675,6 +778,7 @@ static int _gfx_property_map_forward(
 			if(headSize) memcpy(it, headData, headSize);
 
 			prop->index = gfx_vector_get_index(&map->data, it);
+			_gfx_upload_marker_reset(&prop->uploaded, 0, 0);
 
 			return 1;
 		}
@@ -748,11 +852,12 @@ void gfx_property_map_free(
 		/* Unblock the associated program map */
 		_gfx_program_map_unblock(map->programMap);
 
-		/* Free any samplers */
+		/* Free any samplers and release all programs */
 		GFX_Property* prop;
 		unsigned char properties = map->properties;
 
 		for(prop = (GFX_Property*)(internal + 1); properties--; ++prop)
+		{
 			if(
 				(prop->type & ~GFX_INT_PROPERTY_HAS_COPIES) ==
 				GFX_INT_PROPERTY_SAMPLER)
@@ -760,6 +865,10 @@ void gfx_property_map_free(
 				_gfx_property_map_free_samplers(internal, prop);
 			}
 
+			if(prop->program)
+				_gfx_program_release(prop->program, map);
+		}
+
 		gfx_vector_clear(&internal->data);
 		free(map);
 	}
@@ -880,6 +989,9 @@ unsigned int gfx_property_map_shrink(
 				copySize,
 				it);
 
+			/* Removed copies may be appended again */
+			_gfx_upload_marker_reset(&prop->uploaded, map->copies, 0);
+
 			/* Adjust value index of all properties */
 			GFX_Property* Iprop;
 			unsigned char Iprops = map->properties;
@@ -923,6 +1035,8 @@ int gfx_property_map_move(
 
 			/* Copy */
 			memmove(destVal, srcVal, copySize * num);
+
+			_gfx_upload_marker_reset(&prop->uploaded, dest, num);
 		}
 
 	return 1;
@@ -1006,7 +1120,8 @@ int gfx_property_map_forward(
 		default : return 0;
 	}
 
-	/* Set handle, type and location */
+	/* Set program, type and location */
+	forward->program = prog;
 	forward->handle = _gfx_gl_program_get_handle(prog);
 	forward->type |= copies ? GFX_INT_PROPERTY_HAS_COPIES : 0;
 	forward->location = location;
@@ -1044,11 +1159,12 @@ int gfx_property_map_forward_named(
 }
 
 /******************************************************/
-int gfx_property_map_forward_block(
+static int _gfx_property_map_forward_block(
 
 		GFXPropertyMap*  map,
 		unsigned char    index,
 		int              copies,
+		int              value,
 		GFXShaderStage   stage,
 		unsigned short   block)
 {
@@ -1075,11 +1191,20 @@ int gfx_property_map_forward_block(
 	/* First forcefully disable the property */
 	_gfx_property_map_disable(internal, forward);
 
-	/* Set handle, type and location */
+	/* Values store the raw content of the entire block for each copy */
+	GFX_Value head =
+	{
+		.size = bl->size
+	};
+
+	/* Set program, type and location */
+	forward->program =
+		prog;
 	forward->handle =
 		_gfx_gl_program_get_handle(prog);
 
-	forward->type = GFX_INT_PROPERTY_BLOCK |
+	forward->type =
+		(value ? GFX_INT_PROPERTY_BLOCK_VALUE : GFX_INT_PROPERTY_BLOCK) |
 		(copies ? GFX_INT_PROPERTY_HAS_COPIES : 0);
 
 	forward->location = block;
@@ -1088,13 +1213,39 @@ int gfx_property_map_forward_block(
 	return _gfx_property_map_forward(
 		internal,
 		forward,
-		NULL,
-		0,
-		sizeof(GFX_Block),
+		&head,
+		value ? sizeof(GFX_Value) : 0,
+		value ? head.size : sizeof(GFX_Block),
 		GFX_CONT_AS_ARG
 	);
 }
 
+/******************************************************/
+int gfx_property_map_forward_block(
+
+		GFXPropertyMap*  map,
+		unsigned char    index,
+		int              copies,
+		GFXShaderStage   stage,
+		unsigned short   block)
+{
+	return _gfx_property_map_forward_block(
+		map, index, copies, 0, stage, block);
+}
+
+/******************************************************/
+int gfx_property_map_forward_block_value(
+
+		GFXPropertyMap*  map,
+		unsigned char    index,
+		int              copies,
+		GFXShaderStage   stage,
+		unsigned short   block)
+{
+	return _gfx_property_map_forward_block(
+		map, index, copies, 1, stage, block);
+}
+
 /******************************************************/
 int gfx_property_map_forward_named_block(
 
@@ -1115,6 +1266,26 @@ int gfx_property_map_forward_named_block(
 	return gfx_property_map_forward_block(map, index, copies, stage, block);
 }
 
+/******************************************************/
+int gfx_property_map_forward_named_block_value(
+
+		GFXPropertyMap*  map,
+		unsigned char    index,
+		int              copies,
+		GFXShaderStage   stage,
+		const char*      name)
+{
+	/* Get program */
+	GFXProgram* prog = gfx_program_map_get(map->programMap, stage);
+	if(!prog) return 0;
+
+	/* Fetch block index and forward it */
+	unsigned short block = gfx_program_get_named_property_block(prog, name);
+	if(block >= prog->blocks) return 0;
+
+	return gfx_property_map_forward_block_value(map, index, copies, stage, block);
+}
+
 /******************************************************/
 int gfx_property_map_set_value(
 
@@ -1136,7 +1307,8 @@ int gfx_property_map_set_value(
 	unsigned char type = prop->type & ~GFX_INT_PROPERTY_HAS_COPIES;
 	if(
 		type != GFX_INT_PROPERTY_VECTOR &&
-		type != GFX_INT_PROPERTY_MATRIX)
+		type != GFX_INT_PROPERTY_MATRIX &&
+		type != GFX_INT_PROPERTY_BLOCK_VALUE)
 	{
 		return 0;
 	}
@@ -1158,9 +1330,14 @@ int gfx_property_map_set_value(
 
 	size = (!size || size > max) ? max : size;
 
-	/* Set data */
+	/* Set data and make sure it gets uploaded */
 	memcpy(GFX_PTR_ADD_BYTES(data, offset), value, size);
 
+	_gfx_upload_marker_reset(
+		&prop->uploaded,
+		_gfx_property_get_copy_index(prop->type, copy),
+		1);
+
 	return 1;
 }
 
@@ -1475,3 +1652,23 @@ int gfx_property_map_set_shared_buffer(
 		size
 	);
 }
+
+/******************************************************/
+void gfx_property_map_get_stats(
+
+		const GFXPropertyMap*  map,
+		GFXPropertyMapStats*   stats)
+{
+	*stats = ((const GFX_Map*)map)->stats;
+}
+
+/******************************************************/
+void gfx_property_map_reset_stats(
+
+		GFXPropertyMap* map)
+{
+	GFX_Map* internal = (GFX_Map*)map;
+
+	internal->stats.uploads = 0;
+	internal->stats.skips = 0;
+}
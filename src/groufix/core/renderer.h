@@ -16,8 +16,7 @@
 #define GFX_CORE_RENDERER_H
 
 #include "groufix.h"
-#include "groufix/containers/deque.h"
-#include "groufix/containers/vector.h"
+#include "groufix/containers/slot_map.h"
 #include "groufix/core/threading.h"
 
 
@@ -94,8 +93,7 @@ typedef struct GFX_RenderObjectFuncs
 /** Render object container */
 typedef struct GFX_RenderObjects
 {
-	GFXVector          objects;
-	GFXDeque           empties;
+	GFXSlotMap         objects; /* Stores GFX_RenderObjectID* */
 	GFXVector          temp;
 	GFX_PlatformMutex  mutex;
 
@@ -399,6 +397,25 @@ void _gfx_renderer_unload(
 
 		GFX_CONT_ARG);
 
+/** Strings identifying the renderer */
+#define GFX_INT_RENDERER_VENDOR     0x00
+#define GFX_INT_RENDERER_NAME       0x01
+#define GFX_INT_RENDERER_VERSION    0x02
+#define GFX_INT_RENDERER_LANGUAGE   0x03
+#define GFX_INT_RENDERER_STRINGS    0x04
+
+/**
+ * Returns a string identifying the renderer of the current context.
+ *
+ * @param name One of GFX_INT_RENDERER_* (below GFX_INT_RENDERER_STRINGS).
+ * @return NULL if the string is not available.
+ *
+ */
+const char* _gfx_renderer_get_string(
+
+		unsigned char name,
+		GFX_CONT_ARG);
+
 /**
  * Allows the renderer to initialize errors for the current context.
  *
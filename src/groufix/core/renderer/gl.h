@@ -59,6 +59,39 @@ void _gfx_gl_states_set_viewport(
 		GFX_CONT_ARG);
 
 
+/********************************************************
+ * Uniform buffer ring
+ *******************************************************/
+
+/**
+ * Copies data into the uniform buffer ring of the current context.
+ *
+ * @param offset Returns the byte offset of the data within the returned buffer.
+ * @return The buffer the data is written to, 0 on failure.
+ *
+ * The ring is persistently mapped if GFX_INT_EXT_BUFFER_STORAGE is available,
+ * it is fenced per segment so data is never overwritten while in use.
+ * Otherwise data is uploaded and the buffer is orphaned when wrapping around.
+ * The data remains valid until the ring wraps around, which is never before
+ * the draw calls issued in the meantime are finished.
+ *
+ */
+GLuint _gfx_gl_uniform_ring_write(
+
+		const void*  data,
+		GLsizeiptr   size,
+		GLintptr*    offset,
+		GFX_CONT_ARG);
+
+/**
+ * Frees the uniform buffer ring of the current context.
+ *
+ */
+void _gfx_gl_uniform_ring_clear(
+
+		GFX_CONT_ARG);
+
+
 /********************************************************
  * Format descriptor interpreters
  *******************************************************/
@@ -330,6 +363,15 @@ int _gfx_gl_format_to_vertex(
 		GLuint id,
 		GFX_CONT_ARG);*/
 
+/**
+ * Sets the buffer handle as currently bound draw indirect buffer of the current context.
+ *
+ */
+/*void _gfx_gl_indirect_buffer_bind(
+
+		GLuint buffer,
+		GFX_CONT_ARG);*/
+
 /**
  * Sets the layout handle as currently bound to the current context.
  *
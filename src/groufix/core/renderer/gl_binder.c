@@ -528,6 +528,20 @@ void _gfx_gl_program_map_bind(
 	}
 }
 
+/******************************************************/
+void _gfx_gl_indirect_buffer_bind(
+
+		GLuint buffer,
+		GFX_CONT_ARG)
+{
+	/* Prevent binding it twice */
+	if(GFX_REND_GET.indirect != buffer)
+	{
+		GFX_REND_GET.indirect = buffer;
+		GFX_REND_GET.BindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer);
+	}
+}
+
 /******************************************************/
 void _gfx_gl_vertex_layout_bind(
 
@@ -34,6 +34,12 @@
 #ifndef GL_MAP_PERSISTENT_BIT
 	#define GL_MAP_PERSISTENT_BIT   0x0040
 #endif
+#ifndef GL_MAP_COHERENT_BIT
+	#define GL_MAP_COHERENT_BIT     0x0080
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+	#define GL_COMPLETION_STATUS_KHR  0x91b1
+#endif
 
 
 /* Correct context versions */
@@ -120,6 +126,8 @@ typedef void (APIENTRYP GFX_BUFFERSUBDATAPROC)(
 		GLenum, GLintptr, GLsizeiptr, const GLvoid*);
 typedef void (APIENTRYP GFX_CLEARPROC)(
 		GLbitfield);
+typedef GLenum (APIENTRYP GFX_CLIENTWAITSYNCPROC)(
+		GLsync, GLbitfield, GLuint64);
 typedef void (APIENTRYP GFX_COMPILESHADERPROC)(
 		GLuint);
 typedef void (APIENTRYP GFX_COPYBUFFERSUBDATAPROC)(
@@ -160,6 +168,8 @@ typedef void (APIENTRYP GFX_DELETESAMPLERSPROC)(
 		GLsizei, const GLuint*);
 typedef void (APIENTRYP GFX_DELETESHADERPROC)(
 		GLuint);
+typedef void (APIENTRYP GFX_DELETESYNCPROC)(
+		GLsync);
 typedef void (APIENTRYP GFX_DELETETEXTURESPROC)(
 		GLsizei, const GLuint*);
 typedef void (APIENTRYP GFX_DELETEVERTEXARRAYSPROC)(
@@ -204,6 +214,8 @@ typedef void (APIENTRYP GFX_ENABLEVERTEXATTRIBARRAYPROC)(
 		GLuint);
 typedef void (APIENTRYP GFX_ENDTRANSFORMFEEDBACKPROC)(
 		void);
+typedef GLsync (APIENTRYP GFX_FENCESYNCPROC)(
+		GLenum, GLbitfield);
 typedef void (APIENTRYP GFX_FLUSHPROC)(
 		void);
 typedef void (APIENTRYP GFX_FRAMEBUFFERTEXTUREPROC)(
@@ -230,6 +242,8 @@ typedef void (APIENTRYP GFX_GENVERTEXARRAYSPROC)(
 		GLsizei, GLuint*);
 typedef void (APIENTRYP GFX_GETACTIVEUNIFORMPROC)(
 		GLuint, GLuint, GLsizei, GLsizei*, GLint*, GLenum*, GLchar*);
+typedef void (APIENTRYP GFX_GETACTIVEUNIFORMBLOCKNAMEPROC)(
+		GLuint, GLuint, GLsizei, GLsizei*, GLchar*);
 typedef void (APIENTRYP GFX_GETACTIVEUNIFORMBLOCKIVPROC)(
 		GLuint, GLuint, GLenum, GLint*);
 typedef void (APIENTRYP GFX_GETACTIVEUNIFORMSIVPROC)(
@@ -266,6 +280,10 @@ typedef void* (APIENTRYP GFX_MAPBUFFERRANGEPROC)(
 		GLenum, GLintptr, GLsizeiptr, GLbitfield);
 typedef void* (APIENTRYP GFX_MAPNAMEDBUFFERRANGEPROC)(
 		GLuint, GLintptr, GLsizeiptr, GLbitfield);
+typedef void (APIENTRYP GFX_MULTIDRAWARRAYSINDIRECTPROC)(
+		GLenum, const GLvoid*, GLsizei, GLsizei);
+typedef void (APIENTRYP GFX_MULTIDRAWELEMENTSINDIRECTPROC)(
+		GLenum, GLenum, const GLvoid*, GLsizei, GLsizei);
 typedef void (APIENTRYP GFX_NAMEDBUFFERDATAPROC)(
 		GLuint, GLsizeiptr, const GLvoid*, GLenum);
 typedef void (APIENTRYP GFX_NAMEDBUFFERSTORAGEPROC)(
@@ -492,6 +510,10 @@ void APIENTRY _gfx_gl_invalidate_buffer_sub_data(
 		GLuint, GLintptr, GLsizeiptr);
 void* APIENTRY _gfx_gl_map_named_buffer_range(
 		GLuint, GLintptr, GLsizeiptr, GLbitfield);
+void APIENTRY _gfx_gl_multi_draw_arrays_indirect(
+		GLenum, const GLvoid*, GLsizei, GLsizei);
+void APIENTRY _gfx_gl_multi_draw_elements_indirect(
+		GLenum, GLenum, const GLvoid*, GLsizei, GLsizei);
 void APIENTRY _gfx_gl_named_buffer_data(
 		GLuint, GLsizeiptr, const GLvoid*, GLenum);
 void APIENTRY _gfx_gl_named_buffer_storage(
@@ -600,6 +622,8 @@ enum GFX_Extension
 	GFX_INT_EXT_DEBUG_OUTPUT,
 	GFX_INT_EXT_DIRECT_STATE_ACCESS,
 		GFX_INT_EXT_MULTI_BIND,
+	GFX_INT_EXT_MULTI_DRAW_INDIRECT,
+	GFX_INT_EXT_PARALLEL_SHADER_COMPILE,
 		GFX_INT_EXT_SAMPLER_OBJECTS,
 	GFX_INT_EXT_TEXTURE_ARRAY_1D,
 	GFX_INT_EXT_TEXTURE_STORAGE,
@@ -620,6 +644,7 @@ struct GFX_Renderer
 	GLuint         fbos[2];  /* Currently bound FBOs (0 = draw, 1 = read) */
 	GLuint         program;  /* Currently used program or program pipeline */
 	GLuint         vao;      /* Currently bound VAO */
+	GLuint         indirect; /* Currently bound draw indirect buffer */
 	GLuint         post;     /* Layout for post processing */
 
 	/* Viewport & state values */
@@ -633,6 +658,9 @@ struct GFX_Renderer
 	void*          uniformBuffers;
 	void*          textureUnits;
 
+	/* Streamed uniform data */
+	void*          uniformRing;
+
 
 	/* OpenGL Extensions */
 	/* TODO: tabbed out functions to be ported to abstract renderer */
@@ -659,6 +687,7 @@ struct GFX_Renderer
 	GFX_BUFFERSTORAGEPROC                               BufferStorage;
 	GFX_BUFFERSUBDATAPROC                               BufferSubData;
 	GFX_CLEARPROC                                       Clear;
+	GFX_CLIENTWAITSYNCPROC                              ClientWaitSync;
 		GFX_COMPILESHADERPROC                               CompileShader;
 	GFX_COPYBUFFERSUBDATAPROC                           CopyBufferSubData;
 	/* GFX_INT_EXT_DIRECT_STATE_ACCESS, fallback to CopyBufferSubData */
@@ -685,6 +714,7 @@ struct GFX_Renderer
 		GFX_DELETEPROGRAMPIPELINESPROC                      DeleteProgramPipelines;                      /* GFX_EXT_PROGRAM_MAP */
 		GFX_DELETESAMPLERSPROC                              DeleteSamplers;                              /* GFX_INT_EXT_SAMPLER_OBJECTS */
 		GFX_DELETESHADERPROC                                DeleteShader;
+	GFX_DELETESYNCPROC                                  DeleteSync;
 	GFX_DELETETEXTURESPROC                              DeleteTextures;
 	GFX_DELETEVERTEXARRAYSPROC                          DeleteVertexArrays;
 	GFX_DEPTHFUNCPROC                                   DepthFunc;
@@ -709,6 +739,7 @@ struct GFX_Renderer
 	GFX_ENABLEVERTEXARRAYATTRIBPROC                     EnableVertexArrayAttrib;
 	GFX_ENABLEVERTEXATTRIBARRAYPROC                     EnableVertexAttribArray;
 		GFX_ENDTRANSFORMFEEDBACKPROC                        EndTransformFeedback;
+	GFX_FENCESYNCPROC                                   FenceSync;
 		GFX_FLUSHPROC                                       Flush;
 		GFX_FRAMEBUFFERTEXTUREPROC                          FramebufferTexture;                          /* GFX_EXT_BUFFER_TEXTURE */
 		GFX_FRAMEBUFFERTEXTURE2DPROC                        FramebufferTexture2D;
@@ -722,6 +753,7 @@ struct GFX_Renderer
 	GFX_GENTEXTURESPROC                                 GenTextures;
 	GFX_GENVERTEXARRAYSPROC                             GenVertexArrays;
 		GFX_GETACTIVEUNIFORMPROC                            GetActiveUniform;
+		GFX_GETACTIVEUNIFORMBLOCKNAMEPROC                   GetActiveUniformBlockName;
 		GFX_GETACTIVEUNIFORMBLOCKIVPROC                     GetActiveUniformBlockiv;
 		GFX_GETACTIVEUNIFORMSIVPROC                         GetActiveUniformsiv;
 	/* GFX_INT_EXT_BUFFER_READ, fallback to MapBufferRange */
@@ -744,6 +776,10 @@ struct GFX_Renderer
 	GFX_MAPBUFFERRANGEPROC                              MapBufferRange;
 	/* GFX_INT_EXT_DIRECT_STATE_ACCESS, fallback to MapBufferRange */
 	GFX_MAPNAMEDBUFFERRANGEPROC                         MapNamedBufferRange;
+	/* GFX_INT_EXT_MULTI_DRAW_INDIRECT, fallback to a loop */
+	GFX_MULTIDRAWARRAYSINDIRECTPROC                     MultiDrawArraysIndirect;
+	/* GFX_INT_EXT_MULTI_DRAW_INDIRECT, fallback to a loop */
+	GFX_MULTIDRAWELEMENTSINDIRECTPROC                   MultiDrawElementsIndirect;
 	/* GFX_INT_EXT_DIRECT_STATE_ACCESS, fallback to BufferData */
 	GFX_NAMEDBUFFERDATAPROC                             NamedBufferData;
 	/* GFX_INT_EXT_DIRECT_STATE_ACCESS, fallback to BufferStorage */
@@ -336,6 +336,92 @@ void* APIENTRY _gfx_gl_map_named_buffer_range(
 	return GFX_REND_GET.MapBufferRange(GL_ARRAY_BUFFER, offset, length, access);
 }
 
+void APIENTRY _gfx_gl_multi_draw_arrays_indirect(
+
+		GLenum         mode,
+		const GLvoid*  indirect,
+		GLsizei        drawcount,
+		GLsizei        stride)
+{
+	GFX_CONT_INIT_UNSAFE;
+
+	/* No indirect buffer can be bound, so it points to client memory */
+	/* Commands are { count, instanceCount, first, baseInstance } */
+	stride = stride ? stride : (GLsizei)sizeof(GLuint) * 4;
+
+	for(; drawcount > 0; --drawcount)
+	{
+		const GLuint* cmd = indirect;
+
+		if(cmd[3]) GFX_REND_GET.DrawArraysInstancedBaseInstance(
+			mode,
+			cmd[2],
+			cmd[0],
+			cmd[1],
+			cmd[3]);
+
+		else GFX_REND_GET.DrawArraysInstanced(
+			mode,
+			cmd[2],
+			cmd[0],
+			cmd[1]);
+
+		indirect = GFX_PTR_ADD_BYTES(indirect, stride);
+	}
+}
+
+void APIENTRY _gfx_gl_multi_draw_elements_indirect(
+
+		GLenum         mode,
+		GLenum         type,
+		const GLvoid*  indirect,
+		GLsizei        drawcount,
+		GLsizei        stride)
+{
+	GFX_CONT_INIT_UNSAFE;
+
+	/* No indirect buffer can be bound, so it points to client memory */
+	/* Commands are { count, instanceCount, firstIndex, baseVertex, baseInstance } */
+	stride = stride ? stride : (GLsizei)sizeof(GLuint) * 5;
+
+	size_t size =
+		type == GL_UNSIGNED_BYTE ? sizeof(GLubyte) :
+		type == GL_UNSIGNED_SHORT ? sizeof(GLushort) :
+		sizeof(GLuint);
+
+	for(; drawcount > 0; --drawcount)
+	{
+		const GLuint* cmd = indirect;
+		const GLvoid* indices = (const GLvoid*)(cmd[2] * size);
+
+		if(cmd[4]) GFX_REND_GET.DrawElementsInstancedBaseVertexBaseInstance(
+			mode,
+			cmd[0],
+			type,
+			indices,
+			cmd[1],
+			(GLint)cmd[3],
+			cmd[4]);
+
+		else if(cmd[3]) GFX_REND_GET.DrawElementsInstancedBaseVertex(
+			mode,
+			cmd[0],
+			type,
+			indices,
+			cmd[1],
+			(GLint)cmd[3]);
+
+		else GFX_REND_GET.DrawElementsInstanced(
+			mode,
+			cmd[0],
+			type,
+			indices,
+			cmd[1]);
+
+		indirect = GFX_PTR_ADD_BYTES(indirect, stride);
+	}
+}
+
 void APIENTRY _gfx_gl_named_buffer_data(
 
 		GLuint         buffer,
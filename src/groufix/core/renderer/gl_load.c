@@ -13,7 +13,7 @@
  */
 
 #define GL_GLEXT_PROTOTYPES
-#include "groufix/core/renderer.h"
+#include "groufix/core/renderer/gl.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -130,6 +130,7 @@ void _gfx_renderer_load(
 	GFX_REND_GET.BufferStorage                               = _gfx_gl_buffer_storage;
 	GFX_REND_GET.BufferSubData                               = glBufferSubData;
 	GFX_REND_GET.Clear                                       = glClear;
+	GFX_REND_GET.ClientWaitSync                              = glClientWaitSync;
 	GFX_REND_GET.CompileShader                               = glCompileShader;
 	GFX_REND_GET.CopyBufferSubData                           = glCopyBufferSubData;
 	GFX_REND_GET.CopyNamedBufferSubData                      = _gfx_gl_copy_named_buffer_sub_data;
@@ -150,6 +151,7 @@ void _gfx_renderer_load(
 	GFX_REND_GET.DeleteProgramPipelines                      = _gfx_gl_delete_program_pipelines;
 	GFX_REND_GET.DeleteSamplers                              = glDeleteSamplers;
 	GFX_REND_GET.DeleteShader                                = glDeleteShader;
+	GFX_REND_GET.DeleteSync                                  = glDeleteSync;
 	GFX_REND_GET.DeleteTextures                              = glDeleteTextures;
 	GFX_REND_GET.DeleteVertexArrays                          = glDeleteVertexArrays;
 	GFX_REND_GET.DepthFunc                                   = glDepthFunc;
@@ -172,6 +174,7 @@ void _gfx_renderer_load(
 	GFX_REND_GET.EnableVertexArrayAttrib                     = _gfx_gl_enable_vertex_array_attrib;
 	GFX_REND_GET.EnableVertexAttribArray                     = glEnableVertexAttribArray;
 	GFX_REND_GET.EndTransformFeedback                        = glEndTransformFeedback;
+	GFX_REND_GET.FenceSync                                   = glFenceSync;
 	GFX_REND_GET.Flush                                       = glFlush;
 	GFX_REND_GET.FramebufferTexture                          = _gfx_gles_framebuffer_texture;
 	GFX_REND_GET.FramebufferTexture2D                        = glFramebufferTexture2D;
@@ -185,6 +188,7 @@ void _gfx_renderer_load(
 	GFX_REND_GET.GenTextures                                 = glGenTextures;
 	GFX_REND_GET.GenVertexArrays                             = glGenVertexArrays;
 	GFX_REND_GET.GetActiveUniform                            = glGetActiveUniform;
+	GFX_REND_GET.GetActiveUniformBlockName                   = glGetActiveUniformBlockName;
 	GFX_REND_GET.GetActiveUniformBlockiv                     = glGetActiveUniformBlockiv;
 	GFX_REND_GET.GetActiveUniformsiv                         = glGetActiveUniformsiv;
 	GFX_REND_GET.GetBufferSubData                            = _gfx_gles_get_buffer_sub_data;
@@ -203,6 +207,8 @@ void _gfx_renderer_load(
 	GFX_REND_GET.LinkProgram                                 = glLinkProgram;
 	GFX_REND_GET.MapBufferRange                              = glMapBufferRange;
 	GFX_REND_GET.MapNamedBufferRange                         = _gfx_gl_map_named_buffer_range;
+	GFX_REND_GET.MultiDrawArraysIndirect                     = _gfx_gl_multi_draw_arrays_indirect;
+	GFX_REND_GET.MultiDrawElementsIndirect                   = _gfx_gl_multi_draw_elements_indirect;
 	GFX_REND_GET.NamedBufferData                             = _gfx_gl_named_buffer_data;
 	GFX_REND_GET.NamedBufferStorage                          = _gfx_gl_named_buffer_storage;
 	GFX_REND_GET.NamedBufferSubData                          = _gfx_gl_named_buffer_sub_data;
@@ -356,6 +362,23 @@ void _gfx_renderer_load(
 			(GFX_DRAWELEMENTSINSTANCEDBASEVERTEXBASEINSTANCEPROC)_gfx_platform_get_proc_address("glDrawElementsInstancedBaseVertexBaseInstanceEXT");
 	}
 
+	/* GFX_INT_EXT_MULTI_DRAW_INDIRECT */
+	if(_gfx_gl_is_extension_supported("GL_EXT_multi_draw_indirect", GFX_CONT_AS_ARG))
+	{
+		GFX_REND_GET.intExt[GFX_INT_EXT_MULTI_DRAW_INDIRECT] = 1;
+
+		GFX_REND_GET.MultiDrawArraysIndirect =
+			(GFX_MULTIDRAWARRAYSINDIRECTPROC)_gfx_platform_get_proc_address("glMultiDrawArraysIndirectEXT");
+		GFX_REND_GET.MultiDrawElementsIndirect =
+			(GFX_MULTIDRAWELEMENTSINDIRECTPROC)_gfx_platform_get_proc_address("glMultiDrawElementsIndirectEXT");
+	}
+
+	/* GFX_INT_EXT_PARALLEL_SHADER_COMPILE */
+	if(_gfx_gl_is_extension_supported("GL_KHR_parallel_shader_compile", GFX_CONT_AS_ARG))
+	{
+		GFX_REND_GET.intExt[GFX_INT_EXT_PARALLEL_SHADER_COMPILE] = 1;
+	}
+
 	/* GFX_EXT_POLYGON_STATE */
 	if(_gfx_gl_is_extension_supported("GL_NV_polygon_mode", GFX_CONT_AS_ARG))
 	{
@@ -619,6 +642,8 @@ void _gfx_renderer_load(
 		(PFNGLBUFFERSUBDATAPROC)_gfx_platform_get_proc_address("glBufferSubData");
 	GFX_REND_GET.Clear =
 		(PFNGLCLEARPROC)glClear;
+	GFX_REND_GET.ClientWaitSync =
+		(PFNGLCLIENTWAITSYNCPROC)_gfx_platform_get_proc_address("glClientWaitSync");
 	GFX_REND_GET.CompileShader =
 		(PFNGLCOMPILESHADERPROC)_gfx_platform_get_proc_address("glCompileShader");
 	GFX_REND_GET.CopyBufferSubData =
@@ -659,6 +684,8 @@ void _gfx_renderer_load(
 		(PFNGLDELETESAMPLERSPROC)_gfx_gl_delete_samplers;
 	GFX_REND_GET.DeleteShader =
 		(PFNGLDELETESHADERPROC)_gfx_platform_get_proc_address("glDeleteShader");
+	GFX_REND_GET.DeleteSync =
+		(PFNGLDELETESYNCPROC)_gfx_platform_get_proc_address("glDeleteSync");
 	GFX_REND_GET.DeleteTextures =
 		(PFNGLDELETETEXTURESPROC)glDeleteTextures;
 	GFX_REND_GET.DeleteVertexArrays =
@@ -703,6 +730,8 @@ void _gfx_renderer_load(
 		(PFNGLENABLEVERTEXATTRIBARRAYPROC)_gfx_platform_get_proc_address("glEnableVertexAttribArray");
 	GFX_REND_GET.EndTransformFeedback =
 		(PFNGLENDTRANSFORMFEEDBACKPROC)_gfx_platform_get_proc_address("glEndTransformFeedback");
+	GFX_REND_GET.FenceSync =
+		(PFNGLFENCESYNCPROC)_gfx_platform_get_proc_address("glFenceSync");
 	GFX_REND_GET.Flush =
 		(PFNGLFLUSHPROC)glFlush;
 	GFX_REND_GET.FramebufferTexture =
@@ -729,6 +758,8 @@ void _gfx_renderer_load(
 		(PFNGLGENVERTEXARRAYSPROC)_gfx_platform_get_proc_address("glGenVertexArrays");
 	GFX_REND_GET.GetActiveUniform =
 		(PFNGLGETACTIVEUNIFORMPROC)_gfx_platform_get_proc_address("glGetActiveUniform");
+	GFX_REND_GET.GetActiveUniformBlockName =
+		(PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC)_gfx_platform_get_proc_address("glGetActiveUniformBlockName");
 	GFX_REND_GET.GetActiveUniformBlockiv =
 		(PFNGLGETACTIVEUNIFORMBLOCKIVPROC)_gfx_platform_get_proc_address("glGetActiveUniformBlockiv");
 	GFX_REND_GET.GetActiveUniformsiv =
@@ -765,6 +796,10 @@ void _gfx_renderer_load(
 		(PFNGLMAPBUFFERRANGEPROC)_gfx_platform_get_proc_address("glMapBufferRange");
 	GFX_REND_GET.MapNamedBufferRange =
 		(PFNGLMAPNAMEDBUFFERRANGEPROC)_gfx_gl_map_named_buffer_range;
+	GFX_REND_GET.MultiDrawArraysIndirect =
+		(PFNGLMULTIDRAWARRAYSINDIRECTPROC)_gfx_gl_multi_draw_arrays_indirect;
+	GFX_REND_GET.MultiDrawElementsIndirect =
+		(PFNGLMULTIDRAWELEMENTSINDIRECTPROC)_gfx_gl_multi_draw_elements_indirect;
 	GFX_REND_GET.NamedBufferData =
 		(PFNGLNAMEDBUFFERDATAPROC)_gfx_gl_named_buffer_data;
 	GFX_REND_GET.NamedBufferStorage =
@@ -1120,6 +1155,28 @@ void _gfx_renderer_load(
 			(PFNGLBINDBUFFERSRANGEPROC)_gfx_platform_get_proc_address("glBindBuffersRange");
 	}
 
+	/* GFX_INT_EXT_MULTI_DRAW_INDIRECT */
+	if(
+		GFX_CONT_GET.version.major > 4 ||
+		(GFX_CONT_GET.version.major == 4 && GFX_CONT_GET.version.minor > 2) ||
+		_gfx_gl_is_extension_supported("GL_ARB_multi_draw_indirect", GFX_CONT_AS_ARG))
+	{
+		GFX_REND_GET.intExt[GFX_INT_EXT_MULTI_DRAW_INDIRECT] = 1;
+
+		GFX_REND_GET.MultiDrawArraysIndirect =
+			(PFNGLMULTIDRAWARRAYSINDIRECTPROC)_gfx_platform_get_proc_address("glMultiDrawArraysIndirect");
+		GFX_REND_GET.MultiDrawElementsIndirect =
+			(PFNGLMULTIDRAWELEMENTSINDIRECTPROC)_gfx_platform_get_proc_address("glMultiDrawElementsIndirect");
+	}
+
+	/* GFX_INT_EXT_PARALLEL_SHADER_COMPILE */
+	if(
+		_gfx_gl_is_extension_supported("GL_KHR_parallel_shader_compile", GFX_CONT_AS_ARG) ||
+		_gfx_gl_is_extension_supported("GL_ARB_parallel_shader_compile", GFX_CONT_AS_ARG))
+	{
+		GFX_REND_GET.intExt[GFX_INT_EXT_PARALLEL_SHADER_COMPILE] = 1;
+	}
+
 	/* GFX_EXT_PROGRAM_BINARY */
 	if(
 		GFX_CONT_GET.version.major > 4 ||
@@ -1344,11 +1401,33 @@ void _gfx_renderer_load(
 #endif
 }
 
+/******************************************************/
+const char* _gfx_renderer_get_string(
+
+		unsigned char name,
+		GFX_CONT_ARG)
+{
+	static const GLenum names[] =
+	{
+		GL_VENDOR,
+		GL_RENDERER,
+		GL_VERSION,
+		GL_SHADING_LANGUAGE_VERSION
+	};
+
+	if(name >= GFX_INT_RENDERER_STRINGS) return NULL;
+
+	return (const char*)glGetString(names[name]);
+}
+
 /******************************************************/
 void _gfx_renderer_unload(
 
 		GFX_CONT_ARG)
 {
+	/* Free streamed uniform data */
+	_gfx_gl_uniform_ring_clear(GFX_CONT_AS_ARG);
+
 	/* Free binding points */
 	free(GFX_REND_GET.uniformBuffers);
 	free(GFX_REND_GET.textureUnits);
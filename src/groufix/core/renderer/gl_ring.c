@@ -0,0 +1,243 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#define GL_GLEXT_PROTOTYPES
+#include "groufix/core/renderer/gl.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Ring dimensions, every segment is fenced separately */
+#define GFX_GL_RING_SIZE          0x100000
+#define GFX_GL_RING_SEGMENTS      4
+#define GFX_GL_RING_SEGMENT_SIZE  (GFX_GL_RING_SIZE / GFX_GL_RING_SEGMENTS)
+
+/* Nanoseconds to wait for a fence at once */
+#define GFX_GL_RING_TIMEOUT       1000000000
+
+/******************************************************/
+/** Uniform buffer ring */
+typedef struct GFX_UniformRing
+{
+	GLuint         buffer;
+	void*          ptr;     /* Persistently mapped memory, NULL if not mapped */
+	GLintptr       align;   /* Offset alignment of uniform buffer ranges */
+	GLintptr       head;    /* Next byte to write to */
+	unsigned char  segment; /* Segment the head is in */
+
+	GLsync         fences[GFX_GL_RING_SEGMENTS]; /* Fence of each segment, 0 if none */
+
+} GFX_UniformRing;
+
+
+/******************************************************/
+static int _gfx_gl_uniform_ring_init(
+
+		GFX_UniformRing* ring,
+		GFX_CONT_ARG)
+{
+	GFX_REND_GET.CreateBuffers(1, &ring->buffer);
+	if(!ring->buffer) return 0;
+
+	/* Try to persistently map the buffer */
+	if(GFX_REND_GET.intExt[GFX_INT_EXT_BUFFER_STORAGE])
+	{
+		GLbitfield flags =
+			GL_MAP_WRITE_BIT |
+			GL_MAP_PERSISTENT_BIT |
+			GL_MAP_COHERENT_BIT;
+
+		GFX_REND_GET.NamedBufferStorage(
+			ring->buffer,
+			GFX_GL_RING_SIZE,
+			NULL,
+			flags);
+
+		ring->ptr = GFX_REND_GET.MapNamedBufferRange(
+			ring->buffer,
+			0,
+			GFX_GL_RING_SIZE,
+			flags);
+
+		if(ring->ptr) return 1;
+
+		/* Storage is immutable, so start over */
+		GFX_REND_GET.DeleteBuffers(1, &ring->buffer);
+		GFX_REND_GET.CreateBuffers(1, &ring->buffer);
+
+		if(!ring->buffer) return 0;
+	}
+
+	/* Fall back to uploading */
+	GFX_REND_GET.NamedBufferData(
+		ring->buffer,
+		GFX_GL_RING_SIZE,
+		NULL,
+		GL_STREAM_DRAW);
+
+	return 1;
+}
+
+/******************************************************/
+static GFX_UniformRing* _gfx_gl_uniform_ring_get(
+
+		GFX_CONT_ARG)
+{
+	if(GFX_REND_GET.uniformRing)
+		return GFX_REND_GET.uniformRing;
+
+	/* Allocate */
+	GFX_UniformRing* ring = calloc(1, sizeof(GFX_UniformRing));
+	if(!ring)
+	{
+		/* Out of memory error */
+		gfx_errors_push(
+			GFX_ERROR_OUT_OF_MEMORY,
+			"Uniform buffer ring could not be allocated."
+		);
+		return NULL;
+	}
+
+	GLint align;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+	ring->align = align > 0 ? align : 1;
+
+	if(!_gfx_gl_uniform_ring_init(ring, GFX_CONT_AS_ARG))
+	{
+		free(ring);
+		return NULL;
+	}
+
+	return GFX_REND_GET.uniformRing = ring;
+}
+
+/******************************************************/
+static void _gfx_gl_uniform_ring_wait(
+
+		GFX_UniformRing*  ring,
+		unsigned char     segment,
+		GFX_CONT_ARG)
+{
+	GLsync fence = ring->fences[segment];
+	if(!fence) return;
+
+	/* Wait until the GPU is done reading the segment */
+	GLenum result;
+	do result = GFX_REND_GET.ClientWaitSync(
+		fence,
+		GL_SYNC_FLUSH_COMMANDS_BIT,
+		GFX_GL_RING_TIMEOUT);
+
+	while(result == GL_TIMEOUT_EXPIRED);
+
+	GFX_REND_GET.DeleteSync(fence);
+	ring->fences[segment] = 0;
+}
+
+/******************************************************/
+static void _gfx_gl_uniform_ring_advance(
+
+		GFX_UniformRing*  ring,
+		unsigned char     segment,
+		GFX_CONT_ARG)
+{
+	/* Fence all segments the head leaves behind */
+	while(ring->segment != segment)
+	{
+		if(ring->ptr) ring->fences[ring->segment] =
+			GFX_REND_GET.FenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		ring->segment = (ring->segment + 1) % GFX_GL_RING_SEGMENTS;
+
+		if(ring->ptr) _gfx_gl_uniform_ring_wait(
+			ring,
+			ring->segment,
+			GFX_CONT_AS_ARG);
+	}
+}
+
+/******************************************************/
+GLuint _gfx_gl_uniform_ring_write(
+
+		const void*  data,
+		GLsizeiptr   size,
+		GLintptr*    offset,
+		GFX_CONT_ARG)
+{
+	if(size <= 0 || size > GFX_GL_RING_SEGMENT_SIZE) return 0;
+
+	GFX_UniformRing* ring = _gfx_gl_uniform_ring_get(GFX_CONT_AS_ARG);
+	if(!ring) return 0;
+
+	/* Align the head and wrap around if it doesn't fit */
+	GLintptr head =
+		(ring->head + ring->align - 1) / ring->align * ring->align;
+
+	/* Never straddle segments, the first would be fenced before its use */
+	if(head / GFX_GL_RING_SEGMENT_SIZE != (head + size - 1) / GFX_GL_RING_SEGMENT_SIZE)
+		head = (head / GFX_GL_RING_SEGMENT_SIZE + 1) * GFX_GL_RING_SEGMENT_SIZE;
+
+	if(head + size > GFX_GL_RING_SIZE)
+	{
+		head = 0;
+
+		/* Without fences, give the driver a new buffer */
+		if(!ring->ptr) GFX_REND_GET.NamedBufferData(
+			ring->buffer,
+			GFX_GL_RING_SIZE,
+			NULL,
+			GL_STREAM_DRAW);
+	}
+
+	_gfx_gl_uniform_ring_advance(
+		ring,
+		head / GFX_GL_RING_SEGMENT_SIZE,
+		GFX_CONT_AS_ARG);
+
+	/* Copy the data */
+	if(ring->ptr)
+		memcpy(GFX_PTR_ADD_BYTES(ring->ptr, head), data, size);
+
+	else GFX_REND_GET.NamedBufferSubData(
+		ring->buffer,
+		head,
+		size,
+		data);
+
+	ring->head = head + size;
+	*offset = head;
+
+	return ring->buffer;
+}
+
+/******************************************************/
+void _gfx_gl_uniform_ring_clear(
+
+		GFX_CONT_ARG)
+{
+	GFX_UniformRing* ring = GFX_REND_GET.uniformRing;
+	if(!ring) return;
+
+	unsigned char s;
+	for(s = 0; s < GFX_GL_RING_SEGMENTS; ++s)
+		if(ring->fences[s]) GFX_REND_GET.DeleteSync(ring->fences[s]);
+
+	if(ring->ptr)
+		GFX_REND_GET.UnmapNamedBuffer(ring->buffer);
+
+	GFX_REND_GET.DeleteBuffers(1, &ring->buffer);
+
+	free(ring);
+	GFX_REND_GET.uniformRing = NULL;
+}
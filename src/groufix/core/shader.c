@@ -13,6 +13,7 @@
  */
 
 #include "groufix/core/renderer.h"
+#include "groufix/core/utils.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -42,7 +43,9 @@ typedef struct GFX_Shader
 
 	/* Hidden data */
 	GFX_RenderObjectID  id;
-	GLuint              handle; /* OpenGL handle */
+	GLuint              handle;  /* OpenGL handle */
+	uint64_t            hash;    /* Hash of the stage and parsed source */
+	char                pending; /* Non-zero if compiling without querying the status */
 
 } GFX_Shader;
 
@@ -316,6 +319,7 @@ static void _gfx_shader_obj_free(
 
 	shader->id = id;
 	shader->shader.compiled = 0;
+	shader->pending = 0;
 	shader->handle = 0;
 }
 
@@ -346,6 +350,31 @@ GLuint _gfx_gl_shader_get_handle(
 	return ((const GFX_Shader*)shader)->handle;
 }
 
+/******************************************************/
+uint64_t _gfx_shader_get_hash(
+
+		const GFXShader* shader)
+{
+	return ((const GFX_Shader*)shader)->hash;
+}
+
+/******************************************************/
+void _gfx_shader_compile_async(
+
+		GFXShader* shader)
+{
+	GFX_Shader* internal = (GFX_Shader*)shader;
+
+	if(!shader->compiled && !internal->pending)
+	{
+		GFX_CONT_INIT();
+
+		/* Start compiling, do not wait for it */
+		GFX_REND_GET.CompileShader(internal->handle);
+		internal->pending = 1;
+	}
+}
+
 /******************************************************/
 GFXShader* gfx_shader_create(
 
@@ -441,6 +470,15 @@ int gfx_shader_set_source(
 		(const GLint*)&len
 	);
 
+	/* Hash it for the program cache */
+	GFX_Shader* internal = (GFX_Shader*)shader;
+
+	internal->hash = _gfx_program_cache_hash(
+		0, &shader->stage, sizeof(GFXShaderStage));
+	internal->hash = _gfx_program_cache_hash(
+		internal->hash, source, len);
+
+	internal->pending = 0;
 	shader->compiled = 0;
 	free(source);
 
@@ -497,9 +535,13 @@ int gfx_shader_compile(
 
 		GFX_Shader* internal = (GFX_Shader*)shader;
 
-		/* Try to compile */
+		/* Try to compile, unless it was already started */
+		if(!internal->pending)
+			GFX_REND_GET.CompileShader(internal->handle);
+
 		GLint status;
-		GFX_REND_GET.CompileShader(internal->handle);
+		internal->pending = 0;
+
 		GFX_REND_GET.GetShaderiv(
 			internal->handle,
 			GL_COMPILE_STATUS,
@@ -0,0 +1,679 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/core/internal.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Maximum depth of nested includes */
+#define GFX_INT_LIBRARY_MAX_DEPTH  16
+
+/******************************************************/
+/** Internal shader library */
+typedef struct GFX_Library
+{
+	/* Super class */
+	GFXShaderLibrary library;
+
+	/* Hidden data */
+	GFXVector  variants; /* Stores GFX_Variant, sorted on hash */
+	GFXVector  includes; /* Stores GFX_Include */
+
+} GFX_Library;
+
+
+/** Internal shader variant */
+typedef struct GFX_Variant
+{
+	uint64_t        hash;   /* Hash of the stage and canonical source */
+	GFXShaderStage  stage;
+	char*           source; /* Canonical source, to tell apart equal hashes */
+	GFXShader*      shader;
+
+} GFX_Variant;
+
+
+/** Internal source being resolved */
+typedef struct GFX_Resolve
+{
+	GFX_Library*   library;
+	GFXVector*     out;
+	unsigned char  legacy;  /* Non-zero if #line sets the number of the line after the next */
+	unsigned char  started; /* Non-zero once the first line of the base source is seen */
+
+} GFX_Resolve;
+
+
+/** Internal include source */
+typedef struct GFX_Include
+{
+	char*  name;
+	char*  source;
+
+} GFX_Include;
+
+
+/******************************************************/
+static int _gfx_shader_library_append(
+
+		GFXVector*   out,
+		const char*  str,
+		size_t       len)
+{
+	if(!len) return 1;
+
+	GFXVectorIterator it = gfx_vector_insert_range(
+		out,
+		len,
+		(GFXVectorIterator)str,
+		out->end
+	);
+
+	return it != out->end;
+}
+
+/******************************************************/
+static GFX_Include* _gfx_shader_library_find_include(
+
+		GFX_Library*  library,
+		const char*   name)
+{
+	GFX_Include* it;
+	for(
+		it = library->includes.begin;
+		it != library->includes.end;
+		it = gfx_vector_next(&library->includes, it))
+	{
+		if(!strcmp(it->name, name)) return it;
+	}
+
+	return NULL;
+}
+
+/******************************************************/
+static size_t _gfx_shader_library_find_variant(
+
+		const GFX_Library*  library,
+		uint64_t            hash)
+{
+	/* Binary search for the first variant not less than hash */
+	size_t min = 0;
+	size_t max = gfx_vector_get_size(&library->variants);
+
+	while(min < max)
+	{
+		size_t mid = min + ((max - min) >> 1);
+		const GFX_Variant* var = gfx_vector_at(&library->variants, mid);
+
+		if(var->hash < hash) min = mid + 1;
+		else max = mid;
+	}
+
+	return min;
+}
+
+/******************************************************/
+static int _gfx_shader_library_is_open(
+
+		GFXVector*  out,
+		size_t      start)
+{
+	/* Nothing but a # has been written to the line yet */
+	size_t size = gfx_vector_get_size(out);
+
+	return
+		size == start ||
+		(size == start + 1 && *(char*)gfx_vector_at(out, start) == '#');
+}
+
+/******************************************************/
+static void _gfx_shader_library_version(
+
+		GFX_Resolve*  res,
+		const char*   str,
+		size_t        len)
+{
+	/* The version must be the first line, without it the version is 110 */
+	unsigned long version = 110;
+
+	if(len > 8 && !strncmp(str, "#version", 8))
+	{
+		size_t i = 8;
+		while(i < len && (str[i] == ' ' || str[i] == '\t')) ++i;
+
+		for(version = 0; i < len && str[i] >= '0' && str[i] <= '9'; ++i)
+			version = version * 10 + (unsigned long)(str[i] - '0');
+	}
+
+	/* Before GLSL 300, #line sets the number of the line after the next */
+	res->legacy = version < 300;
+	res->started = 1;
+}
+
+/******************************************************/
+static int _gfx_shader_library_append_line(
+
+		GFX_Resolve*   res,
+		unsigned long  line,
+		unsigned int   id)
+{
+	/* Sets the number of the next line and its source string */
+	char buff[64];
+	int len = snprintf(
+		buff, sizeof(buff), "#line %lu %u\n", line - res->legacy, id);
+
+	return _gfx_shader_library_append(res->out, buff, len);
+}
+
+/******************************************************/
+static int _gfx_shader_library_resolve(
+
+		GFX_Resolve*  res,
+		const char*   src,
+		unsigned int  id,
+		size_t        depth);
+
+/******************************************************/
+static int _gfx_shader_library_end_line(
+
+		GFX_Resolve*   res,
+		size_t         start,
+		unsigned long  line,
+		unsigned int   id,
+		size_t         depth,
+		int            last)
+{
+	GFXVector* out = res->out;
+
+	/* Strip trailing whitespace */
+	size_t size = gfx_vector_get_size(out);
+	while(size > start)
+	{
+		char c = *(char*)gfx_vector_at(out, size - 1);
+		if(c != ' ' && c != '\t') break;
+
+		--size;
+	}
+
+	gfx_vector_erase_range_at(out, gfx_vector_get_size(out) - size, size);
+
+	/* Keep empty lines so line numbers stay the same */
+	/* Except after the last line, it has no line ending */
+	if(size == start)
+		return last ? 1 : _gfx_shader_library_append(out, "\n", 1);
+
+	const char* str = gfx_vector_at(out, start);
+	size_t len = size - start;
+
+	/* Includes cannot come before the version, so it is known in time */
+	if(!depth && !res->started)
+		_gfx_shader_library_version(res, str, len);
+
+	if(len <= 8 || strncmp(str, "#include", 8))
+		return _gfx_shader_library_append(out, "\n", 1);
+
+	/* Get the name of the include */
+	size_t begin = 8;
+	while(begin < len && str[begin] != '"' && str[begin] != '<') ++begin;
+
+	size_t end = ++begin;
+	while(end < len && str[end] != '"' && str[end] != '>') ++end;
+
+	if(end >= len)
+	{
+		gfx_errors_push(
+			GFX_ERROR_COMPILE_FAIL,
+			"A shader variant contains a malformed #include directive."
+		);
+		return 0;
+	}
+
+	char name[end - begin + 1];
+	memcpy(name, str + begin, end - begin);
+	name[end - begin] = 0;
+
+	/* Replace the directive with the included source */
+	gfx_vector_erase_range_at(out, len, start);
+
+	GFX_Include* inc = _gfx_shader_library_find_include(res->library, name);
+	if(!inc)
+	{
+		gfx_errors_push(
+			GFX_ERROR_COMPILE_FAIL,
+			"A shader variant includes an unknown source."
+		);
+		return 0;
+	}
+
+	/* Number included lines by their own source string */
+	/* Then continue numbering after the directive */
+	unsigned int incId = 1 + (unsigned int)gfx_vector_get_index(
+		&res->library->includes, inc);
+
+	return
+		_gfx_shader_library_append_line(res, 1, incId) &&
+		_gfx_shader_library_resolve(res, inc->source, incId, depth + 1) &&
+		_gfx_shader_library_append_line(res, line + 1, id);
+}
+
+/******************************************************/
+static int _gfx_shader_library_resolve(
+
+		GFX_Resolve*  res,
+		const char*   src,
+		unsigned int  id,
+		size_t        depth)
+{
+	if(depth > GFX_INT_LIBRARY_MAX_DEPTH)
+	{
+		gfx_errors_push(
+			GFX_ERROR_OVERFLOW,
+			"Shader variant includes are nested too deep, or recursive."
+		);
+		return 0;
+	}
+
+	/* Copy the source line by line */
+	/* Comments and surrounding whitespace are removed, lines are kept */
+	GFXVector* out = res->out;
+	size_t start = gfx_vector_get_size(out);
+	unsigned long line = 1;
+	unsigned char block = 0;
+
+	while(*src)
+	{
+		char c = *src;
+
+		/* End of a line */
+		if(c == '\n')
+		{
+			if(!_gfx_shader_library_end_line(res, start, line, id, depth, 0))
+				return 0;
+
+			start = gfx_vector_get_size(out);
+			++line;
+			++src;
+		}
+
+		/* Inside a block comment */
+		else if(block)
+		{
+			if(c == '*' && src[1] == '/')
+			{
+				/* Comments act as a single space */
+				block = 0;
+				src += 2;
+
+				if(!_gfx_shader_library_is_open(out, start))
+					if(!_gfx_shader_library_append(out, " ", 1)) return 0;
+			}
+			else ++src;
+		}
+
+		/* Start of a comment */
+		else if(c == '/' && src[1] == '/')
+		{
+			while(*src && *src != '\n') ++src;
+		}
+
+		else if(c == '/' && src[1] == '*')
+		{
+			block = 1;
+			src += 2;
+		}
+
+		/* Skip carriage returns, leading whitespace */
+		/* and whitespace between # and a directive */
+		else if(
+			c == '\r' ||
+			((c == ' ' || c == '\t') && _gfx_shader_library_is_open(out, start)))
+		{
+			++src;
+		}
+
+		else
+		{
+			if(!_gfx_shader_library_append(out, src, 1)) return 0;
+			++src;
+		}
+	}
+
+	return _gfx_shader_library_end_line(res, start, line, id, depth, 1);
+}
+
+/******************************************************/
+static int _gfx_shader_library_compare(
+
+		const void*  elem1,
+		const void*  elem2)
+{
+	return strcmp(*(const char**)elem1, *(const char**)elem2);
+}
+
+/******************************************************/
+static int _gfx_shader_library_build(
+
+		GFX_Library*  library,
+		GFXVector*    out,
+		const char*   src,
+		size_t        num,
+		const char**  defines)
+{
+	/* The version is detected while resolving, as the source is canonical */
+	GFX_Resolve res =
+	{
+		.library = library,
+		.legacy = 0,
+		.started = 0
+	};
+
+	/* Resolve the base source */
+	GFXVector body;
+	gfx_vector_init(&body, sizeof(char));
+
+	res.out = &body;
+
+	if(!_gfx_shader_library_resolve(&res, src, 0, 0))
+	{
+		gfx_vector_clear(&body);
+		return 0;
+	}
+
+	/* The version must stay in front of the defines */
+	/* Empty lines are allowed before it */
+	const char* text = body.begin;
+	size_t size = gfx_vector_get_size(&body);
+	size_t ver = 0;
+	unsigned long line = 1;
+
+	for(; ver < size && text[ver] == '\n'; ++ver)
+		++line;
+
+	if(size - ver > 8 && !strncmp(text + ver, "#version", 8))
+	{
+		while(ver < size) if(text[ver++] == '\n') break;
+		++line;
+	}
+	else
+	{
+		ver = 0;
+		line = 1;
+	}
+
+	res.out = out;
+	int success = _gfx_shader_library_append(out, text, ver);
+
+	/* Sort the defines so their order does not matter */
+	const char* sorted[num ? num : 1];
+	if(num)
+	{
+		memcpy(sorted, defines, sizeof(const char*) * num);
+		qsort(sorted, num, sizeof(const char*), _gfx_shader_library_compare);
+	}
+
+	size_t i;
+	for(i = 0; success && i < num; ++i)
+	{
+		/* Skip duplicates */
+		if(i && !strcmp(sorted[i - 1], sorted[i])) continue;
+
+		success =
+			_gfx_shader_library_append(out, "#define ", 8) &&
+			_gfx_shader_library_append(out, sorted[i], strlen(sorted[i])) &&
+			_gfx_shader_library_append(out, "\n", 1);
+	}
+
+	/* Number the remaining source as if there were no defines */
+	if(success && num)
+		success = _gfx_shader_library_append_line(&res, line, 0);
+
+	/* Append the remaining source and terminate */
+	success = success &&
+		_gfx_shader_library_append(out, text + ver, size - ver) &&
+		_gfx_shader_library_append(out, "", 1);
+
+	gfx_vector_clear(&body);
+
+	return success;
+}
+
+/******************************************************/
+GFXShaderLibrary* gfx_shader_library_create(void)
+{
+	/* Create new library */
+	GFX_Library* library = calloc(1, sizeof(GFX_Library));
+	if(!library)
+	{
+		/* Out of memory error */
+		gfx_errors_push(
+			GFX_ERROR_OUT_OF_MEMORY,
+			"Shader library could not be allocated."
+		);
+		return NULL;
+	}
+
+	gfx_vector_init(&library->variants, sizeof(GFX_Variant));
+	gfx_vector_init(&library->includes, sizeof(GFX_Include));
+
+	return (GFXShaderLibrary*)library;
+}
+
+/******************************************************/
+void gfx_shader_library_free(
+
+		GFXShaderLibrary* library)
+{
+	if(library)
+	{
+		GFX_Library* internal = (GFX_Library*)library;
+
+		/* Free all shaders */
+		GFX_Variant* var;
+		for(
+			var = internal->variants.begin;
+			var != internal->variants.end;
+			var = gfx_vector_next(&internal->variants, var))
+		{
+			gfx_shader_free(var->shader);
+			free(var->source);
+		}
+
+		/* Free all includes */
+		GFX_Include* inc;
+		for(
+			inc = internal->includes.begin;
+			inc != internal->includes.end;
+			inc = gfx_vector_next(&internal->includes, inc))
+		{
+			free(inc->name);
+			free(inc->source);
+		}
+
+		gfx_vector_clear(&internal->variants);
+		gfx_vector_clear(&internal->includes);
+
+		free(library);
+	}
+}
+
+/******************************************************/
+int gfx_shader_library_set_include(
+
+		GFXShaderLibrary*  library,
+		const char*        name,
+		const char*        src)
+{
+	GFX_Library* internal = (GFX_Library*)library;
+	GFX_Include* inc = _gfx_shader_library_find_include(internal, name);
+
+	/* Remove the include */
+	if(!src)
+	{
+		if(inc)
+		{
+			free(inc->name);
+			free(inc->source);
+			gfx_vector_erase(&internal->includes, inc);
+		}
+		return 1;
+	}
+
+	/* Copy the source */
+	size_t len = strlen(src) + 1;
+	char* source = malloc(len);
+
+	if(!source)
+	{
+		/* Out of memory error */
+		gfx_errors_push(
+			GFX_ERROR_OUT_OF_MEMORY,
+			"Shader library could not allocate an include."
+		);
+		return 0;
+	}
+
+	memcpy(source, src, len);
+
+	/* Replace an existing include */
+	if(inc)
+	{
+		free(inc->source);
+		inc->source = source;
+
+		return 1;
+	}
+
+	/* Or insert a new one */
+	len = strlen(name) + 1;
+	GFX_Include new = { .name = malloc(len), .source = source };
+
+	if(new.name)
+	{
+		memcpy(new.name, name, len);
+
+		GFXVectorIterator it = gfx_vector_insert(
+			&internal->includes,
+			&new,
+			internal->includes.end
+		);
+
+		if(it != internal->includes.end) return 1;
+	}
+
+	/* Out of memory error */
+	gfx_errors_push(
+		GFX_ERROR_OUT_OF_MEMORY,
+		"Shader library could not allocate an include."
+	);
+
+	free(new.name);
+	free(source);
+
+	return 0;
+}
+
+/******************************************************/
+GFXShader* gfx_shader_library_get(
+
+		GFXShaderLibrary*  library,
+		GFXShaderStage     stage,
+		const char*        src,
+		size_t             num,
+		const char**       defines)
+{
+	GFX_Library* internal = (GFX_Library*)library;
+
+	/* Build the canonical source */
+	GFXVector source;
+	gfx_vector_init(&source, sizeof(char));
+
+	if(!_gfx_shader_library_build(internal, &source, src, num, defines))
+	{
+		gfx_vector_clear(&source);
+		return NULL;
+	}
+
+	/* Hash it and look for an identical variant */
+	uint64_t hash = _gfx_program_cache_hash(
+		0, &stage, sizeof(GFXShaderStage));
+	hash = _gfx_program_cache_hash(
+		hash, source.begin, gfx_vector_get_size(&source));
+
+	/* Only share if the source is equal, not just the hash */
+	size_t index = _gfx_shader_library_find_variant(internal, hash);
+	size_t size = gfx_vector_get_size(&source);
+
+	GFX_Variant* it;
+	for(
+		it = gfx_vector_at(&internal->variants, index);
+		it != internal->variants.end && it->hash == hash;
+		it = gfx_vector_next(&internal->variants, it))
+	{
+		if(it->stage == stage && !strcmp(it->source, source.begin))
+		{
+			gfx_vector_clear(&source);
+			++library->shared;
+
+			return it->shader;
+		}
+	}
+
+	/* Create a new shader */
+	GFX_Variant var =
+	{
+		.hash   = hash,
+		.stage  = stage,
+		.source = malloc(size),
+		.shader = NULL
+	};
+
+	if(!var.source)
+	{
+		/* Out of memory error */
+		gfx_errors_push(
+			GFX_ERROR_OUT_OF_MEMORY,
+			"Shader library could not allocate a variant."
+		);
+
+		gfx_vector_clear(&source);
+		return NULL;
+	}
+
+	memcpy(var.source, source.begin, size);
+	gfx_vector_clear(&source);
+
+	var.shader = gfx_shader_create(stage);
+
+	if(var.shader)
+	{
+		const char* str = var.source;
+
+		if(!gfx_shader_set_source(var.shader, 1, &str, NULL) || gfx_vector_insert(
+			&internal->variants,
+			&var,
+			gfx_vector_at(&internal->variants, index)) == internal->variants.end)
+		{
+			gfx_shader_free(var.shader);
+			var.shader = NULL;
+		}
+
+		else ++library->shaders;
+	}
+
+	if(!var.shader) free(var.source);
+
+	return var.shader;
+}
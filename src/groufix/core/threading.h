@@ -73,6 +73,56 @@ typedef CONDITION_VARIABLE GFX_PlatformCond;
 #endif
 
 
+/** One time initialization, statically initialize with GFX_PLATFORM_ONCE_INIT */
+#if defined(GFX_UNIX)
+typedef pthread_once_t GFX_PlatformOnce;
+#define GFX_PLATFORM_ONCE_INIT PTHREAD_ONCE_INIT
+
+#elif defined(GFX_WIN32)
+typedef INIT_ONCE GFX_PlatformOnce;
+#define GFX_PLATFORM_ONCE_INIT INIT_ONCE_STATIC_INIT
+
+#endif
+
+
+/** Atomic operations, objects accessed through these must be declared GFX_ATOMIC(type) */
+#if defined(GFX_CLANG) || defined(GFX_GCC) || defined(GFX_MINGW)
+	#define GFX_ATOMIC(type)    type
+
+	#define GFX_ATOMIC_RELAXED  __ATOMIC_RELAXED
+	#define GFX_ATOMIC_ACQUIRE  __ATOMIC_ACQUIRE
+	#define GFX_ATOMIC_RELEASE  __ATOMIC_RELEASE
+	#define GFX_ATOMIC_SEQ_CST  __ATOMIC_SEQ_CST
+
+	#define GFX_ATOMIC_LOAD(x,o)     __atomic_load_n(x, o)
+	#define GFX_ATOMIC_STORE(x,y,o)  __atomic_store_n(x, y, o)
+	#define GFX_ATOMIC_ADD(x,y)      __atomic_add_fetch(x, y, __ATOMIC_SEQ_CST)
+	#define GFX_ATOMIC_SUB(x,y)      __atomic_sub_fetch(x, y, __ATOMIC_SEQ_CST)
+	#define GFX_ATOMIC_CAS(x,y,z)    __atomic_compare_exchange_n(x, y, z, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)
+	#define GFX_ATOMIC_FENCE(o)      __atomic_thread_fence(o)
+
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+	#include <stdatomic.h>
+
+	#define GFX_ATOMIC(type)    _Atomic(type)
+
+	#define GFX_ATOMIC_RELAXED  memory_order_relaxed
+	#define GFX_ATOMIC_ACQUIRE  memory_order_acquire
+	#define GFX_ATOMIC_RELEASE  memory_order_release
+	#define GFX_ATOMIC_SEQ_CST  memory_order_seq_cst
+
+	#define GFX_ATOMIC_LOAD(x,o)     atomic_load_explicit(x, o)
+	#define GFX_ATOMIC_STORE(x,y,o)  atomic_store_explicit(x, y, o)
+	#define GFX_ATOMIC_ADD(x,y)      (atomic_fetch_add(x, y) + (y))
+	#define GFX_ATOMIC_SUB(x,y)      (atomic_fetch_sub(x, y) - (y))
+	#define GFX_ATOMIC_CAS(x,y,z)    atomic_compare_exchange_strong_explicit(x, y, z, memory_order_seq_cst, memory_order_relaxed)
+	#define GFX_ATOMIC_FENCE(o)      atomic_thread_fence(o)
+
+#else
+	#error "Atomic operations not supported, use a compiler with C11 atomics (/experimental:c11atomics for Visual C)"
+#endif
+
+
 /********************************************************
  * Threading
  *******************************************************/
@@ -243,6 +293,43 @@ static GFX_ALWAYS_INLINE void* _gfx_platform_key_get(
 #endif
 }
 
+#if defined(GFX_WIN32)
+static inline BOOL CALLBACK _gfx_platform_once_func(
+
+		PINIT_ONCE  once,
+		PVOID       func,
+		PVOID*      context)
+{
+	(*(void (**)(void))func)();
+	return TRUE;
+}
+#endif
+
+/**
+ * Calls a function exactly once, no matter how many threads call this.
+ *
+ * @param once Object initialized with GFX_PLATFORM_ONCE_INIT.
+ * @param func Function to call, cannot be NULL.
+ *
+ * All calls with the same once object return after func has returned.
+ *
+ */
+static GFX_ALWAYS_INLINE void _gfx_platform_once(
+
+		GFX_PlatformOnce*  once,
+		void               (*func)(void))
+{
+#if defined(GFX_UNIX)
+
+	pthread_once(once, func);
+
+#elif defined(GFX_WIN32)
+
+	InitOnceExecuteOnce(once, _gfx_platform_once_func, &func, NULL);
+
+#endif
+}
+
 /**
  * Initializes a new mutex.
  *
@@ -0,0 +1,39 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/core/utils.h"
+
+/******************************************************/
+int _gfx_upload_marker_set(
+
+		GFX_UploadMarker*  marker,
+		unsigned int       copy)
+{
+	if(*marker == copy + 1) return 0;
+	*marker = copy + 1;
+
+	return 1;
+}
+
+/******************************************************/
+void _gfx_upload_marker_reset(
+
+		GFX_UploadMarker*  marker,
+		unsigned int       first,
+		unsigned int       num)
+{
+	/* Nothing uploaded is never within range */
+	if(*marker > first && (!num || *marker - first <= num))
+		*marker = 0;
+}
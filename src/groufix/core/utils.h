@@ -37,6 +37,16 @@ typedef void* GFX_BufferHandle;
 #endif
 
 
+/** Internal fence handle */
+#if defined(GFX_RENDERER_GL)
+typedef GLsync GFX_FenceHandle;
+
+#elif defined(GFX_RENDERER_VK)
+typedef void* GFX_FenceHandle;
+
+#endif
+
+
 /** Internal vertex layout handle */
 #if defined(GFX_RENDERER_GL)
 typedef GLuint GFX_LayoutHandle;
@@ -150,6 +160,111 @@ unsigned char _gfx_sizeof_data_type(
 		GFXDataType type);
 
 
+/********************************************************
+ * Name lookup
+ *******************************************************/
+
+/** Hash table of names, mapping each to an index */
+typedef struct GFX_NameTable
+{
+	GFXVector  names;  /* Stores null terminated names */
+	GFXVector  lookup; /* Stores the (internal) entries of the table */
+
+} GFX_NameTable;
+
+
+/**
+ * Initializes an empty name table.
+ *
+ */
+void _gfx_name_table_init(
+
+		GFX_NameTable* table);
+
+/**
+ * Removes all names from a name table.
+ *
+ */
+void _gfx_name_table_clear(
+
+		GFX_NameTable* table);
+
+/**
+ * Adds a name to the table, it cannot be found before the table is built.
+ *
+ * @param len   Length of name in bytes, it does not need to be null terminated.
+ * @param block Non-zero if the index is of a block, so blocks and properties can share names.
+ *
+ * If this fails, the name is silently left out.
+ *
+ */
+void _gfx_name_table_add(
+
+		GFX_NameTable*  table,
+		const char*     name,
+		size_t          len,
+		unsigned short  index,
+		unsigned char   block);
+
+/**
+ * Builds the hash table of all added names.
+ *
+ * Names cannot be added afterwards, unless the table is cleared first.
+ * If this fails, the table is left empty.
+ *
+ */
+void _gfx_name_table_build(
+
+		GFX_NameTable* table);
+
+/**
+ * Finds a name in a built table.
+ *
+ * @param name Null terminated name to find.
+ * @return The index of the name + 1, 0 if not found.
+ *
+ */
+size_t _gfx_name_table_find(
+
+		const GFX_NameTable*  table,
+		const char*           name,
+		unsigned char         block);
+
+
+/********************************************************
+ * Upload markers
+ *******************************************************/
+
+/** Copy + 1 of a value present in a program, 0 if none */
+typedef unsigned int GFX_UploadMarker;
+
+
+/**
+ * Marks a copy of a value as present in its program.
+ *
+ * @param copy Copy about to be uploaded, 0 for values without copies.
+ * @return Zero if the copy was already present, so uploading can be skipped.
+ *
+ */
+int _gfx_upload_marker_set(
+
+		GFX_UploadMarker*  marker,
+		unsigned int       copy);
+
+/**
+ * Forgets the present copy if it is one of the given copies.
+ *
+ * @param first First copy that changed.
+ * @param num   Number of copies that changed, 0 for all copies from first on.
+ *
+ */
+void _gfx_upload_marker_reset(
+
+		GFX_UploadMarker*  marker,
+		unsigned int       first,
+		unsigned int       num);
+
+
 /********************************************************
  * Error initialization and termination
  *******************************************************/
@@ -262,6 +377,14 @@ void _gfx_errors_terminate(void);
  * Internal program, program map & property map usage
  *******************************************************/
 
+/**
+ * Returns whether a program has an asynchronous link that is not finished.
+ *
+ */
+/*int _gfx_program_is_pending(
+
+		const GFXProgram* program);*/
+
 /**
  * References a program to postpone its destruction.
  *
@@ -277,18 +400,130 @@ void _gfx_errors_terminate(void);
 		GFXProgram*   program,
 		unsigned int  references);*/
 
+/**
+ * Claims the values of a program for a property map.
+ *
+ * @param owner Property map about to upload values.
+ * @return Zero if the owner did not upload the current values of the program.
+ *
+ * After this call the owner owns the values.
+ *
+ */
+/*int _gfx_program_claim(
+
+		GFXProgram*  program,
+		const void*  owner);*/
+
+/**
+ * Releases the values of a program if owned by the given property map.
+ *
+ */
+/*void _gfx_program_release(
+
+		GFXProgram*  program,
+		const void*  owner);*/
+
+/**
+ * Returns the hash of the current source and stage of a shader.
+ *
+ */
+uint64_t _gfx_shader_get_hash(
+
+		const GFXShader* shader);
+
+/**
+ * Starts compiling a shader without waiting for or querying the result.
+ *
+ * The result is retrieved by gfx_shader_compile or by linking a program.
+ *
+ */
+/*void _gfx_shader_compile_async(
+
+		GFXShader* shader);*/
+
+/**
+ * Continues a hash over a number of bytes, used for program cache keys.
+ *
+ * @param hash Hash to continue, 0 to start a new hash.
+ * @return The new hash.
+ *
+ */
+uint64_t _gfx_program_cache_hash(
+
+		uint64_t     hash,
+		const void*  data,
+		size_t       size);
+
+/**
+ * Computes the key of a program in the program cache.
+ *
+ * @param config Hash of the attributes and feedback of the program.
+ * @return Zero if the program cache is not open or not supported.
+ *
+ */
+uint64_t _gfx_program_cache_key(
+
+		uint64_t           config,
+		size_t             num,
+		GFXShader* const*  shaders,
+		GFX_CONT_ARG);
+
+/**
+ * Attempts to link a program using a cached binary.
+ *
+ * @param key Key returned by _gfx_program_cache_key, cannot be zero.
+ * @return Non-zero if the program is linked.
+ *
+ */
+int _gfx_program_cache_load(
+
+		GFXProgram*  program,
+		uint64_t     key);
+
+/**
+ * Stores the binary of a linked program in the program cache.
+ *
+ * @param key Key returned by _gfx_program_cache_key, cannot be zero.
+ *
+ */
+void _gfx_program_cache_store(
+
+		const GFXProgram*  program,
+		uint64_t           key);
+
 /**
  * Blocks the program map from adding anymore programs.
  *
  * @return Zero on failure.
  *
  * This so it can link the programs.
+ * Programs that are still linking are accepted, they are used once
+ * gfx_program_map_is_ready returns non-zero.
  *
  */
 /*int _gfx_program_map_block(
 
 		GFXProgramMap* map);*/
 
+/** Program map poll results */
+#define GFX_INT_MAP_PENDING  0x00
+#define GFX_INT_MAP_READY    0x01
+#define GFX_INT_MAP_FAILED   0x02
+
+/**
+ * Returns whether all programs of the program map are linked.
+ *
+ * @return One of GFX_INT_MAP_*, failed if any program failed to link.
+ *
+ * Without GFX_INT_EXT_PARALLEL_SHADER_COMPILE the driver cannot be asked
+ * whether a link is done, so the first poll blocks until it is done.
+ * With it, this never blocks.
+ *
+ */
+/*int _gfx_program_map_poll(
+
+		GFXProgramMap* map);*/
+
 /**
  * Unblocks the program map from adding anymore programs.
  *
@@ -358,14 +593,16 @@ void _gfx_errors_terminate(void);
 /**
  * Creates a new bucket pipe.
  *
- * @param bits Number of manual bits to sort by (LSB = 1st bit, 0 for all bits).
+ * @param bits  Number of manual bits to sort by (LSB = 1st bit, 0 for all bits).
+ * @param flags Flags to apply to the bucket.
  * @return NULL on failure
  *
  */
 /*GFX_Pipe* _gfx_pipe_create_bucket(
 
 		GFXPipeline*    pipeline,
-		unsigned char   bits);*/
+		unsigned char   bits,
+		GFXBucketFlags  flags);*/
 
 /**
  * Creates a new process pipe.
@@ -401,13 +638,15 @@ void _gfx_errors_terminate(void);
 /**
  * Creates a new bucket.
  *
- * @param bits Number of manual bits to sort by (LSB = 1st bit, 0 for all bits).
+ * @param bits  Number of manual bits to sort by (LSB = 1st bit, 0 for all bits).
+ * @param flags Flags to apply to the bucket.
  * @return NULL on failure.
  *
  */
 /*GFXBucket* _gfx_bucket_create(
 
-		unsigned char bits);*/
+		unsigned char   bits,
+		GFXBucketFlags  flags);*/
 
 /**
  * Makes sure the bucket is freed properly.
@@ -417,9 +656,34 @@ void _gfx_errors_terminate(void);
 
 		GFXBucket* bucket);*/
 
+/**
+ * Shows units of which the program map became ready.
+ *
+ * This queries the context, so it must be called on the context thread
+ * before preparing, _gfx_bucket_process polls by itself if not prepared.
+ *
+ */
+/*void _gfx_bucket_poll(
+
+		GFXBucket* bucket);*/
+
+/**
+ * Sorts, culls and records all units of the bucket ahead of processing.
+ *
+ * This does not make any calls to the context, so buckets may be prepared
+ * by any thread, as long as only one thread accesses a bucket at a time.
+ * Units waiting for their program map are only shown by _gfx_bucket_poll.
+ *
+ */
+/*void _gfx_bucket_prepare(
+
+		GFXBucket* bucket);*/
+
 /**
  * Processes the bucket, drawing all units.
  *
+ * If the bucket was prepared, only the recorded units are replayed.
+ *
  */
 /*void _gfx_bucket_process(
 
@@ -14,6 +14,8 @@
 
 #include "groufix/math.h"
 
+#include <string.h>
+
 /******************************************************/
 /** Mathematical constants */
 const long double GFX_MATH_PI          = 3.1415926535897932384626433832795028841971693993751;
@@ -21,3 +23,524 @@ const long double GFX_MATH_TWO_PI      = 6.2831853071795864769252867665590057683
 const long double GFX_MATH_HALF_PI     = 1.5707963267948966192313216916397514420985846996876;
 const long double GFX_MATH_RAD_TO_DEG  = 57.295779513082320876798154814105170332405472466564;
 const long double GFX_MATH_DEG_TO_RAD  = 0.017453292519943295769236907684886127134428718885417;
+
+/******************************************************/
+static GFX_ALWAYS_INLINE void _gfx_math_transform(
+
+		float*           dest,
+		const gfx_mat4*  a,
+		float            x,
+		float            y,
+		float            z,
+		float            w)
+{
+	size_t r;
+	for(r = 0; r < 4; ++r) dest[r] =
+		a->data[r] * x +
+		a->data[r + 4] * y +
+		a->data[r + 8] * z +
+		a->data[r + 12] * w;
+}
+
+/******************************************************/
+static GFX_ALWAYS_INLINE void _gfx_math_compose(
+
+		gfx_mat4*  dest,
+		float      tx,
+		float      ty,
+		float      tz,
+		float      qw,
+		float      qx,
+		float      qy,
+		float      qz,
+		float      sx,
+		float      sy,
+		float      sz)
+{
+	float x2 = qx + qx;
+	float y2 = qy + qy;
+	float z2 = qz + qz;
+
+	float wx = x2 * qw;
+	float wy = y2 * qw;
+	float wz = z2 * qw;
+	float xx = x2 * qx;
+	float xy = y2 * qx;
+	float xz = z2 * qx;
+	float yy = y2 * qy;
+	float yz = z2 * qy;
+	float zz = z2 * qz;
+
+	float* m = dest->data;
+	m[0]  = (1 - yy - zz) * sx; m[4] = (xy - wz) * sy;     m[8]  = (xz + wy) * sz;     m[12] = tx;
+	m[1]  = (xy + wz) * sx;     m[5] = (1 - xx - zz) * sy; m[9]  = (yz - wx) * sz;     m[13] = ty;
+	m[2]  = (xz - wy) * sx;     m[6] = (yz + wx) * sy;     m[10] = (1 - xx - yy) * sz; m[14] = tz;
+	m[3]  = 0;                  m[7] = 0;                  m[11] = 0;                  m[15] = 1;
+}
+
+/******************************************************/
+static GFX_ALWAYS_INLINE void _gfx_math_normalize(
+
+		float*  w,
+		float*  x,
+		float*  y,
+		float*  z)
+{
+	double norm = sqrt((double)*w * *w + *x * *x + *y * *y + *z * *z);
+	if(norm) norm = 1.0 / norm;
+
+	*w *= norm;
+	*x *= norm;
+	*y *= norm;
+	*z *= norm;
+}
+
+#if defined(GFX_SIMD_SSE2)
+
+/******************************************************/
+static GFX_ALWAYS_INLINE void _gfx_math_compose4(
+
+		gfx_mat4*      dest,
+		const __m128*  t,
+		const __m128*  q,
+		const __m128*  s)
+{
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 zero = _mm_setzero_ps();
+
+	__m128 x2 = _mm_add_ps(q[1], q[1]);
+	__m128 y2 = _mm_add_ps(q[2], q[2]);
+	__m128 z2 = _mm_add_ps(q[3], q[3]);
+
+	__m128 wx = _mm_mul_ps(x2, q[0]);
+	__m128 wy = _mm_mul_ps(y2, q[0]);
+	__m128 wz = _mm_mul_ps(z2, q[0]);
+	__m128 xx = _mm_mul_ps(x2, q[1]);
+	__m128 xy = _mm_mul_ps(y2, q[1]);
+	__m128 xz = _mm_mul_ps(z2, q[1]);
+	__m128 yy = _mm_mul_ps(y2, q[2]);
+	__m128 yz = _mm_mul_ps(z2, q[2]);
+	__m128 zz = _mm_mul_ps(z2, q[3]);
+
+	/* Each register holds an element of four matrices */
+	__m128 m[16];
+	m[0]  = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(yy, zz)), s[0]);
+	m[1]  = _mm_mul_ps(_mm_add_ps(xy, wz), s[0]);
+	m[2]  = _mm_mul_ps(_mm_sub_ps(xz, wy), s[0]);
+	m[3]  = zero;
+	m[4]  = _mm_mul_ps(_mm_sub_ps(xy, wz), s[1]);
+	m[5]  = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, zz)), s[1]);
+	m[6]  = _mm_mul_ps(_mm_add_ps(yz, wx), s[1]);
+	m[7]  = zero;
+	m[8]  = _mm_mul_ps(_mm_add_ps(xz, wy), s[2]);
+	m[9]  = _mm_mul_ps(_mm_sub_ps(yz, wx), s[2]);
+	m[10] = _mm_mul_ps(_mm_sub_ps(one, _mm_add_ps(xx, yy)), s[2]);
+	m[11] = zero;
+	m[12] = t[0];
+	m[13] = t[1];
+	m[14] = t[2];
+	m[15] = one;
+
+	/* Transpose to get the columns of each matrix */
+	size_t c, i;
+	for(c = 0; c < 16; c += 4)
+	{
+		_MM_TRANSPOSE4_PS(m[c], m[c + 1], m[c + 2], m[c + 3]);
+
+		for(i = 0; i < 4; ++i)
+			_mm_storeu_ps(dest[i].data + c, m[c + i]);
+	}
+}
+
+#endif // GFX_SIMD_SSE2
+
+/******************************************************/
+void gfx_math_transform_vec3(
+
+		gfx_vec3*        dest,
+		const gfx_mat4*  a,
+		const gfx_vec3*  src,
+		size_t           num)
+{
+	size_t i;
+
+#if defined(GFX_SIMD_SSE2)
+
+	__m128 c0 = _mm_loadu_ps(a->data + 0);
+	__m128 c1 = _mm_loadu_ps(a->data + 4);
+	__m128 c2 = _mm_loadu_ps(a->data + 8);
+	__m128 c3 = _mm_loadu_ps(a->data + 12);
+
+	for(i = 0; i < num; ++i)
+	{
+		__m128 res = _mm_add_ps(
+			_mm_add_ps(
+				_mm_mul_ps(c0, _mm_set1_ps(src[i].data[0])),
+				_mm_mul_ps(c1, _mm_set1_ps(src[i].data[1]))),
+			_mm_add_ps(
+				_mm_mul_ps(c2, _mm_set1_ps(src[i].data[2])),
+				c3));
+
+		/* Vectors are not padded, store 3 components only */
+		_mm_storel_pi((__m64*)dest[i].data, res);
+		_mm_store_ss(dest[i].data + 2, _mm_movehl_ps(res, res));
+	}
+
+#else
+
+	for(i = 0; i < num; ++i)
+	{
+		float res[4];
+		_gfx_math_transform(
+			res, a,
+			src[i].data[0],
+			src[i].data[1],
+			src[i].data[2],
+			1.0f);
+
+		memcpy(dest[i].data, res, sizeof(gfx_vec3));
+	}
+
+#endif
+}
+
+/******************************************************/
+void gfx_math_transform_vec4(
+
+		gfx_vec4*        dest,
+		const gfx_mat4*  a,
+		const gfx_vec4*  src,
+		size_t           num)
+{
+	size_t i;
+
+#if defined(GFX_SIMD_SSE2)
+
+	__m128 c0 = _mm_loadu_ps(a->data + 0);
+	__m128 c1 = _mm_loadu_ps(a->data + 4);
+	__m128 c2 = _mm_loadu_ps(a->data + 8);
+	__m128 c3 = _mm_loadu_ps(a->data + 12);
+
+	for(i = 0; i < num; ++i)
+	{
+		__m128 v = _mm_loadu_ps(src[i].data);
+		__m128 res = _mm_add_ps(
+			_mm_add_ps(
+				_mm_mul_ps(c0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0))),
+				_mm_mul_ps(c1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)))),
+			_mm_add_ps(
+				_mm_mul_ps(c2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))),
+				_mm_mul_ps(c3, _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)))));
+
+		_mm_storeu_ps(dest[i].data, res);
+	}
+
+#else
+
+	for(i = 0; i < num; ++i)
+		gfx_mat4_mult_vec(dest + i, a, src + i);
+
+#endif
+}
+
+/******************************************************/
+void gfx_math_transform_vec3_soa(
+
+		const GFXVec3Array*  dest,
+		const gfx_mat4*      a,
+		const GFXVec3Array*  src,
+		size_t               num)
+{
+	size_t i = 0;
+
+#if defined(GFX_SIMD_SSE2)
+
+	/* Transform four points at a time */
+	__m128 m[16];
+	size_t e;
+	for(e = 0; e < 16; ++e) m[e] = _mm_set1_ps(a->data[e]);
+
+	for(; i + 4 <= num; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(src->x + i);
+		__m128 y = _mm_loadu_ps(src->y + i);
+		__m128 z = _mm_loadu_ps(src->z + i);
+
+		__m128 rx = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(m[0], x), _mm_mul_ps(m[4], y)),
+			_mm_add_ps(_mm_mul_ps(m[8], z), m[12]));
+		__m128 ry = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(m[1], x), _mm_mul_ps(m[5], y)),
+			_mm_add_ps(_mm_mul_ps(m[9], z), m[13]));
+		__m128 rz = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(m[2], x), _mm_mul_ps(m[6], y)),
+			_mm_add_ps(_mm_mul_ps(m[10], z), m[14]));
+
+		_mm_storeu_ps(dest->x + i, rx);
+		_mm_storeu_ps(dest->y + i, ry);
+		_mm_storeu_ps(dest->z + i, rz);
+	}
+
+#endif
+
+	for(; i < num; ++i)
+	{
+		float res[4];
+		_gfx_math_transform(
+			res, a,
+			src->x[i],
+			src->y[i],
+			src->z[i],
+			1.0f);
+
+		dest->x[i] = res[0];
+		dest->y[i] = res[1];
+		dest->z[i] = res[2];
+	}
+}
+
+/******************************************************/
+void gfx_math_transform_vec4_soa(
+
+		const GFXVec4Array*  dest,
+		const gfx_mat4*      a,
+		const GFXVec4Array*  src,
+		size_t               num)
+{
+	size_t i = 0;
+
+#if defined(GFX_SIMD_SSE2)
+
+	/* Transform four vectors at a time */
+	__m128 m[16];
+	size_t e;
+	for(e = 0; e < 16; ++e) m[e] = _mm_set1_ps(a->data[e]);
+
+	for(; i + 4 <= num; i += 4)
+	{
+		__m128 x = _mm_loadu_ps(src->x + i);
+		__m128 y = _mm_loadu_ps(src->y + i);
+		__m128 z = _mm_loadu_ps(src->z + i);
+		__m128 w = _mm_loadu_ps(src->w + i);
+
+		__m128 res[4];
+
+		size_t r;
+		for(r = 0; r < 4; ++r) res[r] = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(m[r], x), _mm_mul_ps(m[r + 4], y)),
+			_mm_add_ps(_mm_mul_ps(m[r + 8], z), _mm_mul_ps(m[r + 12], w)));
+
+		_mm_storeu_ps(dest->x + i, res[0]);
+		_mm_storeu_ps(dest->y + i, res[1]);
+		_mm_storeu_ps(dest->z + i, res[2]);
+		_mm_storeu_ps(dest->w + i, res[3]);
+	}
+
+#endif
+
+	for(; i < num; ++i)
+	{
+		float res[4];
+		_gfx_math_transform(
+			res, a,
+			src->x[i],
+			src->y[i],
+			src->z[i],
+			src->w[i]);
+
+		dest->x[i] = res[0];
+		dest->y[i] = res[1];
+		dest->z[i] = res[2];
+		dest->w[i] = res[3];
+	}
+}
+
+/******************************************************/
+void gfx_math_compose(
+
+		gfx_mat4*        dest,
+		const gfx_vec3*  translation,
+		const gfx_quat*  rotation,
+		const gfx_vec3*  scale,
+		size_t           num)
+{
+	size_t i = 0;
+
+#if defined(GFX_SIMD_SSE2)
+
+	/* Gather four entities into registers at a time */
+	__m128 one = _mm_set1_ps(1.0f);
+
+	for(; i + 4 <= num; i += 4)
+	{
+		const gfx_vec3* t = translation + i;
+		const gfx_quat* q = rotation + i;
+
+		__m128 vt[3];
+		__m128 vq[4];
+		__m128 vs[3];
+
+		size_t c;
+		for(c = 0; c < 3; ++c) vt[c] = _mm_setr_ps(
+			t[0].data[c], t[1].data[c], t[2].data[c], t[3].data[c]);
+
+		/* Quaternions are 4 wide, so transpose them in registers */
+		vq[0] = _mm_loadu_ps(q[0].data);
+		vq[1] = _mm_loadu_ps(q[1].data);
+		vq[2] = _mm_loadu_ps(q[2].data);
+		vq[3] = _mm_loadu_ps(q[3].data);
+
+		_MM_TRANSPOSE4_PS(vq[0], vq[1], vq[2], vq[3]);
+
+		if(scale)
+		{
+			const gfx_vec3* s = scale + i;
+			for(c = 0; c < 3; ++c) vs[c] = _mm_setr_ps(
+				s[0].data[c], s[1].data[c], s[2].data[c], s[3].data[c]);
+		}
+		else vs[0] = vs[1] = vs[2] = one;
+
+		_gfx_math_compose4(dest + i, vt, vq, vs);
+	}
+
+#endif
+
+	for(; i < num; ++i) _gfx_math_compose(
+		dest + i,
+		translation[i].data[0],
+		translation[i].data[1],
+		translation[i].data[2],
+		rotation[i].data[0],
+		rotation[i].data[1],
+		rotation[i].data[2],
+		rotation[i].data[3],
+		scale ? scale[i].data[0] : 1.0f,
+		scale ? scale[i].data[1] : 1.0f,
+		scale ? scale[i].data[2] : 1.0f);
+}
+
+/******************************************************/
+void gfx_math_compose_soa(
+
+		gfx_mat4*            dest,
+		const GFXVec3Array*  translation,
+		const GFXQuatArray*  rotation,
+		const GFXVec3Array*  scale,
+		size_t               num)
+{
+	size_t i = 0;
+
+#if defined(GFX_SIMD_SSE2)
+
+	/* Compose four matrices at a time */
+	__m128 one = _mm_set1_ps(1.0f);
+
+	for(; i + 4 <= num; i += 4)
+	{
+		__m128 vt[3] = {
+			_mm_loadu_ps(translation->x + i),
+			_mm_loadu_ps(translation->y + i),
+			_mm_loadu_ps(translation->z + i)
+		};
+
+		__m128 vq[4] = {
+			_mm_loadu_ps(rotation->w + i),
+			_mm_loadu_ps(rotation->x + i),
+			_mm_loadu_ps(rotation->y + i),
+			_mm_loadu_ps(rotation->z + i)
+		};
+
+		__m128 vs[3] = { one, one, one };
+		if(scale)
+		{
+			vs[0] = _mm_loadu_ps(scale->x + i);
+			vs[1] = _mm_loadu_ps(scale->y + i);
+			vs[2] = _mm_loadu_ps(scale->z + i);
+		}
+
+		_gfx_math_compose4(dest + i, vt, vq, vs);
+	}
+
+#endif
+
+	for(; i < num; ++i) _gfx_math_compose(
+		dest + i,
+		translation->x[i],
+		translation->y[i],
+		translation->z[i],
+		rotation->w[i],
+		rotation->x[i],
+		rotation->y[i],
+		rotation->z[i],
+		scale ? scale->x[i] : 1.0f,
+		scale ? scale->y[i] : 1.0f,
+		scale ? scale->z[i] : 1.0f);
+}
+
+/******************************************************/
+void gfx_math_normalize_quat(
+
+		gfx_quat*        dest,
+		const gfx_quat*  src,
+		size_t           num)
+{
+	/* Each quaternion fills a register already */
+	size_t i;
+	for(i = 0; i < num; ++i)
+		gfx_quat_normalize(dest + i, src + i);
+}
+
+/******************************************************/
+void gfx_math_normalize_quat_soa(
+
+		const GFXQuatArray*  dest,
+		const GFXQuatArray*  src,
+		size_t               num)
+{
+	size_t i = 0;
+
+#if defined(GFX_SIMD_SSE2)
+
+	/* Normalize four quaternions at a time */
+	__m128 zero = _mm_setzero_ps();
+	__m128 one = _mm_set1_ps(1.0f);
+
+	for(; i + 4 <= num; i += 4)
+	{
+		__m128 w = _mm_loadu_ps(src->w + i);
+		__m128 x = _mm_loadu_ps(src->x + i);
+		__m128 y = _mm_loadu_ps(src->y + i);
+		__m128 z = _mm_loadu_ps(src->z + i);
+
+		__m128 norm = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(w, w), _mm_mul_ps(x, x)),
+			_mm_add_ps(_mm_mul_ps(y, y), _mm_mul_ps(z, z)));
+
+		/* Zero quaternions remain zero */
+		norm = _mm_and_ps(
+			_mm_cmpneq_ps(norm, zero),
+			_mm_div_ps(one, _mm_sqrt_ps(norm)));
+
+		_mm_storeu_ps(dest->w + i, _mm_mul_ps(w, norm));
+		_mm_storeu_ps(dest->x + i, _mm_mul_ps(x, norm));
+		_mm_storeu_ps(dest->y + i, _mm_mul_ps(y, norm));
+		_mm_storeu_ps(dest->z + i, _mm_mul_ps(z, norm));
+	}
+
+#endif
+
+	for(; i < num; ++i)
+	{
+		float w = src->w[i];
+		float x = src->x[i];
+		float y = src->y[i];
+		float z = src->z[i];
+
+		_gfx_math_normalize(&w, &x, &y, &z);
+
+		dest->w[i] = w;
+		dest->x[i] = x;
+		dest->y[i] = y;
+		dest->z[i] = z;
+	}
+}
@@ -141,8 +141,6 @@ void gfx_batch_free(
 	{
 		/* Erase all units and copies */
 		unsigned char level;
-		unsigned int unit;
-
 		for(level = 0; level < batch->levels; ++level)
 		{
 			GFX_Level* lev = _gfx_batch_get_level(
@@ -150,9 +148,10 @@ void gfx_batch_free(
 			_gfx_batch_erase_copies(
 				batch, lev);
 
-			for(unit = 0; unit < lev->num; ++unit) gfx_bucket_erase(
+			gfx_bucket_erase_range(
 				batch->bucket,
-				*_gfx_batch_get_unit(batch, level, unit)
+				lev->num,
+				_gfx_batch_get_unit(batch, level, 0)
 			);
 		}
 
@@ -331,34 +330,26 @@ GFXBucketUnit* gfx_batch_set(
 			gfx_material_get(batch->material, lev->material, &index),
 			batch->materialIndex);
 
-		/* Insert more units */
-		unsigned int unit;
-		for(unit = lev->num; unit < num; ++unit)
+		/* Insert more units, all at once */
+		if(!gfx_bucket_insert_multiple(
+			batch->bucket,
+			num - lev->num,
+			src,
+			map,
+			lev->offset,
+			visible,
+			_gfx_batch_get_unit(batch, level, lev->num)))
 		{
-			GFXBucketUnit new = gfx_bucket_insert(
-				batch->bucket, src, map, lev->offset, visible);
-			*_gfx_batch_get_unit(
-				batch, level, unit) = new;
-
-			/* Nevermind erase them all again */
-			if(!new)
-			{
-				while(unit > lev->num) gfx_bucket_erase(
-					batch->bucket,
-					*_gfx_batch_get_unit(batch, level, unit--)
-				);
-
-				return NULL;
-			}
+			return NULL;
 		}
 	}
 	else
 	{
 		/* Destroy excess units */
-		unsigned int unit;
-		for(unit = num; unit < lev->num; ++unit) gfx_bucket_erase(
+		gfx_bucket_erase_range(
 			batch->bucket,
-			*_gfx_batch_get_unit(batch, level, unit)
+			lev->num - num,
+			_gfx_batch_get_unit(batch, level, num)
 		);
 	}
 
@@ -16,6 +16,7 @@
 #include "groufix/scene/internal.h"
 
 #include <limits.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -27,13 +28,34 @@ typedef struct GFX_Mesh
 	GFX_LodMap lodMap;
 
 	/* Hidden data */
-	GFXVector  layouts; /* Stores GFXVertexLayout* */
+	GFXVector  layouts; /* Stores GFX_Layout */
 	GFXVector  buckets; /* Stores (GFX_Bucket + GFXBucketSource * lodMap size) */
-	GFXVector  buffers; /* Stores GFXSharedBuffer */
+	GFXVector  buffers; /* Stores GFX_Buffer */
 
 } GFX_Mesh;
 
 
+/** Internal layout */
+typedef struct GFX_Layout
+{
+	GFXVertexLayout*  layout;
+	unsigned int      vertexBase; /* Vertex offset of all vertex buffers */
+	size_t            indexBase;  /* Byte offset of the index buffer */
+	char              based;      /* Non-zero if vertexBase is set by a vertex buffer */
+	char              owned;      /* Non-zero if the layout is freed by the mesh */
+
+} GFX_Layout;
+
+
+/** Internal buffer */
+typedef struct GFX_Buffer
+{
+	GFXBufferHeap*  heap;  /* Heap the range is allocated from, NULL if the buffer is owned */
+	GFXBufferRange  range;
+
+} GFX_Buffer;
+
+
 /** Internal source data */
 typedef struct GFX_SourceData
 {
@@ -55,12 +77,12 @@ typedef struct GFX_Bucket
 
 
 /******************************************************/
-static inline GFXVertexLayout* _gfx_mesh_get_layout(
+static inline GFX_Layout* _gfx_mesh_get_layout(
 
 		const GFX_Mesh*  mesh,
 		unsigned int     index)
 {
-	return *(GFXVertexLayout**)gfx_vector_at(&mesh->layouts, index);
+	return gfx_vector_at(&mesh->layouts, index);
 }
 
 /******************************************************/
@@ -79,18 +101,26 @@ static inline size_t _gfx_mesh_bucket_size(
 static GFXMeshLayout _gfx_mesh_insert_layout(
 
 		GFX_Mesh*         mesh,
-		GFXVertexLayout*  layout)
+		GFXVertexLayout*  layout,
+		char              owned)
 {
+	GFX_Layout lay;
+	lay.layout = layout;
+	lay.vertexBase = 0;
+	lay.indexBase = 0;
+	lay.based = 0;
+	lay.owned = owned;
+
 	GFXVectorIterator it = gfx_vector_insert(
 		&mesh->layouts,
-		&layout,
+		&lay,
 		mesh->layouts.end
 	);
 
 	if(it == mesh->layouts.end)
 	{
 		/* Free on failure */
-		gfx_vertex_layout_free(layout);
+		if(owned) gfx_vertex_layout_free(layout);
 		return 0;
 	}
 
@@ -282,16 +312,19 @@ GFXBucketSource _gfx_mesh_get_bucket_source(
 	if(!(*src))
 	{
 		/* Add and set source of bucket if it doesn't exist yet */
-		GFXVertexLayout* layout = _gfx_mesh_get_layout(
+		/* Buffers are bound at the start of a heap block, so apply the bases */
+		GFX_Layout* layout = _gfx_mesh_get_layout(
 			internal,
 			list[index].layout);
 
-		*src = gfx_bucket_add_source(
+		*src = gfx_bucket_add_source_with_base(
 			bucket,
-			layout,
+			layout->layout,
 			list[index].index,
 			list[index].offset,
-			list[index].count);
+			list[index].count,
+			layout->vertexBase,
+			layout->indexBase);
 	}
 
 	return *src;
@@ -343,9 +376,9 @@ GFXMesh* gfx_mesh_create(void)
 		sizeof(GFX_SourceData)
 	);
 
-	gfx_vector_init(&mesh->layouts, sizeof(GFXVertexLayout*));
+	gfx_vector_init(&mesh->layouts, sizeof(GFX_Layout));
 	gfx_vector_init(&mesh->buckets, 1);
-	gfx_vector_init(&mesh->buffers, sizeof(GFXSharedBuffer));
+	gfx_vector_init(&mesh->buffers, sizeof(GFX_Buffer));
 
 	return (GFXMesh*)mesh;
 }
@@ -373,23 +406,27 @@ void gfx_mesh_free(
 			);
 		}
 
-		/* Free all layouts */
+		/* Free all owned layouts */
 		GFXVectorIterator it;
 		for(
 			it = internal->layouts.begin;
 			it != internal->layouts.end;
 			it = gfx_vector_next(&internal->layouts, it))
 		{
-			gfx_vertex_layout_free(*(GFXVertexLayout**)it);
+			if(((GFX_Layout*)it)->owned)
+				gfx_vertex_layout_free(((GFX_Layout*)it)->layout);
 		}
 
-		/* Clear all shared buffers */
+		/* Release all buffers */
 		for(
 			it = internal->buffers.begin;
 			it != internal->buffers.end;
 			it = gfx_vector_next(&internal->buffers, it))
 		{
-			gfx_shared_buffer_clear((GFXSharedBuffer*)it, 1);
+			GFX_Buffer* buff = it;
+
+			if(buff->heap) gfx_buffer_heap_release(buff->heap, &buff->range);
+			else gfx_buffer_free(buff->range.buffer);
 		}
 
 		/* Free everything */
@@ -406,16 +443,18 @@ void gfx_mesh_free(
 GFXMeshLayout gfx_mesh_add_layout(
 
 		GFXMesh*       mesh,
+		unsigned char  buffers,
+		unsigned char  attributes,
 		unsigned char  sources)
 {
 	/* Create new layout */
 	GFXVertexLayout* layout =
-		gfx_vertex_layout_create(sources);
+		gfx_vertex_layout_create(buffers, attributes, sources);
 
 	if(!layout) return 0;
 
 	/* Attempt to insert it */
-	return _gfx_mesh_insert_layout((GFX_Mesh*)mesh, layout);
+	return _gfx_mesh_insert_layout((GFX_Mesh*)mesh, layout, 1);
 }
 
 /******************************************************/
@@ -424,11 +463,10 @@ GFXMeshLayout gfx_mesh_share_layout(
 		GFXMesh*          mesh,
 		GFXVertexLayout*  layout)
 {
-	/* Share the layout */
-	if(!gfx_vertex_layout_share(layout)) return 0;
+	if(!layout) return 0;
 
-	/* Attempt to insert it */
-	return _gfx_mesh_insert_layout((GFX_Mesh*)mesh, layout);
+	/* Attempt to insert it, the caller keeps ownership */
+	return _gfx_mesh_insert_layout((GFX_Mesh*)mesh, layout, 0);
 }
 
 /******************************************************/
@@ -437,35 +475,65 @@ GFXVertexLayout* gfx_mesh_get_layout(
 		const GFXMesh*  mesh,
 		GFXMeshLayout   layout)
 {
-	return _gfx_mesh_get_layout((const GFX_Mesh*)mesh, layout - 1);
+	return _gfx_mesh_get_layout((const GFX_Mesh*)mesh, layout - 1)->layout;
 }
 
 /******************************************************/
 GFXMeshBuffer gfx_mesh_add_buffer(
 
-		GFXMesh*     mesh,
-		size_t       size,
-		const void*  data)
+		GFXMesh*        mesh,
+		GFXBufferHeap*  heap,
+		size_t          size,
+		const void*     data)
 {
 	GFX_Mesh* internal = (GFX_Mesh*)mesh;
 
+	/* Get a range of a buffer */
+	/* Align with the largest integer so index offsets can be aligned */
+	GFX_Buffer buff;
+	buff.heap = heap;
+
+	if(heap)
+	{
+		if(!gfx_buffer_heap_alloc(heap, size, sizeof(uint32_t), &buff.range))
+			return 0;
+
+		if(data && gfx_buffer_write(
+			buff.range.buffer,
+			size,
+			data,
+			buff.range.offset) != size)
+		{
+			gfx_buffer_heap_release(heap, &buff.range);
+			return 0;
+		}
+	}
+	else
+	{
+		buff.range.buffer = gfx_buffer_create(
+			GFX_BUFFER_WRITE,
+			size,
+			data,
+			1);
+
+		if(!buff.range.buffer) return 0;
+
+		buff.range.offset = 0;
+		buff.range.size = size;
+	}
+
 	/* Insert new vector element */
-	GFXSharedBuffer* it = gfx_vector_insert(
+	GFXVectorIterator it = gfx_vector_insert(
 		&internal->buffers,
-		NULL,
+		&buff,
 		internal->buffers.end
 	);
 
-	if(it == internal->buffers.end) return 0;
-
-	/* Create new shared buffer */
-	/* Align with largest integer so index offset can be aligned */
-	GFXDataType type;
-	type.unpacked = GFX_LARGE_INTEGER;
-
-	if(!gfx_shared_buffer_init_align(it, size, data, type))
+	if(it == internal->buffers.end)
 	{
-		gfx_vector_erase(&internal->buffers, it);
+		if(heap) gfx_buffer_heap_release(heap, &buff.range);
+		else gfx_buffer_free(buff.range.buffer);
+
 		return 0;
 	}
 
@@ -476,7 +544,7 @@ GFXMeshBuffer gfx_mesh_add_buffer(
 /******************************************************/
 int gfx_mesh_set_vertex_buffer(
 
-		const GFXMesh*  mesh,
+		GFXMesh*        mesh,
 		GFXMeshLayout   layout,
 		GFXMeshBuffer   buffer,
 		unsigned int    index,
@@ -485,44 +553,113 @@ int gfx_mesh_set_vertex_buffer(
 {
 	GFX_Mesh* internal =
 		(GFX_Mesh*)mesh;
-	GFXVertexLayout* lay =
+	GFX_Layout* lay =
 		_gfx_mesh_get_layout(internal, layout - 1);
+	const GFX_Buffer* buff =
+		gfx_vector_at(&internal->buffers, buffer - 1);
 
-	/* Pass buffer to vertex layout */
-	GFXSharedBuffer* buff = (GFXSharedBuffer*)gfx_vector_at(
-		&internal->buffers,
-		buffer - 1);
+	/* Bind at the start of the vertex the range starts in */
+	/* So meshes sharing a layout and buffer can share its state */
+	offset += buff->range.offset;
+
+	size_t base = stride ? offset / stride : 0;
+	offset -= base * stride;
+
+	/* Bucket vertex bases are signed ints when drawn */
+	if(base > INT_MAX || (lay->based && lay->vertexBase != base))
+		return 0;
+
+	/* A shared layout may not be rebound, other meshes still use its state */
+	if(!lay->owned)
+	{
+		GFXBuffer* curr;
+		size_t currOffset;
+		size_t currStride;
+		unsigned int currDivisor;
+
+		if(gfx_vertex_layout_get_vertex_buffer(
+			lay->layout,
+			index,
+			&curr,
+			&currOffset,
+			&currStride,
+			&currDivisor) && (
+				curr != buff->range.buffer ||
+				currOffset != offset ||
+				currStride != stride ||
+				currDivisor))
+		{
+			gfx_errors_push(
+				GFX_ERROR_INVALID_OPERATION,
+				"A vertex buffer of a shared layout cannot be bound to a different "
+				"backing buffer, offset or stride."
+			);
+			return 0;
+		}
+	}
 
-	return gfx_vertex_layout_set_shared_vertex_buffer(
-		lay,
+	/* Pass buffer to vertex layout */
+	if(!gfx_vertex_layout_set_vertex_buffer(
+		lay->layout,
 		index,
-		buff,
+		buff->range.buffer,
 		offset,
-		stride);
+		stride,
+		0))
+	{
+		return 0;
+	}
+
+	lay->vertexBase = (unsigned int)base;
+	lay->based = 1;
+
+	return 1;
 }
 
 /******************************************************/
-void gfx_mesh_set_index_buffer(
+int gfx_mesh_set_index_buffer(
 
-		const GFXMesh*  mesh,
+		GFXMesh*        mesh,
 		GFXMeshLayout   layout,
 		GFXMeshBuffer   buffer,
 		size_t          offset)
 {
 	GFX_Mesh* internal =
 		(GFX_Mesh*)mesh;
-	GFXVertexLayout* lay =
+	GFX_Layout* lay =
 		_gfx_mesh_get_layout(internal, layout - 1);
+	const GFX_Buffer* buff =
+		gfx_vector_at(&internal->buffers, buffer - 1);
 
-	/* Pass buffer to vertex layout */
-	GFXSharedBuffer* buff = (GFXSharedBuffer*)gfx_vector_at(
-		&internal->buffers,
-		buffer - 1);
+	/* A shared layout may not be rebound, other meshes still use its state */
+	GFXBuffer* curr;
+	size_t currOffset;
 
-	gfx_vertex_layout_set_shared_index_buffer(
-		lay,
-		buff,
-		offset);
+	if(!lay->owned && gfx_vertex_layout_get_index_buffer(
+		lay->layout,
+		&curr,
+		&currOffset) && curr != buff->range.buffer)
+	{
+		gfx_errors_push(
+			GFX_ERROR_INVALID_OPERATION,
+			"The index buffer of a shared layout cannot be bound to a different "
+			"backing buffer."
+		);
+		return 0;
+	}
+
+	/* Bind at the start of the buffer, the offset is applied at the bucket */
+	if(!gfx_vertex_layout_set_index_buffer(
+		lay->layout,
+		buff->range.buffer,
+		0))
+	{
+		return 0;
+	}
+
+	lay->indexBase = buff->range.offset + offset;
+
+	return 1;
 }
 
 /******************************************************/
@@ -539,7 +676,7 @@ int gfx_mesh_add(
 
 	/* Check draw index */
 	GFXVertexLayout* lay =
-		_gfx_mesh_get_layout((GFX_Mesh*)mesh, layout);
+		_gfx_mesh_get_layout((GFX_Mesh*)mesh, layout)->layout;
 
 	if(srcIndex >= lay->sources)
 		return 0;
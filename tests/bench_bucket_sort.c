@@ -0,0 +1,250 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "bucket.h"
+#include "groufix/core/threading.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Manual state bits every unit is sorted on */
+#define GFX_BENCH_BITS      8
+
+/* Number of distinct programs and layouts */
+#define GFX_BENCH_PROGRAMS  64
+#define GFX_BENCH_LAYOUTS   256
+
+/* Total number of units sorted per size, spread over repetitions */
+#define GFX_BENCH_TOTAL     4000000
+
+
+/******************************************************/
+/* Previous sorting path: partition on every state bit, quicksort the rest */
+static int _gfx_bench_qsort(
+
+		const void* u1,
+		const void* u2)
+{
+	const GFX_Unit* unit1 = (const GFX_Unit*)u1;
+	const GFX_Unit* unit2 = (const GFX_Unit*)u2;
+
+	return
+		(unit1->program < unit2->program) ? -1 :
+		(unit1->program > unit2->program) ? 1 :
+		(unit1->vao < unit2->vao) ? -1 :
+		(unit1->vao > unit2->vao) ? 1 :
+		0;
+}
+
+/******************************************************/
+static void _gfx_bench_partition_sort(
+
+		GFX_Unit*     units,
+		GFXUnitState  bit,
+		size_t        num)
+{
+	if(num <= 1) return;
+
+	if(!bit) qsort(
+		units,
+		num,
+		sizeof(GFX_Unit),
+		_gfx_bench_qsort);
+
+	else
+	{
+		size_t st = 0;
+		size_t mi = num;
+
+		while(st < mi)
+		{
+			if(units[st].state & bit)
+				_gfx_bucket_swap_units(units + st, units + (--mi));
+			else
+				++st;
+		}
+
+		bit >>= 1;
+		_gfx_bench_partition_sort(units, bit, mi);
+		_gfx_bench_partition_sort(units + mi, bit, num - mi);
+	}
+}
+
+/******************************************************/
+static int _gfx_bench_is_sorted(
+
+		const GFX_Unit*     units,
+		size_t              num,
+		const GFX_SortKey*  key)
+{
+	size_t i;
+	for(i = 1; i < num; ++i)
+		if(_gfx_bucket_greater(units + i - 1, units + i, key))
+			return 0;
+
+	return 1;
+}
+
+/******************************************************/
+static void _gfx_bench_size(
+
+		GFX_Bucket*  bucket,
+		size_t       num)
+{
+	GFX_Unit* input   = malloc(sizeof(GFX_Unit) * num);
+	GFX_Unit* units   = malloc(sizeof(GFX_Unit) * num);
+	GFX_Unit* sorted  = malloc(sizeof(GFX_Unit) * num);
+	GFX_Unit* scratch = malloc(sizeof(GFX_Unit) * num);
+
+	if(!input || !units || !sorted || !scratch)
+	{
+		fprintf(stderr, "Could not allocate %u units.\n", (unsigned int)num);
+		free(input);
+		free(units);
+		free(sorted);
+		free(scratch);
+
+		++_gfx_test_failures;
+		return;
+	}
+
+	/* Random units, as a scene would insert them */
+	size_t i;
+	for(i = 0; i < num; ++i)
+	{
+		input[i].ref     = i;
+		input[i].state   = rand() & ((1 << GFX_BENCH_BITS) - 1);
+		input[i].program = 1 + rand() % GFX_BENCH_PROGRAMS;
+		input[i].vao     = 1 + rand() % GFX_BENCH_LAYOUTS;
+		input[i].depth   = 0;
+	}
+
+	GFX_SortKey key;
+	key.mask  = (1 << GFX_BENCH_BITS) - 1;
+	key.bits  = GFX_BENCH_BITS;
+	key.depth = 0;
+	key.flip  = 0;
+
+	size_t reps = GFX_BENCH_TOTAL / num;
+	reps = reps ? reps : 1;
+
+	/* Previous path */
+	double old = 0.0;
+	size_t r;
+
+	for(r = 0; r < reps; ++r)
+	{
+		memcpy(units, input, sizeof(GFX_Unit) * num);
+
+		double start = _gfx_test_time();
+		_gfx_bench_partition_sort(units, (GFXUnitState)1 << (GFX_BENCH_BITS - 1), num);
+		old += _gfx_test_time() - start;
+	}
+
+	GFX_TEST_CHECK(_gfx_bench_is_sorted(units, num, &key));
+
+	/* Radix sort */
+	double radix = 0.0;
+
+	for(r = 0; r < reps; ++r)
+	{
+		memcpy(units, input, sizeof(GFX_Unit) * num);
+
+		double start = _gfx_test_time();
+		_gfx_bucket_radix_sort(units, scratch, num, &key);
+		radix += _gfx_test_time() - start;
+	}
+
+	GFX_TEST_CHECK(_gfx_bench_is_sorted(units, num, &key));
+	memcpy(sorted, units, sizeof(GFX_Unit) * num);
+
+	/* Parallel radix sort, falls back to the serial sort for small sizes */
+	double parallel = 0.0;
+
+	for(r = 0; r < reps; ++r)
+	{
+		memcpy(units, input, sizeof(GFX_Unit) * num);
+
+		double start = _gfx_test_time();
+		if(!_gfx_bucket_radix_sort_parallel(bucket, units, scratch, num, &key))
+			_gfx_bucket_radix_sort(units, scratch, num, &key);
+
+		parallel += _gfx_test_time() - start;
+		gfx_arena_reset(&bucket->frame);
+	}
+
+	/* Both are stable, so the result is identical */
+	for(i = 0; i < num; ++i)
+		if(units[i].ref != sorted[i].ref) break;
+
+	GFX_TEST_CHECK(i == num);
+
+	printf(
+		"%8u units  partition+qsort %10.3f us  radix %10.3f us (%5.2fx)  parallel radix %10.3f us (%5.2fx)\n",
+		(unsigned int)num,
+		old * 1e6 / reps,
+		radix * 1e6 / reps,
+		old / radix,
+		parallel * 1e6 / reps,
+		old / parallel);
+
+	free(input);
+	free(units);
+	free(sorted);
+	free(scratch);
+}
+
+/******************************************************/
+int main(void)
+{
+	srand(1);
+
+	/* The parallel sort uses the pool and per-frame arena of a bucket */
+	unsigned long cores = _gfx_platform_get_num_cores();
+	unsigned int workers = cores ? (unsigned int)cores : 1;
+
+	GFXThreadPool* pool = gfx_thread_pool_create(NULL, NULL, 0);
+	GFXBucket* bucket = _gfx_bucket_create(GFX_BENCH_BITS, 0);
+
+	if(!pool || !bucket || gfx_thread_pool_expand(pool, workers, NULL) != workers)
+	{
+		fprintf(stderr, "Could not create a bucket with %u workers.\n", workers);
+		if(bucket) _gfx_bucket_free(bucket);
+		gfx_thread_pool_free(pool);
+
+		return 1;
+	}
+
+	gfx_bucket_set_thread_pool(bucket, pool);
+
+	printf(
+		"Bucket sort, %d state bits, %d programs, %d layouts, %u worker(s):\n",
+		GFX_BENCH_BITS,
+		GFX_BENCH_PROGRAMS,
+		GFX_BENCH_LAYOUTS,
+		workers);
+
+	_gfx_bench_size((GFX_Bucket*)bucket, 1000);
+	_gfx_bench_size((GFX_Bucket*)bucket, 10000);
+	_gfx_bench_size((GFX_Bucket*)bucket, 20000);
+	_gfx_bench_size((GFX_Bucket*)bucket, 100000);
+	_gfx_bench_size((GFX_Bucket*)bucket, 1000000);
+
+	_gfx_bucket_free(bucket);
+	gfx_thread_pool_free(pool);
+
+	return _gfx_test_result("bench_bucket_sort");
+}
@@ -0,0 +1,146 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "math_scalar.h"
+#include "test.h"
+
+#define GFX_TEST_KERNEL simd
+#define GFX_TEST_KERNEL_STORAGE static inline
+#include "math_kernels.h"
+#undef GFX_TEST_KERNEL
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/* Elements per batch, small enough to stay in cache */
+#define GFX_BENCH_BATCH  1024
+
+/* Total number of operations timed per kernel */
+#define GFX_BENCH_TOTAL  (1 << 24)
+
+
+/******************************************************/
+static gfx_mat4  _gfx_bench_ma[GFX_BENCH_BATCH];
+static gfx_mat4  _gfx_bench_mb[GFX_BENCH_BATCH];
+static gfx_mat4  _gfx_bench_mr[GFX_BENCH_BATCH];
+static gfx_vec4  _gfx_bench_va[GFX_BENCH_BATCH];
+static gfx_vec4  _gfx_bench_vr[GFX_BENCH_BATCH];
+static gfx_quat  _gfx_bench_qa[GFX_BENCH_BATCH];
+static gfx_quat  _gfx_bench_qb[GFX_BENCH_BATCH];
+static gfx_quat  _gfx_bench_qr[GFX_BENCH_BATCH];
+
+
+/** Batched kernel taking two inputs */
+typedef void (*GFX_BenchKernel) (size_t, float*, const float*, const float*);
+
+
+/******************************************************/
+static double _gfx_bench_time(
+
+		GFX_BenchKernel  kernel,
+		float*           dest,
+		const float*     a,
+		const float*     b)
+{
+	/* Warm up */
+	kernel(GFX_BENCH_BATCH, dest, a, b);
+
+	double start = _gfx_test_time();
+
+	size_t i;
+	for(i = 0; i < GFX_BENCH_TOTAL / GFX_BENCH_BATCH; ++i)
+		kernel(GFX_BENCH_BATCH, dest, a, b);
+
+	return (_gfx_test_time() - start) * 1e9 / GFX_BENCH_TOTAL;
+}
+
+/******************************************************/
+static void _gfx_bench_print(
+
+		const char*      name,
+		GFX_BenchKernel  scalar,
+		GFX_BenchKernel  simd,
+		float*           dest,
+		const float*     a,
+		const float*     b)
+{
+	double ts = _gfx_bench_time(scalar, dest, a, b);
+	double tv = _gfx_bench_time(simd, dest, a, b);
+
+	printf(
+		"  %-12s  scalar %6.2f ns  simd %6.2f ns  speedup %5.2fx\n",
+		name, ts, tv, tv > 0.0 ? ts / tv : 0.0);
+}
+
+/******************************************************/
+int main(void)
+{
+	srand(1);
+
+	size_t i, j;
+	for(i = 0; i < GFX_BENCH_BATCH; ++i)
+	{
+		for(j = 0; j < 16; ++j)
+		{
+			_gfx_bench_ma[i].data[j] = (float)rand() / RAND_MAX;
+			_gfx_bench_mb[i].data[j] = (float)rand() / RAND_MAX;
+		}
+
+		for(j = 0; j < 4; ++j)
+		{
+			_gfx_bench_va[i].data[j] = (float)rand() / RAND_MAX;
+			_gfx_bench_qa[i].data[j] = (float)rand() / RAND_MAX;
+			_gfx_bench_qb[i].data[j] = (float)rand() / RAND_MAX;
+		}
+	}
+
+#if defined(GFX_SIMD_AVX)
+	const char* set = "AVX";
+#elif defined(GFX_SIMD_SSE4_1)
+	const char* set = "SSE4.1";
+#elif defined(GFX_SIMD_SSE2)
+	const char* set = "SSE2";
+#else
+	const char* set = "none";
+#endif
+
+	printf("Math kernels, %s, time per operation:\n", set);
+
+	_gfx_bench_print(
+		"mat4 * mat4",
+		_gfx_scalar_mat4_mult,
+		_gfx_simd_mat4_mult,
+		_gfx_bench_mr->data,
+		_gfx_bench_ma->data,
+		_gfx_bench_mb->data);
+
+	_gfx_bench_print(
+		"mat4 * vec4",
+		_gfx_scalar_mat4_mult_vec,
+		_gfx_simd_mat4_mult_vec,
+		_gfx_bench_vr->data,
+		_gfx_bench_ma->data,
+		_gfx_bench_va->data);
+
+	_gfx_bench_print(
+		"quat * quat",
+		_gfx_scalar_quat_mult,
+		_gfx_simd_quat_mult,
+		_gfx_bench_qr->data,
+		_gfx_bench_qa->data,
+		_gfx_bench_qb->data);
+
+	return _gfx_test_result("bench_math");
+}
@@ -0,0 +1,186 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/containers/parallel.h"
+#include "groufix/core/threading.h"
+#include "test.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Number of elements processed by a single large parallel for */
+#define GFX_BENCH_FOR_SIZE    (1 << 22)
+
+/* Number of small parallel fors, each of which creates and frees a group */
+#define GFX_BENCH_FOR_CALLS   20000
+#define GFX_BENCH_FOR_SMALL   1024
+
+/* Number of elements sorted */
+#define GFX_BENCH_SORT_SIZE   (1 << 20)
+
+
+/******************************************************/
+static void _gfx_bench_for_func(
+
+		size_t  begin,
+		size_t  end,
+		void*   data)
+{
+	float* out = data;
+
+	for(; begin < end; ++begin)
+		out[begin] = sqrtf((float)begin) * sinf((float)begin);
+}
+
+/******************************************************/
+static int _gfx_bench_compare(
+
+		const void*  v1,
+		const void*  v2,
+		void*        data)
+{
+	unsigned int i1 = *(const unsigned int*)v1;
+	unsigned int i2 = *(const unsigned int*)v2;
+
+	return (i1 < i2) ? -1 : (i1 > i2) ? 1 : 0;
+}
+
+/******************************************************/
+/* Runs all workloads on a pool with a given number of workers */
+static void _gfx_bench_run(
+
+		unsigned int   workers,
+		float*         out,
+		unsigned int*  keys,
+		double         times[3])
+{
+	GFXThreadPool* pool = NULL;
+
+	if(workers)
+	{
+		pool = gfx_thread_pool_create(NULL, NULL, 0);
+		if(!pool || gfx_thread_pool_expand(pool, workers, NULL) != workers)
+		{
+			fprintf(stderr, "Could not create %u workers.\n", workers);
+			gfx_thread_pool_free(pool);
+
+			++_gfx_test_failures;
+			times[0] = times[1] = times[2] = 0.0;
+
+			return;
+		}
+	}
+
+	/* A single large range */
+	double start = _gfx_test_time();
+
+	gfx_parallel_for(pool, 0, GFX_BENCH_FOR_SIZE, 0, _gfx_bench_for_func, out);
+
+	times[0] = _gfx_test_time() - start;
+
+	size_t i;
+	for(i = 0; i < GFX_BENCH_FOR_SIZE; i += 4099)
+		GFX_TEST_CHECK(out[i] == sqrtf((float)i) * sinf((float)i));
+
+	/* Many small ranges, dominated by group overhead */
+	start = _gfx_test_time();
+
+	for(i = 0; i < GFX_BENCH_FOR_CALLS; ++i) gfx_parallel_for(
+		pool, 0, GFX_BENCH_FOR_SMALL, 64, _gfx_bench_for_func, out);
+
+	times[1] = _gfx_test_time() - start;
+
+	/* Sorting */
+	srand(1);
+	for(i = 0; i < GFX_BENCH_SORT_SIZE; ++i)
+		keys[i] = ((unsigned int)rand() << 16) ^ (unsigned int)rand();
+
+	start = _gfx_test_time();
+
+	GFX_TEST_CHECK(gfx_parallel_sort(
+		pool, keys, NULL, GFX_BENCH_SORT_SIZE, sizeof(unsigned int),
+		_gfx_bench_compare, NULL));
+
+	times[2] = _gfx_test_time() - start;
+
+	for(i = 1; i < GFX_BENCH_SORT_SIZE; ++i)
+		if(keys[i - 1] > keys[i]) break;
+
+	GFX_TEST_CHECK(i == GFX_BENCH_SORT_SIZE);
+
+	gfx_thread_pool_free(pool);
+}
+
+/******************************************************/
+int main(void)
+{
+	float* out = malloc(sizeof(float) * GFX_BENCH_FOR_SIZE);
+	unsigned int* keys = malloc(sizeof(unsigned int) * GFX_BENCH_SORT_SIZE);
+
+	if(!out || !keys)
+	{
+		fprintf(stderr, "Could not allocate benchmark data.\n");
+		free(out);
+		free(keys);
+
+		return 1;
+	}
+
+	/* Touch all pages up front, so the serial run is not penalized */
+	memset(out, 0, sizeof(float) * GFX_BENCH_FOR_SIZE);
+	memset(keys, 0, sizeof(unsigned int) * GFX_BENCH_SORT_SIZE);
+
+	/* Scale up to all cores, but at least up to 4 workers */
+	unsigned long cores = _gfx_platform_get_num_cores();
+	unsigned int maxWorkers = cores < 4 ? 4 : (unsigned int)cores;
+
+	printf(
+		"Parallel scaling, %lu core(s), times in ms "
+		"(for %d, %d x for %d, sort %d):\n",
+		cores,
+		GFX_BENCH_FOR_SIZE,
+		GFX_BENCH_FOR_CALLS,
+		GFX_BENCH_FOR_SMALL,
+		GFX_BENCH_SORT_SIZE);
+
+	/* Serial times as baseline, no pool at all */
+	double serial[3];
+	_gfx_bench_run(0, out, keys, serial);
+
+	printf(
+		"  serial       for %8.2f          small %8.2f          sort %8.2f\n",
+		serial[0] * 1e3, serial[1] * 1e3, serial[2] * 1e3);
+
+	unsigned int workers;
+	for(workers = 1; workers <= maxWorkers; workers <<= 1)
+	{
+		double times[3];
+		_gfx_bench_run(workers, out, keys, times);
+
+		printf(
+			"  %2u worker(s)  for %8.2f (%5.2fx)  small %8.2f (%5.2fx)  sort %8.2f (%5.2fx)\n",
+			workers,
+			times[0] * 1e3, times[0] > 0.0 ? serial[0] / times[0] : 0.0,
+			times[1] * 1e3, times[1] > 0.0 ? serial[1] / times[1] : 0.0,
+			times[2] * 1e3, times[2] > 0.0 ? serial[2] / times[2] : 0.0);
+	}
+
+	free(out);
+	free(keys);
+
+	return _gfx_test_result("bench_parallel");
+}
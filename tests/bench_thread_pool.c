@@ -0,0 +1,268 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/containers/thread_pool.h"
+#include "groufix/core/threading.h"
+#include "test.h"
+
+#include <sched.h>
+#include <stdio.h>
+
+
+/* The previous pool, with its public functions renamed */
+#define gfx_thread_pool_create   _gfx_old_pool_create
+#define gfx_thread_pool_free     _gfx_old_pool_free
+#define gfx_thread_pool_expand   _gfx_old_pool_expand
+#define gfx_thread_pool_shrink   _gfx_old_pool_shrink
+#define gfx_thread_pool_push     _gfx_old_pool_push
+#define gfx_thread_pool_suspend  _gfx_old_pool_suspend
+#define gfx_thread_pool_resume   _gfx_old_pool_resume
+#define gfx_thread_pool_flush    _gfx_old_pool_flush
+
+#include "reference/thread_pool.c"
+
+#undef gfx_thread_pool_create
+#undef gfx_thread_pool_free
+#undef gfx_thread_pool_expand
+#undef gfx_thread_pool_shrink
+#undef gfx_thread_pool_push
+#undef gfx_thread_pool_suspend
+#undef gfx_thread_pool_resume
+#undef gfx_thread_pool_flush
+
+
+/* Total number of tiny tasks pushed per run */
+#define GFX_BENCH_TASKS  2000000
+
+/* Number of tasks per root task when spawning from within workers */
+#define GFX_BENCH_SPAWN  64
+
+
+/******************************************************/
+/** Either pool implementation */
+typedef struct GFX_BenchPool
+{
+	const char*  name;
+
+	GFXThreadPool* (*create)(GFXThreadPoolInit, GFXThreadPoolTerminate, int);
+	void           (*free)(GFXThreadPool*);
+	unsigned int   (*expand)(GFXThreadPool*, unsigned int, void*);
+	int            (*push)(GFXThreadPool*, GFXThreadPoolTask, void*, signed char);
+
+} GFX_BenchPool;
+
+
+/** Producer thread data */
+typedef struct GFX_BenchProducer
+{
+	const GFX_BenchPool*  impl;
+	GFXThreadPool*        pool;
+	size_t                tasks;   /* Number of tasks to push */
+	int                   spawn;   /* Non-zero to push root tasks that push the rest */
+
+} GFX_BenchProducer;
+
+
+/** Number of executed tasks */
+static GFX_ATOMIC(size_t) _gfx_bench_done = 0;
+
+/** Number of tasks never executed because a push failed */
+static GFX_ATOMIC(size_t) _gfx_bench_failed = 0;
+
+
+/******************************************************/
+static void _gfx_bench_task(
+
+		void* data)
+{
+	GFX_ATOMIC_ADD(&_gfx_bench_done, 1);
+}
+
+/******************************************************/
+static void _gfx_bench_root(
+
+		void* data)
+{
+	GFX_BenchProducer* prod = data;
+	GFX_ATOMIC_ADD(&_gfx_bench_done, 1);
+
+	/* Pushed from within a worker, as fork-join style work would */
+	size_t t;
+	for(t = 1; t < GFX_BENCH_SPAWN; ++t)
+		if(!prod->impl->push(prod->pool, _gfx_bench_task, NULL, 0))
+			GFX_ATOMIC_ADD(&_gfx_bench_failed, 1);
+}
+
+/******************************************************/
+static unsigned int _gfx_bench_produce(
+
+		void* arg)
+{
+	GFX_BenchProducer* prod = arg;
+
+	if(prod->spawn)
+	{
+		size_t t;
+		for(t = 0; t < prod->tasks; t += GFX_BENCH_SPAWN)
+			if(!prod->impl->push(prod->pool, _gfx_bench_root, prod, 0))
+				GFX_ATOMIC_ADD(&_gfx_bench_failed, GFX_BENCH_SPAWN);
+	}
+	else
+	{
+		size_t t;
+		for(t = 0; t < prod->tasks; ++t)
+			if(!prod->impl->push(prod->pool, _gfx_bench_task, NULL, (signed char)(t & 0x7f)))
+				GFX_ATOMIC_ADD(&_gfx_bench_failed, 1);
+	}
+
+	return 0;
+}
+
+/******************************************************/
+static double _gfx_bench_run(
+
+		const GFX_BenchPool*  impl,
+		unsigned int          workers,
+		unsigned int          producers,
+		int                   spawn)
+{
+	GFXThreadPool* pool = impl->create(NULL, NULL, 0);
+	GFX_BenchProducer prods[64];
+	GFX_PlatformThread threads[64];
+
+	if(!pool || impl->expand(pool, workers, NULL) != workers)
+	{
+		fprintf(stderr, "%s: could not create %u workers.\n", impl->name, workers);
+		impl->free(pool);
+
+		++_gfx_test_failures;
+		return 0.0;
+	}
+
+	GFX_ATOMIC_STORE(&_gfx_bench_done, 0, GFX_ATOMIC_SEQ_CST);
+	GFX_ATOMIC_STORE(&_gfx_bench_failed, 0, GFX_ATOMIC_SEQ_CST);
+
+	double start = _gfx_test_time();
+
+	/* All producers push at once */
+	unsigned int p;
+	for(p = 0; p < producers; ++p)
+	{
+		prods[p].impl = impl;
+		prods[p].pool = pool;
+		prods[p].tasks = GFX_BENCH_TASKS / producers;
+		prods[p].spawn = spawn;
+
+		if(!_gfx_platform_thread_init(threads + p, _gfx_bench_produce, prods + p, 1))
+			break;
+	}
+
+	/* Wait for all tasks to be executed */
+	size_t expected = 0;
+	unsigned int q;
+
+	for(q = 0; q < p; ++q)
+	{
+		_gfx_platform_thread_join(threads[q], NULL);
+		expected += prods[q].tasks;
+	}
+
+	while(
+		GFX_ATOMIC_LOAD(&_gfx_bench_done, GFX_ATOMIC_SEQ_CST) +
+		GFX_ATOMIC_LOAD(&_gfx_bench_failed, GFX_ATOMIC_SEQ_CST) < expected)
+	{
+		sched_yield();
+	}
+
+	double time = _gfx_test_time() - start;
+
+	GFX_TEST_CHECK(p == producers);
+	GFX_TEST_CHECK(expected == (GFX_BENCH_TASKS / producers) * producers);
+	GFX_TEST_CHECK(!GFX_ATOMIC_LOAD(&_gfx_bench_failed, GFX_ATOMIC_SEQ_CST));
+
+	impl->free(pool);
+
+	return time;
+}
+
+/******************************************************/
+int main(void)
+{
+	const GFX_BenchPool impls[] =
+	{
+		{
+			"old",
+			_gfx_old_pool_create,
+			_gfx_old_pool_free,
+			_gfx_old_pool_expand,
+			_gfx_old_pool_push
+		},
+		{
+			"new",
+			gfx_thread_pool_create,
+			gfx_thread_pool_free,
+			gfx_thread_pool_expand,
+			gfx_thread_pool_push
+		}
+	};
+
+	/* Use all cores as workers, and at least scale up to 4 threads */
+	unsigned int cores = _gfx_platform_get_num_cores();
+	unsigned int workers = cores ? cores : 1;
+	unsigned int maxThreads = workers < 4 ? 4 : workers;
+
+	if(maxThreads > 64) maxThreads = 64;
+
+	printf(
+		"Thread pool throughput, %d empty tasks, %u core(s).\n"
+		"Pushed from outside the pool, %u workers:\n",
+		GFX_BENCH_TASKS,
+		cores,
+		workers);
+
+	unsigned int producers;
+	for(producers = 1; producers <= maxThreads; producers <<= 1)
+	{
+		double old = _gfx_bench_run(impls + 0, workers, producers, 0);
+		double new = _gfx_bench_run(impls + 1, workers, producers, 0);
+
+		printf(
+			"%3u producer(s)  old %8.2f Mtasks/s  new %8.2f Mtasks/s  speedup %5.2fx\n",
+			producers,
+			old > 0.0 ? GFX_BENCH_TASKS / old * 1e-6 : 0.0,
+			new > 0.0 ? GFX_BENCH_TASKS / new * 1e-6 : 0.0,
+			new > 0.0 ? old / new : 0.0);
+	}
+
+	/* Work stealing is meant for tasks that push tasks */
+	printf(
+		"Pushed from within workers, %d per root task, 1 producer:\n",
+		GFX_BENCH_SPAWN);
+
+	unsigned int w;
+	for(w = 1; w <= maxThreads; w <<= 1)
+	{
+		double old = _gfx_bench_run(impls + 0, w, 1, 1);
+		double new = _gfx_bench_run(impls + 1, w, 1, 1);
+
+		printf(
+			"%3u worker(s)    old %8.2f Mtasks/s  new %8.2f Mtasks/s  speedup %5.2fx\n",
+			w,
+			old > 0.0 ? GFX_BENCH_TASKS / old * 1e-6 : 0.0,
+			new > 0.0 ? GFX_BENCH_TASKS / new * 1e-6 : 0.0,
+			new > 0.0 ? old / new : 0.0);
+	}
+
+	return _gfx_test_result("bench_thread_pool");
+}
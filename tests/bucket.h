@@ -0,0 +1,390 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#ifndef GFX_TESTS_BUCKET_H
+#define GFX_TESTS_BUCKET_H
+
+#include "groufix/core/utils.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+
+/********************************************************
+ * Bucket harness
+ *
+ * The bucket is compiled into the test itself, all layouts, program maps,
+ * property maps and buffers it touches are stand-ins. The renderer is a
+ * zeroed context of which every call the bucket makes is recorded.
+ *******************************************************/
+
+/** Stand-in of a program map */
+typedef struct GFX_TestProgramMap
+{
+	GFXProgramMap  map;
+	GLuint         handle;
+	int            ready;  /* GFX_INT_MAP_* returned by _gfx_program_map_poll */
+
+} GFX_TestProgramMap;
+
+
+/** Stand-in of a vertex layout */
+typedef struct GFX_TestLayout
+{
+	GFXVertexLayout  layout;
+	GLuint           vao;
+	GFXVertexSource  source;  /* Only source at index 0 */
+	unsigned int     blocks;  /* Number of times the source is blocked */
+
+} GFX_TestLayout;
+
+
+/** Everything the bucket sent to the renderer */
+typedef struct GFX_TestCalls
+{
+	size_t  draws;          /* Direct draw calls */
+	size_t  indirectDraws;  /* Multi draw indirect calls */
+	size_t  indirectUnits;  /* Units drawn by multi draw indirect calls */
+	size_t  layoutBinds;
+	size_t  mapUses;
+	size_t  bufferBinds;    /* Raw BindBuffer calls, should all go through the binder */
+	size_t  indirectBinds;  /* Draw indirect buffer binds through the binder */
+	size_t  readyPolls;     /* Program map ready queries */
+
+} GFX_TestCalls;
+
+
+/** The recorded calls */
+static GFX_TestCalls _gfx_test_calls;
+
+/** The context all bucket calls are made to */
+static GFX_Context* _gfx_test_context = NULL;
+
+
+/********************************************************
+ * Stand-ins of everything the bucket uses
+ *******************************************************/
+
+GLuint _gfx_gl_program_map_get_handle(const GFXProgramMap* map);
+GLuint _gfx_gl_vertex_layout_get_handle(const GFXVertexLayout* layout);
+GLuint _gfx_gl_vertex_layout_get_index_buffer(const GFXVertexLayout* layout, size_t* offset);
+void _gfx_gl_vertex_layout_bind(GLuint vao, GFX_CONT_ARG);
+void _gfx_gl_indirect_buffer_bind(GLuint buffer, GFX_CONT_ARG);
+int _gfx_program_map_poll(GFXProgramMap* map);
+int _gfx_vertex_layout_block(GFXVertexLayout* layout, unsigned char index);
+void _gfx_vertex_layout_unblock(GFXVertexLayout* layout, unsigned char index);
+void _gfx_property_map_use(const GFXPropertyMap* map, unsigned int copy, unsigned int base, GFX_CONT_ARG);
+void _gfx_states_set(const GFXPipeState* state, GFX_CONT_ARG);
+void _gfx_states_set_patch_vertices(unsigned int vertices, GFX_CONT_ARG);
+
+GFXBucket* _gfx_bucket_create(unsigned char bits, GFXBucketFlags flags);
+void _gfx_bucket_free(GFXBucket* bucket);
+void _gfx_bucket_poll(GFXBucket* bucket);
+void _gfx_bucket_prepare(GFXBucket* bucket);
+void _gfx_bucket_process(GFXBucket* bucket, const GFXPipeState* state, GFX_CONT_ARG);
+
+
+/******************************************************/
+GFX_Context* _gfx_context_get_current(void)
+{
+	return _gfx_test_context;
+}
+
+/******************************************************/
+GLuint _gfx_gl_program_map_get_handle(
+
+		const GFXProgramMap* map)
+{
+	return ((const GFX_TestProgramMap*)map)->handle;
+}
+
+/******************************************************/
+int _gfx_program_map_poll(
+
+		GFXProgramMap* map)
+{
+	/* Polling queries the context, which workers do not have */
+	GFX_TEST_CHECK(_gfx_test_context);
+	++_gfx_test_calls.readyPolls;
+
+	return ((GFX_TestProgramMap*)map)->ready;
+}
+
+/******************************************************/
+GLuint _gfx_gl_vertex_layout_get_handle(
+
+		const GFXVertexLayout* layout)
+{
+	return ((const GFX_TestLayout*)layout)->vao;
+}
+
+/******************************************************/
+GLuint _gfx_gl_vertex_layout_get_index_buffer(
+
+		const GFXVertexLayout*  layout,
+		size_t*                 offset)
+{
+	*offset = 0;
+	return 1;
+}
+
+/******************************************************/
+int gfx_vertex_layout_get_source(
+
+		const GFXVertexLayout*  layout,
+		unsigned char           index,
+		GFXVertexSource*        src)
+{
+	if(index) return 0;
+
+	*src = ((const GFX_TestLayout*)layout)->source;
+	return 1;
+}
+
+/******************************************************/
+void _gfx_gl_vertex_layout_bind(
+
+		GLuint vao,
+		GFX_CONT_ARG)
+{
+	++_gfx_test_calls.layoutBinds;
+}
+
+/******************************************************/
+void _gfx_gl_indirect_buffer_bind(
+
+		GLuint buffer,
+		GFX_CONT_ARG)
+{
+	/* Same as the binder, to count actual binds */
+	if(GFX_REND_GET.indirect != buffer)
+	{
+		GFX_REND_GET.indirect = buffer;
+		++_gfx_test_calls.indirectBinds;
+	}
+}
+
+/******************************************************/
+int _gfx_vertex_layout_block(
+
+		GFXVertexLayout*  layout,
+		unsigned char     index)
+{
+	++((GFX_TestLayout*)layout)->blocks;
+	return 1;
+}
+
+/******************************************************/
+void _gfx_vertex_layout_unblock(
+
+		GFXVertexLayout*  layout,
+		unsigned char     index)
+{
+	--((GFX_TestLayout*)layout)->blocks;
+}
+
+/******************************************************/
+void _gfx_property_map_use(
+
+		const GFXPropertyMap*  map,
+		unsigned int           copy,
+		unsigned int           base,
+		GFX_CONT_ARG)
+{
+	++_gfx_test_calls.mapUses;
+}
+
+/******************************************************/
+void _gfx_states_set(
+
+		const GFXPipeState*  state,
+		GFX_CONT_ARG)
+{
+}
+
+/******************************************************/
+void _gfx_states_set_patch_vertices(
+
+		unsigned int  vertices,
+		GFX_CONT_ARG)
+{
+}
+
+/******************************************************/
+unsigned char _gfx_sizeof_data_type(
+
+		GFXDataType type)
+{
+	switch(type)
+	{
+		case GFX_UNSIGNED_BYTE  : return 1;
+		case GFX_UNSIGNED_SHORT : return 2;
+		default                 : return 4;
+	}
+}
+
+/******************************************************/
+GFXBuffer* gfx_buffer_create(
+
+		GFXBufferUsage  usage,
+		size_t          size,
+		const void*     data,
+		unsigned char   count)
+{
+	GFXBuffer* buffer = calloc(1, sizeof(GFXBuffer));
+	if(buffer)
+	{
+		buffer->usage = usage;
+		buffer->size = size;
+		buffer->count = count;
+	}
+
+	return buffer;
+}
+
+/******************************************************/
+void gfx_buffer_free(
+
+		GFXBuffer* buffer)
+{
+	free(buffer);
+}
+
+/******************************************************/
+void gfx_buffer_orphan(
+
+		GFXBuffer* buffer)
+{
+}
+
+/******************************************************/
+size_t gfx_buffer_write(
+
+		GFXBuffer*   buffer,
+		size_t       size,
+		const void*  data,
+		size_t       offset)
+{
+	return offset + size > buffer->size ? 0 : size;
+}
+
+/******************************************************/
+unsigned char _gfx_buffer_get_current(
+
+		const GFXBuffer* buffer)
+{
+	return 0;
+}
+
+/******************************************************/
+GFX_BufferHandle _gfx_buffer_get_handle(
+
+		const GFXBuffer*  buffer,
+		unsigned char     index)
+{
+	return 1;
+}
+
+
+/********************************************************
+ * Recording renderer
+ *******************************************************/
+
+static void APIENTRY _gfx_test_draw_arrays(
+
+		GLenum   mode,
+		GLint    first,
+		GLsizei  count)
+{
+	++_gfx_test_calls.draws;
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_draw_elements(
+
+		GLenum         mode,
+		GLsizei        count,
+		GLenum         type,
+		const GLvoid*  indices)
+{
+	++_gfx_test_calls.draws;
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_multi_draw_arrays_indirect(
+
+		GLenum         mode,
+		const GLvoid*  indirect,
+		GLsizei        drawcount,
+		GLsizei        stride)
+{
+	++_gfx_test_calls.indirectDraws;
+	_gfx_test_calls.indirectUnits += drawcount;
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_multi_draw_elements_indirect(
+
+		GLenum         mode,
+		GLenum         type,
+		const GLvoid*  indirect,
+		GLsizei        drawcount,
+		GLsizei        stride)
+{
+	++_gfx_test_calls.indirectDraws;
+	_gfx_test_calls.indirectUnits += drawcount;
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_bind_buffer(
+
+		GLenum  target,
+		GLuint  buffer)
+{
+	++_gfx_test_calls.bufferBinds;
+}
+
+/******************************************************/
+static inline void _gfx_test_context_init(
+
+		int multiDrawIndirect)
+{
+	if(!_gfx_test_context)
+		_gfx_test_context = calloc(1, sizeof(GFX_Context));
+
+	GFX_Renderer* rend = &_gfx_test_context->renderer;
+
+	rend->intExt[GFX_INT_EXT_MULTI_DRAW_INDIRECT] = multiDrawIndirect ? 1 : 0;
+
+	rend->DrawArrays                = _gfx_test_draw_arrays;
+	rend->DrawElements              = _gfx_test_draw_elements;
+	rend->MultiDrawArraysIndirect   = _gfx_test_multi_draw_arrays_indirect;
+	rend->MultiDrawElementsIndirect = _gfx_test_multi_draw_elements_indirect;
+	rend->BindBuffer                = _gfx_test_bind_buffer;
+}
+
+/******************************************************/
+static inline void _gfx_test_context_clear(void)
+{
+	free(_gfx_test_context);
+	_gfx_test_context = NULL;
+}
+
+
+/******************************************************/
+/* The bucket itself, including all its internal functions */
+#include "groufix/core/bucket.c"
+
+
+#endif // GFX_TESTS_BUCKET_H
@@ -0,0 +1,337 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#ifndef GFX_TESTS_GL_H
+#define GFX_TESTS_GL_H
+
+#include "groufix/core/utils.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Maximum number of buffers and fences ever created */
+#define GFX_TEST_BUFFERS  16
+#define GFX_TEST_FENCES   256
+
+
+/********************************************************
+ * Fake GL harness
+ *
+ * The renderer of a zeroed context is filled with a fake GL. Buffers are
+ * client memory and commands complete immediately, except for fences,
+ * which only signal once the test says the GPU is done.
+ *******************************************************/
+
+/** A buffer object */
+typedef struct GFX_TestBuffer
+{
+	unsigned char*  data;
+	size_t          size;
+	int             live;
+	int             mapped;
+
+} GFX_TestBuffer;
+
+
+/** Everything the fake GL keeps track of */
+typedef struct GFX_TestGL
+{
+	GFX_TestBuffer  buffers[GFX_TEST_BUFFERS + 1]; /* Indexed by handle */
+	GLuint          created;                       /* Number of buffers created */
+	size_t          allocs;                        /* Storage (re)allocations */
+	int             mapFails;                      /* Non-zero if mapping fails */
+
+	int             fences[GFX_TEST_FENCES];       /* Non-zero if live */
+	size_t          fencesCreated;
+	size_t          fencesDeleted;
+
+	int             done;                          /* Non-zero if fences are signaled */
+	size_t          waits;                         /* Blocking waits on a fence */
+
+} GFX_TestGL;
+
+
+/** The fake GL and the context using it */
+static GFX_TestGL _gfx_test_gl;
+static GFX_Context* _gfx_test_context = NULL;
+
+
+/******************************************************/
+static GFX_TestBuffer* _gfx_test_get_buffer(
+
+		GLuint handle)
+{
+	GFX_TEST_CHECK(handle && handle <= _gfx_test_gl.created);
+	GFX_TEST_CHECK(_gfx_test_gl.buffers[handle].live);
+
+	return _gfx_test_gl.buffers + handle;
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_create_buffers(
+
+		GLsizei  n,
+		GLuint*  buffers)
+{
+	while(n--)
+	{
+		GFX_TEST_CHECK(_gfx_test_gl.created < GFX_TEST_BUFFERS);
+
+		GLuint handle = ++_gfx_test_gl.created;
+		_gfx_test_gl.buffers[handle].live = 1;
+
+		*(buffers++) = handle;
+	}
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_delete_buffers(
+
+		GLsizei        n,
+		const GLuint*  buffers)
+{
+	while(n--)
+	{
+		GFX_TestBuffer* buff = _gfx_test_get_buffer(*(buffers++));
+
+		free(buff->data);
+		buff->data = NULL;
+		buff->live = 0;
+		buff->mapped = 0;
+	}
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_named_buffer_data(
+
+		GLuint         buffer,
+		GLsizeiptr     size,
+		const GLvoid*  data,
+		GLenum         usage)
+{
+	GFX_TestBuffer* buff = _gfx_test_get_buffer(buffer);
+	GFX_TEST_CHECK(!buff->mapped);
+
+	free(buff->data);
+	buff->data = calloc(size, 1);
+	buff->size = size;
+
+	++_gfx_test_gl.allocs;
+
+	if(data) memcpy(buff->data, data, size);
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_named_buffer_storage(
+
+		GLuint         buffer,
+		GLsizeiptr     size,
+		const GLvoid*  data,
+		GLbitfield     flags)
+{
+	_gfx_test_named_buffer_data(buffer, size, data, 0);
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_named_buffer_sub_data(
+
+		GLuint         buffer,
+		GLintptr       offset,
+		GLsizeiptr     size,
+		const GLvoid*  data)
+{
+	GFX_TestBuffer* buff = _gfx_test_get_buffer(buffer);
+	GFX_TEST_CHECK((size_t)(offset + size) <= buff->size);
+
+	memcpy(buff->data + offset, data, size);
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_get_named_buffer_sub_data(
+
+		GLuint      buffer,
+		GLintptr    offset,
+		GLsizeiptr  size,
+		GLvoid*     data)
+{
+	GFX_TestBuffer* buff = _gfx_test_get_buffer(buffer);
+	GFX_TEST_CHECK((size_t)(offset + size) <= buff->size);
+
+	memcpy(data, buff->data + offset, size);
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_copy_named_buffer_sub_data(
+
+		GLuint      readBuffer,
+		GLuint      writeBuffer,
+		GLintptr    readOffset,
+		GLintptr    writeOffset,
+		GLsizeiptr  size)
+{
+	GFX_TestBuffer* src = _gfx_test_get_buffer(readBuffer);
+	GFX_TestBuffer* dest = _gfx_test_get_buffer(writeBuffer);
+
+	GFX_TEST_CHECK((size_t)(readOffset + size) <= src->size);
+	GFX_TEST_CHECK((size_t)(writeOffset + size) <= dest->size);
+
+	memmove(dest->data + writeOffset, src->data + readOffset, size);
+}
+
+/******************************************************/
+static void* APIENTRY _gfx_test_map_named_buffer_range(
+
+		GLuint      buffer,
+		GLintptr    offset,
+		GLsizeiptr  length,
+		GLbitfield  access)
+{
+	GFX_TestBuffer* buff = _gfx_test_get_buffer(buffer);
+	GFX_TEST_CHECK((size_t)(offset + length) <= buff->size);
+
+	if(_gfx_test_gl.mapFails) return NULL;
+
+	buff->mapped = 1;
+	return buff->data + offset;
+}
+
+/******************************************************/
+static GLboolean APIENTRY _gfx_test_unmap_named_buffer(
+
+		GLuint buffer)
+{
+	GFX_TestBuffer* buff = _gfx_test_get_buffer(buffer);
+	GFX_TEST_CHECK(buff->mapped);
+
+	buff->mapped = 0;
+	return GL_TRUE;
+}
+
+/******************************************************/
+static GLsync APIENTRY _gfx_test_fence_sync(
+
+		GLenum      condition,
+		GLbitfield  flags)
+{
+	GFX_TEST_CHECK(_gfx_test_gl.fencesCreated < GFX_TEST_FENCES);
+
+	int* fence = _gfx_test_gl.fences + (_gfx_test_gl.fencesCreated++);
+	*fence = 1;
+
+	return (GLsync)fence;
+}
+
+/******************************************************/
+static void APIENTRY _gfx_test_delete_sync(
+
+		GLsync sync)
+{
+	int* fence = (int*)sync;
+	GFX_TEST_CHECK(*fence);
+
+	*fence = 0;
+	++_gfx_test_gl.fencesDeleted;
+}
+
+/******************************************************/
+static GLenum APIENTRY _gfx_test_client_wait_sync(
+
+		GLsync      sync,
+		GLbitfield  flags,
+		GLuint64    timeout)
+{
+	GFX_TEST_CHECK(*(int*)sync);
+
+	/* Waiting for real lets the GPU finish */
+	if(!timeout && !_gfx_test_gl.done)
+		return GL_TIMEOUT_EXPIRED;
+
+	if(timeout) ++_gfx_test_gl.waits;
+
+	return GL_CONDITION_SATISFIED;
+}
+
+
+/******************************************************/
+GFX_Context* _gfx_context_get_current(void)
+{
+	return _gfx_test_context;
+}
+
+/******************************************************/
+static inline void _gfx_test_context_init(
+
+		int bufferStorage)
+{
+	/* Free what is left of the previous run */
+	GLuint i;
+	for(i = 1; i <= _gfx_test_gl.created; ++i)
+		free(_gfx_test_gl.buffers[i].data);
+
+	memset(&_gfx_test_gl, 0, sizeof(GFX_TestGL));
+
+	if(!_gfx_test_context)
+		_gfx_test_context = calloc(1, sizeof(GFX_Context));
+
+	GFX_Renderer* rend = &_gfx_test_context->renderer;
+
+	rend->intExt[GFX_INT_EXT_BUFFER_STORAGE] = bufferStorage ? 1 : 0;
+
+	rend->CreateBuffers          = _gfx_test_create_buffers;
+	rend->DeleteBuffers          = _gfx_test_delete_buffers;
+	rend->NamedBufferData        = _gfx_test_named_buffer_data;
+	rend->NamedBufferStorage     = _gfx_test_named_buffer_storage;
+	rend->NamedBufferSubData     = _gfx_test_named_buffer_sub_data;
+	rend->GetNamedBufferSubData  = _gfx_test_get_named_buffer_sub_data;
+	rend->CopyNamedBufferSubData = _gfx_test_copy_named_buffer_sub_data;
+	rend->MapNamedBufferRange    = _gfx_test_map_named_buffer_range;
+	rend->UnmapNamedBuffer       = _gfx_test_unmap_named_buffer;
+	rend->FenceSync              = _gfx_test_fence_sync;
+	rend->DeleteSync             = _gfx_test_delete_sync;
+	rend->ClientWaitSync         = _gfx_test_client_wait_sync;
+}
+
+/******************************************************/
+/* Number of buffers that are still alive */
+static inline size_t _gfx_test_live_buffers(void)
+{
+	size_t live = 0;
+	GLuint i;
+
+	for(i = 1; i <= _gfx_test_gl.created; ++i)
+		live += _gfx_test_gl.buffers[i].live;
+
+	return live;
+}
+
+/******************************************************/
+/* Number of fences that are still alive */
+static inline size_t _gfx_test_live_fences(void)
+{
+	return _gfx_test_gl.fencesCreated - _gfx_test_gl.fencesDeleted;
+}
+
+/******************************************************/
+static inline void _gfx_test_context_clear(void)
+{
+	_gfx_test_context_init(0);
+
+	free(_gfx_test_context);
+	_gfx_test_context = NULL;
+}
+
+
+#endif // GFX_TESTS_GL_H
@@ -0,0 +1,172 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#ifndef GFX_TESTS_MATH_KERNELS_H
+#define GFX_TESTS_MATH_KERNELS_H
+
+#include "groufix/math.h"
+
+#include <stddef.h>
+
+#define GFX_TEST_KERNEL_FUNC(prefix,postfix) GFX_NAME(GFX_CAT(_gfx_, prefix), postfix)
+
+#endif // GFX_TESTS_MATH_KERNELS_H
+
+
+/********************************************************
+ * Batched math kernels
+ *
+ * Defines GFX_TEST_KERNEL_FUNC(GFX_TEST_KERNEL, *) functions that apply a
+ * template function to num consecutive elements. This header is included by
+ * math_scalar.c with intrinsics disabled and by the tests with intrinsics
+ * enabled, so both code paths can be compared in a single binary.
+ * All arrays must be aligned to 16 bytes.
+ *******************************************************/
+
+#if !defined(GFX_TEST_KERNEL)
+	#error "Missing define for GFX_TEST_KERNEL"
+#else
+
+#if !defined(GFX_TEST_KERNEL_STORAGE)
+	#define GFX_TEST_KERNEL_STORAGE
+#endif
+
+#define GFX_TEST_KFUNC(postfix) GFX_TEST_KERNEL_FUNC(GFX_TEST_KERNEL, postfix)
+
+
+/******************************************************/
+GFX_TEST_KERNEL_STORAGE void GFX_TEST_KFUNC(mat4_mult)(
+
+		size_t        num,
+		float*        dest,
+		const float*  a,
+		const float*  b)
+{
+	for(; num--; dest += 16, a += 16, b += 16) gfx_mat4_mult(
+		(gfx_mat4*)dest, (const gfx_mat4*)a, (const gfx_mat4*)b);
+}
+
+/******************************************************/
+GFX_TEST_KERNEL_STORAGE void GFX_TEST_KFUNC(mat4_mult_vec)(
+
+		size_t        num,
+		float*        dest,
+		const float*  a,
+		const float*  b)
+{
+	for(; num--; dest += 4, a += 16, b += 4) gfx_mat4_mult_vec(
+		(gfx_vec4*)dest, (const gfx_mat4*)a, (const gfx_vec4*)b);
+}
+
+/******************************************************/
+GFX_TEST_KERNEL_STORAGE void GFX_TEST_KFUNC(mat4_transpose)(
+
+		size_t        num,
+		float*        dest,
+		const float*  a)
+{
+	for(; num--; dest += 16, a += 16) gfx_mat4_transpose(
+		(gfx_mat4*)dest, (const gfx_mat4*)a);
+}
+
+/******************************************************/
+GFX_TEST_KERNEL_STORAGE size_t GFX_TEST_KFUNC(mat4_inverse)(
+
+		size_t        num,
+		float*        dest,
+		const float*  a)
+{
+	size_t inverted = 0;
+
+	for(; num--; dest += 16, a += 16) inverted += gfx_mat4_inverse(
+		(gfx_mat4*)dest, (const gfx_mat4*)a);
+
+	return inverted;
+}
+
+/******************************************************/
+GFX_TEST_KERNEL_STORAGE void GFX_TEST_KFUNC(vec4_normalize)(
+
+		size_t        num,
+		float*        dest,
+		const float*  a)
+{
+	for(; num--; dest += 4, a += 4) gfx_vec4_normalize(
+		(gfx_vec4*)dest, (const gfx_vec4*)a);
+}
+
+/******************************************************/
+GFX_TEST_KERNEL_STORAGE void GFX_TEST_KFUNC(vec4_dot)(
+
+		size_t        num,
+		float*        dest,
+		const float*  a,
+		const float*  b)
+{
+	for(; num--; dest += 1, a += 4, b += 4) *dest = gfx_vec4_dot(
+		(const gfx_vec4*)a, (const gfx_vec4*)b);
+}
+
+/******************************************************/
+GFX_TEST_KERNEL_STORAGE void GFX_TEST_KFUNC(quat_mult)(
+
+		size_t        num,
+		float*        dest,
+		const float*  a,
+		const float*  b)
+{
+	for(; num--; dest += 4, a += 4, b += 4) gfx_quat_mult(
+		(gfx_quat*)dest, (const gfx_quat*)a, (const gfx_quat*)b);
+}
+
+/******************************************************/
+GFX_TEST_KERNEL_STORAGE void GFX_TEST_KFUNC(quat_normalize)(
+
+		size_t        num,
+		float*        dest,
+		const float*  a)
+{
+	for(; num--; dest += 4, a += 4) gfx_quat_normalize(
+		(gfx_quat*)dest, (const gfx_quat*)a);
+}
+
+/******************************************************/
+GFX_TEST_KERNEL_STORAGE void GFX_TEST_KFUNC(dmat4_mult)(
+
+		size_t         num,
+		double*        dest,
+		const double*  a,
+		const double*  b)
+{
+	for(; num--; dest += 16, a += 16, b += 16) gfx_dmat4_mult(
+		(gfx_dmat4*)dest, (const gfx_dmat4*)a, (const gfx_dmat4*)b);
+}
+
+/******************************************************/
+GFX_TEST_KERNEL_STORAGE void GFX_TEST_KFUNC(dmat4_mult_vec)(
+
+		size_t         num,
+		double*        dest,
+		const double*  a,
+		const double*  b)
+{
+	for(; num--; dest += 4, a += 16, b += 4) gfx_dmat4_mult_vec(
+		(gfx_dvec4*)dest, (const gfx_dmat4*)a, (const gfx_dvec4*)b);
+}
+
+
+#undef GFX_TEST_KFUNC
+#undef GFX_TEST_KERNEL_STORAGE
+
+#endif
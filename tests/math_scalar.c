@@ -0,0 +1,29 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+/* Compile the math templates without any intrinsics */
+#undef GFX_SSE_YES
+#ifndef GFX_SSE_NO
+	#define GFX_SSE_NO
+#endif
+
+#include "math_scalar.h"
+
+#define GFX_TEST_KERNEL scalar
+#include "math_kernels.h"
+#undef GFX_TEST_KERNEL
+
+#if defined(GFX_SIMD_SSE2) || defined(GFX_SIMD_AVX)
+	#error "Scalar math kernels compiled with intrinsics"
+#endif
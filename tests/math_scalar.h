@@ -0,0 +1,41 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#ifndef GFX_TESTS_MATH_SCALAR_H
+#define GFX_TESTS_MATH_SCALAR_H
+
+#include <stddef.h>
+
+
+/********************************************************
+ * Scalar reference kernels
+ *
+ * The kernels of math_kernels.h as compiled by math_scalar.c, without any
+ * intrinsics. Elements are passed as plain arrays so both sides agree on
+ * the layout, regardless of the alignment of the math structures.
+ *******************************************************/
+
+void _gfx_scalar_mat4_mult(size_t num, float* dest, const float* a, const float* b);
+void _gfx_scalar_mat4_mult_vec(size_t num, float* dest, const float* a, const float* b);
+void _gfx_scalar_mat4_transpose(size_t num, float* dest, const float* a);
+size_t _gfx_scalar_mat4_inverse(size_t num, float* dest, const float* a);
+void _gfx_scalar_vec4_normalize(size_t num, float* dest, const float* a);
+void _gfx_scalar_vec4_dot(size_t num, float* dest, const float* a, const float* b);
+void _gfx_scalar_quat_mult(size_t num, float* dest, const float* a, const float* b);
+void _gfx_scalar_quat_normalize(size_t num, float* dest, const float* a);
+void _gfx_scalar_dmat4_mult(size_t num, double* dest, const double* a, const double* b);
+void _gfx_scalar_dmat4_mult_vec(size_t num, double* dest, const double* a, const double* b);
+
+
+#endif // GFX_TESTS_MATH_SCALAR_H
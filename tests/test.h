@@ -0,0 +1,118 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#ifndef GFX_TESTS_TEST_H
+#define GFX_TESTS_TEST_H
+
+#include "groufix/core/errors.h"
+#include "groufix/core/platform.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+
+/********************************************************
+ * Shared test & benchmark harness
+ *
+ * Tests and benchmarks are single translation units compiled along with
+ * the sources they exercise, no context or window is ever created.
+ *******************************************************/
+
+/** Number of failed checks so far */
+static unsigned int _gfx_test_failures = 0;
+
+/** Number of errors pushed so far */
+static unsigned int _gfx_test_errors = 0;
+
+
+/**
+ * Checks a condition, reports and counts it if it does not hold.
+ *
+ */
+#define GFX_TEST_CHECK(cond) \
+	do { \
+		if(!(cond)) \
+		{ \
+			fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+			++_gfx_test_failures; \
+		} \
+	} while(0)
+
+/**
+ * Returns the exit code of a test, reporting the number of failed checks.
+ *
+ */
+static inline int _gfx_test_result(
+
+		const char* name)
+{
+	if(_gfx_test_failures)
+		fprintf(stderr, "%s: %u check(s) failed.\n", name, _gfx_test_failures);
+	else
+		printf("%s: passed.\n", name);
+
+	return _gfx_test_failures ? 1 : 0;
+}
+
+/**
+ * Returns the time in seconds since some unspecified starting point.
+ *
+ */
+static inline double _gfx_test_time(void)
+{
+	static int init = 0;
+	if(!init) _gfx_platform_init_timer(), init = 1;
+
+	return
+		(double)_gfx_platform_get_time() *
+		_gfx_platform_get_time_resolution();
+}
+
+
+/******************************************************/
+/* Errors are printed as they are raised, the error queue is not linked */
+void gfx_errors_push(
+
+		GFXErrorCode  code,
+		const char*   description,
+		...)
+{
+	va_list args;
+	va_start(args, description);
+
+	++_gfx_test_errors;
+	fprintf(stderr, "[GFX Error 0x%x]: ", (unsigned int)code);
+	if(description) vfprintf(stderr, description, args);
+	fputc('\n', stderr);
+
+	va_end(args);
+}
+
+/******************************************************/
+void gfx_errors_output(
+
+		const char* description,
+		...)
+{
+	va_list args;
+	va_start(args, description);
+
+	vfprintf(stderr, description, args);
+	fputc('\n', stderr);
+
+	va_end(args);
+}
+
+
+#endif // GFX_TESTS_TEST_H
@@ -0,0 +1,315 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/containers/allocator.h"
+#include "groufix/containers/deque.h"
+#include "groufix/containers/vector.h"
+#include "test.h"
+
+#include <stdint.h>
+#include <string.h>
+
+
+/* Number of elements pushed into each container */
+#define GFX_TEST_SIZE    1000
+
+/* Number of reallocations to grow to GFX_TEST_SIZE elements */
+/* Capacities are powers of two, starting at a single element */
+#define GFX_TEST_GROWTH  11
+
+/* Number of frames of the steady state tests */
+#define GFX_TEST_FRAMES  10
+
+/* Sizes of the arena and pool */
+#define GFX_TEST_ARENA   256
+#define GFX_TEST_BLOCK   32
+#define GFX_TEST_CHUNK   4
+
+
+/******************************************************/
+static void* _gfx_test_alloc(
+
+		GFXAllocator*  alloc,
+		size_t         size)
+{
+	void* ptr = gfx_allocator_realloc(alloc, NULL, 0, size);
+
+	GFX_TEST_CHECK(ptr);
+	GFX_TEST_CHECK(((uintptr_t)ptr & 15) == 0);
+
+	return ptr;
+}
+
+/******************************************************/
+/* Pushes values and checks that all of them survived */
+static void _gfx_test_fill(
+
+		GFXVector*  vector,
+		size_t      num,
+		uint32_t    value)
+{
+	size_t i;
+	for(i = 0; i < num; ++i)
+	{
+		uint32_t v = value + i;
+		GFX_TEST_CHECK(gfx_vector_insert(vector, &v, vector->end) != vector->end);
+	}
+
+	size_t fails = gfx_vector_get_size(vector) != num;
+	for(i = 0; !fails && i < num; ++i)
+		fails += *(uint32_t*)gfx_vector_at(vector, i) != value + i;
+
+	GFX_TEST_CHECK(fails == 0);
+}
+
+/******************************************************/
+/* Only the newest allocation is resized in place, a reset reuses all blocks */
+static void _gfx_test_arena(void)
+{
+	GFXArena arena;
+	gfx_arena_init(&arena, GFX_TEST_ARENA);
+
+	GFXAllocator* alloc = &arena.allocator;
+
+	/* Two allocations fit in a block, the third takes a new one */
+	char* a = _gfx_test_alloc(alloc, 100);
+	char* b = _gfx_test_alloc(alloc, 100);
+	GFX_TEST_CHECK(b >= a + 100 && alloc->heapAllocs == 1);
+
+	char* c = _gfx_test_alloc(alloc, 100);
+	GFX_TEST_CHECK(alloc->heapAllocs == 2 && alloc->allocs == 3);
+
+	/* The newest grows in place, others are moved */
+	memset(c, 'c', 100);
+	GFX_TEST_CHECK(gfx_allocator_realloc(alloc, c, 100, 200) == c);
+
+	memset(a, 'a', 100);
+	char* d = gfx_allocator_realloc(alloc, a, 100, 120);
+	GFX_TEST_CHECK(d && d != a && d[0] == 'a' && d[99] == 'a');
+
+	/* Freeing the newest gives its memory back */
+	GFX_TEST_CHECK(!gfx_allocator_realloc(alloc, d, 120, 0));
+	GFX_TEST_CHECK(_gfx_test_alloc(alloc, 120) == d);
+
+	/* A reset merges all blocks, so it all fits from now on */
+	size_t heap = alloc->heapAllocs;
+	gfx_arena_reset(&arena);
+	GFX_TEST_CHECK(alloc->heapAllocs == heap + 1);
+
+	char* first = _gfx_test_alloc(alloc, 100);
+	_gfx_test_alloc(alloc, 100);
+	_gfx_test_alloc(alloc, 200);
+	_gfx_test_alloc(alloc, 120);
+	GFX_TEST_CHECK(alloc->heapAllocs == heap + 1);
+
+	gfx_arena_reset(&arena);
+	GFX_TEST_CHECK(_gfx_test_alloc(alloc, 100) == first);
+	GFX_TEST_CHECK(alloc->heapAllocs == heap + 1);
+
+	/* Per frame vectors stop touching the heap after the first frame */
+	/* Two of them, so their growth cannot always happen in place */
+	gfx_arena_reset(&arena);
+
+	GFXVector vecs[2];
+	gfx_vector_init_with_allocator(vecs + 0, sizeof(uint32_t), alloc);
+	gfx_vector_init_with_allocator(vecs + 1, sizeof(uint32_t), alloc);
+
+	unsigned int f;
+	for(f = 0; f < GFX_TEST_FRAMES; ++f)
+	{
+		size_t allocs = alloc->allocs;
+		heap = alloc->heapAllocs;
+
+		_gfx_test_fill(vecs + 0, GFX_TEST_SIZE, f);
+		_gfx_test_fill(vecs + 1, GFX_TEST_SIZE >> 1, f);
+
+		GFX_TEST_CHECK(alloc->allocs > allocs);
+		GFX_TEST_CHECK(f ? alloc->heapAllocs == heap : alloc->heapAllocs > heap);
+
+		gfx_vector_clear(vecs + 0);
+		gfx_vector_clear(vecs + 1);
+		gfx_arena_reset(&arena);
+	}
+
+	gfx_arena_clear(&arena);
+	GFX_TEST_CHECK(!arena.blocks && !arena.last);
+}
+
+/******************************************************/
+/* Blocks are served from chunks, freed blocks are handed out again first */
+static void _gfx_test_pool(void)
+{
+	GFXPool pool;
+	gfx_pool_init(&pool, GFX_TEST_BLOCK, GFX_TEST_CHUNK);
+
+	GFXAllocator* alloc = &pool.allocator;
+
+	/* One chunk per chunkSize blocks */
+	void* blocks[GFX_TEST_CHUNK * 2];
+	size_t i, j;
+
+	for(i = 0; i < GFX_TEST_CHUNK * 2; ++i)
+	{
+		blocks[i] = _gfx_test_alloc(alloc, 1 + i % GFX_TEST_BLOCK);
+		for(j = 0; j < i; ++j) GFX_TEST_CHECK(blocks[i] != blocks[j]);
+	}
+
+	GFX_TEST_CHECK(alloc->heapAllocs == 2 && alloc->allocs == GFX_TEST_CHUNK * 2);
+
+	/* Freed blocks are reused last in, first out */
+	gfx_allocator_realloc(alloc, blocks[1], GFX_TEST_BLOCK, 0);
+	gfx_allocator_realloc(alloc, blocks[5], GFX_TEST_BLOCK, 0);
+
+	GFX_TEST_CHECK(_gfx_test_alloc(alloc, GFX_TEST_BLOCK) == blocks[5]);
+	GFX_TEST_CHECK(_gfx_test_alloc(alloc, 1) == blocks[1]);
+
+	/* Resizing within a block does not move */
+	GFX_TEST_CHECK(gfx_allocator_realloc(alloc, blocks[1], 1, GFX_TEST_BLOCK) == blocks[1]);
+
+	/* Freeing and allocating everything again never touches the heap */
+	for(i = 0; i < GFX_TEST_CHUNK * 2; ++i)
+		gfx_allocator_realloc(alloc, blocks[i], GFX_TEST_BLOCK, 0);
+
+	for(i = 0; i < GFX_TEST_CHUNK * 2; ++i)
+	{
+		void* ptr = _gfx_test_alloc(alloc, GFX_TEST_BLOCK);
+		for(j = 0; j < GFX_TEST_CHUNK * 2 && blocks[j] != ptr; ++j);
+
+		GFX_TEST_CHECK(j < GFX_TEST_CHUNK * 2);
+	}
+
+	GFX_TEST_CHECK(alloc->heapAllocs == 2);
+
+	/* Growing out of a block moves to the heap and frees the block */
+	char* big = _gfx_test_alloc(alloc, 10);
+	memset(big, 'b', 10);
+
+	big = gfx_allocator_realloc(alloc, big, 10, GFX_TEST_BLOCK * 4);
+	GFX_TEST_CHECK(big && big[0] == 'b' && big[9] == 'b');
+	GFX_TEST_CHECK(alloc->heapAllocs == 4);
+
+	void* reused = _gfx_test_alloc(alloc, 1);
+	GFX_TEST_CHECK(alloc->heapAllocs == 4);
+
+	/* And shrinking back moves it into a block */
+	char* small = gfx_allocator_realloc(alloc, big, GFX_TEST_BLOCK * 4, 10);
+	GFX_TEST_CHECK(small && small[0] == 'b' && small[9] == 'b');
+	GFX_TEST_CHECK(alloc->heapAllocs == 4);
+
+	gfx_allocator_realloc(alloc, small, 10, 0);
+	gfx_allocator_realloc(alloc, reused, 1, 0);
+	gfx_pool_clear(&pool);
+
+	GFX_TEST_CHECK(!pool.chunks && !pool.free);
+
+	/* Blocks always fit a link to the next free block */
+	gfx_pool_init(&pool, 1, 0);
+	GFX_TEST_CHECK(pool.blockSize >= sizeof(void*) && pool.chunkSize == 1);
+
+	void* a = _gfx_test_alloc(alloc, 1);
+	void* b = _gfx_test_alloc(alloc, 1);
+	gfx_allocator_realloc(alloc, a, 1, 0);
+	gfx_allocator_realloc(alloc, b, 1, 0);
+
+	GFX_TEST_CHECK(_gfx_test_alloc(alloc, 1) == b);
+	GFX_TEST_CHECK(_gfx_test_alloc(alloc, 1) == a);
+	GFX_TEST_CHECK(alloc->heapAllocs == 2);
+
+	gfx_pool_clear(&pool);
+}
+
+/******************************************************/
+/* Every (re)allocation of a growing container is forwarded and counted */
+static void _gfx_test_heap(void)
+{
+	GFXAllocator alloc;
+	gfx_allocator_init(&alloc);
+
+	/* Vector growth */
+	GFXVector vector;
+	gfx_vector_init_with_allocator(&vector, sizeof(uint32_t), &alloc);
+
+	_gfx_test_fill(&vector, GFX_TEST_SIZE, 0);
+	GFX_TEST_CHECK(alloc.allocs == GFX_TEST_GROWTH);
+	GFX_TEST_CHECK(alloc.heapAllocs == alloc.allocs);
+
+	gfx_vector_clear(&vector);
+	GFX_TEST_CHECK(alloc.allocs == GFX_TEST_GROWTH);
+
+	/* Deque growth at both ends, it pads with an empty element */
+	gfx_allocator_init(&alloc);
+
+	GFXDeque deque;
+	gfx_deque_init_with_allocator(&deque, sizeof(uint32_t), &alloc);
+
+	size_t i;
+	for(i = 0; i < GFX_TEST_SIZE; ++i)
+	{
+		uint32_t v = i;
+		GFX_TEST_CHECK((i & 1 ?
+			gfx_deque_push_begin(&deque, &v) :
+			gfx_deque_push_end(&deque, &v)) != deque.end);
+	}
+
+	GFX_TEST_CHECK(gfx_deque_get_size(&deque) == GFX_TEST_SIZE);
+	GFX_TEST_CHECK(alloc.allocs > 0 && alloc.allocs <= GFX_TEST_GROWTH + 1);
+	GFX_TEST_CHECK(alloc.heapAllocs == alloc.allocs);
+
+	/* Odd values at the begin in reverse, even values at the end */
+	size_t fails = 0;
+	for(i = 0; i < GFX_TEST_SIZE; ++i)
+	{
+		uint32_t v = i < GFX_TEST_SIZE / 2 ?
+			GFX_TEST_SIZE - 1 - (i << 1) :
+			(i << 1) - GFX_TEST_SIZE;
+
+		fails += *(uint32_t*)gfx_deque_at(&deque, i) != v;
+	}
+
+	GFX_TEST_CHECK(fails == 0);
+
+	/* Popping shrinks, which is counted as well */
+	size_t allocs = alloc.allocs;
+	while(deque.begin != deque.end) gfx_deque_pop_begin(&deque);
+
+	GFX_TEST_CHECK(alloc.allocs > allocs && alloc.heapAllocs == alloc.allocs);
+
+	gfx_deque_clear(&deque);
+
+	/* Copies never use the allocator of their source */
+	gfx_allocator_init(&alloc);
+	gfx_vector_init_with_allocator(&vector, sizeof(uint32_t), &alloc);
+	_gfx_test_fill(&vector, 10, 0);
+
+	allocs = alloc.allocs;
+
+	GFXVector copy;
+	gfx_vector_init_copy(&copy, &vector);
+
+	GFX_TEST_CHECK(copy.allocator == NULL && alloc.allocs == allocs);
+	GFX_TEST_CHECK(!memcmp(copy.begin, vector.begin, gfx_vector_get_byte_size(&vector)));
+
+	gfx_vector_clear(&copy);
+	gfx_vector_clear(&vector);
+}
+
+/******************************************************/
+int main(void)
+{
+	_gfx_test_arena();
+	_gfx_test_pool();
+	_gfx_test_heap();
+
+	return _gfx_test_result("test_allocator");
+}
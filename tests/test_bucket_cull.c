@@ -0,0 +1,224 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "bucket.h"
+
+#include <string.h>
+
+
+/* Kinds of units, cycled through in insertion order */
+#define GFX_TEST_INSIDE      0
+#define GFX_TEST_OUTSIDE     1
+#define GFX_TEST_STRADDLING  2
+#define GFX_TEST_UNBOUNDED   3
+#define GFX_TEST_HIDDEN      4
+
+#define GFX_TEST_KINDS       5
+
+/* Number of units of a small bucket and one large enough to cull in parallel */
+#define GFX_TEST_SMALL       (GFX_TEST_KINDS * 4)
+#define GFX_TEST_LARGE       (GFX_INT_BUCKET_PARALLEL_MIN + 3)
+
+
+/******************************************************/
+/* One layout, one program, one property map */
+static GFX_TestLayout _gfx_test_layout;
+static GFX_TestProgramMap _gfx_test_program;
+static GFXPropertyMap _gfx_test_map;
+
+/* Bounding sphere of each kind of unit, the frustum is the unit cube */
+static const float _gfx_test_bounds[GFX_TEST_KINDS][4] =
+{
+	{  0.0f, 0.0f, 0.0f,  0.5f },
+	{  5.0f, 0.0f, 0.0f,  1.0f },
+	{  1.2f, 0.0f, 0.0f,  0.5f },
+	{ 99.0f, 0.0f, 0.0f, -1.0f },
+	{  0.0f, 0.0f, 0.0f,  0.5f }
+};
+
+
+/******************************************************/
+static void _gfx_test_init(void)
+{
+	memset(&_gfx_test_layout, 0, sizeof(GFX_TestLayout));
+
+	_gfx_test_layout.vao              = 1;
+	_gfx_test_layout.source.primitive = GFX_TRIANGLES;
+	_gfx_test_layout.source.count     = 3;
+
+	_gfx_test_program.handle = 1;
+	_gfx_test_program.ready  = GFX_INT_MAP_READY;
+
+	_gfx_test_map.programMap = &_gfx_test_program.map;
+	_gfx_test_map.properties = 0;
+	_gfx_test_map.copies     = 1;
+}
+
+/******************************************************/
+/* Processes the bucket and checks which kinds of units are visible */
+static void _gfx_test_process(
+
+		GFXBucket*            bucket,
+		const GFXBucketUnit*  units,
+		size_t                num,
+		const int*            visible,
+		size_t                culled)
+{
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+	GFXBucketStats stats;
+
+	memset(&_gfx_test_calls, 0, sizeof(GFX_TestCalls));
+
+	_gfx_bucket_process(bucket, NULL, _gfx_test_context);
+	gfx_bucket_get_stats(bucket, &stats);
+
+	/* Count the units of each kind that should be visible */
+	size_t expected = 0;
+	size_t fails = 0;
+	size_t i;
+
+	for(i = 0; i < num; ++i)
+	{
+		int vis = visible[i % GFX_TEST_KINDS];
+		expected += vis;
+
+		size_t index = gfx_slot_map_get_index(&internal->refs, units[i]);
+		GFX_Ref* ref = gfx_vector_at(&internal->refs.data, index - 1);
+		GFX_Unit* unit = gfx_vector_at(&internal->units, ref->unit - 1);
+
+		/* Visible units are always in front */
+		int cur = (unit->state & GFX_INT_UNIT_VISIBLE) ? 1 : 0;
+		int front = (GFXVectorIterator)unit < internal->visible;
+
+		fails += (cur != vis) || (front != vis);
+	}
+
+	GFX_TEST_CHECK(fails == 0);
+	GFX_TEST_CHECK(stats.visible == expected);
+	GFX_TEST_CHECK(stats.culled == culled);
+	GFX_TEST_CHECK(_gfx_test_calls.draws == expected);
+}
+
+/******************************************************/
+/* Number of units of a kind within a bucket */
+static size_t _gfx_test_count(
+
+		size_t        num,
+		unsigned int  kind)
+{
+	return num / GFX_TEST_KINDS + (num % GFX_TEST_KINDS > kind ? 1 : 0);
+}
+
+/******************************************************/
+static void _gfx_test_cull(
+
+		size_t          num,
+		GFXThreadPool*  pool)
+{
+	GFXBucket* bucket = _gfx_bucket_create(0, 0);
+	gfx_bucket_set_thread_pool(bucket, pool);
+
+	GFXBucketSource src = gfx_bucket_add_source(
+		bucket, &_gfx_test_layout.layout, 0, 0, 3);
+
+	GFX_TEST_CHECK(src);
+
+	GFXBucketUnit* units = malloc(sizeof(GFXBucketUnit) * num);
+	size_t i;
+
+	for(i = 0; i < num; ++i)
+	{
+		unsigned int kind = i % GFX_TEST_KINDS;
+
+		units[i] = gfx_bucket_insert(
+			bucket, src, &_gfx_test_map, 0, kind != GFX_TEST_HIDDEN);
+
+		GFX_TEST_CHECK(units[i]);
+		gfx_bucket_set_bounds(bucket, units[i], _gfx_test_bounds[kind]);
+	}
+
+	/* Look at the unit cube */
+	float matrix[16] =
+	{
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f
+	};
+
+	const int cube[GFX_TEST_KINDS] = { 1, 0, 1, 1, 0 };
+
+	gfx_bucket_set_frustum(bucket, matrix);
+	_gfx_test_process(bucket, units, num, cube,
+		_gfx_test_count(num, GFX_TEST_OUTSIDE));
+
+	/* Nothing changed, nothing moves */
+	_gfx_test_process(bucket, units, num, cube,
+		_gfx_test_count(num, GFX_TEST_OUTSIDE));
+
+	/* Move the camera so the outside units straddle the frustum */
+	/* and all others but the unbounded ones are outside */
+	const int moved[GFX_TEST_KINDS] = { 0, 1, 0, 1, 0 };
+
+	matrix[12] = -4.5f;
+	gfx_bucket_set_frustum(bucket, matrix);
+	_gfx_test_process(bucket, units, num, moved,
+		_gfx_test_count(num, GFX_TEST_INSIDE) +
+		_gfx_test_count(num, GFX_TEST_STRADDLING));
+
+	/* Units shown by the user are still culled */
+	for(i = GFX_TEST_HIDDEN; i < num; i += GFX_TEST_KINDS)
+		gfx_bucket_set_visible(bucket, units[i], 1);
+
+	_gfx_test_process(bucket, units, num, moved,
+		_gfx_test_count(num, GFX_TEST_INSIDE) +
+		_gfx_test_count(num, GFX_TEST_STRADDLING) +
+		_gfx_test_count(num, GFX_TEST_HIDDEN));
+
+	/* Disabling culling shows everything */
+	const int all[GFX_TEST_KINDS] = { 1, 1, 1, 1, 1 };
+
+	gfx_bucket_set_frustum(bucket, NULL);
+	_gfx_test_process(bucket, units, num, all, 0);
+
+	free(units);
+	_gfx_bucket_free(bucket);
+}
+
+/******************************************************/
+int main(void)
+{
+	_gfx_test_init();
+	_gfx_test_context_init(0);
+
+	/* Without a pool, units are culled serially */
+	_gfx_test_cull(GFX_TEST_SMALL, NULL);
+	_gfx_test_cull(GFX_TEST_LARGE, NULL);
+
+	/* With a pool, large buckets are culled in parallel */
+	GFXThreadPool* pool = gfx_thread_pool_create(NULL, NULL, 0);
+	GFX_TEST_CHECK(pool && gfx_thread_pool_expand(pool, 2, NULL) == 2);
+
+	if(pool)
+	{
+		_gfx_test_cull(GFX_TEST_SMALL, pool);
+		_gfx_test_cull(GFX_TEST_LARGE, pool);
+
+		gfx_thread_pool_free(pool);
+	}
+
+	_gfx_test_context_clear();
+
+	return _gfx_test_result("test_bucket_cull");
+}
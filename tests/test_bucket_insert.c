@@ -0,0 +1,372 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "bucket.h"
+
+#include <string.h>
+
+
+/* Number of units inserted at once */
+#define GFX_TEST_SIZE    96
+
+/* Number of copies of each property map */
+#define GFX_TEST_COPIES  4
+
+
+/******************************************************/
+/* Two layouts, two programs, two property maps */
+static GFX_TestLayout _gfx_test_layouts[2];
+static GFX_TestProgramMap _gfx_test_programs[2];
+static GFXPropertyMap _gfx_test_maps[2];
+
+/* Allocator that can be told to fail */
+static GFXAllocator _gfx_test_allocator;
+static int _gfx_test_fail = 0;
+
+
+/******************************************************/
+static void* _gfx_test_realloc(
+
+		GFXAllocator*  allocator,
+		void*          ptr,
+		size_t         oldSize,
+		size_t         newSize)
+{
+	if(!newSize)
+	{
+		free(ptr);
+		return NULL;
+	}
+
+	return _gfx_test_fail ? NULL : realloc(ptr, newSize);
+}
+
+/******************************************************/
+static void _gfx_test_init(void)
+{
+	unsigned int i;
+	for(i = 0; i < 2; ++i)
+	{
+		GFX_TestLayout* layout = _gfx_test_layouts + i;
+		memset(layout, 0, sizeof(GFX_TestLayout));
+
+		layout->vao              = i + 1;
+		layout->source.primitive = GFX_TRIANGLES;
+		layout->source.count     = 3;
+
+		_gfx_test_programs[i].handle = i + 1;
+		_gfx_test_programs[i].ready  = GFX_INT_MAP_READY;
+
+		_gfx_test_maps[i].programMap = &_gfx_test_programs[i].map;
+		_gfx_test_maps[i].properties = 0;
+		_gfx_test_maps[i].copies     = GFX_TEST_COPIES;
+	}
+
+	gfx_allocator_init(&_gfx_test_allocator);
+	_gfx_test_allocator.reallocate = _gfx_test_realloc;
+}
+
+/******************************************************/
+/* Processes the bucket and returns the number of visible units */
+static size_t _gfx_test_process(
+
+		GFXBucket* bucket)
+{
+	GFXBucketStats stats;
+
+	memset(&_gfx_test_calls, 0, sizeof(GFX_TestCalls));
+
+	_gfx_bucket_process(bucket, NULL, _gfx_test_context);
+	gfx_bucket_get_stats(bucket, &stats);
+
+	GFX_TEST_CHECK(stats.visible == _gfx_test_calls.draws);
+
+	return stats.visible;
+}
+
+/******************************************************/
+/* Checks that no ID is 0 or handed out twice */
+static void _gfx_test_unique(
+
+		const GFXBucketUnit*  units,
+		size_t                num)
+{
+	size_t fails = 0;
+	size_t i, j;
+
+	for(i = 0; i < num; ++i)
+	{
+		fails += !units[i];
+		for(j = i + 1; j < num; ++j) fails += units[i] == units[j];
+	}
+
+	GFX_TEST_CHECK(fails == 0);
+}
+
+/******************************************************/
+/* Checks that all IDs are 0 */
+static void _gfx_test_zero(
+
+		const GFXBucketUnit*  units,
+		size_t                num)
+{
+	size_t fails = 0;
+	size_t i;
+
+	for(i = 0; i < num; ++i) fails += units[i] != 0;
+
+	GFX_TEST_CHECK(fails == 0);
+}
+
+/******************************************************/
+/* Inserts many units sharing one source, property map and copy */
+static void _gfx_test_multiple(void)
+{
+	GFXBucket* bucket = _gfx_bucket_create(0, 0);
+	GFXBucketSource src = gfx_bucket_add_source(
+		bucket, &_gfx_test_layouts[0].layout, 0, 0, 3);
+
+	GFXBucketUnit units[GFX_TEST_SIZE];
+	GFX_TEST_CHECK(gfx_bucket_insert_multiple(
+		bucket, GFX_TEST_SIZE, src, _gfx_test_maps + 1, 2, 1, units));
+
+	_gfx_test_unique(units, GFX_TEST_SIZE);
+
+	size_t fails = 0;
+	size_t i;
+
+	for(i = 0; i < GFX_TEST_SIZE; ++i)
+		fails +=
+			gfx_bucket_get_copy(bucket, units[i]) != 2 ||
+			!gfx_bucket_is_visible(bucket, units[i]);
+
+	GFX_TEST_CHECK(fails == 0);
+	GFX_TEST_CHECK(_gfx_test_process(bucket) == GFX_TEST_SIZE);
+
+	/* All share their state, so only bound once */
+	GFX_TEST_CHECK(_gfx_test_calls.layoutBinds == 1);
+	GFX_TEST_CHECK(_gfx_test_calls.mapUses == 1);
+
+	/* Invisible units are inserted, but not drawn */
+	GFXBucketUnit hidden[GFX_TEST_SIZE];
+	GFX_TEST_CHECK(gfx_bucket_insert_multiple(
+		bucket, GFX_TEST_SIZE, src, _gfx_test_maps, 0, 0, hidden));
+
+	_gfx_test_unique(hidden, GFX_TEST_SIZE);
+	GFX_TEST_CHECK(_gfx_test_process(bucket) == GFX_TEST_SIZE);
+
+	/* Nothing to insert */
+	GFX_TEST_CHECK(gfx_bucket_insert_multiple(
+		bucket, 0, src, _gfx_test_maps, 0, 1, hidden));
+
+	_gfx_bucket_free(bucket);
+}
+
+/******************************************************/
+/* Inserts units with mixed sources, maps and copies, then erases half */
+static void _gfx_test_range(void)
+{
+	GFXBucket* bucket = _gfx_bucket_create(0, 0);
+	GFXBucketSource sources[3];
+
+	sources[0] = gfx_bucket_add_source(bucket, &_gfx_test_layouts[0].layout, 0, 0, 3);
+	sources[1] = gfx_bucket_add_source(bucket, &_gfx_test_layouts[1].layout, 0, 0, 3);
+	sources[2] = gfx_bucket_add_source(bucket, &_gfx_test_layouts[0].layout, 0, 0, 3);
+
+	GFXBucketSource srcs[GFX_TEST_SIZE];
+	const GFXPropertyMap* maps[GFX_TEST_SIZE];
+	unsigned int copies[GFX_TEST_SIZE];
+	GFXBucketUnit units[GFX_TEST_SIZE];
+	size_t i;
+
+	for(i = 0; i < GFX_TEST_SIZE; ++i)
+	{
+		srcs[i] = sources[i % 3];
+		maps[i] = _gfx_test_maps + (i & 1);
+		copies[i] = i % GFX_TEST_COPIES;
+	}
+
+	GFX_TEST_CHECK(gfx_bucket_insert_range(
+		bucket, GFX_TEST_SIZE, srcs, maps, copies, 1, units));
+
+	_gfx_test_unique(units, GFX_TEST_SIZE);
+
+	size_t fails = 0;
+	for(i = 0; i < GFX_TEST_SIZE; ++i)
+		fails += gfx_bucket_get_copy(bucket, units[i]) != copies[i];
+
+	GFX_TEST_CHECK(fails == 0);
+	GFX_TEST_CHECK(_gfx_test_process(bucket) == GFX_TEST_SIZE);
+
+	/* Sorted on program, then layout, two of each */
+	GFX_TEST_CHECK(_gfx_test_calls.layoutBinds == 4);
+
+	/* Erase every other unit, including IDs that are stale or 0 */
+	GFXBucketUnit erase[GFX_TEST_SIZE];
+	size_t num = 0;
+
+	for(i = 0; i < GFX_TEST_SIZE; i += 2)
+		erase[num++] = units[i];
+
+	erase[num++] = units[0];
+	erase[num++] = 0;
+
+	gfx_bucket_erase_range(bucket, num, erase);
+
+	fails = 0;
+	for(i = 0; i < GFX_TEST_SIZE; ++i)
+		fails += (i & 1) ?
+			gfx_bucket_get_copy(bucket, units[i]) != copies[i] :
+			gfx_bucket_is_visible(bucket, units[i]) != 0;
+
+	GFX_TEST_CHECK(fails == 0);
+	GFX_TEST_CHECK(_gfx_test_process(bucket) == GFX_TEST_SIZE >> 1);
+
+	/* Only the second map is left */
+	GFX_TEST_CHECK(_gfx_test_calls.layoutBinds == 2);
+
+	/* Erasing them again does nothing */
+	gfx_bucket_erase_range(bucket, num, erase);
+	GFX_TEST_CHECK(_gfx_test_process(bucket) == GFX_TEST_SIZE >> 1);
+
+	_gfx_bucket_free(bucket);
+}
+
+/******************************************************/
+/* Checks a failed insert left no trace */
+static void _gfx_test_failed(
+
+		GFXBucket*            bucket,
+		const GFXBucketUnit*  units,
+		size_t                num,
+		size_t                visible)
+{
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+
+	_gfx_test_zero(units, num);
+
+	GFX_TEST_CHECK(gfx_vector_get_size(&internal->units) == visible);
+	GFX_TEST_CHECK(gfx_slot_map_get_size(&internal->refs) == visible);
+	GFX_TEST_CHECK(_gfx_test_process(bucket) == visible);
+}
+
+/******************************************************/
+/* Failed inserts zero all IDs and insert nothing */
+static void _gfx_test_rollback(void)
+{
+	GFXBucket* bucket = _gfx_bucket_create(0, 0);
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+
+	/* All unit and reference memory comes from the failing allocator */
+	gfx_vector_init_with_allocator(
+		&internal->units, sizeof(GFX_Unit), &_gfx_test_allocator);
+	gfx_vector_init_with_allocator(
+		&internal->refs.data, sizeof(GFX_Ref), &_gfx_test_allocator);
+
+	internal->visible = internal->units.end;
+
+	GFXBucketSource src = gfx_bucket_add_source(
+		bucket, &_gfx_test_layouts[0].layout, 0, 0, 3);
+	GFXBucketSource removed = gfx_bucket_add_source(
+		bucket, &_gfx_test_layouts[1].layout, 0, 0, 3);
+
+	gfx_bucket_remove_source(bucket, removed);
+
+	GFXBucketUnit first[4];
+	GFX_TEST_CHECK(gfx_bucket_insert_multiple(
+		bucket, 4, src, _gfx_test_maps, 0, 1, first));
+
+	GFX_TEST_CHECK(_gfx_test_process(bucket) == 4);
+
+	/* A removed source or missing map anywhere in a range */
+	GFXBucketSource srcs[GFX_TEST_SIZE];
+	const GFXPropertyMap* maps[GFX_TEST_SIZE];
+	unsigned int copies[GFX_TEST_SIZE];
+	GFXBucketUnit units[GFX_TEST_SIZE];
+	size_t i;
+
+	for(i = 0; i < GFX_TEST_SIZE; ++i)
+	{
+		srcs[i] = src;
+		maps[i] = _gfx_test_maps + (i & 1);
+		copies[i] = 0;
+	}
+
+	srcs[GFX_TEST_SIZE >> 1] = removed;
+	memset(units, 0xff, sizeof(units));
+
+	GFX_TEST_CHECK(!gfx_bucket_insert_range(
+		bucket, GFX_TEST_SIZE, srcs, maps, copies, 1, units));
+
+	_gfx_test_failed(bucket, units, GFX_TEST_SIZE, 4);
+
+	srcs[GFX_TEST_SIZE >> 1] = src;
+	maps[GFX_TEST_SIZE - 1] = NULL;
+	memset(units, 0xff, sizeof(units));
+
+	GFX_TEST_CHECK(!gfx_bucket_insert_range(
+		bucket, GFX_TEST_SIZE, srcs, maps, copies, 1, units));
+
+	_gfx_test_failed(bucket, units, GFX_TEST_SIZE, 4);
+
+	/* Out of memory, for units and for references */
+	/* The visible iterator must survive units being reserved */
+	_gfx_test_fail = 1;
+	memset(units, 0xff, sizeof(units));
+
+	GFX_TEST_CHECK(!gfx_bucket_insert_multiple(
+		bucket, GFX_TEST_SIZE, src, _gfx_test_maps, 0, 1, units));
+
+	_gfx_test_failed(bucket, units, GFX_TEST_SIZE, 4);
+
+	/* Reserve units up front, so only the references fail */
+	_gfx_test_fail = 0;
+	GFX_TEST_CHECK(gfx_vector_reserve(&internal->units, 4 + GFX_TEST_SIZE));
+	internal->visible = gfx_vector_at(&internal->units, 4);
+	_gfx_test_fail = 1;
+
+	memset(units, 0xff, sizeof(units));
+
+	GFX_TEST_CHECK(!gfx_bucket_insert_multiple(
+		bucket, GFX_TEST_SIZE, src, _gfx_test_maps, 0, 1, units));
+
+	_gfx_test_failed(bucket, units, GFX_TEST_SIZE, 4);
+
+	/* And it all works again */
+	_gfx_test_fail = 0;
+	maps[GFX_TEST_SIZE - 1] = _gfx_test_maps;
+
+	GFX_TEST_CHECK(gfx_bucket_insert_range(
+		bucket, GFX_TEST_SIZE, srcs, maps, copies, 1, units));
+
+	_gfx_test_unique(units, GFX_TEST_SIZE);
+	GFX_TEST_CHECK(_gfx_test_process(bucket) == 4 + GFX_TEST_SIZE);
+
+	_gfx_bucket_free(bucket);
+}
+
+/******************************************************/
+int main(void)
+{
+	_gfx_test_init();
+	_gfx_test_context_init(0);
+
+	_gfx_test_multiple();
+	_gfx_test_range();
+	_gfx_test_rollback();
+
+	_gfx_test_context_clear();
+
+	return _gfx_test_result("test_bucket_insert");
+}
@@ -0,0 +1,325 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "bucket.h"
+
+#include <string.h>
+
+
+/* Number of units of the depth tests */
+#define GFX_TEST_DEPTHS  10
+
+/* Number of units of the merge tests, one is hidden when merging */
+/* Merged up to 1/ratio of the visible units */
+#define GFX_TEST_MERGE   512
+#define GFX_TEST_LIMIT   ((GFX_TEST_MERGE - 1) / GFX_INT_BUCKET_MERGE_RATIO)
+
+/* Number of units hidden and shown again before each merge */
+#define GFX_TEST_SHOWN   2
+
+
+/******************************************************/
+/* One layout, one program, one property map */
+static GFX_TestLayout _gfx_test_layout;
+static GFX_TestProgramMap _gfx_test_program;
+static GFXPropertyMap _gfx_test_map;
+
+/* Negative, zero, equal and large depths, in insertion order */
+static const float _gfx_test_depths[GFX_TEST_DEPTHS] =
+	{ 3.0f, -1.0f, 0.0f, 2.5f, -7.0f, 3.0f, 0.0f, 100.0f, -1.0f, 3.0f };
+
+
+/******************************************************/
+static void _gfx_test_init(void)
+{
+	memset(&_gfx_test_layout, 0, sizeof(GFX_TestLayout));
+
+	_gfx_test_layout.vao              = 1;
+	_gfx_test_layout.source.primitive = GFX_TRIANGLES;
+	_gfx_test_layout.source.count     = 3;
+
+	_gfx_test_program.handle = 1;
+	_gfx_test_program.ready  = GFX_INT_MAP_READY;
+
+	_gfx_test_map.programMap = &_gfx_test_program.map;
+	_gfx_test_map.properties = 0;
+	_gfx_test_map.copies     = 1;
+}
+
+/******************************************************/
+/* Processes the bucket and returns its visible units in sorted order */
+static size_t _gfx_test_process(
+
+		GFXBucket*      bucket,
+		GFXBucketUnit*  order)
+{
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+	_gfx_bucket_process(bucket, NULL, _gfx_test_context);
+
+	/* Every unit and its reference must point at each other */
+	GFX_Unit* unit;
+	size_t num = 0;
+
+	for(
+		unit = internal->units.begin;
+		unit != internal->visible;
+		unit = gfx_vector_next(&internal->units, unit))
+	{
+		GFX_Ref* ref = gfx_vector_at(&internal->refs.data, unit->ref);
+		GFX_TEST_CHECK(ref->unit == ++num);
+
+		*(order++) = gfx_slot_map_get_handle(&internal->refs, unit->ref);
+	}
+
+	return num;
+}
+
+/******************************************************/
+/* Stable insertion sort of units on depth, the order every sort must match */
+static void _gfx_test_sort(
+
+		const GFXBucket*  bucket,
+		GFXBucketUnit*    units,
+		size_t            num,
+		int               descending)
+{
+	size_t i, j;
+	for(i = 1; i < num; ++i)
+	{
+		GFXBucketUnit unit = units[i];
+		float depth = gfx_bucket_get_depth(bucket, unit);
+
+		for(j = i; j > 0; --j)
+		{
+			float prev = gfx_bucket_get_depth(bucket, units[j - 1]);
+			if(descending ? prev >= depth : prev <= depth) break;
+
+			units[j] = units[j - 1];
+		}
+
+		units[j] = unit;
+	}
+}
+
+/******************************************************/
+/* Checks that the bucket is sorted exactly as the expected order */
+static void _gfx_test_compare(
+
+		GFXBucket*            bucket,
+		const GFXBucketUnit*  expected,
+		size_t                num)
+{
+	GFXBucketUnit* order = malloc(sizeof(GFXBucketUnit) * num);
+
+	GFX_TEST_CHECK(_gfx_test_process(bucket, order) == num);
+	GFX_TEST_CHECK(!memcmp(order, expected, sizeof(GFXBucketUnit) * num));
+
+	free(order);
+}
+
+/******************************************************/
+static void _gfx_test_depth(
+
+		GFXBucketSortMode  mode)
+{
+	int descending = mode == GFX_BUCKET_SORT_DEPTH_DESCENDING;
+
+	GFXBucket* bucket = _gfx_bucket_create(0, 0);
+	gfx_bucket_set_sort_mode(bucket, mode);
+
+	GFXBucketSource src = gfx_bucket_add_source(
+		bucket, &_gfx_test_layout.layout, 0, 0, 3);
+
+	GFX_TEST_CHECK(src);
+
+	/* Units of equal depth keep their insertion order */
+	GFXBucketUnit units[GFX_TEST_DEPTHS];
+	size_t i;
+
+	for(i = 0; i < GFX_TEST_DEPTHS; ++i)
+	{
+		units[i] = gfx_bucket_insert(bucket, src, &_gfx_test_map, 0, 1);
+		GFX_TEST_CHECK(units[i]);
+
+		gfx_bucket_set_depth(bucket, units[i], _gfx_test_depths[i]);
+		GFX_TEST_CHECK(gfx_bucket_get_depth(bucket, units[i]) == _gfx_test_depths[i]);
+	}
+
+	_gfx_test_sort(bucket, units, GFX_TEST_DEPTHS, descending);
+	_gfx_test_compare(bucket, units, GFX_TEST_DEPTHS);
+
+	/* Move units to both ends and in between existing depths */
+	/* The rest keeps its relative order */
+	gfx_bucket_set_depth(bucket, units[0], 1000.0f);
+	gfx_bucket_set_depth(bucket, units[GFX_TEST_DEPTHS - 1], -1000.0f);
+	gfx_bucket_set_depth(bucket, units[GFX_TEST_DEPTHS >> 1], 1.0f);
+
+	_gfx_test_sort(bucket, units, GFX_TEST_DEPTHS, descending);
+	_gfx_test_compare(bucket, units, GFX_TEST_DEPTHS);
+
+	/* Setting the same depth again changes nothing */
+	gfx_bucket_set_depth(bucket, units[1], gfx_bucket_get_depth(bucket, units[1]));
+	_gfx_test_compare(bucket, units, GFX_TEST_DEPTHS);
+
+	/* Flipping the mode reverses all but equal depths */
+	descending = !descending;
+	gfx_bucket_set_sort_mode(bucket, descending ?
+		GFX_BUCKET_SORT_DEPTH_DESCENDING :
+		GFX_BUCKET_SORT_DEPTH_ASCENDING);
+
+	_gfx_test_sort(bucket, units, GFX_TEST_DEPTHS, descending);
+	_gfx_test_compare(bucket, units, GFX_TEST_DEPTHS);
+
+	_gfx_bucket_free(bucket);
+}
+
+/******************************************************/
+/* Shuffles distinct integer depths */
+static void _gfx_test_shuffle(
+
+		float*  depths,
+		size_t  num,
+		float   offset)
+{
+	size_t i;
+	for(i = 0; i < num; ++i)
+		depths[i] = (float)i + offset;
+
+	for(i = num; i > 1; --i)
+	{
+		size_t j = (size_t)rand() % i;
+		float t = depths[i - 1];
+		depths[i - 1] = depths[j];
+		depths[j] = t;
+	}
+}
+
+/******************************************************/
+/* Applies the same changes to a bucket that merges and one that fully sorts */
+static void _gfx_test_merge(
+
+		size_t dirty)
+{
+	/* Check what side of the threshold the changes end up at */
+	size_t pending = dirty + GFX_TEST_SHOWN;
+	int merge = pending <= GFX_TEST_LIMIT;
+
+	GFX_TEST_CHECK(merge == !(pending * GFX_INT_BUCKET_MERGE_RATIO > GFX_TEST_MERGE - 1));
+
+	GFXBucket* buckets[2];
+	GFXBucketUnit units[GFX_TEST_MERGE];
+	float depths[GFX_TEST_MERGE];
+	size_t i, b;
+
+	for(b = 0; b < 2; ++b)
+	{
+		buckets[b] = _gfx_bucket_create(0, 0);
+		gfx_bucket_set_sort_mode(buckets[b], GFX_BUCKET_SORT_DEPTH_ASCENDING);
+	}
+
+	/* Both buckets get the same handles and depths */
+	srand(1);
+	_gfx_test_shuffle(depths, GFX_TEST_MERGE, 0.0f);
+
+	for(b = 0; b < 2; ++b)
+	{
+		GFXBucketSource src = gfx_bucket_add_source(
+			buckets[b], &_gfx_test_layout.layout, 0, 0, 3);
+
+		for(i = 0; i < GFX_TEST_MERGE; ++i)
+		{
+			GFXBucketUnit unit =
+				gfx_bucket_insert(buckets[b], src, &_gfx_test_map, 0, 1);
+
+			GFX_TEST_CHECK(b ? unit == units[i] : unit != 0);
+			units[i] = unit;
+		}
+
+		gfx_bucket_set_depth_range(buckets[b], GFX_TEST_MERGE, units, depths);
+	}
+
+	/* Hide a few units, to show them again along with the changes */
+	GFXBucketUnit* order = malloc(sizeof(GFXBucketUnit) * GFX_TEST_MERGE);
+	GFXBucketUnit* ref = malloc(sizeof(GFXBucketUnit) * GFX_TEST_MERGE);
+
+	for(b = 0; b < 2; ++b)
+	{
+		for(i = 0; i < GFX_TEST_SHOWN; ++i)
+			gfx_bucket_set_visible(buckets[b], units[i], 0);
+
+		_gfx_test_process(buckets[b], b ? ref : order);
+	}
+
+	GFX_TEST_CHECK(!memcmp(order, ref, sizeof(GFXBucketUnit) * (GFX_TEST_MERGE - GFX_TEST_SHOWN)));
+
+	/* Give random units new depths in between the others */
+	/* Some twice and one that is hidden right after, which are not merged */
+	_gfx_test_shuffle(depths, GFX_TEST_MERGE, 0.5f);
+
+	for(b = 0; b < 2; ++b)
+	{
+		for(i = 0; i < GFX_TEST_SHOWN; ++i)
+			gfx_bucket_set_visible(buckets[b], units[i], 1);
+
+		for(i = 0; i < dirty; ++i)
+		{
+			size_t j = GFX_TEST_SHOWN + 1 + i;
+			gfx_bucket_set_depth(buckets[b], units[j], depths[j] - 1.0f);
+			gfx_bucket_set_depth(buckets[b], units[j], depths[j]);
+		}
+
+		gfx_bucket_set_depth(buckets[b], units[GFX_TEST_SHOWN], -1.0f);
+		gfx_bucket_set_visible(buckets[b], units[GFX_TEST_SHOWN], 0);
+	}
+
+	/* The second bucket sorts everything */
+	((GFX_Bucket*)buckets[1])->flags |= GFX_INT_BUCKET_SORT;
+
+	size_t num[2];
+	num[0] = _gfx_test_process(buckets[0], order);
+	num[1] = _gfx_test_process(buckets[1], ref);
+
+	GFX_TEST_CHECK(num[0] == GFX_TEST_MERGE - 1 && num[1] == num[0]);
+	GFX_TEST_CHECK(!memcmp(order, ref, sizeof(GFXBucketUnit) * num[0]));
+
+	for(i = 1; i < num[0]; ++i) GFX_TEST_CHECK(
+		gfx_bucket_get_depth(buckets[0], order[i - 1]) <
+		gfx_bucket_get_depth(buckets[0], order[i]));
+
+	free(order);
+	free(ref);
+
+	for(b = 0; b < 2; ++b)
+		_gfx_bucket_free(buckets[b]);
+}
+
+/******************************************************/
+int main(void)
+{
+	_gfx_test_init();
+	_gfx_test_context_init(0);
+
+	_gfx_test_depth(GFX_BUCKET_SORT_DEPTH_ASCENDING);
+	_gfx_test_depth(GFX_BUCKET_SORT_DEPTH_DESCENDING);
+
+	/* Both sides of the merge threshold */
+	_gfx_test_merge(1);
+	_gfx_test_merge(GFX_TEST_LIMIT - GFX_TEST_SHOWN);
+	_gfx_test_merge(GFX_TEST_LIMIT - GFX_TEST_SHOWN + 1);
+	_gfx_test_merge(GFX_TEST_MERGE >> 2);
+
+	_gfx_test_context_clear();
+
+	return _gfx_test_result("test_bucket_sort");
+}
@@ -0,0 +1,421 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "bucket.h"
+
+#include <string.h>
+
+
+/* Number of buckets prepared in parallel */
+#define GFX_TEST_BUCKETS  16
+
+
+/******************************************************/
+/* Two layouts, two programs, three property maps */
+static GFX_TestLayout _gfx_test_layouts[2];
+static GFX_TestProgramMap _gfx_test_programs[2];
+static GFXPropertyMap _gfx_test_maps[3];
+
+
+/******************************************************/
+static void _gfx_test_init(void)
+{
+	unsigned int i;
+	for(i = 0; i < 2; ++i)
+	{
+		GFX_TestLayout* layout = _gfx_test_layouts + i;
+		memset(layout, 0, sizeof(GFX_TestLayout));
+
+		layout->vao              = i + 1;
+		layout->source.primitive = GFX_TRIANGLES;
+		layout->source.count     = 3;
+
+		_gfx_test_programs[i].handle = i + 1;
+		_gfx_test_programs[i].ready  = GFX_INT_MAP_READY;
+	}
+
+	for(i = 0; i < 3; ++i)
+	{
+		_gfx_test_maps[i].programMap = &_gfx_test_programs[i > 1].map;
+		_gfx_test_maps[i].properties = 0;
+		_gfx_test_maps[i].copies     = 1;
+	}
+}
+
+/******************************************************/
+/* Processes the bucket and checks the stats against the recorded calls */
+static void _gfx_test_process(
+
+		GFXBucket*       bucket,
+		int              prepare,
+		GFXBucketStats*  stats)
+{
+	memset(&_gfx_test_calls, 0, sizeof(GFX_TestCalls));
+
+	/* Prepare as a worker would, without a current context */
+	if(prepare)
+	{
+		GFX_Context* context = _gfx_test_context;
+		_gfx_bucket_poll(bucket);
+
+		_gfx_test_context = NULL;
+		_gfx_bucket_prepare(bucket);
+		_gfx_test_context = context;
+	}
+
+	_gfx_bucket_process(bucket, NULL, _gfx_test_context);
+
+	gfx_bucket_get_stats(bucket, stats);
+
+	GFX_TEST_CHECK(stats->draws == _gfx_test_calls.draws + _gfx_test_calls.indirectDraws);
+	GFX_TEST_CHECK(stats->batched == _gfx_test_calls.indirectUnits);
+	GFX_TEST_CHECK(stats->layoutBinds == _gfx_test_calls.layoutBinds);
+	GFX_TEST_CHECK(stats->mapUses == _gfx_test_calls.mapUses);
+
+	/* Every drawn unit is either drawn on its own or batched */
+	size_t units = _gfx_test_calls.draws + _gfx_test_calls.indirectUnits;
+	GFX_TEST_CHECK(units == stats->visible);
+
+	/* Binds are only skipped for each draw call after the first */
+	size_t calls = _gfx_test_calls.draws + _gfx_test_calls.indirectDraws;
+	GFX_TEST_CHECK(stats->layoutBinds + stats->layoutSkips == calls);
+	GFX_TEST_CHECK(stats->mapUses + stats->mapSkips == calls);
+}
+
+/******************************************************/
+/* Inserts the same six units into any bucket */
+static void _gfx_test_insert(
+
+		GFXBucket*    bucket,
+		GFXBucketUnit units[6])
+{
+	GFXBucketSource src1 = gfx_bucket_add_source(
+		bucket, &_gfx_test_layouts[0].layout, 0, 0, 3);
+	GFXBucketSource src2 = gfx_bucket_add_source(
+		bucket, &_gfx_test_layouts[1].layout, 0, 0, 3);
+
+	GFX_TEST_CHECK(src1 && src2);
+
+	/* Sorted on program, then layout: */
+	/* { map0, map0, map1 } on layout 1, { map0 } on layout 2, { map2, map2 } on layout 2 */
+	units[0] = gfx_bucket_insert(bucket, src1, _gfx_test_maps + 0, 0, 1);
+	units[1] = gfx_bucket_insert(bucket, src2, _gfx_test_maps + 2, 0, 1);
+	units[2] = gfx_bucket_insert(bucket, src1, _gfx_test_maps + 0, 0, 1);
+	units[3] = gfx_bucket_insert(bucket, src2, _gfx_test_maps + 0, 0, 1);
+	units[4] = gfx_bucket_insert(bucket, src1, _gfx_test_maps + 1, 0, 1);
+	units[5] = gfx_bucket_insert(bucket, src2, _gfx_test_maps + 2, 0, 1);
+
+	size_t i;
+	for(i = 0; i < 6; ++i) GFX_TEST_CHECK(units[i]);
+}
+
+/******************************************************/
+static void _gfx_test_direct(void)
+{
+	_gfx_test_context_init(0);
+
+	GFXBucket* bucket = _gfx_bucket_create(0, 0);
+	GFXBucketUnit units[6];
+	GFXBucketStats stats;
+
+	_gfx_test_insert(bucket, units);
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(stats.visible == 6);
+	GFX_TEST_CHECK(stats.draws == 6);
+	GFX_TEST_CHECK(stats.batched == 0);
+	GFX_TEST_CHECK(stats.layoutBinds == 2);
+	GFX_TEST_CHECK(stats.mapUses == 4);
+
+	/* Hidden units are neither drawn nor bound */
+	gfx_bucket_set_visible(bucket, units[4], 0);
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(stats.visible == 5);
+	GFX_TEST_CHECK(stats.mapUses == 2);
+
+	/* Replaying prepared records gives the same counters */
+	/* Nothing changed, so nothing should have moved either */
+	GFXBucketStats prepared;
+	_gfx_test_process(bucket, 1, &prepared);
+
+	GFX_TEST_CHECK(prepared.moved == 0);
+	GFX_TEST_CHECK(prepared.visible == stats.visible);
+	GFX_TEST_CHECK(prepared.draws == stats.draws);
+	GFX_TEST_CHECK(prepared.layoutBinds == stats.layoutBinds);
+	GFX_TEST_CHECK(prepared.layoutSkips == stats.layoutSkips);
+	GFX_TEST_CHECK(prepared.mapUses == stats.mapUses);
+	GFX_TEST_CHECK(prepared.mapSkips == stats.mapSkips);
+
+	_gfx_bucket_free(bucket);
+
+	GFX_TEST_CHECK(!_gfx_test_layouts[0].blocks && !_gfx_test_layouts[1].blocks);
+}
+
+/******************************************************/
+static void _gfx_test_batched(
+
+		int multiDrawIndirect)
+{
+	_gfx_test_context_init(multiDrawIndirect);
+
+	GFXBucket* bucket = _gfx_bucket_create(0, GFX_BUCKET_BATCH);
+	GFXBucketUnit units[6];
+	GFXBucketStats stats;
+
+	_gfx_test_insert(bucket, units);
+	_gfx_test_process(bucket, 0, &stats);
+
+	/* Runs: { map0, map0 }, { map1 }, { map0 }, { map2, map2 } */
+	GFX_TEST_CHECK(stats.visible == 6);
+	GFX_TEST_CHECK(stats.draws == 4);
+	GFX_TEST_CHECK(stats.batched == 4);
+	GFX_TEST_CHECK(_gfx_test_calls.indirectDraws == 2);
+
+	/* Commands are only uploaded if multi draw indirect is supported */
+	/* The indirect buffer is bound through the binder only */
+	GFX_TEST_CHECK(_gfx_test_calls.bufferBinds == 0);
+	GFX_TEST_CHECK(_gfx_test_calls.indirectBinds == (multiDrawIndirect ? 1 : 0));
+
+	/* The same buffer is still bound the next time around */
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(_gfx_test_calls.indirectBinds == 0);
+
+	_gfx_bucket_free(bucket);
+}
+
+/******************************************************/
+static void _gfx_test_recorded(void)
+{
+	_gfx_test_context_init(0);
+
+	GFXBucket* bucket = _gfx_bucket_create(0, GFX_BUCKET_RECORD);
+	GFX_Bucket* internal = (GFX_Bucket*)bucket;
+	GFXBucketUnit units[6];
+	GFXBucketStats stats;
+
+	/* Records give the same counters as submitting directly */
+	_gfx_test_insert(bucket, units);
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(internal->recorded);
+	GFX_TEST_CHECK(gfx_vector_get_size(&internal->records) == 6);
+	GFX_TEST_CHECK(stats.draws == 6);
+	GFX_TEST_CHECK(stats.layoutBinds == 2);
+	GFX_TEST_CHECK(stats.mapUses == 4);
+
+	/* Nothing changed, so the same records are replayed */
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(internal->recorded);
+	GFX_TEST_CHECK(stats.draws == 6);
+	GFX_TEST_CHECK(stats.mapUses == 4);
+
+	/* A different copy splits a run of the same map */
+	gfx_bucket_set_copy(bucket, units[2], 1);
+	GFX_TEST_CHECK(!internal->recorded);
+
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(internal->recorded);
+	GFX_TEST_CHECK(stats.draws == 6);
+	GFX_TEST_CHECK(stats.mapUses == 5);
+
+	/* Hiding a unit drops its record */
+	gfx_bucket_set_visible(bucket, units[4], 0);
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(gfx_vector_get_size(&internal->records) == 5);
+	GFX_TEST_CHECK(stats.visible == 5);
+	GFX_TEST_CHECK(stats.draws == 5);
+
+	_gfx_bucket_free(bucket);
+}
+
+/******************************************************/
+static void _gfx_test_pending(void)
+{
+	_gfx_test_context_init(0);
+
+	GFXBucket* bucket = _gfx_bucket_create(0, 0);
+	GFXBucketUnit units[6];
+	GFXBucketStats stats;
+
+	/* Units of the second program are hidden while it links */
+	_gfx_test_programs[1].ready = GFX_INT_MAP_PENDING;
+
+	_gfx_test_insert(bucket, units);
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(stats.visible == 4);
+	GFX_TEST_CHECK(stats.pending == 2);
+
+	/* Preparing does not poll, only the explicit poll does */
+	_gfx_test_programs[1].ready = GFX_INT_MAP_READY;
+	_gfx_test_process(bucket, 1, &stats);
+
+	GFX_TEST_CHECK(_gfx_test_calls.readyPolls == 2);
+	GFX_TEST_CHECK(stats.visible == 6);
+	GFX_TEST_CHECK(stats.pending == 0);
+
+	/* Nothing is left to poll */
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(_gfx_test_calls.readyPolls == 0);
+	GFX_TEST_CHECK(stats.visible == 6);
+
+	_gfx_bucket_free(bucket);
+}
+
+/******************************************************/
+static void _gfx_test_failed(void)
+{
+	_gfx_test_context_init(0);
+
+	GFXBucket* bucket = _gfx_bucket_create(0, 0);
+	GFXBucketUnit units[6];
+	GFXBucketStats stats;
+
+	_gfx_test_programs[1].ready = GFX_INT_MAP_PENDING;
+
+	_gfx_test_insert(bucket, units);
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(stats.pending == 2);
+
+	/* Units of a program that failed to link leave pending, but stay hidden */
+	unsigned int errors = _gfx_test_errors;
+	_gfx_test_programs[1].ready = GFX_INT_MAP_FAILED;
+	_gfx_test_process(bucket, 1, &stats);
+
+	GFX_TEST_CHECK(_gfx_test_errors == errors + 1);
+	GFX_TEST_CHECK(stats.visible == 4);
+	GFX_TEST_CHECK(stats.pending == 0);
+
+	/* And are never polled again, nor shown by making them visible */
+	gfx_bucket_set_visible(bucket, units[1], 1);
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(_gfx_test_calls.readyPolls == 0);
+	GFX_TEST_CHECK(stats.visible == 4);
+
+	/* Inserting more of them reports it for each insert */
+	GFXBucketUnit more[6];
+	_gfx_test_insert(bucket, more);
+	_gfx_test_process(bucket, 0, &stats);
+
+	GFX_TEST_CHECK(_gfx_test_errors == errors + 3);
+	GFX_TEST_CHECK(stats.visible == 8);
+
+	_gfx_bucket_free(bucket);
+	_gfx_test_programs[1].ready = GFX_INT_MAP_READY;
+}
+
+/******************************************************/
+static void _gfx_test_prepare_range(
+
+		size_t  begin,
+		size_t  end,
+		void*   data)
+{
+	GFXBucket** buckets = data;
+
+	for(; begin < end; ++begin)
+		_gfx_bucket_prepare(buckets[begin]);
+}
+
+/******************************************************/
+static void _gfx_test_parallel(void)
+{
+	_gfx_test_context_init(0);
+
+	GFXThreadPool* pool = gfx_thread_pool_create(NULL, NULL, 0);
+	GFX_TEST_CHECK(pool && gfx_thread_pool_expand(pool, 2, NULL) == 2);
+
+	/* Every other bucket records, every third hides a unit */
+	GFXBucket* buckets[GFX_TEST_BUCKETS];
+	GFXBucketUnit units[6];
+	GFXBucketStats stats;
+	size_t b;
+
+	_gfx_test_programs[1].ready = GFX_INT_MAP_PENDING;
+
+	for(b = 0; b < GFX_TEST_BUCKETS; ++b)
+	{
+		buckets[b] = _gfx_bucket_create(0, (b & 1) ? GFX_BUCKET_RECORD : 0);
+		_gfx_test_insert(buckets[b], units);
+
+		if(!(b % 3)) gfx_bucket_set_visible(buckets[b], units[4], 0);
+	}
+
+	/* The second program finishes linking after polling */
+	/* Only the next frame's poll on the context thread shows its units */
+	unsigned int frame;
+	for(frame = 0; frame < 2; ++frame)
+	{
+		GFX_Context* context = _gfx_test_context;
+
+		for(b = 0; b < GFX_TEST_BUCKETS; ++b)
+			_gfx_bucket_poll(buckets[b]);
+
+		_gfx_test_programs[1].ready = GFX_INT_MAP_READY;
+		_gfx_test_context = NULL;
+
+		gfx_parallel_for(
+			pool, 0, GFX_TEST_BUCKETS, 1, _gfx_test_prepare_range, buckets);
+
+		_gfx_test_context = context;
+
+		/* Only replaying is left, without polling again */
+		for(b = 0; b < GFX_TEST_BUCKETS; ++b)
+		{
+			_gfx_test_process(buckets[b], 0, &stats);
+
+			size_t visible = (frame ? 6 : 4) - ((b % 3) ? 0 : 1);
+			size_t uses = frame ?
+				((b % 3) ? 4 : 2) :
+				((b % 3) ? 3 : 1);
+
+			GFX_TEST_CHECK(_gfx_test_calls.readyPolls == 0);
+			GFX_TEST_CHECK(stats.visible == visible);
+			GFX_TEST_CHECK(stats.draws == visible);
+			GFX_TEST_CHECK(stats.layoutBinds == 2);
+			GFX_TEST_CHECK(stats.mapUses == uses);
+		}
+	}
+
+	for(b = 0; b < GFX_TEST_BUCKETS; ++b)
+		_gfx_bucket_free(buckets[b]);
+
+	gfx_thread_pool_free(pool);
+}
+
+/******************************************************/
+int main(void)
+{
+	_gfx_test_init();
+
+	_gfx_test_direct();
+	_gfx_test_batched(0);
+	_gfx_test_batched(1);
+	_gfx_test_recorded();
+	_gfx_test_pending();
+	_gfx_test_failed();
+	_gfx_test_parallel();
+
+	_gfx_test_context_clear();
+
+	return _gfx_test_result("test_bucket_stats");
+}
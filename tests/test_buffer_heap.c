@@ -0,0 +1,230 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/core/memory.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+
+/* Heap sizes */
+#define GFX_TEST_BLOCK_SIZE  4096
+#define GFX_TEST_MIN_SIZE    16
+
+/* Number of ranges for the fill and random tests */
+#define GFX_TEST_SIZE        1024
+
+
+/** Number of backing buffers alive */
+static unsigned int _gfx_test_buffers = 0;
+
+
+/******************************************************/
+/* Backing buffers are plain memory, no context is ever created */
+GFXBuffer* gfx_buffer_create(
+
+		GFXBufferUsage  usage,
+		size_t          size,
+		const void*     data,
+		unsigned char   count)
+{
+	GFXBuffer* buffer = calloc(1, sizeof(GFXBuffer));
+	if(!buffer) return NULL;
+
+	buffer->usage = usage;
+	buffer->size = size;
+	buffer->count = count;
+
+	++_gfx_test_buffers;
+
+	return buffer;
+}
+
+/******************************************************/
+void gfx_buffer_free(
+
+		GFXBuffer* buffer)
+{
+	if(buffer) --_gfx_test_buffers, free(buffer);
+}
+
+/* Include the heap to reach its internal free lists */
+#include "groufix/core/buffer_heap.c"
+
+
+/******************************************************/
+/* Checks that no two live ranges overlap and all are aligned to their size */
+static void _gfx_test_validate(
+
+		const GFXBufferHeap*   heap,
+		const GFXBufferRange*  ranges,
+		size_t                 num)
+{
+	size_t i, j;
+	for(i = 0; i < num; ++i)
+	{
+		GFX_TEST_CHECK(ranges[i].offset % ranges[i].size == 0);
+		GFX_TEST_CHECK(ranges[i].offset + ranges[i].size <= heap->blockSize);
+
+		for(j = i + 1; j < num; ++j) GFX_TEST_CHECK(
+			ranges[i].buffer != ranges[j].buffer ||
+			ranges[i].offset + ranges[i].size <= ranges[j].offset ||
+			ranges[j].offset + ranges[j].size <= ranges[i].offset);
+	}
+}
+
+/******************************************************/
+/* Checks that all free lists are sorted and, if empty, all memory merged back */
+static void _gfx_test_free_lists(
+
+		GFXBufferHeap*  heap,
+		int             empty)
+{
+	GFX_Heap* internal = (GFX_Heap*)heap;
+
+	unsigned char o;
+	for(o = 0; o < internal->orders; ++o)
+	{
+		GFXVector* free = _gfx_buffer_heap_get_free(internal, o);
+		size_t size = gfx_vector_get_size(free);
+
+		size_t i;
+		for(i = 1; i < size; ++i) GFX_TEST_CHECK(_gfx_buffer_heap_compare(
+			gfx_vector_at(free, i - 1),
+			gfx_vector_at(free, i)) < 0);
+
+		if(empty) GFX_TEST_CHECK(o == internal->orders - 1 ?
+			size == gfx_vector_get_size(&internal->buffers) : !size);
+	}
+}
+
+/******************************************************/
+/* Sizes are rounded and ranges are split from as few buffers as possible */
+static void _gfx_test_alloc(void)
+{
+	GFXBufferHeap* heap = gfx_buffer_heap_create(
+		GFX_BUFFER_WRITE, GFX_TEST_BLOCK_SIZE - 1, GFX_TEST_MIN_SIZE - 1);
+
+	GFX_TEST_CHECK(heap);
+	if(!heap) return;
+
+	GFX_TEST_CHECK(heap->blockSize == GFX_TEST_BLOCK_SIZE);
+	GFX_TEST_CHECK(heap->minSize == GFX_TEST_MIN_SIZE);
+
+	GFXBufferRange a, b, c;
+	GFX_TEST_CHECK(gfx_buffer_heap_alloc(heap, 1, 0, &a));
+	GFX_TEST_CHECK(a.size == GFX_TEST_MIN_SIZE);
+
+	GFX_TEST_CHECK(gfx_buffer_heap_alloc(heap, 100, 4, &b));
+	GFX_TEST_CHECK(b.size == 128 && b.buffer == a.buffer);
+
+	/* Alignment larger than the size picks a larger block */
+	GFX_TEST_CHECK(gfx_buffer_heap_alloc(heap, 8, 256, &c));
+	GFX_TEST_CHECK(c.size == 256 && c.offset % 256 == 0);
+
+	/* Invalid requests */
+	GFXBufferRange d;
+	unsigned int errors = _gfx_test_errors;
+
+	GFX_TEST_CHECK(!gfx_buffer_heap_create(GFX_BUFFER_STREAM, GFX_TEST_BLOCK_SIZE, 0));
+	GFX_TEST_CHECK(_gfx_test_errors == errors + 1 && _gfx_test_buffers == 1);
+
+	GFX_TEST_CHECK(!gfx_buffer_heap_alloc(heap, 0, 0, &d));
+	GFX_TEST_CHECK(!gfx_buffer_heap_alloc(heap, 16, 3, &d));
+	GFX_TEST_CHECK(!gfx_buffer_heap_alloc(heap, GFX_TEST_BLOCK_SIZE + 1, 0, &d));
+
+	/* A full block takes a new backing buffer */
+	GFX_TEST_CHECK(gfx_buffer_heap_alloc(heap, GFX_TEST_BLOCK_SIZE, 0, &d));
+	GFX_TEST_CHECK(d.buffer != a.buffer && d.offset == 0);
+	GFX_TEST_CHECK(_gfx_test_buffers == 2);
+
+	GFXBufferRange ranges[] = { a, b, c, d };
+	_gfx_test_validate(heap, ranges, 4);
+	_gfx_test_free_lists(heap, 0);
+
+	/* Releasing everything merges all buddies back together */
+	gfx_buffer_heap_release(heap, &b);
+	gfx_buffer_heap_release(heap, &d);
+	gfx_buffer_heap_release(heap, &a);
+	gfx_buffer_heap_release(heap, &c);
+	_gfx_test_free_lists(heap, 1);
+
+	/* Which can then be handed out in one piece without a new buffer */
+	GFX_TEST_CHECK(gfx_buffer_heap_alloc(heap, GFX_TEST_BLOCK_SIZE, 0, &a));
+	GFX_TEST_CHECK(gfx_buffer_heap_alloc(heap, GFX_TEST_BLOCK_SIZE, 0, &b));
+	GFX_TEST_CHECK(a.buffer != b.buffer && _gfx_test_buffers == 2);
+
+	gfx_buffer_heap_free(heap);
+	GFX_TEST_CHECK(_gfx_test_buffers == 0);
+}
+
+/******************************************************/
+/* Many small ranges are allocated and released in random order */
+static void _gfx_test_random(void)
+{
+	GFXBufferHeap* heap = gfx_buffer_heap_create(
+		GFX_BUFFER_WRITE, GFX_TEST_BLOCK_SIZE, GFX_TEST_MIN_SIZE);
+
+	GFX_TEST_CHECK(heap);
+	if(!heap) return;
+
+	GFXBufferRange* ranges = malloc(sizeof(GFXBufferRange) * GFX_TEST_SIZE);
+	size_t num = 0;
+
+	unsigned int op;
+	for(op = 0; op < GFX_TEST_SIZE * 16; ++op)
+	{
+		if(num < GFX_TEST_SIZE && (!num || rand() % 3))
+		{
+			size_t size = 1 + (size_t)rand() % 300;
+			GFX_TEST_CHECK(gfx_buffer_heap_alloc(heap, size, 4, ranges + num));
+			GFX_TEST_CHECK(ranges[num].size >= size);
+
+			++num;
+		}
+		else
+		{
+			size_t i = (size_t)rand() % num;
+			gfx_buffer_heap_release(heap, ranges + i);
+			ranges[i] = ranges[--num];
+		}
+
+		if(!(op & 0xff))
+		{
+			_gfx_test_validate(heap, ranges, num);
+			_gfx_test_free_lists(heap, 0);
+		}
+
+		if(_gfx_test_failures) break;
+	}
+
+	while(num) gfx_buffer_heap_release(heap, ranges + (--num));
+	_gfx_test_free_lists(heap, 1);
+
+	free(ranges);
+	gfx_buffer_heap_free(heap);
+
+	GFX_TEST_CHECK(_gfx_test_buffers == 0);
+}
+
+/******************************************************/
+int main(void)
+{
+	srand(1);
+
+	_gfx_test_alloc();
+	_gfx_test_random();
+
+	return _gfx_test_result("test_buffer_heap");
+}
@@ -0,0 +1,200 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "gl.h"
+
+
+/* Size of the buffers read from */
+#define GFX_TEST_SIZE  64
+
+
+/********************************************************
+ * Stand-ins of everything the buffer uses
+ *******************************************************/
+
+/******************************************************/
+int _gfx_render_object_id_init(
+
+		GFX_RenderObjectID*           id,
+		unsigned char                 order,
+		GFXRenderObjectFlags          flags,
+		const GFX_RenderObjectFuncs*  funcs,
+		GFX_RenderObjects*            cont)
+{
+	id->funcs = funcs;
+	id->order = order;
+
+	return 1;
+}
+
+/******************************************************/
+void _gfx_render_object_id_clear(
+
+		GFX_RenderObjectID* id)
+{
+	/* The only container is being dereferenced */
+	if(id->funcs && id->funcs->destruct)
+		id->funcs->destruct(id);
+}
+
+/******************************************************/
+int _gfx_render_object_id_reference(
+
+		GFX_RenderObjectID*   id,
+		GFXRenderObjectFlags  flags,
+		GFX_RenderObjects*    cont)
+{
+	return 1;
+}
+
+
+/******************************************************/
+/* The buffer itself, including all its internal functions */
+#include "groufix/core/buffer.c"
+
+
+/******************************************************/
+static void _gfx_test_read(
+
+		int bufferStorage)
+{
+	_gfx_test_context_init(bufferStorage);
+
+	unsigned char data[GFX_TEST_SIZE];
+	unsigned char out[GFX_TEST_SIZE];
+	unsigned char zero[GFX_TEST_SIZE];
+	size_t i;
+
+	for(i = 0; i < GFX_TEST_SIZE; ++i) data[i] = (unsigned char)(i + 1);
+	memset(zero, 0, GFX_TEST_SIZE);
+
+	GFXBuffer* buffer = gfx_buffer_create(
+		GFX_BUFFER_WRITE, GFX_TEST_SIZE, data, 1);
+
+	GFX_TEST_CHECK(buffer && _gfx_test_live_buffers() == 1);
+	if(!buffer) return;
+
+	/* Blocking reads are direct, without staging buffers or fences */
+	memset(out, 0, GFX_TEST_SIZE);
+
+	GFX_TEST_CHECK(gfx_buffer_read(buffer, 100, out, 16) == GFX_TEST_SIZE - 16);
+	GFX_TEST_CHECK(!memcmp(out, data + 16, GFX_TEST_SIZE - 16));
+	GFX_TEST_CHECK(_gfx_test_gl.created == 1);
+	GFX_TEST_CHECK(_gfx_test_gl.fencesCreated == 0);
+
+	/* Nothing is read past the end */
+	GFX_TEST_CHECK(!gfx_buffer_read_async(buffer, 0, 0));
+	GFX_TEST_CHECK(!gfx_buffer_read_async(buffer, 1, GFX_TEST_SIZE));
+	GFX_TEST_CHECK(_gfx_test_gl.created == 1);
+
+	/* A pending read keeps its data when the buffer is written to */
+	GFXBufferRead* read = gfx_buffer_read_async(buffer, 32, 8);
+
+	GFX_TEST_CHECK(read && read->size == 32);
+	GFX_TEST_CHECK(_gfx_test_live_buffers() == 2);
+	GFX_TEST_CHECK(_gfx_test_gl.fencesCreated == 1);
+
+	gfx_buffer_write(buffer, GFX_TEST_SIZE, zero, 0);
+
+	/* Polling does not block, and is done once the GPU is */
+	GFX_TEST_CHECK(!gfx_buffer_read_poll(read));
+	GFX_TEST_CHECK(!gfx_buffer_read_poll(read));
+
+	_gfx_test_gl.done = 1;
+
+	GFX_TEST_CHECK(gfx_buffer_read_poll(read));
+	GFX_TEST_CHECK(gfx_buffer_read_poll(read));
+	GFX_TEST_CHECK(_gfx_test_gl.fencesDeleted == 1);
+
+	memset(out, 0, GFX_TEST_SIZE);
+
+	GFX_TEST_CHECK(gfx_buffer_read_finish(read, out) == 32);
+	GFX_TEST_CHECK(!memcmp(out, data + 8, 32));
+	GFX_TEST_CHECK(_gfx_test_gl.waits == 0);
+	GFX_TEST_CHECK(_gfx_test_live_buffers() == 1);
+
+	/* A pending read outlives the buffer, and is clipped to its size */
+	_gfx_test_gl.done = 0;
+	gfx_buffer_write(buffer, GFX_TEST_SIZE, data, 0);
+
+	read = gfx_buffer_read_async(buffer, 16, GFX_TEST_SIZE - 4);
+	GFX_TEST_CHECK(read && read->size == 4);
+
+	gfx_buffer_free(buffer);
+	GFX_TEST_CHECK(_gfx_test_live_buffers() == 1);
+
+	/* Finishing without polling waits for the GPU */
+	memset(out, 0, GFX_TEST_SIZE);
+
+	GFX_TEST_CHECK(gfx_buffer_read_finish(read, out) == 4);
+	GFX_TEST_CHECK(!memcmp(out, data + GFX_TEST_SIZE - 4, 4));
+	GFX_TEST_CHECK(_gfx_test_gl.waits == 1);
+	GFX_TEST_CHECK(_gfx_test_live_buffers() == 0);
+	GFX_TEST_CHECK(_gfx_test_gl.fencesDeleted == _gfx_test_gl.fencesCreated);
+}
+
+/******************************************************/
+static void _gfx_test_read_current(void)
+{
+	_gfx_test_context_init(1);
+
+	unsigned char data[GFX_TEST_SIZE];
+	unsigned char out[GFX_TEST_SIZE];
+	size_t i;
+
+	for(i = 0; i < GFX_TEST_SIZE; ++i) data[i] = (unsigned char)(i + 1);
+
+	/* Only the first backbuffer is initialized */
+	GFXBuffer* buffer = gfx_buffer_create(
+		GFX_BUFFER_WRITE, GFX_TEST_SIZE, NULL, 2);
+
+	GFX_TEST_CHECK(buffer && _gfx_test_live_buffers() == 2);
+	if(!buffer) return;
+
+	gfx_buffer_swap(buffer);
+	gfx_buffer_write(buffer, GFX_TEST_SIZE, data, 0);
+
+	/* Reads come from the current backbuffer */
+	GFXBufferRead* read = gfx_buffer_read_async(buffer, GFX_TEST_SIZE, 0);
+	GFX_TEST_CHECK(read);
+
+	memset(out, 0, GFX_TEST_SIZE);
+
+	GFX_TEST_CHECK(gfx_buffer_read_finish(read, out) == GFX_TEST_SIZE);
+	GFX_TEST_CHECK(!memcmp(out, data, GFX_TEST_SIZE));
+
+	/* Finishing without output still frees the staging buffer */
+	read = gfx_buffer_read_async(buffer, GFX_TEST_SIZE, 0);
+	GFX_TEST_CHECK(read && _gfx_test_live_buffers() == 3);
+
+	GFX_TEST_CHECK(gfx_buffer_read_finish(read, NULL) == 0);
+	GFX_TEST_CHECK(_gfx_test_live_buffers() == 2);
+	GFX_TEST_CHECK(_gfx_test_gl.fencesDeleted == _gfx_test_gl.fencesCreated);
+
+	gfx_buffer_free(buffer);
+	GFX_TEST_CHECK(_gfx_test_live_buffers() == 0);
+}
+
+/******************************************************/
+int main(void)
+{
+	/* With and without immutable storage */
+	_gfx_test_read(0);
+	_gfx_test_read(1);
+	_gfx_test_read_current();
+
+	_gfx_test_context_clear();
+
+	return _gfx_test_result("test_buffer_read");
+}
@@ -0,0 +1,197 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/containers/deque.h"
+#include "test.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Number of random operations per element size */
+#define GFX_TEST_OPERATIONS  200000
+
+/* Largest number of elements in the reference */
+#define GFX_TEST_MAX_SIZE    4096
+
+
+/******************************************************/
+/* Element sizes that do not divide any power of two */
+/* The upper bound of the deque then differs from its capacity */
+typedef struct GFX_TestElem12 { uint32_t v[3]; } GFX_TestElem12;
+typedef struct GFX_TestElem24 { uint32_t v[6]; } GFX_TestElem24;
+
+
+/******************************************************/
+static void _gfx_test_fill(
+
+		void*     elem,
+		size_t    size,
+		uint32_t  value)
+{
+	uint32_t* v = elem;
+	size_t i;
+
+	for(i = 0; i < size / sizeof(uint32_t); ++i)
+		v[i] = value + i;
+}
+
+/******************************************************/
+static int _gfx_test_equal(
+
+		const void*  elem,
+		size_t       size,
+		uint32_t     value)
+{
+	const uint32_t* v = elem;
+	size_t i;
+
+	for(i = 0; i < size / sizeof(uint32_t); ++i)
+		if(v[i] != value + i) return 0;
+
+	return 1;
+}
+
+/******************************************************/
+/* Random pushes and pops at both ends, checked against a plain array */
+static void _gfx_test_random(
+
+		size_t elementSize)
+{
+	uint32_t* ref = malloc(sizeof(uint32_t) * GFX_TEST_MAX_SIZE * 2);
+	size_t head = GFX_TEST_MAX_SIZE;
+	size_t size = 0;
+
+	GFXDeque deque;
+	gfx_deque_init(&deque, elementSize);
+
+	uint32_t elem[8];
+	uint32_t next = 0;
+	size_t op;
+
+	for(op = 0; op < GFX_TEST_OPERATIONS; ++op)
+	{
+		/* Grow in bursts, so the deque wraps before it reallocates */
+		int r = rand() % 16;
+		int grow = (op / 2048) % 2 == 0;
+
+		if(r < (grow ? 10 : 6) && size < GFX_TEST_MAX_SIZE)
+		{
+			_gfx_test_fill(elem, elementSize, ++next);
+
+			if(r & 1)
+			{
+				GFX_TEST_CHECK(gfx_deque_push_end(&deque, elem) != deque.end);
+				ref[head + size++] = next;
+			}
+			else
+			{
+				GFX_TEST_CHECK(gfx_deque_push_begin(&deque, elem) != deque.end);
+				ref[--head] = next;
+				++size;
+			}
+
+			/* Recenter the reference if it runs out of room in front */
+			if(!head)
+			{
+				memmove(ref + GFX_TEST_MAX_SIZE / 2, ref, sizeof(uint32_t) * size);
+				head = GFX_TEST_MAX_SIZE / 2;
+			}
+		}
+
+		else if(size)
+		{
+			if(r & 1)
+			{
+				gfx_deque_pop_begin(&deque);
+				++head;
+			}
+			else
+				gfx_deque_pop_end(&deque);
+
+			--size;
+		}
+
+		GFX_TEST_CHECK(gfx_deque_get_size(&deque) == size);
+		if(_gfx_test_failures) break;
+	}
+
+	/* Every element must have survived all reallocations */
+	size_t i;
+	for(i = 0; i < size; ++i)
+		GFX_TEST_CHECK(_gfx_test_equal(
+			gfx_deque_at(&deque, i), elementSize, ref[head + i]));
+
+	gfx_deque_clear(&deque);
+	free(ref);
+}
+
+/******************************************************/
+/* Grow a wrapped deque, as the thread pool injection queue does */
+static void _gfx_test_wrapped_growth(
+
+		size_t elementSize)
+{
+	GFXDeque deque;
+	gfx_deque_init(&deque, elementSize);
+
+	uint32_t elem[8];
+	uint32_t first = 1;
+	uint32_t next = 0;
+
+	/* Queue behaviour, keep a few elements alive at all times */
+	size_t round;
+	for(round = 0; round < 512; ++round)
+	{
+		size_t push = 1 + round % 7;
+		size_t pop = round % 5;
+
+		while(push--)
+		{
+			_gfx_test_fill(elem, elementSize, ++next);
+			GFX_TEST_CHECK(gfx_deque_push_end(&deque, elem) != deque.end);
+		}
+
+		while(pop-- && deque.begin != deque.end)
+		{
+			GFX_TEST_CHECK(_gfx_test_equal(deque.begin, elementSize, first++));
+			gfx_deque_pop_begin(&deque);
+		}
+	}
+
+	while(deque.begin != deque.end)
+	{
+		GFX_TEST_CHECK(_gfx_test_equal(deque.begin, elementSize, first++));
+		gfx_deque_pop_begin(&deque);
+	}
+
+	GFX_TEST_CHECK(first == next + 1);
+
+	gfx_deque_clear(&deque);
+}
+
+/******************************************************/
+int main(void)
+{
+	srand(1);
+
+	_gfx_test_wrapped_growth(sizeof(GFX_TestElem12));
+	_gfx_test_wrapped_growth(sizeof(GFX_TestElem24));
+	_gfx_test_random(sizeof(GFX_TestElem12));
+	_gfx_test_random(sizeof(GFX_TestElem24));
+	_gfx_test_random(sizeof(uint32_t));
+
+	return _gfx_test_result("test_deque");
+}
@@ -0,0 +1,603 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/math.h"
+#include "math_scalar.h"
+#include "test.h"
+
+#define GFX_TEST_KERNEL simd
+#define GFX_TEST_KERNEL_STORAGE static inline
+#include "math_kernels.h"
+#undef GFX_TEST_KERNEL
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* Number of random elements compared per kernel */
+#define GFX_TEST_NUM    4096
+
+/* Largest number of elements of the batched transforms, 4 wide steps plus a tail */
+#define GFX_TEST_BATCH  39
+
+
+/******************************************************/
+/* Inputs and outputs of both code paths */
+static gfx_mat4  _gfx_test_ma[GFX_TEST_NUM];
+static gfx_mat4  _gfx_test_mb[GFX_TEST_NUM];
+static gfx_mat4  _gfx_test_mr[2][GFX_TEST_NUM];
+static gfx_vec4  _gfx_test_va[GFX_TEST_NUM];
+static gfx_vec4  _gfx_test_vr[2][GFX_TEST_NUM];
+static gfx_quat  _gfx_test_qa[GFX_TEST_NUM];
+static gfx_quat  _gfx_test_qb[GFX_TEST_NUM];
+static gfx_quat  _gfx_test_qr[2][GFX_TEST_NUM];
+static float     _gfx_test_fr[2][GFX_TEST_NUM];
+
+static gfx_dmat4 _gfx_test_da[GFX_TEST_NUM];
+static gfx_dmat4 _gfx_test_db[GFX_TEST_NUM];
+static gfx_dmat4 _gfx_test_dr[2][GFX_TEST_NUM];
+static gfx_dvec4 _gfx_test_dv[GFX_TEST_NUM];
+static gfx_dvec4 _gfx_test_dvr[2][GFX_TEST_NUM];
+
+
+/******************************************************/
+static double _gfx_test_rand(void)
+{
+	return (double)rand() / RAND_MAX * 2.0 - 1.0;
+}
+
+/******************************************************/
+/* Largest difference relative to the magnitude of the values compared */
+static double _gfx_test_error(
+
+		const float*  a,
+		const float*  b,
+		size_t        num)
+{
+	double err = 0.0;
+
+	size_t i;
+	for(i = 0; i < num; ++i)
+	{
+		double d = fabs((double)a[i] - b[i]) / (1.0 + fabs(a[i]) + fabs(b[i]));
+		err = (d > err || d != d) ? d : err;
+	}
+
+	return err;
+}
+
+/******************************************************/
+static double _gfx_test_error_d(
+
+		const double*  a,
+		const double*  b,
+		size_t         num)
+{
+	double err = 0.0;
+
+	size_t i;
+	for(i = 0; i < num; ++i)
+	{
+		double d = fabs(a[i] - b[i]) / (1.0 + fabs(a[i]) + fabs(b[i]));
+		err = (d > err || d != d) ? d : err;
+	}
+
+	return err;
+}
+
+/******************************************************/
+static void _gfx_test_init(void)
+{
+	size_t i, j;
+	for(i = 0; i < GFX_TEST_NUM; ++i)
+	{
+		for(j = 0; j < 16; ++j)
+		{
+			/* Diagonally dominant, so well conditioned to invert */
+			double diag = (j % 5 == 0) ? 4.0 : 0.0;
+
+			_gfx_test_ma[i].data[j] = _gfx_test_rand() + diag;
+			_gfx_test_mb[i].data[j] = _gfx_test_rand();
+			_gfx_test_da[i].data[j] = _gfx_test_rand() + diag;
+			_gfx_test_db[i].data[j] = _gfx_test_rand();
+		}
+
+		for(j = 0; j < 4; ++j)
+		{
+			_gfx_test_va[i].data[j] = _gfx_test_rand();
+			_gfx_test_qa[i].data[j] = _gfx_test_rand();
+			_gfx_test_qb[i].data[j] = _gfx_test_rand();
+			_gfx_test_dv[i].data[j] = _gfx_test_rand();
+		}
+	}
+
+	/* Zero length vectors must normalize to zero on both paths */
+	gfx_vec4_set_zero(_gfx_test_va);
+	gfx_quat_set_zero(_gfx_test_qa);
+}
+
+/******************************************************/
+static void _gfx_test_mat4(void)
+{
+	float* ma = _gfx_test_ma->data;
+	float* mb = _gfx_test_mb->data;
+	float* va = _gfx_test_va->data;
+	float* r0 = _gfx_test_mr[0]->data;
+	float* r1 = _gfx_test_mr[1]->data;
+
+	/* mat4 x mat4 */
+	_gfx_scalar_mat4_mult(GFX_TEST_NUM, r0, ma, mb);
+	_gfx_simd_mat4_mult(GFX_TEST_NUM, r1, ma, mb);
+
+	GFX_TEST_CHECK(_gfx_test_error(r0, r1, GFX_TEST_NUM * 16) < 1e-6);
+
+	/* Aliased destination */
+	memcpy(r1, ma, sizeof(gfx_mat4) * GFX_TEST_NUM);
+	_gfx_simd_mat4_mult(GFX_TEST_NUM, r1, r1, mb);
+
+	GFX_TEST_CHECK(_gfx_test_error(r0, r1, GFX_TEST_NUM * 16) < 1e-6);
+
+	/* mat4 x vec4 */
+	r0 = _gfx_test_vr[0]->data;
+	r1 = _gfx_test_vr[1]->data;
+
+	_gfx_scalar_mat4_mult_vec(GFX_TEST_NUM, r0, ma, va);
+	_gfx_simd_mat4_mult_vec(GFX_TEST_NUM, r1, ma, va);
+
+	GFX_TEST_CHECK(_gfx_test_error(r0, r1, GFX_TEST_NUM * 4) < 1e-6);
+
+	/* Transpose is exact */
+	r0 = _gfx_test_mr[0]->data;
+	r1 = _gfx_test_mr[1]->data;
+
+	_gfx_scalar_mat4_transpose(GFX_TEST_NUM, r0, ma);
+	_gfx_simd_mat4_transpose(GFX_TEST_NUM, r1, ma);
+
+	GFX_TEST_CHECK(!memcmp(r0, r1, sizeof(gfx_mat4) * GFX_TEST_NUM));
+
+	/* Inverse, both must agree and give the identity when multiplied */
+	GFX_TEST_CHECK(_gfx_scalar_mat4_inverse(GFX_TEST_NUM, r0, ma) == GFX_TEST_NUM);
+	GFX_TEST_CHECK(_gfx_simd_mat4_inverse(GFX_TEST_NUM, r1, ma) == GFX_TEST_NUM);
+
+	GFX_TEST_CHECK(_gfx_test_error(r0, r1, GFX_TEST_NUM * 16) < 1e-5);
+
+	size_t i, j;
+	for(i = 0; i < GFX_TEST_NUM; ++i)
+	{
+		gfx_mat4 id;
+		gfx_mat4_mult(&id, _gfx_test_ma + i, _gfx_test_mr[1] + i);
+
+		for(j = 0; j < 16; ++j)
+			GFX_TEST_CHECK(fabs(id.data[j] - (j % 5 == 0 ? 1.0 : 0.0)) < 1e-4);
+	}
+
+	/* Singular matrices are rejected by both */
+	gfx_mat4 zero;
+	gfx_mat4_set_zero(&zero);
+
+	GFX_TEST_CHECK(!_gfx_scalar_mat4_inverse(1, r0, zero.data));
+	GFX_TEST_CHECK(!_gfx_simd_mat4_inverse(1, r1, zero.data));
+}
+
+/******************************************************/
+static void _gfx_test_vec4(void)
+{
+	float* va = _gfx_test_va->data;
+	float* vb = _gfx_test_qb->data;
+	float* r0 = _gfx_test_vr[0]->data;
+	float* r1 = _gfx_test_vr[1]->data;
+
+	_gfx_scalar_vec4_normalize(GFX_TEST_NUM, r0, va);
+	_gfx_simd_vec4_normalize(GFX_TEST_NUM, r1, va);
+
+	GFX_TEST_CHECK(_gfx_test_error(r0, r1, GFX_TEST_NUM * 4) < 1e-6);
+	GFX_TEST_CHECK(gfx_vec4_is_zero(_gfx_test_vr[1]));
+
+	_gfx_scalar_vec4_dot(GFX_TEST_NUM, _gfx_test_fr[0], va, vb);
+	_gfx_simd_vec4_dot(GFX_TEST_NUM, _gfx_test_fr[1], va, vb);
+
+	GFX_TEST_CHECK(_gfx_test_error(_gfx_test_fr[0], _gfx_test_fr[1], GFX_TEST_NUM) < 1e-6);
+}
+
+/******************************************************/
+static void _gfx_test_quat(void)
+{
+	float* qa = _gfx_test_qa->data;
+	float* qb = _gfx_test_qb->data;
+	float* r0 = _gfx_test_qr[0]->data;
+	float* r1 = _gfx_test_qr[1]->data;
+
+	/* Compose */
+	_gfx_scalar_quat_mult(GFX_TEST_NUM, r0, qa, qb);
+	_gfx_simd_quat_mult(GFX_TEST_NUM, r1, qa, qb);
+
+	GFX_TEST_CHECK(_gfx_test_error(r0, r1, GFX_TEST_NUM * 4) < 1e-6);
+
+	/* Normalize, then composing unit quaternions remains unit length */
+	_gfx_scalar_quat_normalize(GFX_TEST_NUM, r0, qb);
+	_gfx_simd_quat_normalize(GFX_TEST_NUM, r1, qb);
+
+	GFX_TEST_CHECK(_gfx_test_error(r0, r1, GFX_TEST_NUM * 4) < 1e-6);
+
+	_gfx_simd_quat_mult(GFX_TEST_NUM - 1, r0, r1, r1 + 4);
+
+	size_t i;
+	for(i = 0; i < GFX_TEST_NUM - 1; ++i)
+		GFX_TEST_CHECK(fabs(gfx_quat_norm(_gfx_test_qr[0] + i) - 1.0) < 1e-5);
+
+	/* Zero quaternions stay zero */
+	_gfx_simd_quat_normalize(1, r1, qa);
+	GFX_TEST_CHECK(gfx_quat_is_zero(_gfx_test_qr[1]));
+}
+
+/******************************************************/
+static void _gfx_test_dmat4(void)
+{
+	double* da = _gfx_test_da->data;
+	double* db = _gfx_test_db->data;
+	double* dv = _gfx_test_dv->data;
+
+	_gfx_scalar_dmat4_mult(GFX_TEST_NUM, _gfx_test_dr[0]->data, da, db);
+	_gfx_simd_dmat4_mult(GFX_TEST_NUM, _gfx_test_dr[1]->data, da, db);
+
+	GFX_TEST_CHECK(_gfx_test_error_d(
+		_gfx_test_dr[0]->data, _gfx_test_dr[1]->data, GFX_TEST_NUM * 16) < 1e-14);
+
+	_gfx_scalar_dmat4_mult_vec(GFX_TEST_NUM, _gfx_test_dvr[0]->data, da, dv);
+	_gfx_simd_dmat4_mult_vec(GFX_TEST_NUM, _gfx_test_dvr[1]->data, da, dv);
+
+	GFX_TEST_CHECK(_gfx_test_error_d(
+		_gfx_test_dvr[0]->data, _gfx_test_dvr[1]->data, GFX_TEST_NUM * 4) < 1e-14);
+}
+
+/******************************************************/
+/* Structure of arrays, each array starts one float past an aligned address */
+typedef struct GFX_TestArrays
+{
+	float*  base[4];
+	float*  comp[4];
+
+} GFX_TestArrays;
+
+
+/******************************************************/
+static void _gfx_test_arrays_init(
+
+		GFX_TestArrays*  arrays,
+		size_t           num,
+		size_t           offset)
+{
+	size_t c;
+	for(c = 0; c < 4; ++c)
+	{
+		arrays->base[c] = malloc(sizeof(float) * (num + offset + 4));
+		arrays->comp[c] = arrays->base[c] + offset;
+	}
+}
+
+/******************************************************/
+static void _gfx_test_arrays_clear(
+
+		GFX_TestArrays* arrays)
+{
+	size_t c;
+	for(c = 0; c < 4; ++c) free(arrays->base[c]);
+}
+
+/******************************************************/
+/* Transforms by a matrix in double precision */
+static void _gfx_test_transform(
+
+		double*          dest,
+		const gfx_mat4*  a,
+		const float*     v,
+		double           w)
+{
+	size_t r;
+	for(r = 0; r < 4; ++r) dest[r] =
+		(double)a->data[r] * v[0] +
+		(double)a->data[r + 4] * v[1] +
+		(double)a->data[r + 8] * v[2] +
+		(double)a->data[r + 12] * w;
+}
+
+/******************************************************/
+/* Rotates by a quaternion (w, x, y, z) in double precision, as q * v * q^-1 */
+static void _gfx_test_rotate(
+
+		double*        dest,
+		const float*   q,
+		const double*  v)
+{
+	double w = q[0], x = q[1], y = q[2], z = q[3];
+
+	/* t = 2 * cross(q.xyz, v), v' = v + w * t + cross(q.xyz, t) */
+	double t[3] = {
+		2.0 * (y * v[2] - z * v[1]),
+		2.0 * (z * v[0] - x * v[2]),
+		2.0 * (x * v[1] - y * v[0])
+	};
+
+	dest[0] = v[0] + w * t[0] + (y * t[2] - z * t[1]);
+	dest[1] = v[1] + w * t[1] + (z * t[0] - x * t[2]);
+	dest[2] = v[2] + w * t[2] + (x * t[1] - y * t[0]);
+}
+
+/******************************************************/
+static void _gfx_test_batch_transform(
+
+		size_t  num,
+		size_t  offset)
+{
+	const gfx_mat4* m = _gfx_test_ma + num;
+
+	gfx_vec3 src3[GFX_TEST_BATCH];
+	gfx_vec3 dst3[GFX_TEST_BATCH];
+	gfx_vec4 dst4[GFX_TEST_BATCH];
+
+	GFX_TestArrays src;
+	GFX_TestArrays dst;
+	_gfx_test_arrays_init(&src, num, offset);
+	_gfx_test_arrays_init(&dst, num, offset);
+
+	size_t i, c;
+	for(i = 0; i < num; ++i)
+		for(c = 0; c < 4; ++c)
+		{
+			float f = _gfx_test_va[i].data[c];
+			if(c < 3) src3[i].data[c] = f;
+
+			src.comp[c][i] = f;
+		}
+
+	/* Sentinels past the end must not be touched */
+	for(c = 0; c < 4; ++c) dst.comp[c][num] = 42.0f;
+
+	gfx_math_transform_vec3(dst3, m, src3, num);
+	gfx_math_transform_vec4(dst4, m, _gfx_test_va, num);
+
+	GFXVec3Array s3 = { src.comp[0], src.comp[1], src.comp[2] };
+	GFXVec3Array d3 = { dst.comp[0], dst.comp[1], dst.comp[2] };
+	gfx_math_transform_vec3_soa(&d3, m, &s3, num);
+
+	double err3 = 0.0, err4 = 0.0, errSoa3 = 0.0, errSoa4 = 0.0;
+
+	for(i = 0; i < num; ++i)
+	{
+		double r[4];
+		_gfx_test_transform(r, m, _gfx_test_va[i].data, 1.0);
+
+		float rf[3] = { (float)r[0], (float)r[1], (float)r[2] };
+		float soa[3] = { dst.comp[0][i], dst.comp[1][i], dst.comp[2][i] };
+
+		double e = _gfx_test_error(rf, dst3[i].data, 3);
+		err3 = e > err3 ? e : err3;
+
+		e = _gfx_test_error(rf, soa, 3);
+		errSoa3 = e > errSoa3 ? e : errSoa3;
+	}
+
+	GFX_TEST_CHECK(err3 < 1e-6);
+	GFX_TEST_CHECK(errSoa3 < 1e-6);
+	GFX_TEST_CHECK(dst.comp[0][num] == 42.0f && dst.comp[2][num] == 42.0f);
+
+	/* Vectors, in place */
+	GFXVec4Array s4 = { src.comp[0], src.comp[1], src.comp[2], src.comp[3] };
+	gfx_math_transform_vec4_soa(&s4, m, &s4, num);
+
+	for(i = 0; i < num; ++i)
+	{
+		double r[4];
+		_gfx_test_transform(r, m, _gfx_test_va[i].data, _gfx_test_va[i].data[3]);
+
+		float rf[4] = { (float)r[0], (float)r[1], (float)r[2], (float)r[3] };
+		float soa[4] = { src.comp[0][i], src.comp[1][i], src.comp[2][i], src.comp[3][i] };
+
+		double e = _gfx_test_error(rf, dst4[i].data, 4);
+		err4 = e > err4 ? e : err4;
+
+		e = _gfx_test_error(rf, soa, 4);
+		errSoa4 = e > errSoa4 ? e : errSoa4;
+	}
+
+	GFX_TEST_CHECK(err4 < 1e-6);
+	GFX_TEST_CHECK(errSoa4 < 1e-6);
+
+	_gfx_test_arrays_clear(&src);
+	_gfx_test_arrays_clear(&dst);
+}
+
+/******************************************************/
+static void _gfx_test_batch_compose(
+
+		size_t  num,
+		size_t  offset)
+{
+	gfx_vec3 t[GFX_TEST_BATCH];
+	gfx_quat q[GFX_TEST_BATCH];
+	gfx_vec3 s[GFX_TEST_BATCH];
+	gfx_mat4 m[GFX_TEST_BATCH];
+	gfx_mat4 msoa[GFX_TEST_BATCH];
+	gfx_mat4 mnone[GFX_TEST_BATCH];
+
+	GFX_TestArrays ta, qa, sa;
+	_gfx_test_arrays_init(&ta, num, offset);
+	_gfx_test_arrays_init(&qa, num, offset);
+	_gfx_test_arrays_init(&sa, num, offset);
+
+	size_t i, c;
+	for(i = 0; i < num; ++i)
+	{
+		gfx_quat_normalize(q + i, _gfx_test_qb + i);
+
+		for(c = 0; c < 4; ++c)
+		{
+			if(c < 3)
+			{
+				t[i].data[c] = ta.comp[c][i] = _gfx_test_mb[i].data[c] * 10.0f;
+				s[i].data[c] = sa.comp[c][i] = _gfx_test_mb[i].data[c + 4] + 2.0f;
+			}
+
+			qa.comp[c][i] = q[i].data[c];
+		}
+	}
+
+	gfx_math_compose(m, t, q, s, num);
+	gfx_math_compose(mnone, t, q, NULL, num);
+
+	GFXVec3Array tsoa = { ta.comp[0], ta.comp[1], ta.comp[2] };
+	GFXQuatArray qsoa = { qa.comp[0], qa.comp[1], qa.comp[2], qa.comp[3] };
+	GFXVec3Array ssoa = { sa.comp[0], sa.comp[1], sa.comp[2] };
+	gfx_math_compose_soa(msoa, &tsoa, &qsoa, &ssoa, num);
+
+	/* Both layouts give the same matrices */
+	GFX_TEST_CHECK(_gfx_test_error(m->data, msoa->data, num * 16) < 1e-6);
+
+	/* A matrix maps p to t + q * (s * p) * q^-1 */
+	double err = 0.0, errNone = 0.0;
+
+	for(i = 0; i < num; ++i)
+	{
+		const float* p = _gfx_test_va[(i + 1) % GFX_TEST_NUM].data;
+
+		double scaled[3], unscaled[3] = { p[0], p[1], p[2] };
+		for(c = 0; c < 3; ++c) scaled[c] = (double)s[i].data[c] * p[c];
+
+		double r[4], rs[3], rn[3];
+		_gfx_test_rotate(rs, q[i].data, scaled);
+		_gfx_test_rotate(rn, q[i].data, unscaled);
+
+		float fs[4], fn[4], got[4];
+		for(c = 0; c < 3; ++c)
+		{
+			fs[c] = (float)(rs[c] + t[i].data[c]);
+			fn[c] = (float)(rn[c] + t[i].data[c]);
+		}
+
+		fs[3] = fn[3] = 1.0f;
+
+		_gfx_test_transform(r, m + i, p, 1.0);
+		for(c = 0; c < 4; ++c) got[c] = (float)r[c];
+
+		double e = _gfx_test_error(fs, got, 4);
+		err = e > err ? e : err;
+
+		_gfx_test_transform(r, mnone + i, p, 1.0);
+		for(c = 0; c < 4; ++c) got[c] = (float)r[c];
+
+		e = _gfx_test_error(fn, got, 4);
+		errNone = e > errNone ? e : errNone;
+	}
+
+	GFX_TEST_CHECK(err < 1e-5);
+	GFX_TEST_CHECK(errNone < 1e-5);
+
+	_gfx_test_arrays_clear(&ta);
+	_gfx_test_arrays_clear(&qa);
+	_gfx_test_arrays_clear(&sa);
+}
+
+/******************************************************/
+static void _gfx_test_batch_normalize(
+
+		size_t  num,
+		size_t  offset)
+{
+	gfx_quat q[GFX_TEST_BATCH];
+
+	GFX_TestArrays qa;
+	_gfx_test_arrays_init(&qa, num, offset);
+
+	/* The first quaternion of _gfx_test_qa is zero */
+	size_t i, c;
+	for(i = 0; i < num; ++i)
+		for(c = 0; c < 4; ++c)
+			qa.comp[c][i] = _gfx_test_qa[i].data[c];
+
+	gfx_math_normalize_quat(q, _gfx_test_qa, num);
+
+	GFXQuatArray soa = { qa.comp[0], qa.comp[1], qa.comp[2], qa.comp[3] };
+	gfx_math_normalize_quat_soa(&soa, &soa, num);
+
+	double err = 0.0, errSoa = 0.0;
+
+	for(i = 0; i < num; ++i)
+	{
+		const float* a = _gfx_test_qa[i].data;
+		double norm = sqrt(
+			(double)a[0] * a[0] + (double)a[1] * a[1] +
+			(double)a[2] * a[2] + (double)a[3] * a[3]);
+
+		float r[4], got[4];
+		for(c = 0; c < 4; ++c)
+		{
+			r[c] = norm ? (float)(a[c] / norm) : 0.0f;
+			got[c] = qa.comp[c][i];
+		}
+
+		double e = _gfx_test_error(r, q[i].data, 4);
+		err = e > err ? e : err;
+
+		e = _gfx_test_error(r, got, 4);
+		errSoa = e > errSoa ? e : errSoa;
+	}
+
+	GFX_TEST_CHECK(err < 1e-6);
+	GFX_TEST_CHECK(errSoa < 1e-6);
+
+	/* Zero quaternions stay zero */
+	GFX_TEST_CHECK(!num || gfx_quat_is_zero(q));
+	GFX_TEST_CHECK(!num || (
+		!qa.comp[0][0] && !qa.comp[1][0] && !qa.comp[2][0] && !qa.comp[3][0]));
+
+	_gfx_test_arrays_clear(&qa);
+}
+
+/******************************************************/
+static void _gfx_test_batch(void)
+{
+	/* Every tail length, aligned and unaligned arrays */
+	size_t num, offset;
+	for(num = 0; num <= GFX_TEST_BATCH; num += (num < 9) ? 1 : 10)
+		for(offset = 0; offset < 2; ++offset)
+		{
+			_gfx_test_batch_transform(num, offset);
+			_gfx_test_batch_compose(num, offset);
+			_gfx_test_batch_normalize(num, offset);
+		}
+}
+
+/******************************************************/
+int main(void)
+{
+#if defined(GFX_SIMD_AVX)
+	printf("test_math: comparing SSE & AVX kernels against scalar.\n");
+#elif defined(GFX_SIMD_SSE2)
+	printf("test_math: comparing SSE kernels against scalar, build with -mavx to test AVX.\n");
+#else
+	printf("test_math: no intrinsics enabled, comparing scalar against scalar.\n");
+#endif
+
+	srand(1);
+
+	_gfx_test_init();
+	_gfx_test_mat4();
+	_gfx_test_vec4();
+	_gfx_test_quat();
+	_gfx_test_dmat4();
+	_gfx_test_batch();
+
+	return _gfx_test_result("test_math");
+}
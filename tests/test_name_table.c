@@ -0,0 +1,180 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "test.h"
+
+/* Include the table to reach its entries */
+#include "groufix/core/name_table.c"
+
+#include <stdio.h>
+
+
+/* Number of properties and blocks */
+#define GFX_TEST_PROPERTIES  300
+#define GFX_TEST_BLOCKS      40
+
+
+/******************************************************/
+static void _gfx_test_name(
+
+		char*         buff,
+		const char*   prefix,
+		unsigned int  i)
+{
+	sprintf(buff, "%s%u", prefix, i);
+}
+
+/******************************************************/
+/* Checks every name can be found and the table is at most half full */
+static void _gfx_test_find_all(
+
+		const GFX_NameTable*  table,
+		size_t                num)
+{
+	char buff[64];
+	size_t fails = 0;
+	unsigned int i;
+
+	for(i = 0; i < GFX_TEST_PROPERTIES; ++i)
+	{
+		_gfx_test_name(buff, "value", i);
+		fails += _gfx_name_table_find(table, buff, 0) != i + 1;
+
+		/* Arrays are found with and without their [0] suffix */
+		_gfx_test_name(buff, "array", i);
+		fails += _gfx_name_table_find(table, buff, 0) != i + 1;
+
+		strcat(buff, "[0]");
+		fails += _gfx_name_table_find(table, buff, 0) != i + 1;
+	}
+
+	for(i = 0; i < GFX_TEST_BLOCKS; ++i)
+	{
+		/* Blocks may share names with properties */
+		_gfx_test_name(buff, "value", i);
+		fails += _gfx_name_table_find(table, buff, 1) != i + 1 + GFX_TEST_PROPERTIES;
+
+		_gfx_test_name(buff, "block", i);
+		fails += _gfx_name_table_find(table, buff, 1) != i + 1;
+		fails += _gfx_name_table_find(table, buff, 0) != 0;
+	}
+
+	GFX_TEST_CHECK(fails == 0);
+
+	/* Table size is a power of two, at least twice the number of names */
+	size_t size = gfx_vector_get_size(&table->lookup);
+	GFX_TEST_CHECK(size >= (num << 1) && !(size & (size - 1)));
+
+	size_t used = 0;
+	for(i = 0; i < size; ++i)
+		used += ((GFX_Name*)gfx_vector_at(&table->lookup, i))->index != 0;
+
+	GFX_TEST_CHECK(used == num);
+}
+
+/******************************************************/
+static size_t _gfx_test_fill(
+
+		GFX_NameTable* table)
+{
+	char buff[64];
+	size_t num = 0;
+	unsigned int i;
+
+	for(i = 0; i < GFX_TEST_PROPERTIES; ++i)
+	{
+		_gfx_test_name(buff, "value", i);
+		_gfx_name_table_add(table, buff, strlen(buff), i, 0);
+
+		/* Only part of the string is the name */
+		_gfx_test_name(buff, "array", i);
+		strcat(buff, "[0]");
+
+		_gfx_name_table_add(table, buff, strlen(buff), i, 0);
+		_gfx_name_table_add(table, buff, strlen(buff) - 3, i, 0);
+
+		num += 3;
+	}
+
+	for(i = 0; i < GFX_TEST_BLOCKS; ++i)
+	{
+		_gfx_test_name(buff, "value", i);
+		_gfx_name_table_add(table, buff, strlen(buff), i + GFX_TEST_PROPERTIES, 1);
+
+		_gfx_test_name(buff, "block", i);
+		_gfx_name_table_add(table, buff, strlen(buff), i, 1);
+
+		num += 2;
+	}
+
+	return num;
+}
+
+/******************************************************/
+int main(void)
+{
+	GFX_NameTable table;
+	_gfx_name_table_init(&table);
+
+	/* Nothing is found in an empty table, built or not */
+	GFX_TEST_CHECK(!_gfx_name_table_find(&table, "value0", 0));
+
+	_gfx_name_table_build(&table);
+	GFX_TEST_CHECK(!_gfx_name_table_find(&table, "value0", 0));
+	GFX_TEST_CHECK(!gfx_vector_get_size(&table.lookup));
+
+	/* Fill and find everything */
+	size_t num = _gfx_test_fill(&table);
+	_gfx_name_table_build(&table);
+	_gfx_test_find_all(&table, num);
+
+	/* Names that are prefixes of, or extend, existing names */
+	GFX_TEST_CHECK(!_gfx_name_table_find(&table, "", 0));
+	GFX_TEST_CHECK(!_gfx_name_table_find(&table, "value", 0));
+	GFX_TEST_CHECK(!_gfx_name_table_find(&table, "value1x", 0));
+	GFX_TEST_CHECK(!_gfx_name_table_find(&table, "array1[1]", 0));
+	GFX_TEST_CHECK(!_gfx_name_table_find(&table, "value1000", 0));
+	GFX_TEST_CHECK(!_gfx_name_table_find(&table, "block1", 0));
+
+	/* A cleared table can be filled again, as when relinking */
+	_gfx_name_table_clear(&table);
+	GFX_TEST_CHECK(!_gfx_name_table_find(&table, "value0", 0));
+
+	num = _gfx_test_fill(&table);
+	_gfx_name_table_build(&table);
+	_gfx_test_find_all(&table, num);
+
+	_gfx_name_table_clear(&table);
+
+	/* Names with equal hashes are told apart */
+	/* Give a single name the hash of another */
+	_gfx_name_table_add(&table, "first", 5, 0, 0);
+	_gfx_name_table_build(&table);
+
+	GFX_Name* entry = table.lookup.begin;
+	if(!entry->index) entry = gfx_vector_next(&table.lookup, entry);
+
+	GFX_Name forged = *entry;
+	forged.hash = _gfx_name_table_hash("second", 6);
+
+	memset(table.lookup.begin, 0, gfx_vector_get_byte_size(&table.lookup));
+	*(GFX_Name*)gfx_vector_at(&table.lookup,
+		forged.hash & (gfx_vector_get_size(&table.lookup) - 1)) = forged;
+
+	GFX_TEST_CHECK(!_gfx_name_table_find(&table, "second", 0));
+
+	_gfx_name_table_clear(&table);
+
+	return _gfx_test_result("test_name_table");
+}
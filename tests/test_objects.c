@@ -0,0 +1,223 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "test.h"
+
+/* Include the containers to reach their references */
+#include "groufix/core/objects.c"
+
+
+/* Number of objects and distinct orders among them */
+#define GFX_TEST_OBJECTS  12
+#define GFX_TEST_ORDERS   3
+
+
+/******************************************************/
+/** A render object counting its callbacks */
+typedef struct GFX_TestObject
+{
+	GFX_RenderObjectID  id;
+	unsigned int        destructs;
+	unsigned int        prepares;
+	unsigned int        transfers;
+
+} GFX_TestObject;
+
+
+/** All objects and the order in which they were prepared */
+static GFX_TestObject _gfx_test_objects[GFX_TEST_OBJECTS];
+static unsigned char _gfx_test_prepared[GFX_TEST_OBJECTS];
+static size_t _gfx_test_num_prepared = 0;
+
+
+/******************************************************/
+static void _gfx_test_destruct(
+
+		GFX_RenderObjectIDArg arg)
+{
+	++((GFX_TestObject*)arg)->destructs;
+}
+
+/******************************************************/
+static void _gfx_test_prepare(
+
+		GFX_RenderObjectIDArg  arg,
+		void**                 temp,
+		int                    shared)
+{
+	GFX_TestObject* obj = arg;
+	++obj->prepares;
+
+	if(_gfx_test_num_prepared < GFX_TEST_OBJECTS)
+		_gfx_test_prepared[_gfx_test_num_prepared++] = obj->id.order;
+
+	*temp = obj;
+}
+
+/******************************************************/
+static void _gfx_test_transfer(
+
+		GFX_RenderObjectIDArg  arg,
+		void**                 temp,
+		int                    shared)
+{
+	GFX_TestObject* obj = arg;
+	obj->transfers += (*temp == obj);
+}
+
+/******************************************************/
+static const GFX_RenderObjectFuncs _gfx_test_funcs =
+{
+	.destruct = _gfx_test_destruct,
+	.prepare  = _gfx_test_prepare,
+	.transfer = _gfx_test_transfer
+};
+
+
+/******************************************************/
+/* Checks every reference of every object resolves to that object */
+static void _gfx_test_check_refs(void)
+{
+	size_t fails = 0;
+	size_t i;
+
+	for(i = 0; i < GFX_TEST_OBJECTS; ++i)
+	{
+		GFX_RenderObjectID* id = &_gfx_test_objects[i].id;
+		const GFX_RenderObjectRef* ref;
+
+		if(id->refs.objects) for(ref = &id->refs; ref; ref = ref->next)
+		{
+			GFX_RenderObjectID** found =
+				gfx_slot_map_at(&ref->objects->objects, ref->id);
+
+			fails += !found || *found != id;
+		}
+	}
+
+	GFX_TEST_CHECK(fails == 0);
+}
+
+/******************************************************/
+/* Number of objects referencing a container */
+static size_t _gfx_test_count(
+
+		const GFX_RenderObjects* cont)
+{
+	size_t num = 0;
+	size_t i;
+
+	for(i = 0; i < GFX_TEST_OBJECTS; ++i)
+		num += _gfx_render_object_id_check(&_gfx_test_objects[i].id, cont);
+
+	GFX_TEST_CHECK(num == gfx_slot_map_get_size(&cont->objects));
+
+	return num;
+}
+
+/******************************************************/
+int main(void)
+{
+	const GFXRenderObjectFlags flags =
+		GFX_OBJECT_NEEDS_REFERENCE | GFX_OBJECT_CAN_SHARE;
+
+	GFX_RenderObjects a, b, c;
+	GFX_TEST_CHECK(_gfx_render_objects_init(&a));
+	GFX_TEST_CHECK(_gfx_render_objects_init(&b));
+	GFX_TEST_CHECK(_gfx_render_objects_init(&c));
+
+	/* Objects needing a reference need a container */
+	GFX_TEST_CHECK(!_gfx_render_object_id_init(
+		&_gfx_test_objects[0].id, 0, flags, &_gfx_test_funcs, NULL));
+
+	/* Reference all objects at the first container, every other at the second */
+	size_t i;
+	for(i = 0; i < GFX_TEST_OBJECTS; ++i)
+	{
+		GFX_RenderObjectID* id = &_gfx_test_objects[i].id;
+
+		GFX_TEST_CHECK(_gfx_render_object_id_init(
+			id, i % GFX_TEST_ORDERS, flags, &_gfx_test_funcs, &a));
+
+		if(!(i & 1))
+			GFX_TEST_CHECK(_gfx_render_object_id_reference(id, flags, &b));
+	}
+
+	/* Referencing twice does nothing, sharing needs the flag */
+	GFX_TEST_CHECK(_gfx_render_object_id_reference(&_gfx_test_objects[0].id, flags, &b));
+	GFX_TEST_CHECK(!_gfx_render_object_id_reference(&_gfx_test_objects[1].id, 0, &b));
+
+	GFX_TEST_CHECK(_gfx_test_count(&a) == GFX_TEST_OBJECTS);
+	GFX_TEST_CHECK(_gfx_test_count(&b) == GFX_TEST_OBJECTS / 2);
+	_gfx_test_check_refs();
+
+	/* Clearing objects in the middle keeps all other references valid */
+	_gfx_render_object_id_clear(&_gfx_test_objects[0].id);
+	_gfx_render_object_id_clear(&_gfx_test_objects[5].id);
+
+	GFX_TEST_CHECK(_gfx_test_objects[0].destructs == 1);
+	GFX_TEST_CHECK(_gfx_test_objects[5].destructs == 1);
+	GFX_TEST_CHECK(_gfx_test_count(&a) == GFX_TEST_OBJECTS - 2);
+	GFX_TEST_CHECK(_gfx_test_count(&b) == GFX_TEST_OBJECTS / 2 - 1);
+	_gfx_test_check_refs();
+
+	/* The last reference of an object that needs one cannot be dropped */
+	GFX_RenderObjectID* id = &_gfx_test_objects[2].id;
+
+	GFX_TEST_CHECK(_gfx_render_object_id_dereference(id, flags, &a));
+	GFX_TEST_CHECK(!_gfx_render_object_id_dereference(id, flags, &b));
+	GFX_TEST_CHECK(_gfx_test_objects[2].destructs == 0);
+
+	GFX_TEST_CHECK(_gfx_render_object_id_dereference(id, 0, &b));
+	GFX_TEST_CHECK(_gfx_test_objects[2].destructs == 1);
+	_gfx_test_check_refs();
+
+	/* Preparing dereferences everything in order, without destructing */
+	size_t prepared = _gfx_test_count(&a);
+	_gfx_render_objects_prepare(&a, 0);
+
+	GFX_TEST_CHECK(_gfx_test_num_prepared == prepared);
+	GFX_TEST_CHECK(_gfx_test_count(&a) == 0);
+	_gfx_test_check_refs();
+
+	for(i = 1; i < _gfx_test_num_prepared; ++i)
+		GFX_TEST_CHECK(_gfx_test_prepared[i - 1] <= _gfx_test_prepared[i]);
+
+	/* Transferring references them all at the new container */
+	_gfx_render_objects_transfer(&a, &c, 0);
+
+	GFX_TEST_CHECK(_gfx_test_count(&c) == prepared);
+	_gfx_test_check_refs();
+
+	for(i = 0; i < GFX_TEST_OBJECTS; ++i)
+	{
+		GFX_TestObject* obj = _gfx_test_objects + i;
+		GFX_TEST_CHECK(obj->prepares == obj->transfers);
+	}
+
+	/* Clearing the containers destructs every object exactly once */
+	_gfx_render_objects_clear(&b);
+	_gfx_render_objects_clear(&c);
+	_gfx_render_objects_clear(&a);
+
+	for(i = 0; i < GFX_TEST_OBJECTS; ++i)
+	{
+		GFX_TestObject* obj = _gfx_test_objects + i;
+
+		GFX_TEST_CHECK(obj->destructs == 1);
+		GFX_TEST_CHECK(!obj->id.refs.objects);
+	}
+
+	return _gfx_test_result("test_objects");
+}
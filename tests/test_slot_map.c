@@ -0,0 +1,263 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/containers/slot_map.h"
+#include "test.h"
+
+#include <stdlib.h>
+
+
+/* Number of times a slot is reused, well past the 8 bit generation */
+#define GFX_TEST_REUSES  1000
+
+/* Number of elements for the reset, churn and random tests */
+#define GFX_TEST_SIZE    64
+
+/* Number of erase/insert pairs, past the 2^24 handle space */
+#define GFX_TEST_CHURN   ((1 << 24) + (1 << 20))
+
+/* Number of most recent generations of a slot that never alias */
+#define GFX_TEST_WINDOW  255
+
+
+/******************************************************/
+/* Checks that exactly the live handles resolve to their values */
+static void _gfx_test_validate(
+
+		const GFXSlotMap*     map,
+		const GFXSlotHandle*  live,
+		const unsigned int*   values,
+		size_t                num)
+{
+	GFX_TEST_CHECK(gfx_slot_map_get_size(map) == num);
+
+	size_t i;
+	for(i = 0; i < num; ++i)
+	{
+		unsigned int* v = gfx_slot_map_at(map, live[i]);
+		GFX_TEST_CHECK(v && *v == values[i]);
+
+		size_t index = gfx_slot_map_get_index(map, live[i]);
+		GFX_TEST_CHECK(index && gfx_slot_map_get_handle(map, index - 1) == live[i]);
+	}
+}
+
+/******************************************************/
+/* Erasing and inserting reuses the same slot over and over */
+static void _gfx_test_reuse(void)
+{
+	GFXSlotMap map;
+	gfx_slot_map_init(&map, sizeof(unsigned int));
+
+	GFXSlotHandle* stale = malloc(sizeof(GFXSlotHandle) * GFX_TEST_REUSES);
+
+	unsigned int v;
+	for(v = 0; v < GFX_TEST_REUSES; ++v)
+	{
+		stale[v] = gfx_slot_map_insert(&map, &v);
+		GFX_TEST_CHECK(stale[v]);
+
+		/* No recent handle may alias the new one */
+		size_t i;
+		for(i = v > GFX_TEST_WINDOW ? v - GFX_TEST_WINDOW : 0; i < v; ++i)
+			GFX_TEST_CHECK(stale[i] != stale[v] && !gfx_slot_map_at(&map, stale[i]));
+
+		GFX_TEST_CHECK(gfx_slot_map_erase(&map, stale[v]));
+		GFX_TEST_CHECK(!gfx_slot_map_erase(&map, stale[v]));
+
+		if(_gfx_test_failures) break;
+	}
+
+	/* The generation wraps around, a single slot is all it takes */
+	GFX_TEST_CHECK(gfx_vector_get_size(&map.slots) == 1);
+
+	/* No stale handle is valid while nothing is inserted */
+	for(v = 0; v < GFX_TEST_REUSES; ++v)
+		GFX_TEST_CHECK(!gfx_slot_map_at(&map, stale[v]));
+
+	gfx_slot_map_compact(&map);
+	GFX_TEST_CHECK(gfx_vector_get_size(&map.slots) == 0);
+
+	gfx_slot_map_clear(&map);
+	free(stale);
+}
+
+/******************************************************/
+/* Resetting invalidates every handle, also after many resets */
+static void _gfx_test_reset(void)
+{
+	GFXSlotMap map;
+	gfx_slot_map_init(&map, sizeof(unsigned int));
+
+	GFXSlotHandle* stale = malloc(sizeof(GFXSlotHandle) * GFX_TEST_SIZE * GFX_TEST_REUSES);
+	GFXSlotHandle live[GFX_TEST_SIZE];
+	unsigned int values[GFX_TEST_SIZE];
+
+	size_t round, i;
+	for(round = 0; round < GFX_TEST_REUSES; ++round)
+	{
+		for(i = 0; i < GFX_TEST_SIZE; ++i)
+		{
+			values[i] = (unsigned int)(round * GFX_TEST_SIZE + i);
+			live[i] = gfx_slot_map_insert(&map, values + i);
+			stale[round * GFX_TEST_SIZE + i] = live[i];
+		}
+
+		_gfx_test_validate(&map, live, values, GFX_TEST_SIZE);
+
+		/* Handles of recent rounds are not handed out again */
+		size_t first = round > GFX_TEST_WINDOW ? round - GFX_TEST_WINDOW : 0;
+		size_t j;
+		for(j = first * GFX_TEST_SIZE; j < round * GFX_TEST_SIZE; j += 7)
+			GFX_TEST_CHECK(!gfx_slot_map_at(&map, stale[j]));
+
+		/* Erase a few in between, so generations differ per slot */
+		if(round & 1) gfx_slot_map_erase(&map, live[round % GFX_TEST_SIZE]);
+
+		gfx_slot_map_reset(&map);
+
+		/* All handles of this round are invalid */
+		for(i = 0; i < GFX_TEST_SIZE; ++i)
+			GFX_TEST_CHECK(!gfx_slot_map_at(&map, live[i]));
+
+		if(_gfx_test_failures) break;
+	}
+
+	/* Resetting never grows the slot table */
+	GFX_TEST_CHECK(gfx_vector_get_size(&map.slots) == GFX_TEST_SIZE);
+
+	gfx_slot_map_clear(&map);
+	free(stale);
+}
+
+/******************************************************/
+/* Churning through more handles than fit in a handle never runs out */
+static void _gfx_test_churn(void)
+{
+	GFXSlotMap map;
+	gfx_slot_map_init(&map, sizeof(unsigned int));
+
+	GFXSlotHandle live[GFX_TEST_SIZE];
+	unsigned int values[GFX_TEST_SIZE];
+	GFXSlotHandle erased[GFX_TEST_WINDOW];
+
+	size_t i;
+	for(i = 0; i < GFX_TEST_SIZE; ++i)
+	{
+		values[i] = (unsigned int)i;
+		live[i] = gfx_slot_map_insert(&map, values + i);
+	}
+
+	for(i = 0; i < GFX_TEST_WINDOW; ++i)
+		erased[i] = 0;
+
+	unsigned int next = GFX_TEST_SIZE;
+	size_t op;
+
+	for(op = 0; op < GFX_TEST_CHURN; ++op)
+	{
+		size_t e = (size_t)rand() % GFX_TEST_SIZE;
+		erased[op % GFX_TEST_WINDOW] = live[e];
+
+		gfx_slot_map_erase(&map, live[e]);
+
+		values[e] = next++;
+		live[e] = gfx_slot_map_insert(&map, values + e);
+
+		GFX_TEST_CHECK(live[e]);
+
+		/* The most recently erased handles are all still invalid */
+		if(!(op & 0xfff))
+		{
+			size_t j;
+			for(j = 0; j < GFX_TEST_WINDOW; ++j)
+				GFX_TEST_CHECK(!erased[j] || !gfx_slot_map_at(&map, erased[j]));
+		}
+
+		if(_gfx_test_failures) break;
+	}
+
+	GFX_TEST_CHECK(gfx_vector_get_size(&map.slots) <= GFX_TEST_SIZE + 1);
+	_gfx_test_validate(&map, live, values, GFX_TEST_SIZE);
+
+	gfx_slot_map_clear(&map);
+}
+
+/******************************************************/
+/* Random inserts and erasures against a plain array */
+static void _gfx_test_random(void)
+{
+	GFXSlotMap map;
+	gfx_slot_map_init(&map, sizeof(unsigned int));
+
+	GFXSlotHandle live[GFX_TEST_SIZE];
+	unsigned int values[GFX_TEST_SIZE];
+	size_t num = 0;
+
+	unsigned int next = 0;
+	size_t op;
+
+	for(op = 0; op < 100000; ++op)
+	{
+		int r = rand() % 8;
+
+		if(r < 4 && num < GFX_TEST_SIZE)
+		{
+			values[num] = ++next;
+			live[num] = gfx_slot_map_insert(&map, values + num);
+
+			GFX_TEST_CHECK(live[num]);
+			++num;
+		}
+
+		else if(r < 7 && num)
+		{
+			/* Erase by handle or by index */
+			size_t i = (size_t)rand() % num;
+			GFXSlotHandle handle = live[i];
+
+			if(r & 1)
+				GFX_TEST_CHECK(gfx_slot_map_erase(&map, handle));
+			else
+				gfx_slot_map_erase_at(&map, gfx_slot_map_get_index(&map, handle) - 1);
+
+			GFX_TEST_CHECK(!gfx_slot_map_at(&map, handle));
+
+			live[i] = live[--num];
+			values[i] = values[num];
+		}
+
+		else gfx_slot_map_compact(&map);
+
+		if(!(op & 0xff)) _gfx_test_validate(&map, live, values, num);
+		if(_gfx_test_failures) break;
+	}
+
+	_gfx_test_validate(&map, live, values, num);
+
+	gfx_slot_map_clear(&map);
+}
+
+/******************************************************/
+int main(void)
+{
+	srand(1);
+
+	_gfx_test_reuse();
+	_gfx_test_reset();
+	_gfx_test_churn();
+	_gfx_test_random();
+
+	return _gfx_test_result("test_slot_map");
+}
@@ -0,0 +1,175 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "groufix/containers/thread_pool.h"
+#include "groufix/core/threading.h"
+#include "test.h"
+
+#include <sched.h>
+
+
+/* Number of times a group is created, waited on and freed */
+#define GFX_TEST_ROUNDS  300000
+
+/* Number of workers, more than cores to provoke interleaving */
+#define GFX_TEST_WORKERS  4
+
+/* Number of tasks pushed per flush, each of which pushes another */
+#define GFX_TEST_FLUSH_TASKS  8
+
+
+/******************************************************/
+static GFX_ATOMIC(size_t) _gfx_test_executed = 0;
+
+
+/******************************************************/
+static void _gfx_test_task(
+
+		void* data)
+{
+	GFX_ATOMIC_ADD(&_gfx_test_executed, 1);
+}
+
+/******************************************************/
+static void _gfx_test_parent(
+
+		void* data)
+{
+	GFX_ATOMIC_ADD(&_gfx_test_executed, 1);
+
+	/* Pushed to the deque of this worker, any other worker may steal it */
+	if(!gfx_thread_pool_push(data, _gfx_test_task, NULL, 0))
+		_gfx_test_task(NULL);
+}
+
+/******************************************************/
+/* Groups are freed right after waiting, while the last task might still finish */
+static void _gfx_test_single(
+
+		GFXThreadPool* pool)
+{
+	size_t expected = 0;
+	size_t r;
+
+	GFX_ATOMIC_STORE(&_gfx_test_executed, 0, GFX_ATOMIC_SEQ_CST);
+
+	for(r = 0; r < GFX_TEST_ROUNDS; ++r)
+	{
+		GFXThreadPoolGroup* group = gfx_thread_pool_group_create(pool);
+		GFX_TEST_CHECK(group);
+		if(!group) break;
+
+		size_t t, tasks = 1 + r % 3;
+		for(t = 0; t < tasks; ++t)
+			if(gfx_thread_pool_group_push(group, NULL, _gfx_test_task, NULL, 0))
+				++expected;
+
+		gfx_thread_pool_group_wait(group);
+		gfx_thread_pool_group_free(group);
+
+		/* Everything must be done once wait returns */
+		GFX_TEST_CHECK(GFX_ATOMIC_LOAD(&_gfx_test_executed, GFX_ATOMIC_SEQ_CST) == expected);
+		if(_gfx_test_failures) break;
+	}
+}
+
+/******************************************************/
+/* Same, but the finishing task also pushes deferred tasks of another group */
+static void _gfx_test_dependent(
+
+		GFXThreadPool* pool)
+{
+	size_t expected = 0;
+	size_t r;
+
+	GFX_ATOMIC_STORE(&_gfx_test_executed, 0, GFX_ATOMIC_SEQ_CST);
+
+	for(r = 0; r < GFX_TEST_ROUNDS; ++r)
+	{
+		GFXThreadPoolGroup* first = gfx_thread_pool_group_create(pool);
+		GFXThreadPoolGroup* second = gfx_thread_pool_group_create(pool);
+		GFX_TEST_CHECK(first && second);
+		if(!first || !second) break;
+
+		expected += gfx_thread_pool_group_push(first, NULL, _gfx_test_task, NULL, 0);
+		expected += gfx_thread_pool_group_push(second, first, _gfx_test_task, NULL, 0);
+		expected += gfx_thread_pool_group_push(second, first, _gfx_test_task, NULL, 0);
+
+		/* Free the dependency as soon as possible */
+		gfx_thread_pool_group_wait(first);
+		gfx_thread_pool_group_free(first);
+
+		gfx_thread_pool_group_wait(second);
+		gfx_thread_pool_group_free(second);
+
+		GFX_TEST_CHECK(GFX_ATOMIC_LOAD(&_gfx_test_executed, GFX_ATOMIC_SEQ_CST) == expected);
+		if(_gfx_test_failures) break;
+	}
+}
+
+/******************************************************/
+/* Tasks pushed by workers are counted before any other worker can take them */
+/* If not, the pending count underflows and flushing either hangs or returns */
+/* while tasks are still queued */
+static void _gfx_test_flush(
+
+		GFXThreadPool* pool)
+{
+	size_t expected = 0;
+	size_t r;
+
+	GFX_ATOMIC_STORE(&_gfx_test_executed, 0, GFX_ATOMIC_SEQ_CST);
+
+	for(r = 0; r < GFX_TEST_ROUNDS / GFX_TEST_FLUSH_TASKS; ++r)
+	{
+		size_t t;
+		for(t = 0; t < GFX_TEST_FLUSH_TASKS; ++t)
+			if(gfx_thread_pool_push(pool, _gfx_test_parent, pool, 0))
+				expected += 2;
+
+		gfx_thread_pool_flush(pool);
+	}
+
+	/* Flushing only waits until tasks are taken, give them time to run */
+	double start = _gfx_test_time();
+	while(
+		GFX_ATOMIC_LOAD(&_gfx_test_executed, GFX_ATOMIC_SEQ_CST) != expected &&
+		_gfx_test_time() - start < 10.0)
+	{
+		sched_yield();
+	}
+
+	GFX_TEST_CHECK(GFX_ATOMIC_LOAD(&_gfx_test_executed, GFX_ATOMIC_SEQ_CST) == expected);
+}
+
+/******************************************************/
+int main(void)
+{
+	GFXThreadPool* pool = gfx_thread_pool_create(NULL, NULL, 0);
+	GFX_TEST_CHECK(pool);
+
+	if(pool)
+	{
+		GFX_TEST_CHECK(
+			gfx_thread_pool_expand(pool, GFX_TEST_WORKERS, NULL) == GFX_TEST_WORKERS);
+
+		_gfx_test_single(pool);
+		_gfx_test_dependent(pool);
+		_gfx_test_flush(pool);
+
+		gfx_thread_pool_free(pool);
+	}
+
+	return _gfx_test_result("test_thread_pool_group");
+}
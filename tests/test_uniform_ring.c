@@ -0,0 +1,165 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "gl.h"
+
+
+/* Uniform buffer offset alignment of the fake GL */
+#define GFX_TEST_ALIGN  256
+
+/* Number of times to wrap around the ring */
+#define GFX_TEST_LAPS   3
+
+
+/******************************************************/
+void APIENTRY glGetIntegerv(
+
+		GLenum  pname,
+		GLint*  data)
+{
+	*data = (pname == GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT) ? GFX_TEST_ALIGN : 0;
+}
+
+
+/******************************************************/
+/* The ring itself, including all its internal functions */
+#include "groufix/core/renderer/gl_ring.c"
+
+
+/******************************************************/
+/* Writes to the ring and checks where the data ended up */
+static GLintptr _gfx_test_write(
+
+		GLsizeiptr     size,
+		unsigned char  value)
+{
+	unsigned char* data = malloc(size);
+	memset(data, value, size);
+
+	GLintptr offset = -1;
+	GLuint buffer = _gfx_gl_uniform_ring_write(
+		data, size, &offset, _gfx_test_context);
+
+	GFX_TEST_CHECK(buffer);
+
+	if(buffer)
+	{
+		const GFX_UniformRing* ring = _gfx_test_context->renderer.uniformRing;
+		GFX_TestBuffer* buff = _gfx_test_get_buffer(buffer);
+
+		GFX_TEST_CHECK(buffer == ring->buffer);
+		GFX_TEST_CHECK(offset >= 0 && !(offset % GFX_TEST_ALIGN));
+		GFX_TEST_CHECK(offset + size <= GFX_GL_RING_SIZE);
+		GFX_TEST_CHECK(!memcmp(buff->data + offset, data, size));
+
+		/* Data is in a single segment, which the GPU is done with */
+		GLintptr s = offset / GFX_GL_RING_SEGMENT_SIZE;
+
+		GFX_TEST_CHECK(s == (offset + size - 1) / GFX_GL_RING_SEGMENT_SIZE);
+		GFX_TEST_CHECK(s == ring->segment && !ring->fences[s]);
+	}
+
+	free(data);
+
+	return offset;
+}
+
+/******************************************************/
+static void _gfx_test_ring(
+
+		int  bufferStorage,
+		int  mapFails)
+{
+	_gfx_test_context_init(bufferStorage);
+	_gfx_test_gl.mapFails = mapFails;
+
+	int mapped = bufferStorage && !mapFails;
+
+	/* Nothing is created for data that cannot fit */
+	GLintptr offset;
+	GFX_TEST_CHECK(!_gfx_gl_uniform_ring_write(
+		"", 0, &offset, _gfx_test_context));
+
+	GFX_TEST_CHECK(!_gfx_gl_uniform_ring_write(
+		NULL, GFX_GL_RING_SEGMENT_SIZE + 1, &offset, _gfx_test_context));
+
+	GFX_TEST_CHECK(!_gfx_test_context->renderer.uniformRing);
+	GFX_TEST_CHECK(_gfx_test_live_buffers() == 0);
+
+	/* The ring is created on the first write and aligns every write */
+	GFX_TEST_CHECK(_gfx_test_write(10, 1) == 0);
+	GFX_TEST_CHECK(_gfx_test_write(10, 2) == GFX_TEST_ALIGN);
+	GFX_TEST_CHECK(_gfx_test_write(GFX_TEST_ALIGN, 3) == GFX_TEST_ALIGN * 2);
+
+	const GFX_UniformRing* ring = _gfx_test_context->renderer.uniformRing;
+	GFX_TEST_CHECK(ring && (ring->ptr != NULL) == mapped);
+	GFX_TEST_CHECK(_gfx_test_live_buffers() == 1);
+	GFX_TEST_CHECK(_gfx_test_gl.created == (mapFails ? 2u : 1u));
+
+	/* Go around the ring a couple of times */
+	GLsizeiptr size = GFX_GL_RING_SEGMENT_SIZE / 2 + 1;
+	size_t allocs = _gfx_test_gl.allocs;
+	unsigned int laps = 0;
+	unsigned int i;
+
+	for(i = 0; laps < GFX_TEST_LAPS; ++i)
+	{
+		GLintptr prev = ring->head;
+		GLintptr next = _gfx_test_write(size, (unsigned char)(i + 4));
+
+		if(next < prev)
+		{
+			++laps;
+
+			/* Every segment entered is waited for, except on the first lap */
+			/* Without mapping, wrapping orphans the buffer instead */
+			size_t waits = laps * GFX_GL_RING_SEGMENTS - (GFX_GL_RING_SEGMENTS - 1);
+
+			GFX_TEST_CHECK(next == 0);
+			GFX_TEST_CHECK(_gfx_test_gl.waits == (mapped ? waits : 0));
+			GFX_TEST_CHECK(_gfx_test_gl.allocs == allocs + (mapped ? 0 : laps));
+		}
+
+		/* Only segments the head left behind are fenced */
+		GFX_TEST_CHECK(_gfx_test_live_fences() <= (mapped ? GFX_GL_RING_SEGMENTS - 1 : 0));
+	}
+
+	/* Freeing releases everything, and only once */
+	_gfx_gl_uniform_ring_clear(_gfx_test_context);
+
+	GFX_TEST_CHECK(!_gfx_test_context->renderer.uniformRing);
+	GFX_TEST_CHECK(_gfx_test_live_buffers() == 0);
+	GFX_TEST_CHECK(_gfx_test_live_fences() == 0);
+
+	_gfx_gl_uniform_ring_clear(_gfx_test_context);
+
+	/* And a new ring is created on the next write */
+	GFX_TEST_CHECK(_gfx_test_write(10, 1) == 0);
+	GFX_TEST_CHECK(_gfx_test_live_buffers() == 1);
+
+	_gfx_gl_uniform_ring_clear(_gfx_test_context);
+}
+
+/******************************************************/
+int main(void)
+{
+	/* Uploaded, persistently mapped and failing to map */
+	_gfx_test_ring(0, 0);
+	_gfx_test_ring(1, 0);
+	_gfx_test_ring(1, 1);
+
+	_gfx_test_context_clear();
+
+	return _gfx_test_result("test_uniform_ring");
+}
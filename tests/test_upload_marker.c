@@ -0,0 +1,118 @@
+/**
+ * Groufix  :  Graphics Engine produced by Ckef Worx.
+ * www      :  <http://www.ckef-worx.com>.
+ *
+ * This file is part of Groufix.
+ *
+ * Copyright (C) Stef Velzel.
+ *
+ * Groufix is licensed under the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the license,
+ * or (at your option) any later version.
+ *
+ */
+
+#include "test.h"
+
+/* Include the markers themselves */
+#include "groufix/core/upload_marker.c"
+
+#include <limits.h>
+
+
+/* Number of copies to test all ranges of */
+#define GFX_TEST_COPIES  8
+
+
+/******************************************************/
+/* Resets every uploaded copy with every range and compares */
+static void _gfx_test_ranges(void)
+{
+	size_t fails = 0;
+	unsigned int copy, first, num;
+
+	for(copy = 0; copy < GFX_TEST_COPIES; ++copy)
+		for(first = 0; first < GFX_TEST_COPIES; ++first)
+			for(num = 0; num < GFX_TEST_COPIES; ++num)
+			{
+				GFX_UploadMarker marker = 0;
+				_gfx_upload_marker_set(&marker, copy);
+				_gfx_upload_marker_reset(&marker, first, num);
+
+				int changed = copy >= first && (!num || copy < first + num);
+				fails += changed ? (marker != 0) : (marker != copy + 1);
+			}
+
+	GFX_TEST_CHECK(fails == 0);
+
+	/* Nothing uploaded stays that way */
+	GFX_UploadMarker marker = 0;
+	_gfx_upload_marker_reset(&marker, 0, 0);
+	GFX_TEST_CHECK(marker == 0);
+
+	/* Ranges reaching past the last copy do not wrap around */
+	_gfx_upload_marker_set(&marker, UINT_MAX - 1);
+	_gfx_upload_marker_reset(&marker, UINT_MAX - 2, UINT_MAX);
+	GFX_TEST_CHECK(marker == 0);
+
+	_gfx_upload_marker_set(&marker, 0);
+	_gfx_upload_marker_reset(&marker, 1, UINT_MAX);
+	GFX_TEST_CHECK(marker == 1);
+}
+
+/******************************************************/
+/* Follows a single property through a couple of frames */
+static void _gfx_test_frames(void)
+{
+	GFX_UploadMarker marker = 0;
+
+	/* Using the same copy twice uploads once */
+	GFX_TEST_CHECK(_gfx_upload_marker_set(&marker, 2));
+	GFX_TEST_CHECK(!_gfx_upload_marker_set(&marker, 2));
+
+	/* Switching copies uploads every time */
+	GFX_TEST_CHECK(_gfx_upload_marker_set(&marker, 3));
+	GFX_TEST_CHECK(_gfx_upload_marker_set(&marker, 2));
+
+	/* Only setting the uploaded copy uploads again */
+	_gfx_upload_marker_reset(&marker, 3, 1);
+	GFX_TEST_CHECK(!_gfx_upload_marker_set(&marker, 2));
+
+	_gfx_upload_marker_reset(&marker, 2, 1);
+	GFX_TEST_CHECK(_gfx_upload_marker_set(&marker, 2));
+
+	/* Moving onto the uploaded copy uploads again */
+	_gfx_upload_marker_reset(&marker, 0, 2);
+	GFX_TEST_CHECK(!_gfx_upload_marker_set(&marker, 2));
+
+	_gfx_upload_marker_reset(&marker, 1, 2);
+	GFX_TEST_CHECK(_gfx_upload_marker_set(&marker, 2));
+
+	/* Shrinking keeps remaining copies, removed copies upload again */
+	_gfx_upload_marker_reset(&marker, 3, 0);
+	GFX_TEST_CHECK(!_gfx_upload_marker_set(&marker, 2));
+
+	_gfx_upload_marker_reset(&marker, 2, 0);
+	GFX_TEST_CHECK(_gfx_upload_marker_set(&marker, 2));
+
+	/* Values without copies always use copy 0 */
+	marker = 0;
+	GFX_TEST_CHECK(_gfx_upload_marker_set(&marker, 0));
+	GFX_TEST_CHECK(!_gfx_upload_marker_set(&marker, 0));
+
+	_gfx_upload_marker_reset(&marker, 0, 1);
+	GFX_TEST_CHECK(_gfx_upload_marker_set(&marker, 0));
+
+	/* Another map used the program, everything uploads again */
+	_gfx_upload_marker_reset(&marker, 0, 0);
+	GFX_TEST_CHECK(_gfx_upload_marker_set(&marker, 0));
+}
+
+/******************************************************/
+int main(void)
+{
+	_gfx_test_ranges();
+	_gfx_test_frames();
+
+	return _gfx_test_result("test_upload_marker");
+}